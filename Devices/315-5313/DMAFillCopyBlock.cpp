@@ -0,0 +1,60 @@
+#include "DMAFillCopyBlock.h"
+
+//----------------------------------------------------------------------------------------
+//Fill functions
+//----------------------------------------------------------------------------------------
+//This function builds the list of VRAM writes for a run of DMA fill steps. Each step
+//writes the same byte, with the target address advanced by the auto-increment value
+//between steps, so the address of each write is calculated directly from its step
+//number. Note that the VDP stores VRAM words byteswapped, while we don't, so the LSB of
+//each byte-wide target address is inverted here, in the same way as
+//S315_5313::M5WriteVRAM8Bit.
+//----------------------------------------------------------------------------------------
+void DMAFillCopyBlock::BuildFillWrites(unsigned int firstTargetAddress, unsigned int autoIncrement, unsigned char fillData, unsigned int stepCount, unsigned int* writeAddresses, unsigned char* writeData)
+{
+	for(unsigned int i = 0; i < stepCount; ++i)
+	{
+		writeAddresses[i] = ((firstTargetAddress + (i * autoIncrement)) & (vramSize - 1)) ^ 0x1;
+		writeData[i] = fillData;
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Copy functions
+//----------------------------------------------------------------------------------------
+void DMAFillCopyBlock::BuildCopyReadAddresses(unsigned int firstSourceAddress, unsigned int stepCount, unsigned int* readAddresses)
+{
+	//The source address of a DMA copy always advances by one byte per step, regardless
+	//of the auto-increment value.
+	for(unsigned int i = 0; i < stepCount; ++i)
+	{
+		readAddresses[i] = ((firstSourceAddress + i) & (vramSize - 1)) ^ 0x1;
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//This function builds the list of VRAM writes for a run of DMA copy steps. The caller
+//supplies the data at each source address as it was before the run began. Where the
+//source of a step is the target of an earlier step in the same run, the data from that
+//earlier write is used instead, so the result matches performing each step in turn.
+//The latestWriteIndex buffer records the step number plus one of the most recent write
+//to each address. It must hold vramSize entries which are all zero on entry, and is
+//returned in the same state.
+//----------------------------------------------------------------------------------------
+void DMAFillCopyBlock::BuildCopyWrites(unsigned int firstTargetAddress, unsigned int autoIncrement, unsigned int stepCount, const unsigned int* readAddresses, const unsigned char* readData, unsigned int* writeAddresses, unsigned char* writeData, std::vector<unsigned int>& latestWriteIndex)
+{
+	for(unsigned int i = 0; i < stepCount; ++i)
+	{
+		unsigned int writeAddress = ((firstTargetAddress + (i * autoIncrement)) & (vramSize - 1)) ^ 0x1;
+		unsigned int sourceWriteIndex = latestWriteIndex[readAddresses[i]];
+		writeAddresses[i] = writeAddress;
+		writeData[i] = (sourceWriteIndex != 0)? writeData[sourceWriteIndex - 1]: readData[i];
+		latestWriteIndex[writeAddress] = i + 1;
+	}
+
+	//Clear the entries we used in the write index buffer, ready for the next run
+	for(unsigned int i = 0; i < stepCount; ++i)
+	{
+		latestWriteIndex[writeAddresses[i]] = 0;
+	}
+}
@@ -0,0 +1,20 @@
+#ifndef __DMAFILLCOPYBLOCK_H__
+#define __DMAFILLCOPYBLOCK_H__
+#include <vector>
+
+class DMAFillCopyBlock
+{
+public:
+	//Constants
+	static const unsigned int vramSize = 0x10000;
+
+public:
+	//Fill functions
+	static void BuildFillWrites(unsigned int firstTargetAddress, unsigned int autoIncrement, unsigned char fillData, unsigned int stepCount, unsigned int* writeAddresses, unsigned char* writeData);
+
+	//Copy functions
+	static void BuildCopyReadAddresses(unsigned int firstSourceAddress, unsigned int stepCount, unsigned int* readAddresses);
+	static void BuildCopyWrites(unsigned int firstTargetAddress, unsigned int autoIncrement, unsigned int stepCount, const unsigned int* readAddresses, const unsigned char* readData, unsigned int* writeAddresses, unsigned char* writeData, std::vector<unsigned int>& latestWriteIndex);
+};
+
+#endif
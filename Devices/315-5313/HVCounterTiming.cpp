@@ -0,0 +1,858 @@
+#include "HVCounterTiming.h"
+
+//----------------------------------------------------------------------------------------
+//Horizontal scan timing settings
+//----------------------------------------------------------------------------------------
+//Analog screen sections in relation to HCounter (H32 mode):
+//-----------------------------------------------------------------
+//| Screen section | HCounter  |Pixel| Pixel |Serial|Serial |MCLK |
+//| (PAL/NTSC H32) |  value    |clock| clock |clock |clock  |ticks|
+//|                |           |ticks|divider|ticks |divider|     |
+//|----------------|-----------|-----|-------|------|-------|-----|
+//|Left border     |0x00B-0x017|  13 |SCLK/2 |   26 |MCLK/5 | 130 |
+//|----------------|-----------|-----|-------|------|-------|-----|
+//|Active display  |0x018-0x117| 256 |SCLK/2 |  512 |MCLK/5 |2560 |
+//|----------------|-----------|-----|-------|------|-------|-----|
+//|Right border    |0x118-0x125|  14 |SCLK/2 |   28 |MCLK/5 | 140 |
+//|----------------|-----------|-----|-------|------|-------|-----|
+//|Front porch     |0x126-0x127|   9 |SCLK/2 |   18 |MCLK/5 |  90 |
+//|(Right Blanking)|0x1D2-0x1D8|     |       |      |       |     |
+//|----------------|-----------|-----|-------|------|-------|-----|
+//|Horizontal sync |0x1D9-0x1F2|  26 |SCLK/2 |   52 |MCLK/5 | 260 |
+//|----------------|-----------|-----|-------|------|-------|-----|
+//|Back porch      |0x1F3-0x00A|  24 |SCLK/2 |   48 |MCLK/5 | 240 |
+//|(Left Blanking) |           |     |       |      |       |     |
+//|----------------|-----------|-----|-------|------|-------|-----|
+//|TOTALS          |           | 342 |       |  684 |       |3420 |
+//-----------------------------------------------------------------
+
+//Analog screen sections in relation to HCounter (H40 mode):
+//--------------------------------------------------------------------
+//| Screen section |   HCounter    |Pixel| Pixel |EDCLK| EDCLK |MCLK |
+//| (PAL/NTSC H40) |    value      |clock| clock |ticks|divider|ticks|
+//|                |               |ticks|divider|     |       |     |
+//|----------------|---------------|-----|-------|-----|-------|-----|
+//|Left border     |0x00D-0x019    |  13 |EDCLK/2|  26 |MCLK/4 | 104 |
+//|----------------|---------------|-----|-------|-----|-------|-----|
+//|Active display  |0x01A-0x159    | 320 |EDCLK/2| 640 |MCLK/4 |2560 |
+//|----------------|---------------|-----|-------|-----|-------|-----|
+//|Right border    |0x15A-0x167    |  14 |EDCLK/2|  28 |MCLK/4 | 112 |
+//|----------------|---------------|-----|-------|-----|-------|-----|
+//|Front porch     |0x168-0x16C    |   9 |EDCLK/2|  18 |MCLK/4 |  72 |
+//|(Right Blanking)|0x1C9-0x1CC    |     |       |     |       |     |
+//|----------------|---------------|-----|-------|-----|-------|-----|
+//|Horizontal sync |0x1CD.0-0x1D4.5| 7.5 |EDCLK/2|  15 |MCLK/5 |  75 |
+//|                |0x1D4.5-0x1D5.5|   1 |EDCLK/2|   2 |MCLK/4 |   8 |
+//|                |0x1D5.5-0x1DC.0| 7.5 |EDCLK/2|  15 |MCLK/5 |  75 |
+//|                |0x1DD.0        |   1 |EDCLK/2|   2 |MCLK/4 |   8 |
+//|                |0x1DE.0-0x1E5.5| 7.5 |EDCLK/2|  15 |MCLK/5 |  75 |
+//|                |0x1E5.5-0x1E6.5|   1 |EDCLK/2|   2 |MCLK/4 |   8 |
+//|                |0x1E6.5-0x1EC.0| 6.5 |EDCLK/2|  13 |MCLK/5 |  65 |
+//|                |===============|=====|=======|=====|=======|=====|
+//|        Subtotal|0x1CD-0x1EC    | (32)|       | (64)|       |(314)|
+//|----------------|---------------|-----|-------|-----|-------|-----|
+//|Back porch      |0x1ED          |   1 |EDCLK/2|   2 |MCLK/5 |  10 |
+//|(Left Blanking) |0x1EE-0x00C    |  31 |EDCLK/2|  62 |MCLK/4 | 248 |
+//|                |===============|=====|=======|=====|=======|=====|
+//|        Subtotal|0x1ED-0x00C    | (32)|       | (64)|       |(258)|
+//|----------------|---------------|-----|-------|-----|-------|-----|
+//|TOTALS          |               | 420 |       | 840 |       |3420 |
+//--------------------------------------------------------------------
+
+//Digital render events in relation to HCounter:
+//----------------------------------------------------
+//|        Video |PAL/NTSC         |PAL/NTSC         |
+//|         Mode |H32     (RSx=00) |H40     (RSx=11) |
+//|              |V28/V30 (M2=*)   |V28/V30 (M2=*)   |
+//| Event        |Int any (LSMx=**)|Int any (LSMx=**)|
+//|--------------------------------------------------|
+//|HCounter      |[1]0x000-0x127   |[1]0x000-0x16C   |
+//|progression   |[2]0x1D2-0x1FF   |[2]0x1C9-0x1FF   |
+//|9-bit internal|                 |                 |
+//|--------------------------------------------------|
+//|VCounter      |HCounter changes |HCounter changes |
+//|increment     |from 0x109 to    |from 0x149 to    |
+//|              |0x10A in [1].    |0x14A in [1].    |
+//|--------------------------------------------------| //Logic analyzer tests conducted on 2012-11-03 confirm 18 SC
+//|HBlank set    |HCounter changes |HCounter changes | //cycles between HBlank set in status register and HSYNC
+//|              |from 0x125 to    |from 0x165 to    | //asserted in H32 mode, and 21 SC cycles in H40 mode.
+//|              |0x126 in [1].    |0x166 in [1].    | //Note this actually means in H40 mode, HBlank is set at 0x166.5.
+//|--------------------------------------------------| //Logic analyzer tests conducted on 2012-11-03 confirm 46 SC
+//|HBlank cleared|HCounter changes |HCounter changes | //cycles between HSYNC cleared and HBlank cleared in status
+//|              |from 0x009 to    |from 0x00A to    | //register in H32 mode, and 61 SC cycles in H40 mode.
+//|              |0x00A in [1].    |0x00B in [1].    | //Note this actually means in H40 mode, HBlank is cleared at 0x00B.5.
+//|--------------------------------------------------|
+//|F flag set    |HCounter changes |HCounter changes | //Logic analyzer tests conducted on 2012-11-03 confirm 28 SC
+//|              |from 0x000 to    |from 0x000 to    | //cycles between HSYNC cleared and f flag set in status
+//|              |0x001 in [1]     |0x001 in [1]     | //register in H32 mode, and 40 SC cycles in H40 mode.
+//|--------------------------------------------------|
+//|ODD flag      |HCounter changes |HCounter changes | //Logic analyzer tests conducted on 2012-11-03 confirm 30 SC
+//|toggled       |from 0x001 to    |from 0x001 to    | //cycles between HSYNC cleared and odd flag toggled in status
+//|              |0x002 in [1]     |0x002 in [1]     | //register in H32 mode, and 42 SC cycles in H40 mode.
+//|--------------------------------------------------|
+//|HINT flagged  |HCounter changes |HCounter changes | //Logic analyzer tests conducted on 2012-11-02 confirm 74 SC
+//|via IPL lines |from 0x109 to    |from 0x149 to    | //cycles between HINT flagged in IPL lines and HSYNC
+//|              |0x10A in [1].    |0x14A in [1].    | //asserted in H32 mode, and 78 SC cycles in H40 mode.
+//|--------------------------------------------------|
+//|VINT flagged  |HCounter changes |HCounter changes | //Logic analyzer tests conducted on 2012-11-02 confirm 28 SC
+//|via IPL lines |from 0x000 to    |from 0x000 to    | //cycles between HSYNC cleared and VINT flagged in IPL lines
+//|              |0x001 in [1].    |0x001 in [1].    | //in H32 mode, and 40 SC cycles in H40 mode.
+//|--------------------------------------------------|
+//|HSYNC asserted|HCounter changes |HCounter changes |
+//|              |from 0x1D8 to    |from 0x1CC to    |
+//|              |0x1D9 in [2].    |0x1CD in [2].    |
+//|--------------------------------------------------|
+//|HSYNC negated |HCounter changes |HCounter changes |
+//|              |from 0x1F2 to    |from 0x1EC to    |
+//|              |0x1F3 in [2].    |0x1ED in [2].    |
+//----------------------------------------------------
+//##TODO##
+//-There are 40 SC cycles from HSYNC negated to INT asserted in H40 mode
+//-There are 28 SC cycles from HSYNC negated to INT asserted in H32 mode
+//-There are 91 SC cycles from INT negated to HSYNC asserted in H40 mode
+//-There are 87 SC cycles from INT negated to HSYNC asserted in H32 mode
+//##TODO## Hardware tests confirm that the INT line remains asserted, even after the Z80
+//runs an interrupt acknowledge cycle.
+const HVCounterTiming::HScanSettings HVCounterTiming::h32ScanSettingsStatic(0x127, 0x1D2, 0x10A, 0x126, 0x00A, 0x001, 0x002, 0x1FF, 0x001, 0x1D9, 0x1F3, 0x018, 0x117, 256, 0x00B, 0x017, 13, 0x118, 0x125, 14, 0x1F3, 0x00A, 24, 0x126, 0x1D8, 9, 0);
+const HVCounterTiming::HScanSettings HVCounterTiming::h40ScanSettingsStatic(0x16C, 0x1C9, 0x14A, 0x166, 0x00B, 0x001, 0x002, 0x1FF, 0x001, 0x1CD, 0x1ED, 0x01A, 0x159, 320, 0x00D, 0x019, 13, 0x15A, 0x167, 14, 0x1ED, 0x00C, 32, 0x168, 0x1CC, 9, 1);
+
+//----------------------------------------------------------------------------------------
+//Vertical scan timing settings
+//----------------------------------------------------------------------------------------
+//Analog screen sections in relation to VCounter:
+//-------------------------------------------------------------------------------------------
+//|           Video |NTSC             |NTSC             |PAL              |PAL              |
+//|            Mode |H32/H40(RSx00/11)|H32/H40(RSx00/11)|H32/H40(RSx00/11)|H32/H40(RSx00/11)|
+//|                 |V28     (M2=0)   |V30     (M2=1)   |V28     (M2=0)   |V30     (M2=1)   |
+//|                 |Int none(LSMx=*0)|Int none(LSMx=*0)|Int none(LSMx=*0)|Int none(LSMx=*0)|
+//|                 |------------------------------------------------------------------------
+//|                 | VCounter  |Line | VCounter  |Line | VCounter  |Line | VCounter  |Line |
+//| Screen section  |  value    |count|  value    |count|  value    |count|  value    |count|
+//|-----------------|-----------|-----|-----------|-----|-----------|-----|-----------|-----|
+//|Active display   |0x000-0x0DF| 224 |0x000-0x1FF| 240*|0x000-0x0DF| 224 |0x000-0x0EF| 240 |
+//|-----------------|-----------|-----|-----------|-----|-----------|-----|-----------|-----|
+//|Bottom border    |0x0E0-0x0E7|   8 |           |   0 |0x0E0-0x0FF|  32 |0x0F0-0x107|  24 |
+//|-----------------|-----------|-----|-----------|-----|-----------|-----|-----------|-----|
+//|Bottom blanking  |0x0E8-0x0EA|   3 |           |   0 |0x100-0x102|   3 |0x108-0x10A|   3 |
+//|-----------------|-----------|-----|-----------|-----|-----------|-----|-----------|-----|
+//|Vertical sync    |0x1E5-0x1E7|   3 |           |   0 |0x1CA-0x1CC|   3 |0x1D2-0x1D4|   3 |
+//|-----------------|-----------|-----|-----------|-----|-----------|-----|-----------|-----|
+//|Top blanking     |0x1E8-0x1F4|  13 |           |   0 |0x1CD-0x1D9|  13 |0x1D5-0x1E1|  13 |
+//|-----------------|-----------|-----|-----------|-----|-----------|-----|-----------|-----|
+//|Top border       |0x1F5-0x1FF|  11 |           |   0 |0x1DA-0x1FF|  38 |0x1E2-0x1FF|  30 |
+//|-----------------|-----------|-----|-----------|-----|-----------|-----|-----------|-----|
+//|TOTALS           |           | 262 |           | 240*|           | 313 |           | 313 |
+//-------------------------------------------------------------------------------------------
+//*When V30 mode and NTSC mode are both active, no border, blanking, or retrace occurs. A
+//30-row display is setup and rendered, however, immediately following the end of the 30th
+//row, the 1st row starts again. In addition, the VCounter is never reset, which usually
+//happens at the beginning of vertical blanking. Instead, the VCounter continuously counts
+//from 0x000-0x1FF, then wraps around back to 0x000 and begins again. Since there are only
+//240 lines output as part of the display, this means the actual line being rendered is
+//desynchronized from the VCounter. Digital events such as vblank flags being set/cleared,
+//VInt being triggered, the odd flag being toggled, and so forth, still occur at the
+//correct VCounter positions they would occur in (IE, the same as PAL mode V30), however,
+//since the VCounter has 512 lines per cycle, this means VInt is triggered at a slower
+//rate than normal.
+//##TODO## Confirm on the hardware that the rendering row is desynchronized from the
+//VCounter. This would seem unlikely, since a separate render line counter would have to
+//be maintained apart from VCounter for this to occur.
+
+//Digital render events in relation to VCounter under NTSC mode:
+//#ODD - Runs only when the ODD flag is set
+//----------------------------------------------------------------------------------------
+//|        Video |NTSC             |NTSC             |NTSC             |NTSC             |
+//|         Mode |H32/H40(RSx00/11)|H32/H40(RSx00/11)|H32/H40(RSx00/11)|H32/H40(RSx00/11)|
+//|              |V28     (M2=0)   |V28     (M2=0)   |V30     (M2=1)   |V30     (M2=1)   |
+//| Event        |Int none(LSMx=*0)|Int both(LSMx=*1)|Int none(LSMx=*0)|Int both(LSMx=*1)|
+//|--------------------------------------------------------------------------------------|
+//|VCounter      |[1]0x000-0x0EA   |[1]0x000-0x0EA   |[1]0x000-0x1FF   |[1]0x000-0x1FF   |
+//|progression   |[2]0x1E5-0x1FF   |[2]0x1E4(#ODD)   |                 |                 |
+//|9-bit internal|                 |[3]0x1E5-0x1FF   |                 |                 |
+//|--------------------------------------------------------------------------------------|
+//|VBlank set    |VCounter changes |                 |VCounter changes |                 |
+//|              |from 0x0DF to    |     <Same>      |from 0x0EF to    |     <Same>      |
+//|              |0x0E0 in [1].    |                 |0x0F0 in [1].    |                 |
+//|--------------------------------------------------------------------------------------|
+//|VBlank cleared|VCounter changes |                 |VCounter changes |                 |
+//|              |from 0x1FE to    |     <Same>      |from 0x1FE to    |     <Same>      |
+//|              |0x1FF in [2].    |                 |0x1FF in [1].    |                 |
+//|--------------------------------------------------------------------------------------|
+//|F flag set    |At indicated     |                 |At indicated     |                 |
+//|              |HCounter position|                 |HCounter position|                 |
+//|              |while VCounter is|     <Same>      |while VCounter is|     <Same>      |
+//|              |set to 0x0E0 in  |                 |set to 0x0F0 in  |                 |
+//|              |[1].             |                 |[1].             |                 |
+//|--------------------------------------------------------------------------------------|
+//|VSYNC asserted|VCounter changes |                 |      Never      |                 |
+//|              |from 0x0E7 to    |     <Same>      |                 |     <Same>      |
+//|              |0x0E8 in [1].    |                 |                 |                 |
+//|--------------------------------------------------------------------------------------|
+//|VSYNC cleared |VCounter changes |                 |      Never      |                 |
+//|              |from 0x1F4 to    |     <Same>      |                 |     <Same>      |
+//|              |0x1F5 in [2].    |                 |                 |                 |
+//|--------------------------------------------------------------------------------------|
+//|ODD flag      |At indicated     |                 |At indicated     |                 |
+//|toggled       |HCounter position|                 |HCounter position|                 |
+//|              |while VCounter is|     <Same>      |while VCounter is|     <Same>      |
+//|              |set to 0x0E0 in  |                 |set to 0x0F0 in  |                 |
+//|              |[1].             |                 |[1].             |                 |
+//----------------------------------------------------------------------------------------
+
+//Digital render events in relation to VCounter under PAL mode:
+//#ODD - Runs only when the ODD flag is set
+//----------------------------------------------------------------------------------------
+//|        Video |PAL              |PAL              |PAL              |PAL              |
+//|         Mode |H32/H40(RSx00/11)|H32/H40(RSx00/11)|H32/H40(RSx00/11)|H32/H40(RSx00/11)|
+//|              |V28     (M2=0)   |V28     (M2=0)   |V30     (M2=1)   |V30     (M2=1)   |
+//| Event        |Int none(LSMx=*0)|Int both(LSMx=*1)|Int none(LSMx=*0)|Int both(LSMx=*1)|
+//|--------------------------------------------------------------------------------------|
+//|VCounter      |[1]0x000-0x102   |[1]0x000-0x101   |[1]0x000-0x10A   |[1]0x000-0x109   |
+//|progression   |[2]0x1CA-0x1FF   |[2]0x1C9(#ODD)   |[2]0x1D2-0x1FF   |[2]0x1D1(#ODD)   |
+//|9-bit internal|                 |[3]0x1CA-0x1FF   |                 |[3]0x1D2-0x1FF   |
+//|--------------------------------------------------------------------------------------|
+//|VBlank set    |VCounter changes |                 |VCounter changes |                 |
+//|              |from 0x0DF to    |     <Same>      |from 0x0EF to    |     <Same>      |
+//|              |0x0E0 in [1].    |                 |0x0F0 in [1].    |                 |
+//|--------------------------------------------------------------------------------------|
+//|VBlank cleared|VCounter changes |                 |VCounter changes |                 |
+//|              |from 0x1FE to    |     <Same>      |from 0x1FE to    |     <Same>      |
+//|              |0x1FF in [2].    |                 |0x1FF in [2].    |                 |
+//|--------------------------------------------------------------------------------------|
+//|F flag set    |At indicated     |                 |At indicated     |                 |
+//|              |HCounter position|                 |HCounter position|                 |
+//|              |while VCounter is|     <Same>      |while VCounter is|     <Same>      |
+//|              |set to 0x0E0 in  |                 |set to 0x0F0 in  |                 |
+//|              |[1].             |                 |[1].             |                 |
+//|--------------------------------------------------------------------------------------|
+//|VSYNC asserted|VCounter changes |                 |VCounter changes |                 |
+//|              |from 0x0FF to    |     <Same>      |from 0x107 to    |     <Same>      |
+//|              |0x100 in [1].    |                 |0x108 in [1].    |                 |
+//|--------------------------------------------------------------------------------------|
+//|VSYNC cleared |VCounter changes |                 |VCounter changes |                 |
+//|              |from 0x1D9 to    |     <Same>      |from 0x1E1 to    |     <Same>      |
+//|              |0x1DA in [2].    |                 |0x1E2 in [2].    |                 |
+//|--------------------------------------------------------------------------------------|
+//|ODD flag      |At indicated     |                 |At indicated     |                 |
+//|toggled       |HCounter position|                 |HCounter position|                 |
+//|              |while VCounter is|     <Same>      |while VCounter is|     <Same>      |
+//|              |set to 0x0E0 in  |                 |set to 0x0F0 in  |                 |
+//|              |[1].             |                 |[1].             |                 |
+//----------------------------------------------------------------------------------------
+//##TODO## Evaluate the way we're using the first parameter vcounterActiveScanMaxValue in
+//code. Note that we subtract 1 from this value for the interlace values in PAL mode, but
+//we use the same values for both interlace and non-interlace modes in NTSC. Confirm if
+//this is correct.
+const HVCounterTiming::VScanSettings HVCounterTiming::v28PalNoIntScanSettingsStatic (0x102, 0x1CA, 0x1C9, 0x0E0, 0x1FF, 0x1FF, 0x100, 0x1DA, 313, 0x000, 0x0DF, 224, 0x1DA, 0x1FF, 38, 0x0E0, 0x0FF, 32, 0x1CD, 0x1D9, 13, 0x100, 0x102, 3, 0);
+const HVCounterTiming::VScanSettings HVCounterTiming::v28PalIntEnScanSettingsStatic (0x101, 0x1CA, 0x1C9, 0x0E0, 0x1FF, 0x1FF, 0x100, 0x1DA, 313, 0x000, 0x0DF, 224, 0x1DA, 0x1FF, 38, 0x0E0, 0x0FF, 32, 0x1CD, 0x1D9, 13, 0x100, 0x102, 3, 1);
+const HVCounterTiming::VScanSettings HVCounterTiming::v30PalNoIntScanSettingsStatic (0x10A, 0x1D2, 0x1D1, 0x0F0, 0x1FF, 0x1FF, 0x108, 0x1E2, 313, 0x000, 0x0EF, 240, 0x1E2, 0x1FF, 30, 0x0F0, 0x107, 24, 0x1D5, 0x1E1, 13, 0x108, 0x10A, 3, 2);
+const HVCounterTiming::VScanSettings HVCounterTiming::v30PalIntEnScanSettingsStatic (0x109, 0x1D2, 0x1D1, 0x0F0, 0x1FF, 0x1FF, 0x108, 0x1E2, 313, 0x000, 0x0EF, 240, 0x1E2, 0x1FF, 30, 0x0F0, 0x107, 24, 0x1D5, 0x1E1, 13, 0x108, 0x10A, 3, 3);
+const HVCounterTiming::VScanSettings HVCounterTiming::v28NtscNoIntScanSettingsStatic(0x0EA, 0x1E5, 0x1E4, 0x0E0, 0x1FF, 0x1FF, 0x0E8, 0x1F5, 262, 0x000, 0x0DF, 224, 0x1F5, 0x1FF, 11, 0x0E0, 0x0E7,  8, 0x1E8, 0x1F4, 13, 0x0E8, 0x0EA, 3, 4);
+const HVCounterTiming::VScanSettings HVCounterTiming::v28NtscIntEnScanSettingsStatic(0x0EA, 0x1E5, 0x1E4, 0x0E0, 0x1FF, 0x1FF, 0x0E8, 0x1F5, 262, 0x000, 0x0DF, 224, 0x1F5, 0x1FF, 11, 0x0E0, 0x0E7,  8, 0x1E8, 0x1F4, 13, 0x0E8, 0x0EA, 3, 5);
+const HVCounterTiming::VScanSettings HVCounterTiming::v30NtscNoIntScanSettingsStatic(0x1FF, 0x200, 0x200, 0x0F0, 0x1FF, 0x1FF, 0x1FF, 0x1FF, 262, 0x000, 0x0EF, 240, 0x200, 0x200,  0, 0x200, 0x200,  0, 0x000, 0x000,  0, 0x000, 0x000, 0, 6);
+const HVCounterTiming::VScanSettings HVCounterTiming::v30NtscIntEnScanSettingsStatic(0x1FF, 0x200, 0x200, 0x0F0, 0x1FF, 0x1FF, 0x1FF, 0x1FF, 262, 0x000, 0x0EF, 240, 0x200, 0x200,  0, 0x200, 0x200,  0, 0x000, 0x000,  0, 0x000, 0x000, 0, 7);
+
+//----------------------------------------------------------------------------------------
+//Frame tables
+//----------------------------------------------------------------------------------------
+std::once_flag HVCounterTiming::frameTableBuilt[hscanSettingsCount][vscanSettingsCount][2];
+std::unique_ptr<HVCounterTiming::FrameTable> HVCounterTiming::frameTables[hscanSettingsCount][vscanSettingsCount][2];
+
+//----------------------------------------------------------------------------------------
+//HV counter internal/linear conversion
+//----------------------------------------------------------------------------------------
+//These conversions sit underneath every HV counter calculation made by the core, so
+//they're performed using lookup tables which are built for each screen mode when the
+//scan settings are constructed. The tables are generated from the calculated versions
+//of these functions below, which remain the reference implementation. Values outside
+//the range of the tables fall back to the calculated form.
+//----------------------------------------------------------------------------------------
+unsigned int HVCounterTiming::HCounterValueFromVDPInternalToLinear(const HScanSettings& hscanSettings, unsigned int hcounterCurrent)
+{
+	return (hcounterCurrent < HScanSettings::counterLookupTableSize)? hscanSettings.hcounterInternalToLinear[hcounterCurrent]: HCounterValueFromVDPInternalToLinearCalculated(hscanSettings, hcounterCurrent);
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int HVCounterTiming::VCounterValueFromVDPInternalToLinear(const VScanSettings& vscanSettings, unsigned int vcounterCurrent, bool oddFlagSet)
+{
+	return (vcounterCurrent < VScanSettings::counterLookupTableSize)? vscanSettings.vcounterInternalToLinear[oddFlagSet? 1: 0][vcounterCurrent]: VCounterValueFromVDPInternalToLinearCalculated(vscanSettings, vcounterCurrent, oddFlagSet);
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int HVCounterTiming::HCounterValueFromLinearToVDPInternal(const HScanSettings& hscanSettings, unsigned int hcounterCurrent)
+{
+	return (hcounterCurrent < HScanSettings::counterLookupTableSize)? hscanSettings.hcounterLinearToInternal[hcounterCurrent]: HCounterValueFromLinearToVDPInternalCalculated(hscanSettings, hcounterCurrent);
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int HVCounterTiming::VCounterValueFromLinearToVDPInternal(const VScanSettings& vscanSettings, unsigned int vcounterCurrent, bool oddFlagSet)
+{
+	return (vcounterCurrent < VScanSettings::counterLookupTableSize)? vscanSettings.vcounterLinearToInternal[oddFlagSet? 1: 0][vcounterCurrent]: VCounterValueFromLinearToVDPInternalCalculated(vscanSettings, vcounterCurrent, oddFlagSet);
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int HVCounterTiming::HCounterValueFromVDPInternalToLinearCalculated(const HScanSettings& hscanSettings, unsigned int hcounterCurrent)
+{
+	return (hcounterCurrent >= hscanSettings.hcounterBlankingInitialValue)? hscanSettings.hcounterActiveScanMaxValue + ((hcounterCurrent - hscanSettings.hcounterBlankingInitialValue) + 1): hcounterCurrent;
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int HVCounterTiming::VCounterValueFromVDPInternalToLinearCalculated(const VScanSettings& vscanSettings, unsigned int vcounterCurrent, bool oddFlagSet)
+{
+	unsigned int blankingInitialValue = oddFlagSet? vscanSettings.vcounterBlankingInitialValueOddFlag: vscanSettings.vcounterBlankingInitialValue;
+	return (vcounterCurrent >= blankingInitialValue)? vscanSettings.vcounterActiveScanMaxValue + ((vcounterCurrent - blankingInitialValue) + 1): vcounterCurrent;
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int HVCounterTiming::HCounterValueFromLinearToVDPInternalCalculated(const HScanSettings& hscanSettings, unsigned int hcounterCurrent)
+{
+	return (hcounterCurrent > hscanSettings.hcounterActiveScanMaxValue)? ((hcounterCurrent - hscanSettings.hcounterActiveScanMaxValue) - 1) + hscanSettings.hcounterBlankingInitialValue: hcounterCurrent;
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int HVCounterTiming::VCounterValueFromLinearToVDPInternalCalculated(const VScanSettings& vscanSettings, unsigned int vcounterCurrent, bool oddFlagSet)
+{
+	unsigned int blankingInitialValue = oddFlagSet? vscanSettings.vcounterBlankingInitialValueOddFlag: vscanSettings.vcounterBlankingInitialValue;
+	return (vcounterCurrent > vscanSettings.vcounterActiveScanMaxValue)? ((vcounterCurrent - vscanSettings.vcounterActiveScanMaxValue) - 1) + blankingInitialValue: vcounterCurrent;
+}
+
+//----------------------------------------------------------------------------------------
+//Video scan settings functions
+//----------------------------------------------------------------------------------------
+const HVCounterTiming::HScanSettings& HVCounterTiming::GetHScanSettings(bool screenModeRS0Active, bool screenModeRS1Active)
+{
+	//Select the scan settings which correspond with the current screen mode
+	return (screenModeRS1Active)? h40ScanSettingsStatic: h32ScanSettingsStatic;
+}
+
+//----------------------------------------------------------------------------------------
+const HVCounterTiming::VScanSettings& HVCounterTiming::GetVScanSettings(bool screenModeV30Active, bool palModeActive, bool interlaceActive)
+{
+	//Select the scan settings which correspond with the current screen mode
+	if(palModeActive)
+	{
+		if(screenModeV30Active)
+		{
+			return (interlaceActive)? v30PalIntEnScanSettingsStatic: v30PalNoIntScanSettingsStatic;
+		}
+		else
+		{
+			return (interlaceActive)? v28PalIntEnScanSettingsStatic: v28PalNoIntScanSettingsStatic;
+		}
+	}
+	else
+	{
+		if(screenModeV30Active)
+		{
+			return (interlaceActive)? v30NtscIntEnScanSettingsStatic: v30NtscNoIntScanSettingsStatic;
+		}
+		else
+		{
+			return (interlaceActive)? v28NtscIntEnScanSettingsStatic: v28NtscNoIntScanSettingsStatic;
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Frame table functions
+//----------------------------------------------------------------------------------------
+//The frame tables map each position within a field to the HV counter values at that
+//point, and back again, for one combination of scan settings. Each table is built the
+//first time its combination is used, by stepping the counters one pixel clock step at a
+//time through each field using AdvanceHVCountersOneStep, so lookups give the same
+//results as stepping the counters manually. A table takes around 1MB.
+//----------------------------------------------------------------------------------------
+const HVCounterTiming::FrameTable& HVCounterTiming::GetFrameTable(const HScanSettings& hscanSettings, const VScanSettings& vscanSettings, bool interlaceIsEnabled)
+{
+	unsigned int interlaceIndex = interlaceIsEnabled? 1: 0;
+	std::unique_ptr<FrameTable>& frameTable = frameTables[hscanSettings.frameTableIndex][vscanSettings.frameTableIndex][interlaceIndex];
+	std::call_once(frameTableBuilt[hscanSettings.frameTableIndex][vscanSettings.frameTableIndex][interlaceIndex], [&]()
+	{
+		frameTable.reset(new FrameTable());
+		BuildFrameTable(hscanSettings, vscanSettings, interlaceIsEnabled, *frameTable);
+	});
+	return *frameTable;
+}
+
+//----------------------------------------------------------------------------------------
+void HVCounterTiming::BuildFrameTable(const HScanSettings& hscanSettings, const VScanSettings& vscanSettings, bool interlaceIsEnabled, FrameTable& frameTable)
+{
+	//Clear the HV counter to position tables, so that counter values which never occur
+	//in this screen mode are flagged as invalid.
+	for(unsigned int i = 0; i < HScanSettings::counterLookupTableSize; ++i)
+	{
+		frameTable.hcounterToLineOffset[i] = invalidFramePosition;
+		frameTable.vcounterToLineNo[0][i] = invalidFramePosition;
+		frameTable.vcounterToLineNo[1][i] = invalidFramePosition;
+	}
+
+	//Record the offset of each hcounter value from the start of the line
+	frameTable.hcounterStepsPerLine = hscanSettings.hcounterStepsPerIteration;
+	unsigned int hcounter = hscanSettings.vcounterIncrementPoint;
+	for(unsigned int lineOffset = 0; lineOffset < frameTable.hcounterStepsPerLine; ++lineOffset)
+	{
+		frameTable.hcounterToLineOffset[hcounter] = lineOffset;
+		hcounter = AddStepsToHCounter(hscanSettings, hcounter, 1);
+	}
+	frameTable.oddFlagToggleLineOffset = frameTable.hcounterToLineOffset[hscanSettings.oddFlagTogglePoint];
+
+	//Step through the field which follows each state of the odd flag, from the point
+	//where the odd flag is toggled until we return to it, recording the counter values at
+	//each step, and the line each vcounter value appears on. Note that the vcounter value
+	//of line 0 appears again at the end of the field, up to the toggle point.
+	for(unsigned int fieldNo = 0; fieldNo < 2; ++fieldNo)
+	{
+		bool oddFlagSet = (fieldNo != 0);
+		unsigned int vcounter = vscanSettings.vblankSetPoint;
+		unsigned int lineNo = 0;
+		hcounter = hscanSettings.oddFlagTogglePoint;
+		frameTable.vcounterToLineNo[fieldNo][vcounter] = lineNo;
+		std::vector<unsigned int>& positionToHVCounter = frameTable.positionToHVCounter[fieldNo];
+		positionToHVCounter.reserve((vscanSettings.vcounterStepsPerIterationOddFlag + 1) * frameTable.hcounterStepsPerLine);
+		do
+		{
+			positionToHVCounter.push_back(hcounter | (vcounter << 16));
+			AdvanceHVCountersOneStep(hscanSettings, hcounter, vscanSettings, interlaceIsEnabled, oddFlagSet, vcounter);
+			if(hcounter == hscanSettings.vcounterIncrementPoint)
+			{
+				++lineNo;
+				if(frameTable.vcounterToLineNo[fieldNo][vcounter] == invalidFramePosition)
+				{
+					frameTable.vcounterToLineNo[fieldNo][vcounter] = lineNo;
+				}
+			}
+		}
+		while((hcounter != hscanSettings.oddFlagTogglePoint) || (vcounter != vscanSettings.vblankSetPoint));
+		frameTable.fieldPixelClockSteps[fieldNo] = (unsigned int)positionToHVCounter.size();
+	}
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int HVCounterTiming::GetFramePosition(const FrameTable& frameTable, unsigned int hcounterCurrent, unsigned int vcounterCurrent, bool oddFlagSet)
+{
+	//Look up the line offset of the hcounter value and the line number of the vcounter
+	//value, and return an invalid position if either value doesn't occur in this field.
+	unsigned int fieldNo = oddFlagSet? 1: 0;
+	if((hcounterCurrent >= HScanSettings::counterLookupTableSize) || (vcounterCurrent >= VScanSettings::counterLookupTableSize))
+	{
+		return invalidFramePosition;
+	}
+	unsigned int lineOffset = frameTable.hcounterToLineOffset[hcounterCurrent];
+	unsigned int lineNo = frameTable.vcounterToLineNo[fieldNo][vcounterCurrent];
+	if((lineOffset == invalidFramePosition) || (lineNo == invalidFramePosition))
+	{
+		return invalidFramePosition;
+	}
+
+	//Calculate the position relative to the odd flag toggle point. Positions on line 0
+	//which come before the toggle point are the last positions in the field.
+	unsigned int position = (lineNo * frameTable.hcounterStepsPerLine) + lineOffset;
+	return (position >= frameTable.oddFlagToggleLineOffset)? position - frameTable.oddFlagToggleLineOffset: (position + frameTable.fieldPixelClockSteps[fieldNo]) - frameTable.oddFlagToggleLineOffset;
+}
+
+//----------------------------------------------------------------------------------------
+//HV counter comparison functions
+//----------------------------------------------------------------------------------------
+//##TODO## Refactor this to make it more readable
+bool HVCounterTiming::EventOccursWithinCounterRange(const HScanSettings& hscanSettings, unsigned int hcounterStart, unsigned int vcounterStart, unsigned int hcounterEnd, unsigned int vcounterEnd, unsigned int hcounterEventPos, unsigned int vcounterEventPos)
+{
+	return (((vcounterStart < vcounterEventPos)
+	      || ((vcounterStart == vcounterEventPos)
+	       && (((hcounterStart < hscanSettings.vcounterIncrementPoint)
+	         && (hcounterEventPos < hscanSettings.vcounterIncrementPoint)
+	         && (hcounterStart <= hcounterEventPos))
+	        || ((hcounterStart >= hscanSettings.vcounterIncrementPoint)
+	         && (hcounterEventPos >= hscanSettings.vcounterIncrementPoint)
+	         && (hcounterStart <= hcounterEventPos))
+	        || ((hcounterStart >= hscanSettings.vcounterIncrementPoint)
+	         && (hcounterEventPos < hscanSettings.vcounterIncrementPoint)
+	        )))) //The target event occurs at or after the start position
+	     && ((vcounterEnd > vcounterEventPos)
+	      || ((vcounterEnd == vcounterEventPos)
+	       && (((hcounterEnd < hscanSettings.vcounterIncrementPoint)
+	         && (hcounterEventPos < hscanSettings.vcounterIncrementPoint))
+	         && (hcounterEnd >= hcounterEventPos)
+	        || ((hcounterEnd >= hscanSettings.vcounterIncrementPoint)
+	         && (hcounterEventPos >= hscanSettings.vcounterIncrementPoint))
+	         && (hcounterEnd >= hcounterEventPos)
+	        || ((hcounterEventPos >= hscanSettings.vcounterIncrementPoint)
+	         && (hcounterEnd < hscanSettings.vcounterIncrementPoint)
+	       ))))); //The target event occurs at or after the end position
+}
+
+//----------------------------------------------------------------------------------------
+//This function finds the next position at which the target counter values occur using
+//the frame table for the current screen mode. Since the position of each vcounter value
+//can differ between fields, we search up to two fields ahead, to cover target values
+//which only occur in the field which follows the next odd flag toggle point. If the
+//current or target counter values can't be found, we fall back to the calculated form of
+//this function.
+//----------------------------------------------------------------------------------------
+unsigned int HVCounterTiming::GetPixelClockStepsBetweenHVCounterValues(bool advanceIfValuesMatch, const HScanSettings& hscanSettings, unsigned int hcounterCurrent, unsigned int hcounterTarget, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool oddFlagSet, unsigned int vcounterCurrent, unsigned int vcounterTarget)
+{
+	//Find the position of the current counter values within the current field
+	const FrameTable& frameTable = GetFrameTable(hscanSettings, vscanSettings, interlaceIsEnabled);
+	unsigned int position = GetFramePosition(frameTable, hcounterCurrent, vcounterCurrent, oddFlagSet);
+	if(position != invalidFramePosition)
+	{
+		//If the target counter values occur later in the current field, return the number
+		//of steps to reach them. Note that if the target values match the current values,
+		//and we've been asked to advance in this case, we search for the next time they
+		//occur instead.
+		unsigned int targetPosition = GetFramePosition(frameTable, hcounterTarget, vcounterTarget, oddFlagSet);
+		if((targetPosition != invalidFramePosition) && ((targetPosition > position) || ((targetPosition == position) && !advanceIfValuesMatch)))
+		{
+			return targetPosition - position;
+		}
+
+		//Search the following fields for the target counter values
+		unsigned int totalPixelClockSteps = frameTable.fieldPixelClockSteps[oddFlagSet? 1: 0] - position;
+		bool fieldOddFlagSet = oddFlagSet;
+		for(unsigned int i = 0; i < 2; ++i)
+		{
+			fieldOddFlagSet = interlaceIsEnabled & !fieldOddFlagSet;
+			targetPosition = GetFramePosition(frameTable, hcounterTarget, vcounterTarget, fieldOddFlagSet);
+			if(targetPosition != invalidFramePosition)
+			{
+				return totalPixelClockSteps + targetPosition;
+			}
+			totalPixelClockSteps += frameTable.fieldPixelClockSteps[fieldOddFlagSet? 1: 0];
+		}
+	}
+	return GetPixelClockStepsBetweenHVCounterValuesCalculated(advanceIfValuesMatch, hscanSettings, hcounterCurrent, hcounterTarget, vscanSettings, interlaceIsEnabled, oddFlagSet, vcounterCurrent, vcounterTarget);
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int HVCounterTiming::GetPixelClockStepsBetweenHVCounterValuesCalculated(bool advanceIfValuesMatch, const HScanSettings& hscanSettings, unsigned int hcounterCurrent, unsigned int hcounterTarget, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool oddFlagSet, unsigned int vcounterCurrent, unsigned int vcounterTarget)
+{
+	unsigned int totalPixelClockSteps = 0;
+
+	//If we've been requested to still advance the counters if they match, and they are
+	//the same value right now, shortcut the rest of the process, and calculate the number
+	//of pixel clock steps required to return to the current horizontal and vertical
+	//counter values.
+	if(advanceIfValuesMatch && (hcounterCurrent == hcounterTarget) && (vcounterCurrent == vcounterTarget))
+	{
+		AdvanceHVCountersOneStep(hscanSettings, hcounterCurrent, vscanSettings, interlaceIsEnabled, oddFlagSet, vcounterCurrent);
+		totalPixelClockSteps = GetPixelClockStepsBetweenHVCounterValuesCalculated(false, hscanSettings, hcounterCurrent, hcounterTarget, vscanSettings, interlaceIsEnabled, oddFlagSet, vcounterCurrent, vcounterTarget);
+		++totalPixelClockSteps;
+		return totalPixelClockSteps;
+	}
+
+	//Check if the hcounter is going to pass the vcounter increment point when advancing
+	//it from its current position to the target position
+	if(((hcounterCurrent < hcounterTarget) && (hcounterCurrent < hscanSettings.vcounterIncrementPoint) && (hcounterTarget >= hscanSettings.vcounterIncrementPoint))
+	|| ((hcounterCurrent > hcounterTarget) && ((hcounterCurrent < hscanSettings.vcounterIncrementPoint) || (hcounterTarget >= hscanSettings.vcounterIncrementPoint))))
+	{
+		//If the hcounter advancement is going to increment the vcounter, advance the
+		//hcounter up to the vcounter increment point, and increment the vcounter.
+		totalPixelClockSteps += GetPixelClockStepsBetweenHCounterValues(hscanSettings, hcounterCurrent, hscanSettings.vcounterIncrementPoint);
+		hcounterCurrent = hscanSettings.vcounterIncrementPoint;
+		vcounterCurrent = AddStepsToVCounter(hscanSettings, hcounterCurrent, vscanSettings, interlaceIsEnabled, oddFlagSet, vcounterCurrent, 1);
+	}
+
+	//Calculate the total number of steps required to advance the vcounter to its final
+	//position
+	if(vcounterCurrent != vcounterTarget)
+	{
+		//##FIX## This function first advances the hcounter to the vcounter increment point,
+		//then leaves it there and advances the vcounter.
+		totalPixelClockSteps += GetPixelClockStepsBetweenVCounterValues(hscanSettings, hcounterCurrent, vscanSettings, interlaceIsEnabled, oddFlagSet, vcounterCurrent, vcounterTarget);
+		hcounterCurrent = hscanSettings.vcounterIncrementPoint;
+	}
+
+	//Calculate the total number of steps required to advance the hcounter to its final
+	//position
+	totalPixelClockSteps += GetPixelClockStepsBetweenHCounterValues(hscanSettings, hcounterCurrent, hcounterTarget);
+
+	return totalPixelClockSteps;
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int HVCounterTiming::GetPixelClockStepsBetweenHCounterValues(const HScanSettings& hscanSettings, unsigned int hcounterCurrent, unsigned int hcounterTarget)
+{
+	//Convert the internal hcounter values into linear values
+	hcounterCurrent = HCounterValueFromVDPInternalToLinear(hscanSettings, hcounterCurrent);
+	hcounterTarget = HCounterValueFromVDPInternalToLinear(hscanSettings, hcounterTarget);
+
+	//Calculate the number of pixel clock steps required to advance the current hcounter
+	//to the target value.
+	return (hcounterTarget >= hcounterCurrent)? hcounterTarget - hcounterCurrent: (hscanSettings.hcounterStepsPerIteration - hcounterCurrent) + hcounterTarget;
+}
+
+//----------------------------------------------------------------------------------------
+//##TODO## What happens if the target vcounter is the extra line in an odd interlace frame?
+unsigned int HVCounterTiming::GetPixelClockStepsBetweenVCounterValues(const HScanSettings& hscanSettings, unsigned int hcounterCurrent, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool oddFlagSet, unsigned int vcounterCurrent, unsigned int vcounterTarget)
+{
+	unsigned int totalPixelClockSteps = 0;
+	if(vcounterCurrent != vcounterTarget)
+	{
+		bool hcounterAdvancedToIncrementPoint = false;
+		if(hcounterCurrent != hscanSettings.vcounterIncrementPoint)
+		{
+			//Add the number of pixel clock steps required to advance the hcounter to the
+			//point where the vcounter is incremented.
+			totalPixelClockSteps += GetPixelClockStepsBetweenHCounterValues(hscanSettings, hcounterCurrent, hscanSettings.vcounterIncrementPoint);
+			hcounterAdvancedToIncrementPoint = true;
+		}
+
+		//Convert the internal vcounter values into linear values
+		vcounterCurrent = VCounterValueFromVDPInternalToLinear(vscanSettings, vcounterCurrent, oddFlagSet);
+		vcounterTarget = VCounterValueFromVDPInternalToLinear(vscanSettings, vcounterTarget, oddFlagSet);
+
+		//If the current horizontal and vertical counters haven't yet passed the point
+		//where the odd flag is toggled, and the target vcounter value is passed that
+		//point, update the value of the odd flag.
+		if(((vcounterCurrent < vscanSettings.vblankSetPoint) || ((vcounterCurrent == vscanSettings.vblankSetPoint) && (hcounterCurrent < hscanSettings.oddFlagTogglePoint))) && (vcounterTarget > vscanSettings.vblankSetPoint))
+		{
+			oddFlagSet = interlaceIsEnabled && !oddFlagSet;
+		}
+
+		//Calculate the number of vcounter increment steps required to reach the target
+		//vcounter value.
+		unsigned int vcounterStepsPerIteration = oddFlagSet? vscanSettings.vcounterStepsPerIterationOddFlag: vscanSettings.vcounterStepsPerIteration;
+		unsigned int totalVCounterStepsBetweenValues = ((vcounterTarget + vcounterStepsPerIteration) - vcounterCurrent) % vcounterStepsPerIteration;
+
+		if(hcounterAdvancedToIncrementPoint)
+		{
+			//Subtract 1 from the total number of vcounter increment steps, since we know we
+			//will already have advanced one vcounter step by advancing the hcounter to the
+			//vcounter increment point, which we did above. Note that it is safe to subtract
+			//here because we know the current and target vcounter values are different, since
+			//we've already filtered for that above.
+			totalVCounterStepsBetweenValues -= 1;
+		}
+
+		//Add the number of pixel clock steps required to advance the required number of
+		//vcounter steps.
+		totalPixelClockSteps += totalVCounterStepsBetweenValues * hscanSettings.hcounterStepsPerIteration;
+	}
+	return totalPixelClockSteps;
+}
+
+//----------------------------------------------------------------------------------------
+//HV counter advancement functions
+//----------------------------------------------------------------------------------------
+unsigned int HVCounterTiming::AddStepsToHCounter(const HScanSettings& hscanSettings, unsigned int hcounterCurrent, unsigned int hcounterStepsToAdd)
+{
+	//Convert the internal hcounter value into a linear value
+	hcounterCurrent = HCounterValueFromVDPInternalToLinear(hscanSettings, hcounterCurrent);
+
+	//Calculate the initial value for the target hcounter value
+	unsigned int hcounterTarget = hcounterCurrent + hcounterStepsToAdd;
+
+	//Wrap the hcounter value back around to the start if we've passed the total number of
+	//steps per iteration.
+	hcounterTarget %= hscanSettings.hcounterStepsPerIteration;
+
+	//Convert the linear hcounter value back into an internal value
+	hcounterTarget = HCounterValueFromLinearToVDPInternal(hscanSettings, hcounterTarget);
+
+	//Return the incremented hcounter
+	return hcounterTarget;
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int HVCounterTiming::AddStepsToVCounter(const HScanSettings& hscanSettings, unsigned int hcounterCurrent, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool oddFlagSet, unsigned int vcounterCurrent, unsigned int vcounterStepsToAdd)
+{
+	//Convert the internal vcounter value into a linear value
+	vcounterCurrent = VCounterValueFromVDPInternalToLinear(vscanSettings, vcounterCurrent, oddFlagSet);
+
+	//Calculate the initial value for the target vcounter value
+	unsigned int vcounterTarget = vcounterCurrent + vcounterStepsToAdd;
+
+	//If the current horizontal and vertical counters haven't yet passed the point
+	//where the odd flag is toggled, and the target vcounter value is passed that
+	//point, update the value of the odd flag.
+	if(((vcounterCurrent < vscanSettings.vblankSetPoint) || ((vcounterCurrent == vscanSettings.vblankSetPoint) && (hcounterCurrent < hscanSettings.oddFlagTogglePoint))) && (vcounterTarget > vscanSettings.vblankSetPoint))
+	{
+		oddFlagSet = interlaceIsEnabled && !oddFlagSet;
+	}
+
+	//Wrap the vcounter value back around to the start if we've passed the total number of
+	//steps per iteration.
+	unsigned int vcounterStepsPerIteration = oddFlagSet? vscanSettings.vcounterStepsPerIterationOddFlag: vscanSettings.vcounterStepsPerIteration;
+	vcounterTarget %= vcounterStepsPerIteration;
+
+	//Convert the linear vcounter value back into an internal value
+	vcounterTarget = VCounterValueFromLinearToVDPInternal(vscanSettings, vcounterTarget, oddFlagSet);
+
+	//Return the incremented vcounter
+	return vcounterTarget;
+}
+
+//----------------------------------------------------------------------------------------
+//This function advances the counters using the frame table for the current screen mode.
+//Where the current counter values don't occur in the current field, which can happen
+//briefly after a screen mode change, we fall back to the calculated form of this
+//function.
+//----------------------------------------------------------------------------------------
+void HVCounterTiming::AdvanceHVCounters(const HScanSettings& hscanSettings, unsigned int& hcounterCurrent, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool& oddFlagSet, unsigned int& vcounterCurrent, unsigned int pixelClockSteps)
+{
+	//Find the position of the current counter values within the current field
+	const FrameTable& frameTable = GetFrameTable(hscanSettings, vscanSettings, interlaceIsEnabled);
+	unsigned int position = GetFramePosition(frameTable, hcounterCurrent, vcounterCurrent, oddFlagSet);
+	if(position == invalidFramePosition)
+	{
+		AdvanceHVCountersCalculated(hscanSettings, hcounterCurrent, vscanSettings, interlaceIsEnabled, oddFlagSet, vcounterCurrent, pixelClockSteps);
+		return;
+	}
+
+	//While there's enough steps remaining to reach the end of the field, advance to the
+	//odd flag toggle point which begins the next field, and update the odd flag.
+	unsigned int fieldNo = oddFlagSet? 1: 0;
+	while(pixelClockSteps >= (frameTable.fieldPixelClockSteps[fieldNo] - position))
+	{
+		pixelClockSteps -= (frameTable.fieldPixelClockSteps[fieldNo] - position);
+		position = 0;
+		oddFlagSet = interlaceIsEnabled & !oddFlagSet;
+		fieldNo = oddFlagSet? 1: 0;
+	}
+
+	//Look up the counter values at the final position
+	unsigned int hvcounter = frameTable.positionToHVCounter[fieldNo][position + pixelClockSteps];
+	hcounterCurrent = hvcounter & 0xFFFF;
+	vcounterCurrent = hvcounter >> 16;
+}
+
+//----------------------------------------------------------------------------------------
+void HVCounterTiming::AdvanceHVCountersCalculated(const HScanSettings& hscanSettings, unsigned int& hcounterCurrent, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool& oddFlagSet, unsigned int& vcounterCurrent, unsigned int pixelClockSteps)
+{
+	//Convert the internal hcounter and vcounter values into linear values
+	hcounterCurrent = HCounterValueFromVDPInternalToLinear(hscanSettings, hcounterCurrent);
+	vcounterCurrent = VCounterValueFromVDPInternalToLinear(vscanSettings, vcounterCurrent, oddFlagSet);
+
+	//Calculate the number of times the hcounter needs to be incremented in order to reach
+	//the odd flag toggle point.
+	unsigned int hcounterIncrementStepsUntilOddFlagToggle;
+	if(hcounterCurrent < hscanSettings.oddFlagTogglePoint)
+	{
+		hcounterIncrementStepsUntilOddFlagToggle = hscanSettings.oddFlagTogglePoint - hcounterCurrent;
+	}
+	else
+	{
+		hcounterIncrementStepsUntilOddFlagToggle = (hscanSettings.hcounterStepsPerIteration - hcounterCurrent) + hscanSettings.oddFlagTogglePoint;
+	}
+
+	//Calculate the number of times the vcounter needs to be incremented in order to reach
+	//the odd flag toggle point.
+	unsigned int vcounterStepsPerIteration = oddFlagSet? vscanSettings.vcounterStepsPerIterationOddFlag: vscanSettings.vcounterStepsPerIteration;
+	unsigned int vcounterIncrementStepsUntilOddFlagToggle;
+	if((vcounterCurrent < vscanSettings.vblankSetPoint) || ((vcounterCurrent == vscanSettings.vblankSetPoint) && (hcounterCurrent < hscanSettings.oddFlagTogglePoint)))
+	{
+		vcounterIncrementStepsUntilOddFlagToggle = vscanSettings.vblankSetPoint - vcounterCurrent;
+	}
+	else
+	{
+		vcounterIncrementStepsUntilOddFlagToggle = (vcounterStepsPerIteration - vcounterCurrent) + vscanSettings.vblankSetPoint;
+	}
+
+	//Calculate the actual number of manual vcounter increment steps that need to be made
+	//in order to advance to the odd flag toggle point. If we're going to pass the
+	//vcounter increment point when advancing the hcounter to the odd flag toggle point,
+	//the manual vcounter increment step count is one less than the actual number of
+	//vcounter increment steps that need to occur. We only need to use this value when
+	//calculating the number of pixel clock steps required to reach the target counter
+	//value.
+	unsigned int vcounterManualIncrementStepsUntilOddFlagToggle = vcounterIncrementStepsUntilOddFlagToggle;
+	if((hcounterCurrent >= hscanSettings.oddFlagTogglePoint) && (hcounterCurrent < hscanSettings.vcounterIncrementPoint))
+	{
+		vcounterManualIncrementStepsUntilOddFlagToggle = (vcounterIncrementStepsUntilOddFlagToggle > 0)? vcounterIncrementStepsUntilOddFlagToggle - 1: vcounterStepsPerIteration - 1;
+	}
+
+	//Calculate the number of pixel clock steps until the odd flag needs to be toggled
+	unsigned int pixelClockStepsUntilOddFlagToggle = (vcounterManualIncrementStepsUntilOddFlagToggle * hscanSettings.hcounterStepsPerIteration) + hcounterIncrementStepsUntilOddFlagToggle;
+
+	//While there's enough cycles remaining to reach the odd flag toggle point, advance to
+	//that point, and update the odd flag.
+	while(pixelClockStepsUntilOddFlagToggle <= pixelClockSteps)
+	{
+		//Advance the hcounter and vcounter to the odd flag toggle point
+		hcounterCurrent += hcounterIncrementStepsUntilOddFlagToggle;
+		hcounterCurrent -= (hcounterCurrent < hscanSettings.hcounterStepsPerIteration)? 0: hscanSettings.hcounterStepsPerIteration;
+		vcounterCurrent += vcounterIncrementStepsUntilOddFlagToggle;
+		vcounterCurrent -= (vcounterCurrent < vcounterStepsPerIteration)? 0: vcounterStepsPerIteration;
+
+		//Update the odd flag, now that we've reached the toggle point.
+		oddFlagSet = interlaceIsEnabled & !oddFlagSet;
+
+		//Update the remaining pixel clock steps to advance
+		pixelClockSteps -= pixelClockStepsUntilOddFlagToggle;
+
+		//Recalculate the number of vcounter steps per iteration, to take into account the
+		//updated odd flag setting.
+		vcounterStepsPerIteration = oddFlagSet? vscanSettings.vcounterStepsPerIterationOddFlag: vscanSettings.vcounterStepsPerIteration;
+
+		//Calculate the time to the next odd flag toggle point
+		pixelClockStepsUntilOddFlagToggle = vcounterStepsPerIteration * hscanSettings.hcounterStepsPerIteration;
+	}
+
+	//Calculate the number of times the hcounter needs to be incremented in order to reach
+	//the vcounter increment point.
+	unsigned int hcounterIncrementStepsUntilVCounterIncrement;
+	if(hcounterCurrent < hscanSettings.vcounterIncrementPoint)
+	{
+		hcounterIncrementStepsUntilVCounterIncrement = hscanSettings.vcounterIncrementPoint - hcounterCurrent;
+	}
+	else
+	{
+		hcounterIncrementStepsUntilVCounterIncrement = (hscanSettings.hcounterStepsPerIteration - hcounterCurrent) + hscanSettings.vcounterIncrementPoint;
+	}
+
+	//Advance the hcounter and vcounter to their final positions
+	hcounterCurrent = (hcounterCurrent + pixelClockSteps) % hscanSettings.hcounterStepsPerIteration;
+	if(hcounterIncrementStepsUntilVCounterIncrement <= pixelClockSteps)
+	{
+		unsigned int vcounterIncrementSteps = ((pixelClockSteps - hcounterIncrementStepsUntilVCounterIncrement) / hscanSettings.hcounterStepsPerIteration) + 1;
+		vcounterCurrent = (vcounterCurrent + vcounterIncrementSteps) % vcounterStepsPerIteration;
+	}
+
+	//Convert the final hcounter and vcounter values from linear values back to internal
+	//values, and return them to the caller.
+	hcounterCurrent = HCounterValueFromLinearToVDPInternal(hscanSettings, hcounterCurrent);
+	vcounterCurrent = VCounterValueFromLinearToVDPInternal(vscanSettings, vcounterCurrent, oddFlagSet);
+}
+
+//----------------------------------------------------------------------------------------
+void HVCounterTiming::AdvanceHVCountersOneStep(const HScanSettings& hscanSettings, unsigned int& hcounterCurrent, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool& oddFlagSet, unsigned int& vcounterCurrent)
+{
+	//Advance the hcounter by one step
+	if(hcounterCurrent == hscanSettings.hcounterActiveScanMaxValue)
+	{
+		hcounterCurrent = hscanSettings.hcounterBlankingInitialValue;
+	}
+	else if(hcounterCurrent == hscanSettings.hcounterMaxValue)
+	{
+		hcounterCurrent = 0;
+	}
+	else
+	{
+		++hcounterCurrent;
+	}
+
+	//Perform any adjustments required based on the new hcounter position
+	if(hcounterCurrent == hscanSettings.vcounterIncrementPoint)
+	{
+		//Advance the vcounter by one step. Note that we have an unusual check here for
+		//vcounterBlankingInitialValue being less than vcounterMaxValue. This is only here
+		//right now to support our unusual handling of a H32 V30 display in NTSC, where
+		//there is no vertical blanking period.
+		if((vcounterCurrent == vscanSettings.vcounterActiveScanMaxValue) && (vscanSettings.vcounterBlankingInitialValue < vscanSettings.vcounterMaxValue))
+		{
+			vcounterCurrent = oddFlagSet? vscanSettings.vcounterBlankingInitialValueOddFlag: vscanSettings.vcounterBlankingInitialValue;
+		}
+		else if(vcounterCurrent == vscanSettings.vcounterMaxValue)
+		{
+			vcounterCurrent = 0;
+		}
+		else
+		{
+			++vcounterCurrent;
+		}
+	}
+	else if((vcounterCurrent == vscanSettings.vblankSetPoint) && (hcounterCurrent == hscanSettings.oddFlagTogglePoint))
+	{
+		//Update the odd flag, now that we've reached the toggle point.
+		oddFlagSet = interlaceIsEnabled & !oddFlagSet;
+	}
+}
@@ -0,0 +1,80 @@
+#ifndef __HVCOUNTERTIMING_H__
+#define __HVCOUNTERTIMING_H__
+#include <vector>
+#include <memory>
+#include <mutex>
+
+class HVCounterTiming
+{
+public:
+	//Structures
+	struct HScanSettings;
+	struct VScanSettings;
+	struct FrameTable;
+
+	//Constants
+	static const unsigned int hscanSettingsCount = 2;
+	static const unsigned int vscanSettingsCount = 8;
+	static const unsigned int invalidFramePosition = 0xFFFFFFFF;
+
+public:
+	//HV counter internal/linear conversion
+	static unsigned int HCounterValueFromVDPInternalToLinear(const HScanSettings& hscanSettings, unsigned int hcounterCurrent);
+	static unsigned int VCounterValueFromVDPInternalToLinear(const VScanSettings& vscanSettings, unsigned int vcounterCurrent, bool oddFlagSet);
+	static unsigned int HCounterValueFromLinearToVDPInternal(const HScanSettings& hscanSettings, unsigned int hcounterCurrent);
+	static unsigned int VCounterValueFromLinearToVDPInternal(const VScanSettings& vscanSettings, unsigned int vcounterCurrent, bool oddFlagSet);
+	static unsigned int HCounterValueFromVDPInternalToLinearCalculated(const HScanSettings& hscanSettings, unsigned int hcounterCurrent);
+	static unsigned int VCounterValueFromVDPInternalToLinearCalculated(const VScanSettings& vscanSettings, unsigned int vcounterCurrent, bool oddFlagSet);
+	static unsigned int HCounterValueFromLinearToVDPInternalCalculated(const HScanSettings& hscanSettings, unsigned int hcounterCurrent);
+	static unsigned int VCounterValueFromLinearToVDPInternalCalculated(const VScanSettings& vscanSettings, unsigned int vcounterCurrent, bool oddFlagSet);
+
+	//Video scan settings functions
+	//##TODO## Consider removing the RS0 parameter here. We only need the RS1 bit.
+	static const HScanSettings& GetHScanSettings(bool screenModeRS0Active, bool screenModeRS1Active);
+	static const VScanSettings& GetVScanSettings(bool screenModeV30Active, bool palModeActive, bool interlaceActive);
+
+	//Frame table functions
+	static const FrameTable& GetFrameTable(const HScanSettings& hscanSettings, const VScanSettings& vscanSettings, bool interlaceIsEnabled);
+	static unsigned int GetFramePosition(const FrameTable& frameTable, unsigned int hcounterCurrent, unsigned int vcounterCurrent, bool oddFlagSet);
+
+	//HV counter comparison functions
+	static bool EventOccursWithinCounterRange(const HScanSettings& hscanSettings, unsigned int hcounterStart, unsigned int vcounterStart, unsigned int hcounterEnd, unsigned int vcounterEnd, unsigned int hcounterEventPos, unsigned int vcounterEventPos);
+	static unsigned int GetPixelClockStepsBetweenHVCounterValues(bool advanceIfValuesMatch, const HScanSettings& hscanSettings, unsigned int hcounterCurrent, unsigned int hcounterTarget, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool oddFlagSet, unsigned int vcounterCurrent, unsigned int vcounterTarget);
+	static unsigned int GetPixelClockStepsBetweenHVCounterValuesCalculated(bool advanceIfValuesMatch, const HScanSettings& hscanSettings, unsigned int hcounterCurrent, unsigned int hcounterTarget, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool oddFlagSet, unsigned int vcounterCurrent, unsigned int vcounterTarget);
+	static unsigned int GetPixelClockStepsBetweenHCounterValues(const HScanSettings& hscanSettings, unsigned int hcounterCurrent, unsigned int hcounterTarget);
+	static unsigned int GetPixelClockStepsBetweenVCounterValues(const HScanSettings& hscanSettings, unsigned int hcounterCurrent, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool oddFlagSet, unsigned int vcounterCurrent, unsigned int vcounterTarget);
+
+	//HV counter advancement functions
+	static unsigned int AddStepsToHCounter(const HScanSettings& hscanSettings, unsigned int hcounterCurrent, unsigned int hcounterStepsToAdd);
+	static unsigned int AddStepsToVCounter(const HScanSettings& hscanSettings, unsigned int hcounterCurrent, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool oddFlagSet, unsigned int vcounterCurrent, unsigned int vcounterStepsToAdd);
+	static void AdvanceHVCounters(const HScanSettings& hscanSettings, unsigned int& hcounterCurrent, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool& oddFlagSet, unsigned int& vcounterCurrent, unsigned int pixelClockSteps);
+	static void AdvanceHVCountersCalculated(const HScanSettings& hscanSettings, unsigned int& hcounterCurrent, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool& oddFlagSet, unsigned int& vcounterCurrent, unsigned int pixelClockSteps);
+	static void AdvanceHVCountersOneStep(const HScanSettings& hscanSettings, unsigned int& hcounterCurrent, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool& oddFlagSet, unsigned int& vcounterCurrent);
+
+public:
+	//Horizontal scan timing settings
+	static const HScanSettings h32ScanSettingsStatic;
+	static const HScanSettings h40ScanSettingsStatic;
+
+	//Vertical scan timing settings
+	static const VScanSettings v28PalNoIntScanSettingsStatic;
+	static const VScanSettings v28PalIntEnScanSettingsStatic;
+	static const VScanSettings v30PalNoIntScanSettingsStatic;
+	static const VScanSettings v30PalIntEnScanSettingsStatic;
+	static const VScanSettings v28NtscNoIntScanSettingsStatic;
+	static const VScanSettings v28NtscIntEnScanSettingsStatic;
+	static const VScanSettings v30NtscNoIntScanSettingsStatic;
+	static const VScanSettings v30NtscIntEnScanSettingsStatic;
+
+private:
+	//Frame table functions
+	static void BuildFrameTable(const HScanSettings& hscanSettings, const VScanSettings& vscanSettings, bool interlaceIsEnabled, FrameTable& frameTable);
+
+private:
+	//Frame tables
+	static std::once_flag frameTableBuilt[hscanSettingsCount][vscanSettingsCount][2];
+	static std::unique_ptr<FrameTable> frameTables[hscanSettingsCount][vscanSettingsCount][2];
+};
+
+#include "HVCounterTiming.inl"
+#endif
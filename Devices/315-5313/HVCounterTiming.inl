@@ -0,0 +1,229 @@
+//----------------------------------------------------------------------------------------
+//Structures
+//----------------------------------------------------------------------------------------
+struct HVCounterTiming::HScanSettings
+{
+	HScanSettings(unsigned int ahcounterActiveScanMaxValue,
+	              unsigned int ahcounterBlankingInitialValue,
+	              unsigned int avcounterIncrementPoint,
+	              unsigned int ahblankSetPoint,
+	              unsigned int ahblankClearedPoint,
+	              unsigned int afflagSetPoint,
+	              unsigned int aoddFlagTogglePoint,
+	              unsigned int ahcounterMaxValue,
+	              unsigned int avintFlagged,
+	              unsigned int ahsyncAsserted,
+	              unsigned int ahsyncNegated,
+	              unsigned int aactiveDisplayHCounterFirstValue,
+	              unsigned int aactiveDisplayHCounterLastValue,
+	              unsigned int aactiveDisplayPixelCount,
+	              unsigned int aleftBorderHCounterFirstValue,
+	              unsigned int aleftBorderHCounterLastValue,
+	              unsigned int aleftBorderPixelCount,
+	              unsigned int arightBorderHCounterFirstValue,
+	              unsigned int arightBorderHCounterLastValue,
+	              unsigned int arightBorderPixelCount,
+	              unsigned int aleftBlankingHCounterFirstValue,
+	              unsigned int aleftBlankingHCounterLastValue,
+	              unsigned int aleftBlankingPixelCount,
+	              unsigned int arightBlankingHCounterFirstValue,
+	              unsigned int arightBlankingHCounterLastValue,
+	              unsigned int arightBlankingPixelCount,
+	              unsigned int aframeTableIndex)
+	:hcounterActiveScanMaxValue(ahcounterActiveScanMaxValue),
+	 hcounterBlankingInitialValue(ahcounterBlankingInitialValue),
+	 vcounterIncrementPoint(avcounterIncrementPoint),
+	 hblankSetPoint(ahblankSetPoint),
+	 hblankClearedPoint(ahblankClearedPoint),
+	 fflagSetPoint(afflagSetPoint),
+	 oddFlagTogglePoint(aoddFlagTogglePoint),
+	 hcounterMaxValue(ahcounterMaxValue),
+	 vintFlagged(avintFlagged),
+	 hsyncAsserted(ahsyncAsserted),
+	 hsyncNegated(ahsyncNegated),
+	 activeDisplayHCounterFirstValue(aactiveDisplayHCounterFirstValue),
+	 activeDisplayHCounterLastValue(aactiveDisplayHCounterLastValue),
+	 activeDisplayPixelCount(aactiveDisplayPixelCount),
+	 leftBorderHCounterFirstValue(aleftBorderHCounterFirstValue),
+	 leftBorderHCounterLastValue(aleftBorderHCounterLastValue),
+	 leftBorderPixelCount(aleftBorderPixelCount),
+	 rightBorderHCounterFirstValue(arightBorderHCounterFirstValue),
+	 rightBorderHCounterLastValue(arightBorderHCounterLastValue),
+	 rightBorderPixelCount(arightBorderPixelCount),
+	 leftBlankingHCounterFirstValue(aleftBlankingHCounterFirstValue),
+	 leftBlankingHCounterLastValue(aleftBlankingHCounterLastValue),
+	 leftBlankingPixelCount(aleftBlankingPixelCount),
+	 rightBlankingHCounterFirstValue(arightBlankingHCounterFirstValue),
+	 rightBlankingHCounterLastValue(arightBlankingHCounterLastValue),
+	 rightBlankingPixelCount(arightBlankingPixelCount),
+	 hcounterStepsPerIteration(ahcounterActiveScanMaxValue + 1 + ((ahcounterMaxValue + 1) - ahcounterBlankingInitialValue)),
+	 frameTableIndex(aframeTableIndex)
+	{
+		//Build the lookup tables for converting between internal and linear hcounter
+		//values in this screen mode
+		for(unsigned int i = 0; i < counterLookupTableSize; ++i)
+		{
+			hcounterInternalToLinear[i] = HVCounterTiming::HCounterValueFromVDPInternalToLinearCalculated(*this, i);
+			hcounterLinearToInternal[i] = HVCounterTiming::HCounterValueFromLinearToVDPInternalCalculated(*this, i);
+		}
+	}
+
+	static const unsigned int counterLookupTableSize = 0x200;
+
+	unsigned int hcounterActiveScanMaxValue;
+	unsigned int hcounterBlankingInitialValue;
+	unsigned int vcounterIncrementPoint;
+	unsigned int hblankSetPoint;
+	unsigned int hblankClearedPoint;
+	unsigned int fflagSetPoint;
+	unsigned int oddFlagTogglePoint;
+	unsigned int hcounterMaxValue;
+	unsigned int hcounterStepsPerIteration;
+	unsigned int hintTriggerPoint;
+	unsigned int vintFlagged;
+	unsigned int hsyncAsserted;
+	unsigned int hsyncNegated;
+
+	unsigned int activeDisplayPixelCount;
+	unsigned int leftBorderPixelCount;
+	unsigned int rightBorderPixelCount;
+	unsigned int leftBlankingPixelCount;
+	unsigned int rightBlankingPixelCount;
+	unsigned int activeDisplayHCounterFirstValue;
+	unsigned int activeDisplayHCounterLastValue;
+	unsigned int leftBorderHCounterFirstValue;
+	unsigned int leftBorderHCounterLastValue;
+	unsigned int rightBorderHCounterFirstValue;
+	unsigned int rightBorderHCounterLastValue;
+	unsigned int leftBlankingHCounterFirstValue;
+	unsigned int leftBlankingHCounterLastValue;
+	unsigned int rightBlankingHCounterFirstValue;
+	unsigned int rightBlankingHCounterLastValue;
+	unsigned int frameTableIndex;
+
+	unsigned int hcounterInternalToLinear[counterLookupTableSize];
+	unsigned int hcounterLinearToInternal[counterLookupTableSize];
+};
+
+//----------------------------------------------------------------------------------------
+struct HVCounterTiming::VScanSettings
+{
+	VScanSettings(unsigned int avcounterActiveScanMaxValue,
+	              unsigned int avcounterBlankingInitialValue,
+	              unsigned int avcounterBlankingInitialValueOddFlag,
+	              unsigned int avblankSetPoint,
+	              unsigned int avblankClearedPoint,
+	              unsigned int avcounterMaxValue,
+	              unsigned int avsyncAssertedPoint,
+	              unsigned int avsyncClearedPoint,
+	              unsigned int alinesPerFrame,
+	              unsigned int aactiveDisplayVCounterFirstValue,
+	              unsigned int aactiveDisplayVCounterLastValue,
+	              unsigned int aactiveDisplayLineCount,
+	              unsigned int atopBorderVCounterFirstValue,
+	              unsigned int atopBorderVCounterLastValue,
+	              unsigned int atopBorderLineCount,
+	              unsigned int abottomBorderVCounterFirstValue,
+	              unsigned int abottomBorderVCounterLastValue,
+	              unsigned int abottomBorderLineCount,
+	              unsigned int atopBlankingVCounterFirstValue,
+	              unsigned int atopBlankingVCounterLastValue,
+	              unsigned int atopBlankingLineCount,
+	              unsigned int abottomBlankingVCounterFirstValue,
+	              unsigned int abottomBlankingVCounterLastValue,
+	              unsigned int abottomBlankingLineCount,
+	              unsigned int aframeTableIndex)
+	:vcounterActiveScanMaxValue(avcounterActiveScanMaxValue),
+	 vcounterBlankingInitialValue(avcounterBlankingInitialValue),
+	 vcounterBlankingInitialValueOddFlag(avcounterBlankingInitialValueOddFlag),
+	 vblankSetPoint(avblankSetPoint),
+	 vblankClearedPoint(avblankClearedPoint),
+	 vcounterMaxValue(avcounterMaxValue),
+	 vsyncAssertedPoint(avsyncAssertedPoint),
+	 vsyncClearedPoint(avsyncClearedPoint),
+	 linesPerFrame(alinesPerFrame),
+	 activeDisplayVCounterFirstValue(aactiveDisplayVCounterFirstValue),
+	 activeDisplayVCounterLastValue(aactiveDisplayVCounterLastValue),
+	 activeDisplayLineCount(aactiveDisplayLineCount),
+	 topBorderVCounterFirstValue(atopBorderVCounterFirstValue),
+	 topBorderVCounterLastValue(atopBorderVCounterLastValue),
+	 topBorderLineCount(atopBorderLineCount),
+	 bottomBorderVCounterFirstValue(abottomBorderVCounterFirstValue),
+	 bottomBorderVCounterLastValue(abottomBorderVCounterLastValue),
+	 bottomBorderLineCount(abottomBorderLineCount),
+	 topBlankingVCounterFirstValue(atopBlankingVCounterFirstValue),
+	 topBlankingVCounterLastValue(atopBlankingVCounterLastValue),
+	 topBlankingLineCount(atopBlankingLineCount),
+	 bottomBlankingVCounterFirstValue(abottomBlankingVCounterFirstValue),
+	 bottomBlankingVCounterLastValue(abottomBlankingVCounterLastValue),
+	 bottomBlankingLineCount(abottomBlankingLineCount),
+	 vcounterStepsPerIteration(avcounterActiveScanMaxValue + 1 + ((avcounterMaxValue + 1) - avcounterBlankingInitialValue)),
+	 vcounterStepsPerIterationOddFlag(avcounterActiveScanMaxValue + 1 + ((avcounterMaxValue + 1) - avcounterBlankingInitialValueOddFlag)),
+	 frameTableIndex(aframeTableIndex)
+	{
+		//Build the lookup tables for converting between internal and linear vcounter
+		//values in this screen mode, for both states of the odd flag.
+		for(unsigned int i = 0; i < counterLookupTableSize; ++i)
+		{
+			vcounterInternalToLinear[0][i] = HVCounterTiming::VCounterValueFromVDPInternalToLinearCalculated(*this, i, false);
+			vcounterInternalToLinear[1][i] = HVCounterTiming::VCounterValueFromVDPInternalToLinearCalculated(*this, i, true);
+			vcounterLinearToInternal[0][i] = HVCounterTiming::VCounterValueFromLinearToVDPInternalCalculated(*this, i, false);
+			vcounterLinearToInternal[1][i] = HVCounterTiming::VCounterValueFromLinearToVDPInternalCalculated(*this, i, true);
+		}
+	}
+
+	static const unsigned int counterLookupTableSize = 0x200;
+
+	unsigned int vcounterActiveScanMaxValue;
+	unsigned int vcounterBlankingInitialValue;
+	unsigned int vcounterBlankingInitialValueOddFlag;
+	unsigned int vblankSetPoint;
+	unsigned int vblankClearedPoint;
+	unsigned int vcounterMaxValue;
+	unsigned int vcounterStepsPerIteration;
+	unsigned int vcounterStepsPerIterationOddFlag;
+	unsigned int vsyncAssertedPoint;
+	unsigned int vsyncClearedPoint;
+	unsigned int linesPerFrame;
+
+	unsigned int activeDisplayVCounterFirstValue;
+	unsigned int activeDisplayVCounterLastValue;
+	unsigned int activeDisplayLineCount;
+	unsigned int topBorderVCounterFirstValue;
+	unsigned int topBorderVCounterLastValue;
+	unsigned int topBorderLineCount;
+	unsigned int bottomBorderVCounterFirstValue;
+	unsigned int bottomBorderVCounterLastValue;
+	unsigned int bottomBorderLineCount;
+	unsigned int topBlankingLineCount;
+	unsigned int topBlankingVCounterFirstValue;
+	unsigned int topBlankingVCounterLastValue;
+	unsigned int bottomBlankingLineCount;
+	unsigned int bottomBlankingVCounterFirstValue;
+	unsigned int bottomBlankingVCounterLastValue;
+	unsigned int frameTableIndex;
+
+	unsigned int vcounterInternalToLinear[2][counterLookupTableSize];
+	unsigned int vcounterLinearToInternal[2][counterLookupTableSize];
+};
+
+//----------------------------------------------------------------------------------------
+struct HVCounterTiming::FrameTable
+{
+	//Position to HV counter mapping. Positions are measured in pixel clock steps from the
+	//point where the odd flag is toggled, with a separate field for each state the odd
+	//flag is set to at that point. Entries hold the internal hcounter value in the lower
+	//16 bits, and the internal vcounter value in the upper 16 bits.
+	unsigned int fieldPixelClockSteps[2];
+	std::vector<unsigned int> positionToHVCounter[2];
+
+	//HV counter to position mapping. A position is made up of the line which holds the
+	//vcounter value and the offset of the hcounter value within that line, so we hold a
+	//table for each half here rather than a table for every HV counter pair. Lines begin
+	//at the vcounter increment point, with line 0 being the line the odd flag is toggled
+	//in.
+	unsigned int hcounterStepsPerLine;
+	unsigned int oddFlagToggleLineOffset;
+	unsigned int hcounterToLineOffset[HScanSettings::counterLookupTableSize];
+	unsigned int vcounterToLineNo[2][VScanSettings::counterLookupTableSize];
+};
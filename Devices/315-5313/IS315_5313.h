@@ -38,7 +38,7 @@ public:
 
 public:
 	//Interface version functions
-	static inline unsigned int ThisIS315_5313Version() { return 1; }
+	static inline unsigned int ThisIS315_5313Version() { return 4; }
 	virtual unsigned int GetIS315_5313Version() const = 0;
 
 	//Device access functions
@@ -56,11 +56,11 @@ public:
 	virtual unsigned int GetImageLastRenderedFrameToken() const = 0;
 	virtual unsigned int GetImageCompletedBufferPlaneNo() const = 0;
 	virtual unsigned int GetImageDrawingBufferPlaneNo() const = 0;
-	virtual void LockImageBufferData(unsigned int planeNo) = 0;
-	virtual void UnlockImageBufferData(unsigned int planeNo) = 0;
+	virtual unsigned int AcquireCompletedImageBufferPlane(unsigned int& frameToken) const = 0;
+	virtual void ReleaseImageBufferPlane(unsigned int planeNo) const = 0;
 	virtual const unsigned char* GetImageBufferData(unsigned int planeNo) const = 0;
-	virtual const ImageBufferInfo* GetImageBufferInfo(unsigned int planeNo) const = 0;
-	virtual const ImageBufferInfo* GetImageBufferInfo(unsigned int planeNo, unsigned int lineNo, unsigned int pixelNo) const = 0;
+	virtual void RequestImageBufferInfo(unsigned int posX, unsigned int posY, unsigned int width, unsigned int height) = 0;
+	virtual bool GetImageBufferInfo(unsigned int planeNo, unsigned int lineNo, unsigned int pixelNo, ImageBufferInfo& pixelInfo) const = 0;
 	virtual bool GetImageBufferOddInterlaceFrame(unsigned int planeNo) const = 0;
 	virtual unsigned int GetImageBufferLineCount(unsigned int planeNo) const = 0;
 	virtual unsigned int GetImageBufferLineWidth(unsigned int planeNo, unsigned int lineNo) const = 0;
@@ -121,6 +121,10 @@ public:
 	inline void SetVideoShowStatusBar(bool adata);
 	inline bool GetVideoEnableLineSmoothing() const;
 	inline void SetVideoEnableLineSmoothing(bool adata);
+	inline unsigned int GetVideoFrameSkip() const;
+	inline void SetVideoFrameSkip(unsigned int adata);
+	inline bool GetVideoFrameSkipAuto() const;
+	inline void SetVideoFrameSkipAuto(bool adata);
 	inline bool GetCurrentRenderPosOnScreen() const;
 	inline void SetCurrentRenderPosOnScreen(bool adata);
 	inline unsigned int GetCurrentRenderPosScreenX() const;
@@ -127,6 +127,8 @@ enum class IS315_5313::IS315_5313DataSource
 	SettingsVideoFixedAspectRatio,
 	SettingsVideoShowStatusBar,
 	SettingsVideoEnableLineSmoothing,
+	SettingsVideoFrameSkip,
+	SettingsVideoFrameSkipAuto,
 	SettingsCurrentRenderPosOnScreen,
 	SettingsCurrentRenderPosScreenX,
 	SettingsCurrentRenderPosScreenY,
@@ -457,6 +459,36 @@ void IS315_5313::SetVideoEnableLineSmoothing(bool adata)
 	WriteGenericData((unsigned int)IS315_5313DataSource::SettingsVideoEnableLineSmoothing, 0, data);
 }
 
+//----------------------------------------------------------------------------------------
+unsigned int IS315_5313::GetVideoFrameSkip() const
+{
+	GenericAccessDataValueUInt data;
+	ReadGenericData((unsigned int)IS315_5313DataSource::SettingsVideoFrameSkip, 0, data);
+	return data.GetValue();
+}
+
+//----------------------------------------------------------------------------------------
+void IS315_5313::SetVideoFrameSkip(unsigned int adata)
+{
+	GenericAccessDataValueUInt data(adata);
+	WriteGenericData((unsigned int)IS315_5313DataSource::SettingsVideoFrameSkip, 0, data);
+}
+
+//----------------------------------------------------------------------------------------
+bool IS315_5313::GetVideoFrameSkipAuto() const
+{
+	GenericAccessDataValueBool data;
+	ReadGenericData((unsigned int)IS315_5313DataSource::SettingsVideoFrameSkipAuto, 0, data);
+	return data.GetValue();
+}
+
+//----------------------------------------------------------------------------------------
+void IS315_5313::SetVideoFrameSkipAuto(bool adata)
+{
+	GenericAccessDataValueBool data(adata);
+	WriteGenericData((unsigned int)IS315_5313DataSource::SettingsVideoFrameSkipAuto, 0, data);
+}
+
 //----------------------------------------------------------------------------------------
 bool IS315_5313::GetCurrentRenderPosOnScreen() const
 {
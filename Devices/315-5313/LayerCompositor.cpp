@@ -0,0 +1,507 @@
+#include "LayerCompositor.h"
+#include "WindowsSupport/WindowsSupport.pkg"
+#include <emmintrin.h>
+#include <immintrin.h>
+
+//----------------------------------------------------------------------------------------
+//Layer priority functions
+//----------------------------------------------------------------------------------------
+void LayerCompositor::BuildLayerPriorityLookupTable(std::vector<unsigned int>& layerPriorityLookupTable)
+{
+	layerPriorityLookupTable.resize(lookupTableSize);
+	for(unsigned int i = 0; i < lookupTableSize; ++i)
+	{
+		//Determine the input layer settings for this table index value
+		bool shadowHighlightEnabled = (i & (1 << 8)) != 0;
+		bool spriteIsShadowOperator = (i & (1 << 7)) != 0;
+		bool spriteIsHighlightOperator = (i & (1 << 6)) != 0;
+		bool foundSpritePixel = (i & (1 << 5)) != 0;
+		bool foundLayerAPixel = (i & (1 << 4)) != 0;
+		bool foundLayerBPixel = (i & (1 << 3)) != 0;
+		bool prioritySprite = (i & (1 << 2)) != 0;
+		bool priorityLayerA = (i & (1 << 1)) != 0;
+		bool priorityLayerB = (i & 1) != 0;
+
+		//Resolve the layer priority for this combination of layer settings
+		unsigned int layerIndex;
+		bool shadow;
+		bool highlight;
+		CalculateLayerPriorityIndex(layerIndex, shadow, highlight, shadowHighlightEnabled, spriteIsShadowOperator, spriteIsHighlightOperator, foundSpritePixel, foundLayerAPixel, foundLayerBPixel, prioritySprite, priorityLayerA, priorityLayerB);
+
+		//Incorporate the shadow and highlight bits into the layer index value
+		layerIndex |= shadow? 1 << 3: 0;
+		layerIndex |= highlight? 1 << 2: 0;
+
+		//Write the combined value to the layer priority lookup table
+		layerPriorityLookupTable[i] = layerIndex;
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void LayerCompositor::CalculateLayerPriorityIndex(unsigned int& layerIndex, bool& shadow, bool& highlight, bool shadowHighlightEnabled, bool spriteIsShadowOperator, bool spriteIsHighlightOperator, bool foundSpritePixel, bool foundLayerAPixel, bool foundLayerBPixel, bool prioritySprite, bool priorityLayerA, bool priorityLayerB)
+{
+	//Initialize the shadow/highlight flags
+	shadow = false;
+	highlight = false;
+
+	//Perform layer priority calculations
+	if(!shadowHighlightEnabled)
+	{
+		//Perform standard layer priority calculations
+		if(foundSpritePixel && prioritySprite)
+		{
+			layerIndex = LAYERINDEX_SPRITE;
+		}
+		else if(foundLayerAPixel && priorityLayerA)
+		{
+			layerIndex = LAYERINDEX_LAYERA;
+		}
+		else if(foundLayerBPixel && priorityLayerB)
+		{
+			layerIndex = LAYERINDEX_LAYERB;
+		}
+		else if(foundSpritePixel)
+		{
+			layerIndex = LAYERINDEX_SPRITE;
+		}
+		else if(foundLayerAPixel)
+		{
+			layerIndex = LAYERINDEX_LAYERA;
+		}
+		else if(foundLayerBPixel)
+		{
+			layerIndex = LAYERINDEX_LAYERB;
+		}
+		else
+		{
+			layerIndex = LAYERINDEX_BACKGROUND;
+		}
+	}
+	else
+	{
+		//Perform shadow/highlight mode layer priority calculations. Note that some
+		//illustrations in the official documentation from Sega demonstrating the
+		//behaviour of shadow/highlight mode are incorrect. In particular, the third and
+		//fifth illustrations on page 64 of the "Genesis Software Manual", showing layers
+		//B and A being shadowed when a shadow sprite operator is at a lower priority, are
+		//incorrect. If any layer is above an operator sprite pixel, the sprite operator
+		//is ignored, and the higher priority pixel is output without the sprite operator
+		//being applied. This has been confirmed through hardware tests. All other
+		//illustrations describing the operation of shadow/highlight mode in relation to
+		//layer priority settings appear to be correct.
+		if(foundSpritePixel && prioritySprite && !spriteIsShadowOperator && !spriteIsHighlightOperator)
+		{
+			layerIndex = LAYERINDEX_SPRITE;
+		}
+		else if(foundLayerAPixel && priorityLayerA)
+		{
+			layerIndex = LAYERINDEX_LAYERA;
+			if(prioritySprite && spriteIsShadowOperator)
+			{
+				shadow = true;
+			}
+			else if(prioritySprite && spriteIsHighlightOperator)
+			{
+				highlight = true;
+			}
+		}
+		else if(foundLayerBPixel && priorityLayerB)
+		{
+			layerIndex = LAYERINDEX_LAYERB;
+			if(prioritySprite && spriteIsShadowOperator)
+			{
+				shadow = true;
+			}
+			else if(prioritySprite && spriteIsHighlightOperator)
+			{
+				highlight = true;
+			}
+		}
+		else if(foundSpritePixel && !spriteIsShadowOperator && !spriteIsHighlightOperator)
+		{
+			layerIndex = LAYERINDEX_SPRITE;
+			if(!priorityLayerA && !priorityLayerB)
+			{
+				shadow = true;
+			}
+		}
+		else if(foundLayerAPixel)
+		{
+			layerIndex = LAYERINDEX_LAYERA;
+			if(!priorityLayerA && !priorityLayerB)
+			{
+				shadow = true;
+			}
+			if(spriteIsShadowOperator)
+			{
+				shadow = true;
+			}
+			else if(spriteIsHighlightOperator)
+			{
+				highlight = true;
+			}
+		}
+		else if(foundLayerBPixel)
+		{
+			layerIndex = LAYERINDEX_LAYERB;
+			if(!priorityLayerA && !priorityLayerB)
+			{
+				shadow = true;
+			}
+			if(spriteIsShadowOperator)
+			{
+				shadow = true;
+			}
+			else if(spriteIsHighlightOperator)
+			{
+				highlight = true;
+			}
+		}
+		else
+		{
+			layerIndex = LAYERINDEX_BACKGROUND;
+			if(!priorityLayerA && !priorityLayerB)
+			{
+				shadow = true;
+			}
+			if(spriteIsShadowOperator)
+			{
+				shadow = true;
+			}
+			else if(spriteIsHighlightOperator)
+			{
+				highlight = true;
+			}
+		}
+
+		//If shadow and highlight are both set, they cancel each other out. This is why a
+		//sprite acting as a highlight operator is unable to highlight layer A, B, or the
+		//background, if layers A and B both have their priority bits unset. This has been
+		//confirmed on the hardware.
+		if(shadow && highlight)
+		{
+			shadow = false;
+			highlight = false;
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Layer compositor functions
+//----------------------------------------------------------------------------------------
+//The layer compositor functions resolve the layer priority and shadow/highlight state for
+//a block of pixels in the active scan region at once. Each pixel is described by a layer
+//flags byte, which contains the lower 8 bits of the index used to access the layer
+//priority lookup table, and a separate shadow/highlight enable byte, which contains the
+//upper bit. The layer flags byte is packed as follows:
+//---------------------------------
+//| 7 | 6 | 5 | 4 | 3 | 2 | 1 | 0 |
+//|-------------------------------|
+//|SO |HO |fS |fA |fB |pS |pA |pB |
+//---------------------------------
+//SO: Sprite is a shadow operator
+//HO: Sprite is a highlight operator
+//fS: Sprite pixel is opaque
+//fA: Layer A pixel is opaque
+//fB: Layer B pixel is opaque
+//pS: Sprite priority bit
+//pA: Layer A priority bit
+//pB: Layer B priority bit
+//The paletteEntries buffer holds the combined palette line and index for each layer,
+//stored as a separate array of blockPixelCount entries for each layer in layer
+//index order. The combined result for each pixel is written to layerSelections, in the
+//same format as entries in the layer priority lookup table, and the palette entry for the
+//selected layer is written to selectedPaletteEntries.
+//----------------------------------------------------------------------------------------
+LayerCompositor::CompositorFunction LayerCompositor::SelectCompositorFunction(const std::vector<unsigned int>& layerPriorityLookupTable)
+{
+	//Select the widest supported implementation whose output is bit-exact with the scalar
+	//lookup table path. The priority index for a pixel only has 512 possible values, so
+	//VerifyCompositorFunction can cover every one of them, comparing both the selected
+	//palette entry and the selected layer. Complete lines are compared against
+	//CalculateLayerPriorityIndex by the unit tests for this device.
+	if(ProcessorSupportsAVX2() && VerifyCompositorFunction(CompositeLayerPixelsAVX2, layerPriorityLookupTable))
+	{
+		return CompositeLayerPixelsAVX2;
+	}
+	if(ProcessorSupportsSSE2() && VerifyCompositorFunction(CompositeLayerPixelsSSE2, layerPriorityLookupTable))
+	{
+		return CompositeLayerPixelsSSE2;
+	}
+	return CompositeLayerPixelsScalar;
+}
+
+//----------------------------------------------------------------------------------------
+bool LayerCompositor::VerifyCompositorFunction(CompositorFunction compositorFunction, const std::vector<unsigned int>& layerPriorityLookupTable)
+{
+	//Run every entry in the layer priority lookup table through both the target
+	//compositor and the scalar compositor, in blocks of blockPixelCount pixels.
+	//We give each layer a distinct palette entry for each pixel, so that we can confirm
+	//the correct palette entry is being selected as well as the correct layer.
+	for(unsigned int blockBase = 0; blockBase < lookupTableSize; blockBase += blockPixelCount)
+	{
+		unsigned char layerFlags[blockPixelCount];
+		unsigned char shadowHighlightEnabled[blockPixelCount];
+		unsigned char paletteEntries[4 * blockPixelCount];
+		for(unsigned int i = 0; i < blockPixelCount; ++i)
+		{
+			unsigned int priorityIndex = blockBase + i;
+			layerFlags[i] = (unsigned char)(priorityIndex & 0xFF);
+			shadowHighlightEnabled[i] = (unsigned char)(priorityIndex >> 8);
+			for(unsigned int layerNo = 0; layerNo < 4; ++layerNo)
+			{
+				paletteEntries[(layerNo * blockPixelCount) + i] = (unsigned char)((layerNo << 4) | (i & 0x0F));
+			}
+		}
+
+		//Test both a complete block, and a partial block, to exercise the path for any
+		//pixels left over at the end of a block.
+		static const unsigned int pixelCountsToTest[2] = {blockPixelCount, blockPixelCount - 3};
+		for(unsigned int testNo = 0; testNo < 2; ++testNo)
+		{
+			unsigned int pixelCount = pixelCountsToTest[testNo];
+			unsigned char expectedPaletteEntries[blockPixelCount];
+			unsigned char expectedLayerSelections[blockPixelCount];
+			unsigned char actualPaletteEntries[blockPixelCount];
+			unsigned char actualLayerSelections[blockPixelCount];
+			CompositeLayerPixelsScalar(pixelCount, &layerFlags[0], &shadowHighlightEnabled[0], &paletteEntries[0], &expectedPaletteEntries[0], &expectedLayerSelections[0], &layerPriorityLookupTable[0]);
+			compositorFunction(pixelCount, &layerFlags[0], &shadowHighlightEnabled[0], &paletteEntries[0], &actualPaletteEntries[0], &actualLayerSelections[0], &layerPriorityLookupTable[0]);
+			for(unsigned int i = 0; i < pixelCount; ++i)
+			{
+				if((expectedPaletteEntries[i] != actualPaletteEntries[i]) || (expectedLayerSelections[i] != actualLayerSelections[i]))
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+void LayerCompositor::CompositeLayerPixelsScalar(unsigned int pixelCount, const unsigned char* layerFlags, const unsigned char* shadowHighlightEnabled, const unsigned char* paletteEntries, unsigned char* selectedPaletteEntries, unsigned char* layerSelections, const unsigned int* layerPriorityLookupTable)
+{
+	for(unsigned int i = 0; i < pixelCount; ++i)
+	{
+		unsigned int priorityIndex = ((unsigned int)shadowHighlightEnabled[i] << 8) | (unsigned int)layerFlags[i];
+		unsigned int layerSelectionResult = layerPriorityLookupTable[priorityIndex];
+		layerSelections[i] = (unsigned char)layerSelectionResult;
+		selectedPaletteEntries[i] = paletteEntries[((layerSelectionResult & 0x03) * blockPixelCount) + i];
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void LayerCompositor::CompositeLayerPixelsSSE2(unsigned int pixelCount, const unsigned char* layerFlags, const unsigned char* shadowHighlightEnabled, const unsigned char* paletteEntries, unsigned char* selectedPaletteEntries, unsigned char* layerSelections, const unsigned int* layerPriorityLookupTable)
+{
+	//Note that the vector implementation doesn't use the layer priority lookup table.
+	//Instead, it evaluates the same decision tree as CalculateLayerPriorityIndex for 16
+	//pixels at once, using byte masks in place of each branch. Each "else if" in the
+	//decision tree is implemented by evaluating the conditions in reverse order, with
+	//each successive condition overwriting the result of the last.
+	static const unsigned int pixelsPerVector = 16;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bitSO = _mm_set1_epi8((char)0x80);
+	const __m128i bitHO = _mm_set1_epi8(0x40);
+	const __m128i bitFS = _mm_set1_epi8(0x20);
+	const __m128i bitFA = _mm_set1_epi8(0x10);
+	const __m128i bitFB = _mm_set1_epi8(0x08);
+	const __m128i bitPS = _mm_set1_epi8(0x04);
+	const __m128i bitPA = _mm_set1_epi8(0x02);
+	const __m128i bitPB = _mm_set1_epi8(0x01);
+	const __m128i layerA = _mm_set1_epi8(LAYERINDEX_LAYERA);
+	const __m128i layerB = _mm_set1_epi8(LAYERINDEX_LAYERB);
+	const __m128i layerBackground = _mm_set1_epi8(LAYERINDEX_BACKGROUND);
+	const __m128i highlightBit = _mm_set1_epi8(0x04);
+	const __m128i shadowBit = _mm_set1_epi8(0x08);
+
+	unsigned int i = 0;
+	while((i + pixelsPerVector) <= pixelCount)
+	{
+		//Expand each flag bit into a byte mask
+		__m128i flags = _mm_loadu_si128((const __m128i*)&layerFlags[i]);
+		__m128i so = _mm_cmpeq_epi8(_mm_and_si128(flags, bitSO), bitSO);
+		__m128i ho = _mm_cmpeq_epi8(_mm_and_si128(flags, bitHO), bitHO);
+		__m128i fs = _mm_cmpeq_epi8(_mm_and_si128(flags, bitFS), bitFS);
+		__m128i fa = _mm_cmpeq_epi8(_mm_and_si128(flags, bitFA), bitFA);
+		__m128i fb = _mm_cmpeq_epi8(_mm_and_si128(flags, bitFB), bitFB);
+		__m128i ps = _mm_cmpeq_epi8(_mm_and_si128(flags, bitPS), bitPS);
+		__m128i pa = _mm_cmpeq_epi8(_mm_and_si128(flags, bitPA), bitPA);
+		__m128i pb = _mm_cmpeq_epi8(_mm_and_si128(flags, bitPB), bitPB);
+		__m128i ste = _mm_andnot_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)&shadowHighlightEnabled[i]), zero), _mm_cmpeq_epi8(zero, zero));
+		__m128i highPriorityS = _mm_and_si128(fs, ps);
+		__m128i highPriorityA = _mm_and_si128(fa, pa);
+		__m128i highPriorityB = _mm_and_si128(fb, pb);
+
+		//Perform standard layer priority calculations. Note that the layer index for the
+		//sprite layer is 0, so we can select it by clearing the result.
+		__m128i normalLayer = layerBackground;
+		normalLayer = _mm_or_si128(_mm_and_si128(fb, layerB), _mm_andnot_si128(fb, normalLayer));
+		normalLayer = _mm_or_si128(_mm_and_si128(fa, layerA), _mm_andnot_si128(fa, normalLayer));
+		normalLayer = _mm_andnot_si128(fs, normalLayer);
+		normalLayer = _mm_or_si128(_mm_and_si128(highPriorityB, layerB), _mm_andnot_si128(highPriorityB, normalLayer));
+		normalLayer = _mm_or_si128(_mm_and_si128(highPriorityA, layerA), _mm_andnot_si128(highPriorityA, normalLayer));
+		normalLayer = _mm_andnot_si128(highPriorityS, normalLayer);
+
+		//Perform shadow/highlight mode layer priority calculations
+		__m128i spriteNormal = _mm_andnot_si128(_mm_or_si128(so, ho), fs);
+		__m128i spriteNormalHighPriority = _mm_and_si128(spriteNormal, ps);
+		__m128i bothLayersLowPriority = _mm_andnot_si128(_mm_or_si128(pa, pb), _mm_cmpeq_epi8(zero, zero));
+		__m128i operatorShadow = _mm_and_si128(ps, so);
+		__m128i operatorHighlight = _mm_andnot_si128(so, _mm_and_si128(ps, ho));
+		__m128i lowShadow = _mm_or_si128(bothLayersLowPriority, so);
+		__m128i lowHighlight = _mm_andnot_si128(so, ho);
+		__m128i steLayer = layerBackground;
+		__m128i shadow = lowShadow;
+		__m128i highlight = lowHighlight;
+		steLayer = _mm_or_si128(_mm_and_si128(fb, layerB), _mm_andnot_si128(fb, steLayer));
+		steLayer = _mm_or_si128(_mm_and_si128(fa, layerA), _mm_andnot_si128(fa, steLayer));
+		steLayer = _mm_andnot_si128(spriteNormal, steLayer);
+		shadow = _mm_or_si128(_mm_and_si128(spriteNormal, bothLayersLowPriority), _mm_andnot_si128(spriteNormal, shadow));
+		highlight = _mm_andnot_si128(spriteNormal, highlight);
+		steLayer = _mm_or_si128(_mm_and_si128(highPriorityB, layerB), _mm_andnot_si128(highPriorityB, steLayer));
+		shadow = _mm_or_si128(_mm_and_si128(highPriorityB, operatorShadow), _mm_andnot_si128(highPriorityB, shadow));
+		highlight = _mm_or_si128(_mm_and_si128(highPriorityB, operatorHighlight), _mm_andnot_si128(highPriorityB, highlight));
+		steLayer = _mm_or_si128(_mm_and_si128(highPriorityA, layerA), _mm_andnot_si128(highPriorityA, steLayer));
+		shadow = _mm_or_si128(_mm_and_si128(highPriorityA, operatorShadow), _mm_andnot_si128(highPriorityA, shadow));
+		highlight = _mm_or_si128(_mm_and_si128(highPriorityA, operatorHighlight), _mm_andnot_si128(highPriorityA, highlight));
+		steLayer = _mm_andnot_si128(spriteNormalHighPriority, steLayer);
+		shadow = _mm_andnot_si128(spriteNormalHighPriority, shadow);
+		highlight = _mm_andnot_si128(spriteNormalHighPriority, highlight);
+
+		//If shadow and highlight are both set, they cancel each other out
+		__m128i shadowAndHighlight = _mm_and_si128(shadow, highlight);
+		shadow = _mm_andnot_si128(shadowAndHighlight, shadow);
+		highlight = _mm_andnot_si128(shadowAndHighlight, highlight);
+
+		//Combine the results for each mode, and build the final layer selection value in
+		//the same format as the layer priority lookup table.
+		__m128i layer = _mm_or_si128(_mm_and_si128(ste, steLayer), _mm_andnot_si128(ste, normalLayer));
+		__m128i result = _mm_or_si128(layer, _mm_and_si128(ste, _mm_or_si128(_mm_and_si128(shadow, shadowBit), _mm_and_si128(highlight, highlightBit))));
+		_mm_storeu_si128((__m128i*)&layerSelections[i], result);
+
+		//Select the palette entry from the chosen layer
+		__m128i paletteEntry = _mm_and_si128(_mm_cmpeq_epi8(layer, zero), _mm_loadu_si128((const __m128i*)&paletteEntries[(LAYERINDEX_SPRITE * blockPixelCount) + i]));
+		paletteEntry = _mm_or_si128(paletteEntry, _mm_and_si128(_mm_cmpeq_epi8(layer, layerA), _mm_loadu_si128((const __m128i*)&paletteEntries[(LAYERINDEX_LAYERA * blockPixelCount) + i])));
+		paletteEntry = _mm_or_si128(paletteEntry, _mm_and_si128(_mm_cmpeq_epi8(layer, layerB), _mm_loadu_si128((const __m128i*)&paletteEntries[(LAYERINDEX_LAYERB * blockPixelCount) + i])));
+		paletteEntry = _mm_or_si128(paletteEntry, _mm_and_si128(_mm_cmpeq_epi8(layer, layerBackground), _mm_loadu_si128((const __m128i*)&paletteEntries[(LAYERINDEX_BACKGROUND * blockPixelCount) + i])));
+		_mm_storeu_si128((__m128i*)&selectedPaletteEntries[i], paletteEntry);
+
+		i += pixelsPerVector;
+	}
+
+	//Process any remaining pixels which don't fill a complete vector
+	for(; i < pixelCount; ++i)
+	{
+		unsigned int priorityIndex = ((unsigned int)shadowHighlightEnabled[i] << 8) | (unsigned int)layerFlags[i];
+		unsigned int layerSelectionResult = layerPriorityLookupTable[priorityIndex];
+		layerSelections[i] = (unsigned char)layerSelectionResult;
+		selectedPaletteEntries[i] = paletteEntries[((layerSelectionResult & 0x03) * blockPixelCount) + i];
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void LayerCompositor::CompositeLayerPixelsAVX2(unsigned int pixelCount, const unsigned char* layerFlags, const unsigned char* shadowHighlightEnabled, const unsigned char* paletteEntries, unsigned char* selectedPaletteEntries, unsigned char* layerSelections, const unsigned int* layerPriorityLookupTable)
+{
+	//This is the same algorithm as CompositeLayerPixelsSSE2, operating on 32 pixels at a
+	//time. Refer to the comments in that function for more information.
+	static const unsigned int pixelsPerVector = 32;
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i allBitsSet = _mm256_cmpeq_epi8(zero, zero);
+	const __m256i bitSO = _mm256_set1_epi8((char)0x80);
+	const __m256i bitHO = _mm256_set1_epi8(0x40);
+	const __m256i bitFS = _mm256_set1_epi8(0x20);
+	const __m256i bitFA = _mm256_set1_epi8(0x10);
+	const __m256i bitFB = _mm256_set1_epi8(0x08);
+	const __m256i bitPS = _mm256_set1_epi8(0x04);
+	const __m256i bitPA = _mm256_set1_epi8(0x02);
+	const __m256i bitPB = _mm256_set1_epi8(0x01);
+	const __m256i layerA = _mm256_set1_epi8(LAYERINDEX_LAYERA);
+	const __m256i layerB = _mm256_set1_epi8(LAYERINDEX_LAYERB);
+	const __m256i layerBackground = _mm256_set1_epi8(LAYERINDEX_BACKGROUND);
+	const __m256i highlightBit = _mm256_set1_epi8(0x04);
+	const __m256i shadowBit = _mm256_set1_epi8(0x08);
+
+	unsigned int i = 0;
+	while((i + pixelsPerVector) <= pixelCount)
+	{
+		//Expand each flag bit into a byte mask
+		__m256i flags = _mm256_loadu_si256((const __m256i*)&layerFlags[i]);
+		__m256i so = _mm256_cmpeq_epi8(_mm256_and_si256(flags, bitSO), bitSO);
+		__m256i ho = _mm256_cmpeq_epi8(_mm256_and_si256(flags, bitHO), bitHO);
+		__m256i fs = _mm256_cmpeq_epi8(_mm256_and_si256(flags, bitFS), bitFS);
+		__m256i fa = _mm256_cmpeq_epi8(_mm256_and_si256(flags, bitFA), bitFA);
+		__m256i fb = _mm256_cmpeq_epi8(_mm256_and_si256(flags, bitFB), bitFB);
+		__m256i ps = _mm256_cmpeq_epi8(_mm256_and_si256(flags, bitPS), bitPS);
+		__m256i pa = _mm256_cmpeq_epi8(_mm256_and_si256(flags, bitPA), bitPA);
+		__m256i pb = _mm256_cmpeq_epi8(_mm256_and_si256(flags, bitPB), bitPB);
+		__m256i ste = _mm256_andnot_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)&shadowHighlightEnabled[i]), zero), allBitsSet);
+		__m256i highPriorityS = _mm256_and_si256(fs, ps);
+		__m256i highPriorityA = _mm256_and_si256(fa, pa);
+		__m256i highPriorityB = _mm256_and_si256(fb, pb);
+
+		//Perform standard layer priority calculations
+		__m256i normalLayer = layerBackground;
+		normalLayer = _mm256_blendv_epi8(normalLayer, layerB, fb);
+		normalLayer = _mm256_blendv_epi8(normalLayer, layerA, fa);
+		normalLayer = _mm256_andnot_si256(fs, normalLayer);
+		normalLayer = _mm256_blendv_epi8(normalLayer, layerB, highPriorityB);
+		normalLayer = _mm256_blendv_epi8(normalLayer, layerA, highPriorityA);
+		normalLayer = _mm256_andnot_si256(highPriorityS, normalLayer);
+
+		//Perform shadow/highlight mode layer priority calculations
+		__m256i spriteNormal = _mm256_andnot_si256(_mm256_or_si256(so, ho), fs);
+		__m256i spriteNormalHighPriority = _mm256_and_si256(spriteNormal, ps);
+		__m256i bothLayersLowPriority = _mm256_andnot_si256(_mm256_or_si256(pa, pb), allBitsSet);
+		__m256i operatorShadow = _mm256_and_si256(ps, so);
+		__m256i operatorHighlight = _mm256_andnot_si256(so, _mm256_and_si256(ps, ho));
+		__m256i steLayer = layerBackground;
+		__m256i shadow = _mm256_or_si256(bothLayersLowPriority, so);
+		__m256i highlight = _mm256_andnot_si256(so, ho);
+		steLayer = _mm256_blendv_epi8(steLayer, layerB, fb);
+		steLayer = _mm256_blendv_epi8(steLayer, layerA, fa);
+		steLayer = _mm256_andnot_si256(spriteNormal, steLayer);
+		shadow = _mm256_blendv_epi8(shadow, bothLayersLowPriority, spriteNormal);
+		highlight = _mm256_andnot_si256(spriteNormal, highlight);
+		steLayer = _mm256_blendv_epi8(steLayer, layerB, highPriorityB);
+		shadow = _mm256_blendv_epi8(shadow, operatorShadow, highPriorityB);
+		highlight = _mm256_blendv_epi8(highlight, operatorHighlight, highPriorityB);
+		steLayer = _mm256_blendv_epi8(steLayer, layerA, highPriorityA);
+		shadow = _mm256_blendv_epi8(shadow, operatorShadow, highPriorityA);
+		highlight = _mm256_blendv_epi8(highlight, operatorHighlight, highPriorityA);
+		steLayer = _mm256_andnot_si256(spriteNormalHighPriority, steLayer);
+		shadow = _mm256_andnot_si256(spriteNormalHighPriority, shadow);
+		highlight = _mm256_andnot_si256(spriteNormalHighPriority, highlight);
+
+		//If shadow and highlight are both set, they cancel each other out
+		__m256i shadowAndHighlight = _mm256_and_si256(shadow, highlight);
+		shadow = _mm256_andnot_si256(shadowAndHighlight, shadow);
+		highlight = _mm256_andnot_si256(shadowAndHighlight, highlight);
+
+		//Combine the results for each mode
+		__m256i layer = _mm256_blendv_epi8(normalLayer, steLayer, ste);
+		__m256i result = _mm256_or_si256(layer, _mm256_and_si256(ste, _mm256_or_si256(_mm256_and_si256(shadow, shadowBit), _mm256_and_si256(highlight, highlightBit))));
+		_mm256_storeu_si256((__m256i*)&layerSelections[i], result);
+
+		//Select the palette entry from the chosen layer
+		__m256i paletteEntry = _mm256_loadu_si256((const __m256i*)&paletteEntries[(LAYERINDEX_SPRITE * blockPixelCount) + i]);
+		paletteEntry = _mm256_blendv_epi8(paletteEntry, _mm256_loadu_si256((const __m256i*)&paletteEntries[(LAYERINDEX_LAYERA * blockPixelCount) + i]), _mm256_cmpeq_epi8(layer, layerA));
+		paletteEntry = _mm256_blendv_epi8(paletteEntry, _mm256_loadu_si256((const __m256i*)&paletteEntries[(LAYERINDEX_LAYERB * blockPixelCount) + i]), _mm256_cmpeq_epi8(layer, layerB));
+		paletteEntry = _mm256_blendv_epi8(paletteEntry, _mm256_loadu_si256((const __m256i*)&paletteEntries[(LAYERINDEX_BACKGROUND * blockPixelCount) + i]), _mm256_cmpeq_epi8(layer, layerBackground));
+		_mm256_storeu_si256((__m256i*)&selectedPaletteEntries[i], paletteEntry);
+
+		i += pixelsPerVector;
+	}
+
+	//Clear the upper halves of the ymm registers, to avoid a transition penalty when SSE
+	//code is executed after this function returns.
+	_mm256_zeroupper();
+
+	//Process any remaining pixels which don't fill a complete vector
+	for(; i < pixelCount; ++i)
+	{
+		unsigned int priorityIndex = ((unsigned int)shadowHighlightEnabled[i] << 8) | (unsigned int)layerFlags[i];
+		unsigned int layerSelectionResult = layerPriorityLookupTable[priorityIndex];
+		layerSelections[i] = (unsigned char)layerSelectionResult;
+		selectedPaletteEntries[i] = paletteEntries[((layerSelectionResult & 0x03) * blockPixelCount) + i];
+	}
+}
@@ -0,0 +1,32 @@
+#ifndef __LAYERCOMPOSITOR_H__
+#define __LAYERCOMPOSITOR_H__
+#include <vector>
+
+class LayerCompositor
+{
+public:
+	//Enumerations
+	enum LayerIndex :unsigned int;
+
+	//Typedefs
+	typedef void (*CompositorFunction)(unsigned int pixelCount, const unsigned char* layerFlags, const unsigned char* shadowHighlightEnabled, const unsigned char* paletteEntries, unsigned char* selectedPaletteEntries, unsigned char* layerSelections, const unsigned int* layerPriorityLookupTable);
+
+	//Constants
+	static const unsigned int blockPixelCount = 32;
+	static const unsigned int lookupTableSize = 0x200;
+
+public:
+	//Layer priority functions
+	static void BuildLayerPriorityLookupTable(std::vector<unsigned int>& layerPriorityLookupTable);
+	static void CalculateLayerPriorityIndex(unsigned int& layerIndex, bool& shadow, bool& highlight, bool shadowHighlightEnabled, bool spriteIsShadowOperator, bool spriteIsHighlightOperator, bool foundSpritePixel, bool foundLayerAPixel, bool foundLayerBPixel, bool prioritySprite, bool priorityLayerA, bool priorityLayerB);
+
+	//Compositor functions
+	static CompositorFunction SelectCompositorFunction(const std::vector<unsigned int>& layerPriorityLookupTable);
+	static bool VerifyCompositorFunction(CompositorFunction compositorFunction, const std::vector<unsigned int>& layerPriorityLookupTable);
+	static void CompositeLayerPixelsScalar(unsigned int pixelCount, const unsigned char* layerFlags, const unsigned char* shadowHighlightEnabled, const unsigned char* paletteEntries, unsigned char* selectedPaletteEntries, unsigned char* layerSelections, const unsigned int* layerPriorityLookupTable);
+	static void CompositeLayerPixelsSSE2(unsigned int pixelCount, const unsigned char* layerFlags, const unsigned char* shadowHighlightEnabled, const unsigned char* paletteEntries, unsigned char* selectedPaletteEntries, unsigned char* layerSelections, const unsigned int* layerPriorityLookupTable);
+	static void CompositeLayerPixelsAVX2(unsigned int pixelCount, const unsigned char* layerFlags, const unsigned char* shadowHighlightEnabled, const unsigned char* paletteEntries, unsigned char* selectedPaletteEntries, unsigned char* layerSelections, const unsigned int* layerPriorityLookupTable);
+};
+
+#include "LayerCompositor.inl"
+#endif
@@ -0,0 +1,10 @@
+//----------------------------------------------------------------------------------------
+//Enumerations
+//----------------------------------------------------------------------------------------
+enum LayerCompositor::LayerIndex :unsigned int
+{
+	LAYERINDEX_SPRITE = 0,
+	LAYERINDEX_LAYERA = 1,
+	LAYERINDEX_LAYERB = 2,
+	LAYERINDEX_BACKGROUND = 3
+};
@@ -0,0 +1,255 @@
+#include "S315_5313.h"
+#include <thread>
+
+//----------------------------------------------------------------------------------------
+//Render band functions
+//----------------------------------------------------------------------------------------
+//Pixels staged for the layer compositor are grouped into bands of consecutive output
+//lines, which are resolved and written to the image buffer by a pool of worker threads
+//while the render thread continues generating the following lines. Note that only the
+//layer priority resolution and colour conversion stages are performed by the workers.
+//The render thread still performs all the sequential parts of the render process,
+//including pattern and sprite decoding. Each band takes a copy of CRAM when it's
+//started, and each compositor block carries a reference to the copy which was current
+//when the block was opened, so that bands can be resolved in any order and still
+//produce the same output. A new copy is only taken within a band when CRAM has actually
+//been written to, so palette changes made part way through a line are preserved. Since
+//each pixel in a frame is only ever generated once, and we wait for all outstanding
+//bands to complete before handing over a completed frame, the final image buffer
+//contents are identical to resolving each pixel as it's generated.
+//----------------------------------------------------------------------------------------
+void S315_5313::StartRenderBandWorkers()
+{
+	//Calculate the number of worker threads to use. We leave one hardware thread for the
+	//render thread, and one for the rest of the system. If there aren't enough hardware
+	//threads available to run any workers, bands are resolved directly on the render
+	//thread.
+	unsigned int hardwareThreadCount = std::thread::hardware_concurrency();
+	unsigned int workerCount = (hardwareThreadCount > 2)? hardwareThreadCount - 2: 0;
+	workerCount = (workerCount > renderBandMaxWorkerCount)? renderBandMaxWorkerCount: workerCount;
+
+	//Start the render band worker threads
+	std::unique_lock<std::mutex> lock(renderBandMutex);
+	renderBandWorkersActive = true;
+	for(unsigned int i = 0; i < workerCount; ++i)
+	{
+		++renderBandRunningWorkerCount;
+		renderBandWorkerThreads.push_back(std::thread(std::bind(std::mem_fn(&S315_5313::RenderBandWorkerThread), this)));
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void S315_5313::StopRenderBandWorkers()
+{
+	//Instruct the render band worker threads to stop, and wait for each thread to
+	//terminate. Note that we need to release the lock while we join the threads, since
+	//each worker needs to obtain it in order to exit.
+	std::unique_lock<std::mutex> lock(renderBandMutex);
+	renderBandWorkersActive = false;
+	renderBandWorkerUpdate.notify_all();
+	std::vector<std::thread> workerThreads;
+	workerThreads.swap(renderBandWorkerThreads);
+	lock.unlock();
+	for(unsigned int i = 0; i < (unsigned int)workerThreads.size(); ++i)
+	{
+		workerThreads[i].join();
+	}
+	lock.lock();
+	renderBandRunningWorkerCount = 0;
+}
+
+//----------------------------------------------------------------------------------------
+void S315_5313::RenderBandWorkerThread()
+{
+	std::unique_lock<std::mutex> lock(renderBandMutex);
+	while(renderBandWorkersActive || !renderBandPendingJobs.empty())
+	{
+		//If there are no bands waiting to be resolved, wait for a new band to be
+		//submitted or for this thread to be instructed to stop.
+		if(renderBandPendingJobs.empty())
+		{
+			renderBandWorkerUpdate.wait(lock);
+			continue;
+		}
+
+		//Resolve the next pending band
+		RenderBandJob* renderBandJob = renderBandPendingJobs.front();
+		renderBandPendingJobs.pop_front();
+		lock.unlock();
+		CompositeRenderBand(*renderBandJob);
+		lock.lock();
+
+		//Return the band to the free list, and notify the render thread if there are no
+		//more bands outstanding.
+		renderBandFreeJobs.push_back(renderBandJob);
+		--renderBandOutstandingJobCount;
+		if(renderBandOutstandingJobCount == 0)
+		{
+			renderBandJobsComplete.notify_all();
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------
+S315_5313::CompositorPixelBlock& S315_5313::BeginCompositorPixelBlock(unsigned int currentRow)
+{
+	//If we've moved outside the line range of the current band, submit it to be resolved.
+	//Note that we rely on unsigned wrapping here to also submit the band if the current
+	//row is before the first row in the band.
+	if((renderBandCurrentJob != 0) && ((currentRow - renderBandCurrentJob->firstRow) >= renderBandLineCount))
+	{
+		SubmitRenderBand();
+	}
+
+	//If there's no band currently being built, start a new band. Each band takes its own
+	//copy of CRAM, so that it doesn't depend on any other band.
+	if(renderBandCurrentJob == 0)
+	{
+		std::unique_lock<std::mutex> lock(renderBandMutex);
+		if(renderBandFreeJobs.empty())
+		{
+			RenderBandJob* newRenderBandJob = new RenderBandJob();
+			renderBandAllocatedJobs.push_back(newRenderBandJob);
+			renderBandFreeJobs.push_back(newRenderBandJob);
+		}
+		renderBandCurrentJob = renderBandFreeJobs.front();
+		renderBandFreeJobs.pop_front();
+		renderBandCurrentJob->firstRow = currentRow;
+		renderBandCurrentJob->blockCount = 0;
+		renderBandCurrentJob->cramSnapshotCount = 0;
+		renderCompositorCRAMSnapshotStale = true;
+	}
+	RenderBandJob& renderBandJob = *renderBandCurrentJob;
+
+	//If CRAM may have been modified since the last snapshot was taken, take a new copy of
+	//the current committed CRAM state for this block.
+	if(renderCompositorCRAMSnapshotStale)
+	{
+		unsigned int cramSnapshotOffset = renderBandJob.cramSnapshotCount * cramSize;
+		if(renderBandJob.cramSnapshots.size() < (cramSnapshotOffset + cramSize))
+		{
+			renderBandJob.cramSnapshots.resize(cramSnapshotOffset + cramSize);
+		}
+		for(unsigned int i = 0; i < cramSize; ++i)
+		{
+			renderBandJob.cramSnapshots[cramSnapshotOffset + i] = cram->ReadCommitted(i);
+		}
+		++renderBandJob.cramSnapshotCount;
+		renderCompositorCRAMSnapshotStale = false;
+	}
+
+	//Open a new compositor block in this band
+	if(renderBandJob.blocks.size() <= renderBandJob.blockCount)
+	{
+		renderBandJob.blocks.resize(renderBandJob.blockCount + 1);
+	}
+	CompositorPixelBlock& block = renderBandJob.blocks[renderBandJob.blockCount++];
+	block.pixelCount = 0;
+	block.cramSnapshotIndex = renderBandJob.cramSnapshotCount - 1;
+	renderCompositorBlock = &block;
+	return block;
+}
+
+//----------------------------------------------------------------------------------------
+void S315_5313::EndCompositorPixelBlock()
+{
+	renderCompositorBlock = 0;
+}
+
+//----------------------------------------------------------------------------------------
+void S315_5313::SubmitRenderBand()
+{
+	//If there's no band currently being built, abort any further processing.
+	EndCompositorPixelBlock();
+	if(renderBandCurrentJob == 0)
+	{
+		return;
+	}
+	RenderBandJob* renderBandJob = renderBandCurrentJob;
+	renderBandCurrentJob = 0;
+
+	//If there are no worker threads available, resolve this band directly, otherwise add
+	//it to the queue of bands waiting to be resolved by a worker.
+	std::unique_lock<std::mutex> lock(renderBandMutex);
+	if(renderBandRunningWorkerCount == 0)
+	{
+		lock.unlock();
+		CompositeRenderBand(*renderBandJob);
+		lock.lock();
+		renderBandFreeJobs.push_back(renderBandJob);
+		return;
+	}
+	renderBandPendingJobs.push_back(renderBandJob);
+	++renderBandOutstandingJobCount;
+	renderBandWorkerUpdate.notify_one();
+}
+
+//----------------------------------------------------------------------------------------
+void S315_5313::WaitForRenderBandsComplete()
+{
+	SubmitRenderBand();
+	std::unique_lock<std::mutex> lock(renderBandMutex);
+	while(renderBandOutstandingJobCount > 0)
+	{
+		renderBandJobsComplete.wait(lock);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void S315_5313::CompositeRenderBand(const RenderBandJob& renderBandJob) const
+{
+	//Constants
+	static const unsigned int paletteEntriesPerLine = 16;
+	static const unsigned int paletteEntrySize = 2;
+
+	for(unsigned int blockNo = 0; blockNo < renderBandJob.blockCount; ++blockNo)
+	{
+		//Resolve the layer priority for each pixel in the block
+		const CompositorPixelBlock& block = renderBandJob.blocks[blockNo];
+		if(block.pixelCount == 0)
+		{
+			continue;
+		}
+		unsigned char selectedPaletteEntries[compositorBlockPixelCount];
+		unsigned char layerSelections[compositorBlockPixelCount];
+		layerCompositor(block.pixelCount, &block.layerFlags[0], &block.shadowHighlightEnabled[0], &block.paletteEntries[0], &selectedPaletteEntries[0], &layerSelections[0], &layerPriorityLookupTable[0]);
+
+		//Convert each resolved palette entry into an output colour, using the copy of
+		//CRAM which was current when the pixels in this block were generated.
+		const unsigned char* cramData = &renderBandJob.cramSnapshots[block.cramSnapshotIndex * cramSize];
+		for(unsigned int i = 0; i < block.pixelCount; ++i)
+		{
+			//Determine the palette entry to display for this pixel. If a CRAM write
+			//occurred while this pixel was being output, the palette entry being written
+			//replaces the entry selected by the layer priority calculation.
+			unsigned int combinedPaletteEntry = (block.paletteEntryOverride[i] != compositorNoPaletteEntryOverride)? block.paletteEntryOverride[i]: selectedPaletteEntries[i];
+			unsigned int paletteLine = combinedPaletteEntry >> 4;
+			unsigned int paletteIndex = combinedPaletteEntry & 0x0F;
+			bool shadow = (layerSelections[i] & 0x08) != 0;
+			bool highlight = (layerSelections[i] & 0x04) != 0;
+
+			//Read and decode the target palette entry
+			unsigned int paletteEntryAddress = (paletteIndex + (paletteLine * paletteEntriesPerLine)) * paletteEntrySize;
+			Data paletteData(16);
+			paletteData = ((unsigned int)cramData[paletteEntryAddress+0] << 8) | (unsigned int)cramData[paletteEntryAddress+1];
+			unsigned int colorIntensityR = paletteData.GetDataSegment(1, 3);
+			unsigned int colorIntensityG = paletteData.GetDataSegment(5, 3);
+			unsigned int colorIntensityB = paletteData.GetDataSegment(9, 3);
+			if(block.reducedPalette[i])
+			{
+				colorIntensityR = (colorIntensityR & 0x01) << 2;
+				colorIntensityG = (colorIntensityG & 0x01) << 2;
+				colorIntensityB = (colorIntensityB & 0x01) << 2;
+			}
+
+			//Convert the palette data to a 32-bit RGBA triple and write it to the image
+			//buffer
+			ImageBufferColorEntry& imageBufferEntry = *block.outputEntry[i];
+			const unsigned char* intensityTable = (shadow == highlight)? &paletteEntryTo8Bit[0]: (shadow? &paletteEntryTo8BitShadow[0]: &paletteEntryTo8BitHighlight[0]);
+			imageBufferEntry.r = intensityTable[colorIntensityR];
+			imageBufferEntry.g = intensityTable[colorIntensityG];
+			imageBufferEntry.b = intensityTable[colorIntensityB];
+			imageBufferEntry.a = 0xFF;
+		}
+	}
+}
@@ -48,7 +48,10 @@ renderPatternDataCacheLayerB(maxCellsPerRow, Data(32)),
 renderPatternDataCacheRowNoLayerA(maxCellsPerRow, 0),
 renderPatternDataCacheRowNoLayerB(maxCellsPerRow, 0),
 renderSpriteDisplayCache(maxSpriteDisplayCacheSize),
-renderSpriteDisplayCellCache(maxSpriteDisplayCellCacheSize)
+renderSpriteLineListChain(maxSpriteLineListChainLength),
+renderSpriteLineListRows(spriteLineListRowCount),
+renderSpriteDisplayCellCache(maxSpriteDisplayCellCacheSize),
+imageBufferInfoCapture(imageBufferPlanes)
 {
 	fifoBuffer.resize(fifoBufferSize);
 	bfifoBuffer.resize(fifoBufferSize);
@@ -92,8 +95,30 @@ renderSpriteDisplayCellCache(maxSpriteDisplayCellCacheSize)
 	renderTimeslicePending = false;
 	drawingImageBufferPlane = 0;
 	lastRenderedFrameToken = 0;
+	renderFrameSkipActive = false;
+	renderFrameSkipCount = 0;
+	imageBufferCompletedPlane = 0;
+	layerCompositor = LayerCompositor::CompositeLayerPixelsScalar;
+	renderCompositorBlock = 0;
+	renderCompositorCRAMSnapshotStale = true;
+	renderSpriteLineListChainLength = 0;
+	renderSpriteLineListStale = true;
+	renderSpriteLineListTimesliceWritten = false;
+	renderSpriteLineListInterlaceMode2 = false;
+	renderSpriteLineListScreenModeRS1 = false;
+	renderSpriteLineListActive = false;
+	renderSpriteLineListChainIndex = 0;
+	renderSpriteLineListRowEntryIndex = 0;
+	renderBandWorkersActive = false;
+	renderBandRunningWorkerCount = 0;
+	renderBandOutstandingJobCount = 0;
+	renderBandCurrentJob = 0;
+	imageBufferInfoRequested = false;
+	renderImageBufferInfoCapture = 0;
 	for(unsigned int bufferPlaneNo = 0; bufferPlaneNo < imageBufferPlanes; ++bufferPlaneNo)
 	{
+		imageBufferPlaneReaderCount[bufferPlaneNo] = 0;
+		imageBufferFrameToken[bufferPlaneNo] = 0;
 		imageBufferLineCount[bufferPlaneNo] = 0;
 		for(unsigned int lineNo = 0; lineNo < imageBufferHeight; ++lineNo)
 		{
@@ -126,6 +151,8 @@ renderSpriteDisplayCellCache(maxSpriteDisplayCellCacheSize)
 	videoFixedAspectRatio = true;
 	videoShowStatusBar = true;
 	videoEnableLineSmoothing = true;
+	videoFrameSkip = 0;
+	videoFrameSkipAuto = false;
 	videoShowBoundaryActiveImage = false;
 	videoShowBoundaryActionSafe = false;
 	videoShowBoundaryTitleSafe = false;
@@ -149,6 +176,19 @@ renderSpriteDisplayCellCache(maxSpriteDisplayCellCacheSize)
 	portMonitorLastModifiedToken = 0;
 }
 
+//----------------------------------------------------------------------------------------
+S315_5313::~S315_5313()
+{
+	//Stop and join any render band worker threads which are still running
+	StopRenderBandWorkers();
+
+	//Delete all allocated render band jobs
+	for(std::list<RenderBandJob*>::const_iterator i = renderBandAllocatedJobs.begin(); i != renderBandAllocatedJobs.end(); ++i)
+	{
+		delete *i;
+	}
+}
+
 //----------------------------------------------------------------------------------------
 //Interface version functions
 //----------------------------------------------------------------------------------------
@@ -172,33 +212,15 @@ bool S315_5313::BuildDevice()
 {
 	//Initialize the layer priority lookup table. We use this table to speed up layer
 	//priority selection during rendering.
-	layerPriorityLookupTable.resize(layerPriorityLookupTableSize);
-	for(unsigned int i = 0; i < layerPriorityLookupTableSize; ++i)
-	{
-		//Determine the input layer settings for this table index value
-		bool shadowHighlightEnabled = (i & (1 << 8)) != 0;
-		bool spriteIsShadowOperator = (i & (1 << 7)) != 0;
-		bool spriteIsHighlightOperator = (i & (1 << 6)) != 0;
-		bool foundSpritePixel = (i & (1 << 5)) != 0;
-		bool foundLayerAPixel = (i & (1 << 4)) != 0;
-		bool foundLayerBPixel = (i & (1 << 3)) != 0;
-		bool prioritySprite = (i & (1 << 2)) != 0;
-		bool priorityLayerA = (i & (1 << 1)) != 0;
-		bool priorityLayerB = (i & 1) != 0;
-
-		//Resolve the layer priority for this combination of layer settings
-		unsigned int layerIndex;
-		bool shadow;
-		bool highlight;
-		CalculateLayerPriorityIndex(layerIndex, shadow, highlight, shadowHighlightEnabled, spriteIsShadowOperator, spriteIsHighlightOperator, foundSpritePixel, foundLayerAPixel, foundLayerBPixel, prioritySprite, priorityLayerA, priorityLayerB);
-
-		//Incorporate the shadow and highlight bits into the layer index value
-		layerIndex |= shadow? 1 << 3: 0;
-		layerIndex |= highlight? 1 << 2: 0;
-
-		//Write the combined value to the layer priority lookup table
-		layerPriorityLookupTable[i] = layerIndex;
-	}
+	LayerCompositor::BuildLayerPriorityLookupTable(layerPriorityLookupTable);
+
+	//Select the layer compositor implementation to use for this processor. Any vector
+	//implementation is verified against the layer priority lookup table we've just built
+	//before it's selected.
+	layerCompositor = LayerCompositor::SelectCompositorFunction(layerPriorityLookupTable);
+	LogEntry compositorLogEntry(LogEntry::EventLevel::Debug);
+	compositorLogEntry << L"Selected the " << ((layerCompositor == LayerCompositor::CompositeLayerPixelsAVX2)? L"AVX2": ((layerCompositor == LayerCompositor::CompositeLayerPixelsSSE2)? L"SSE2": L"scalar")) << L" layer compositor";
+	GetDeviceContext()->WriteLogEvent(compositorLogEntry);
 
 	//Register each data source with the generic data access base class
 	bool result = true;
@@ -206,6 +228,8 @@ bool S315_5313::BuildDevice()
 	result &= AddGenericDataInfo((new GenericAccessDataInfo(IS315_5313DataSource::SettingsVideoFixedAspectRatio, IGenericAccessDataValue::DataType::Bool)));
 	result &= AddGenericDataInfo((new GenericAccessDataInfo(IS315_5313DataSource::SettingsVideoShowStatusBar, IGenericAccessDataValue::DataType::Bool)));
 	result &= AddGenericDataInfo((new GenericAccessDataInfo(IS315_5313DataSource::SettingsVideoEnableLineSmoothing, IGenericAccessDataValue::DataType::Bool)));
+	result &= AddGenericDataInfo((new GenericAccessDataInfo(IS315_5313DataSource::SettingsVideoFrameSkip, IGenericAccessDataValue::DataType::UInt))->SetUIntMaxValue(frameSkipMaxCount));
+	result &= AddGenericDataInfo((new GenericAccessDataInfo(IS315_5313DataSource::SettingsVideoFrameSkipAuto, IGenericAccessDataValue::DataType::Bool)));
 	result &= AddGenericDataInfo((new GenericAccessDataInfo(IS315_5313DataSource::SettingsVideoDisableRenderOutput, IGenericAccessDataValue::DataType::Bool)));
 	result &= AddGenericDataInfo((new GenericAccessDataInfo(IS315_5313DataSource::SettingsVideoHighlightRenderPos, IGenericAccessDataValue::DataType::Bool)));
 	result &= AddGenericDataInfo((new GenericAccessDataInfo(IS315_5313DataSource::SettingsVideoEnableSpriteBoxing, IGenericAccessDataValue::DataType::Bool)));
@@ -235,7 +259,9 @@ bool S315_5313::BuildDevice()
 	systemSettingsPage->AddEntry(new GenericAccessGroupDataEntry(IS315_5313DataSource::SettingsVideoSingleBuffering, L"Single Buffering"))
 	                  ->AddEntry(new GenericAccessGroupDataEntry(IS315_5313DataSource::SettingsVideoFixedAspectRatio, L"Fixed Aspect Ratio"))
 	                  ->AddEntry(new GenericAccessGroupDataEntry(IS315_5313DataSource::SettingsVideoShowStatusBar, L"Show Status Bar"))
-	                  ->AddEntry(new GenericAccessGroupDataEntry(IS315_5313DataSource::SettingsVideoEnableLineSmoothing, L"Enable Line Smoothing"));
+	                  ->AddEntry(new GenericAccessGroupDataEntry(IS315_5313DataSource::SettingsVideoEnableLineSmoothing, L"Enable Line Smoothing"))
+	                  ->AddEntry(new GenericAccessGroupDataEntry(IS315_5313DataSource::SettingsVideoFrameSkip, L"Frame Skip"))
+	                  ->AddEntry(new GenericAccessGroupDataEntry(IS315_5313DataSource::SettingsVideoFrameSkipAuto, L"Auto Frame Skip"));
 	result &= AddGenericAccessPage(systemSettingsPage);
 	GenericAccessPage* debugSettingsPage = new GenericAccessPage(L"DebugSettings", L"Debug Settings");
 	debugSettingsPage->AddEntry((new GenericAccessGroup(L"Image Debug"))
@@ -340,6 +366,11 @@ void S315_5313::Initialize()
 		fifoBuffer[i].pendingDataWrite = false;
 	}
 	renderVSRAMCachedRead = 0;
+	renderCompositorCRAMSnapshotStale = true;
+	renderFrameSkipActive = false;
+	renderFrameSkipCount = 0;
+	renderSpriteLineListStale = true;
+	renderSpriteLineListActive = false;
 	readDataAvailable = false;
 	readDataHalfCached = false;
 	dmaFillOperationRunning = false;
@@ -530,6 +561,9 @@ void S315_5313::BeginExecution()
 	vsramTimesliceList.clear();
 	spriteCacheTimesliceList.clear();
 
+	//Start the render band worker threads
+	StartRenderBandWorkers();
+
 	//Start the render worker thread
 	renderThreadActive = true;
 	std::thread renderThread(std::bind(std::mem_fn(&S315_5313::RenderThread), this));
@@ -553,6 +587,9 @@ void S315_5313::SuspendExecution()
 		renderThreadStopped.wait(renderLock);
 	}
 
+	//Suspend the render band worker threads
+	StopRenderBandWorkers();
+
 	//Suspend the DMA worker thread
 	std::unique_lock<std::mutex> workerLock(workerThreadMutex);
 	if(workerThreadActive)
@@ -1778,6 +1815,27 @@ void S315_5313::UpdateInternalState(unsigned int mclkCyclesTarget, bool checkFif
 		}
 	}
 
+	//If a DMA fill or copy operation is the only work waiting on access slots, perform
+	//every step of the operation which falls before the target time in a single pass.
+	//The remaining work to reach the target, if any, is carried out by the normal
+	//update loop below, which steps between each access slot individually. Since an
+	//access to the status register or data port from an external device triggers an
+	//update to the time of that access, per-slot stepping is only ever required here
+	//when the state of the VDP is actually being observed mid-transfer.
+	if(DMAFillCopyBlockAdvanceAllowed(stopWhenFifoEmpty, stopWhenFifoFull, stopWhenFifoNotFull, stopWhenReadDataAvailable, allowAdvancePastCycleTarget))
+	{
+		AdvanceDMAFillCopyBlock(mclkCyclesTarget);
+
+		//Gather some info about the new state
+		dmaOperationWillRun = commandCode.GetBit(5) && (!dmd1 || dmd0 || dmaFillOperationRunning);
+		readOperationWillRun = ValidReadTargetInCommandCode() && !readDataAvailable;
+		writeOperationWillRun = !IsWriteFIFOEmpty();
+
+		//Stop the update process if the DMA operation completing has caused one of the
+		//target states to be reached
+		targetFifoStateReached = TargetProcessorStateReached(stopWhenFifoEmpty, stopWhenFifoFull, stopWhenFifoNotFull, stopWhenReadDataAvailable, stopWhenNoDMAOperationInProgress);
+	}
+
 	//Check if we need to stop at an access slot on the next step
 	bool stopAtAccessSlot = writeOperationWillRun || readOperationWillRun || dmaOperationWillRun;
 
@@ -1822,7 +1880,7 @@ void S315_5313::UpdateInternalState(unsigned int mclkCyclesTarget, bool checkFif
 			if(!IsWriteFIFOFull())
 			{
 				PerformDMATransferOperation();
-				AdvanceDMAState();
+				AdvanceDMAState(1);
 			}
 		}
 
@@ -1832,15 +1890,15 @@ void S315_5313::UpdateInternalState(unsigned int mclkCyclesTarget, bool checkFif
 		//fill once the FIFO returns to an empty state.
 		if(commandCode.GetBit(5) && dmd1 && !dmd0 && dmaFillOperationRunning && IsWriteFIFOEmpty())
 		{
-			PerformDMAFillOperation();
-			AdvanceDMAState();
+			PerformDMAFillOperation(GetProcessorStateMclkCurrent());
+			AdvanceDMAState(1);
 		}
 
 		//Advance a DMA copy operation
 		if(commandCode.GetBit(5) && dmd1 && dmd0)
 		{
-			PerformDMACopyOperation();
-			AdvanceDMAState();
+			PerformDMACopyOperation(GetProcessorStateMclkCurrent());
+			AdvanceDMAState(1);
 		}
 
 		//Perform a VRAM read cache operation
@@ -1871,7 +1929,7 @@ void S315_5313::UpdateInternalState(unsigned int mclkCyclesTarget, bool checkFif
 			//If there is space in the write FIFO to store another write value, empty the
 			//DMA transfer read cache data into the FIFO.
 			PerformDMATransferOperation();
-			AdvanceDMAState();
+			AdvanceDMAState(1);
 		}
 
 		//Update the FIFO full and empty flags in the status register
@@ -2620,7 +2678,7 @@ void S315_5313::PerformFIFOWriteOperation()
 }
 
 //----------------------------------------------------------------------------------------
-void S315_5313::PerformDMACopyOperation()
+void S315_5313::PerformDMACopyOperation(unsigned int mclkTime)
 {
 	//Get the current source address
 	unsigned int sourceAddress = (dmaSourceAddressByte1) | (dmaSourceAddressByte2 << 8);
@@ -2660,7 +2718,7 @@ void S315_5313::PerformDMACopyOperation()
 	//Perform the copy. Note that hardware tests have shown that DMA copy operations
 	//always target VRAM, regardless of the state of CD0-CD3.
 	RAMAccessTarget ramAccessTarget;
-	ramAccessTarget.AccessTime(GetProcessorStateMclkCurrent());
+	ramAccessTarget.AccessTime(mclkTime);
 	unsigned char data;
 	data = vram->Read(sourceAddressByteswapped.GetData(), ramAccessTarget);
 	vram->Write(targetAddressByteswapped.GetData(), data, ramAccessTarget);
@@ -2670,7 +2728,7 @@ void S315_5313::PerformDMACopyOperation()
 }
 
 //----------------------------------------------------------------------------------------
-void S315_5313::PerformDMAFillOperation()
+void S315_5313::PerformDMAFillOperation(unsigned int mclkTime)
 {
 	//##FIX## We need to determine how the VDP knows a write has been made to the data
 	//port. VSRAM and CRAM fill targets grab the next available entry in the FIFO, after
@@ -2783,7 +2841,7 @@ void S315_5313::PerformDMAFillOperation()
 	//##TODO## Test on hardware to determine what happens when the data port is written to
 	//while a DMA fill operation is in progress.
 	RAMAccessTarget ramAccessTarget;
-	ramAccessTarget.AccessTime(GetProcessorStateMclkCurrent());
+	ramAccessTarget.AccessTime(mclkTime);
 	switch(commandCode.GetDataSegment(0, 4))
 	{
 	case 0x01: //??0001 VRAM Write
@@ -2880,12 +2938,174 @@ void S315_5313::PerformDMATransferOperation()
 }
 
 //----------------------------------------------------------------------------------------
-void S315_5313::AdvanceDMAState()
+bool S315_5313::DMAFillCopyBlockAdvanceAllowed(bool stopWhenFifoEmpty, bool stopWhenFifoFull, bool stopWhenFifoNotFull, bool stopWhenReadDataAvailable, bool allowAdvancePastCycleTarget) const
+{
+	//Block advancement is only possible when a DMA fill to VRAM or a DMA copy is the only
+	//operation which will use the access slots. A fill to CRAM or VSRAM is excluded, as
+	//VSRAM contents are sampled by the render read cache at each update step, and these
+	//fills are too short to benefit anyway.
+	bool dmaFillToVRAMWillRun = commandCode.GetBit(5) && dmd1 && !dmd0 && dmaFillOperationRunning && (commandCode.GetDataSegment(0, 4) == 0x01);
+	bool dmaCopyWillRun = commandCode.GetBit(5) && dmd1 && dmd0;
+	if((!dmaFillToVRAMWillRun && !dmaCopyWillRun) || !IsWriteFIFOEmpty() || (ValidReadTargetInCommandCode() && !readDataAvailable))
+	{
+		return false;
+	}
+
+	//The FIFO and read cache state never changes during a block advance, so only a
+	//request to stop when the DMA operation completes can be honoured. Any other stop
+	//condition needs to be evaluated at each individual access slot.
+	if(stopWhenFifoEmpty || stopWhenFifoFull || stopWhenFifoNotFull || stopWhenReadDataAvailable || allowAdvancePastCycleTarget)
+	{
+		return false;
+	}
+
+	//Access slot positions depend on the current screen mode, so if a screen mode
+	//change is waiting to be latched at hblank or vblank, we fall back to the normal
+	//update process.
+	bool hscanSettingsChanged = (screenModeRS0 != screenModeRS0Cached) || (screenModeRS1 != screenModeRS1Cached);
+	bool vscanSettingsChanged = (screenModeV30 != screenModeV30Cached) || (palMode != palModeLineState) || (interlaceEnabled != interlaceEnabledCached);
+	return !hscanSettingsChanged && !vscanSettingsChanged;
+}
+
+//----------------------------------------------------------------------------------------
+//This function performs each step of an active DMA fill or copy operation which falls
+//before the target time, without the full processor state being advanced between each
+//access slot. We first walk the HV counter forward from one access slot to the next to
+//build the list of slot times, stopping at the target time or the end of the DMA
+//operation. The DMA operation is then advanced by that number of steps in a single
+//operation. The address and data for each VRAM write are calculated directly from the
+//step number, and the writes are submitted to VRAM as one block, each stamped with the
+//time of its own access slot, so the resulting VRAM contents are identical to those
+//produced by per-slot stepping. Finally, the processor state is advanced to the last
+//access slot used in a single call, which processes any interrupt and counter events
+//which occurred in between. Access slots which fall exactly on the target time are left
+//for the caller to process.
+//----------------------------------------------------------------------------------------
+void S315_5313::AdvanceDMAFillCopyBlock(unsigned int mclkCyclesTarget)
+{
+	//Obtain the current hscan and vscan settings. We've confirmed no screen mode
+	//changes are pending, so these remain constant for the whole block.
+	const HScanSettings& hscanSettings = GetHScanSettings(screenModeRS0, screenModeRS1);
+	const VScanSettings& vscanSettings = GetVScanSettings(screenModeV30, palMode, interlaceEnabled);
+
+	//Build the list of access slot times before the target time, up to the number of
+	//steps remaining in the DMA operation. Note that a DMA length counter value of 0 is
+	//equivalent to a length of 0x10000.
+	unsigned int stepsRemaining = (dmaLengthCounter == 0)? 0x10000: dmaLengthCounter;
+	unsigned int hcounterCurrent = hcounter.GetData();
+	unsigned int vcounterCurrent = vcounter.GetData();
+	bool oddFlagSet = GetStatusFlagOddInterlaceFrame();
+	unsigned int mclkCurrent = GetProcessorStateMclkCurrent();
+	unsigned int mclkUnused = stateLastUpdateMclkUnused;
+	dmaBlockWriteTimes.clear();
+	while((dmaBlockWriteTimes.size() < stepsRemaining) && (mclkCurrent < mclkCyclesTarget))
+	{
+		//Stop when the next access slot doesn't occur before the target time
+		unsigned int pixelClockTicksBeforeAccessSlot = GetPixelClockTicksUntilNextAccessSlot(hscanSettings, vscanSettings, hcounterCurrent, screenModeRS0, screenModeRS1, displayEnabledCached, vcounterCurrent);
+		unsigned int mclkRemainingCycles;
+		unsigned int pixelClockTicksAvailable = GetPixelClockTicksForMclkTicks(hscanSettings, mclkUnused + (mclkCyclesTarget - mclkCurrent), hcounterCurrent, screenModeRS0, screenModeRS1, mclkRemainingCycles);
+		if(pixelClockTicksBeforeAccessSlot >= pixelClockTicksAvailable)
+		{
+			break;
+		}
+
+		//Advance to the access slot, and record its time
+		mclkCurrent += GetMclkTicksForPixelClockTicks(hscanSettings, pixelClockTicksBeforeAccessSlot, hcounterCurrent, screenModeRS0, screenModeRS1) - mclkUnused;
+		mclkUnused = 0;
+		AdvanceHVCounters(hscanSettings, hcounterCurrent, vscanSettings, interlaceEnabled, oddFlagSet, vcounterCurrent, pixelClockTicksBeforeAccessSlot);
+		dmaBlockWriteTimes.push_back(mclkCurrent);
+	}
+	unsigned int stepCount = (unsigned int)dmaBlockWriteTimes.size();
+	if(stepCount == 0)
+	{
+		return;
+	}
+
+	//Perform every step of the DMA operation which falls within this block
+	if(dmd0)
+	{
+		PerformDMACopyBlock(stepCount);
+	}
+	else
+	{
+		PerformDMAFillBlock(stepCount);
+	}
+	AdvanceDMAState(stepCount);
+
+	//Bring the processor state up to the last access slot we used
+	AdvanceProcessorState(mclkCurrent, false, false);
+}
+
+//----------------------------------------------------------------------------------------
+void S315_5313::PerformDMAFillBlock(unsigned int stepCount)
+{
+	//Latch the fill data, and advance the target address past every step in the block.
+	//Refer to PerformDMAFillOperation for a description of how a DMA fill to VRAM uses
+	//the FIFO entry which triggered it. Note that the target address is incremented
+	//before each write is made.
+	unsigned int fifoLastReadEntry = (fifoNextReadEntry+(fifoBufferSize-1)) % fifoBufferSize;
+	unsigned char fillData = (unsigned char)fifoBuffer[fifoLastReadEntry].dataPortWriteData.GetUpperBits(8);
+	unsigned int firstTargetAddress = fifoBuffer[fifoLastReadEntry].addressRegData.GetData() + autoIncrementData;
+	fifoBuffer[fifoLastReadEntry].addressRegData += stepCount * autoIncrementData;
+	commandAddress += stepCount * autoIncrementData;
+
+	//Build the list of writes for the block
+	dmaBlockWriteAddresses.resize(stepCount);
+	dmaBlockWriteData.resize(stepCount);
+	DMAFillCopyBlock::BuildFillWrites(firstTargetAddress, autoIncrementData, fillData, stepCount, &dmaBlockWriteAddresses[0], &dmaBlockWriteData[0]);
+
+	//Mirror any writes which fall within the sprite attribute table into the sprite
+	//cache, then submit the writes to VRAM.
+	RAMAccessTarget ramAccessTarget;
+	for(unsigned int i = 0; i < stepCount; ++i)
+	{
+		ramAccessTarget.AccessTime(dmaBlockWriteTimes[i]);
+		M5WriteSpriteCache(dmaBlockWriteAddresses[i], fillData, ramAccessTarget);
+	}
+	vram->WriteBlock(stepCount, &dmaBlockWriteAddresses[0], &dmaBlockWriteTimes[0], &dmaBlockWriteData[0]);
+}
+
+//----------------------------------------------------------------------------------------
+void S315_5313::PerformDMACopyBlock(unsigned int stepCount)
+{
+	//Latch the source and target addresses, and advance the target address past every
+	//step in the block. Note that the source address is advanced by AdvanceDMAState.
+	//Refer to PerformDMACopyOperation for a description of how a DMA copy accesses VRAM.
+	unsigned int firstSourceAddress = (dmaSourceAddressByte1) | (dmaSourceAddressByte2 << 8);
+	unsigned int firstTargetAddress = commandAddress.GetData();
+	commandAddress += stepCount * autoIncrementData;
+
+	//Read the source data for each step. Any source byte which is written earlier in the
+	//same block is replaced with the written value when the writes are built below.
+	dmaBlockReadAddresses.resize(stepCount);
+	dmaBlockReadData.resize(stepCount);
+	DMAFillCopyBlock::BuildCopyReadAddresses(firstSourceAddress, stepCount, &dmaBlockReadAddresses[0]);
+	RAMAccessTarget ramAccessTarget;
+	for(unsigned int i = 0; i < stepCount; ++i)
+	{
+		ramAccessTarget.AccessTime(dmaBlockWriteTimes[i]);
+		dmaBlockReadData[i] = vram->Read(dmaBlockReadAddresses[i], ramAccessTarget);
+	}
+
+	//Build the list of writes for the block, and submit them to VRAM
+	if(dmaBlockLatestWriteIndex.size() < DMAFillCopyBlock::vramSize)
+	{
+		dmaBlockLatestWriteIndex.assign(DMAFillCopyBlock::vramSize, 0);
+	}
+	dmaBlockWriteAddresses.resize(stepCount);
+	dmaBlockWriteData.resize(stepCount);
+	DMAFillCopyBlock::BuildCopyWrites(firstTargetAddress, autoIncrementData, stepCount, &dmaBlockReadAddresses[0], &dmaBlockReadData[0], &dmaBlockWriteAddresses[0], &dmaBlockWriteData[0], dmaBlockLatestWriteIndex);
+	vram->WriteBlock(stepCount, &dmaBlockWriteAddresses[0], &dmaBlockWriteTimes[0], &dmaBlockWriteData[0]);
+}
+
+//----------------------------------------------------------------------------------------
+void S315_5313::AdvanceDMAState(unsigned int stepCount)
 {
 	//Decrement the DMA transfer count registers. Note that the transfer count is
 	//decremented before it is tested against 0, so a transfer count of 0 is equivalent to
-	//a transfer count of 0x10000.
-	dmaLengthCounter = (dmaLengthCounter - 1) & 0xFFFF;
+	//a transfer count of 0x10000. The caller never advances past the end of the
+	//operation, so the count only reaches 0 on the final step.
+	dmaLengthCounter = (dmaLengthCounter - stepCount) & 0xFFFF;
 
 	//Increment the DMA source address registers. Note that all DMA operations cause the
 	//DMA source address registers to be advanced, including a DMA fill operation, even
@@ -2896,7 +3116,7 @@ void S315_5313::AdvanceDMAState()
 	//transfer operation from crossing a 0x20000 byte boundary. This behaviour is
 	//undocumented but well known, and has been verified through hardware tests.
 	unsigned int incrementedDMASourceAddress = dmaSourceAddressByte1 | (dmaSourceAddressByte2 << 8);
-	++incrementedDMASourceAddress;
+	incrementedDMASourceAddress += stepCount;
 	dmaSourceAddressByte1 = incrementedDMASourceAddress & 0xFF;
 	dmaSourceAddressByte2 = (incrementedDMASourceAddress >> 8) & 0xFF;
 
@@ -3104,31 +3324,45 @@ void S315_5313::M5WriteVRAM8Bit(const Data& address, const Data& data, const RAM
 	tempAddress.SetBit(0, !tempAddress.GetBit(0));
 	unsigned int tempAddressData = tempAddress.GetData();
 
-	//Update the sprite cache if required. The sprite cache is an internal memory buffer
-	//which is designed to maintain a mirror of a portion of the sprite attribute table.
-	//The first 4 bytes of each 8-byte table entry are stored in the cache. Since the
-	//sprite cache is not reloaded when the sprite attribute table address is changed,
-	//correct emulation of the cache is required in order to correctly emulate VDP sprite
-	//support. Level 6-3 of "Castlevania Bloodlines" on the Mega Drive is known to rely on
-	//the sprite cache not being invalidated by a table address change, in order to
-	//implement an "upside down" effect.
-	if((tempAddressData >= spriteAttributeTableBaseAddressDecoded) //Target address is at or above the start of the sprite table
-	&& (tempAddressData < (spriteAttributeTableBaseAddressDecoded + (spriteCacheSize * 2))) //Target address is before the end of the sprite table
-	&& ((tempAddressData & 0x4) == 0)) //Target address is within the first 4 bytes of a sprite table entry
+	//Update the sprite cache if required
+	M5WriteSpriteCache(tempAddressData, (unsigned char)data.GetByteFromBottomUp(0), accessTarget);
+
+	//Write the data
+	vram->Write(tempAddressData, data.GetByteFromBottomUp(0), accessTarget);
+}
+
+//----------------------------------------------------------------------------------------
+void S315_5313::M5WriteSpriteCache(unsigned int vramAddress, unsigned char data, const RAMAccessTarget& accessTarget)
+{
+	//The sprite cache is an internal memory buffer which is designed to maintain a mirror
+	//of a portion of the sprite attribute table. The first 4 bytes of each 8-byte table
+	//entry are stored in the cache. Since the sprite cache is not reloaded when the
+	//sprite attribute table address is changed, correct emulation of the cache is
+	//required in order to correctly emulate VDP sprite support. Level 6-3 of
+	//"Castlevania Bloodlines" on the Mega Drive is known to rely on the sprite cache not
+	//being invalidated by a table address change, in order to implement an "upside down"
+	//effect.
+	if((vramAddress >= spriteAttributeTableBaseAddressDecoded) //Target address is at or above the start of the sprite table
+	&& (vramAddress < (spriteAttributeTableBaseAddressDecoded + (spriteCacheSize * 2))) //Target address is before the end of the sprite table
+	&& ((vramAddress & 0x4) == 0)) //Target address is within the first 4 bytes of a sprite table entry
 	{
 		//Calculate the address of this write in the sprite cache. We first convert the
 		//target address into a relative byte index into the sprite attribute table, then
 		//we strip out bit 2 from the address, to discard addresses in the upper 4 bytes
 		//of each table entry, which we filtered out above.
-		unsigned int spriteCacheAddress = (tempAddressData - spriteAttributeTableBaseAddressDecoded);
+		unsigned int spriteCacheAddress = (vramAddress - spriteAttributeTableBaseAddressDecoded);
 		spriteCacheAddress = ((spriteCacheAddress >> 1) & ~0x3) | (spriteCacheAddress & 0x3);
 
 		//Perform the write to the sprite cache
-		spriteCache->Write(spriteCacheAddress, data.GetByteFromBottomUp(0), accessTarget);
-	}
+		spriteCache->Write(spriteCacheAddress, data, accessTarget);
 
-	//Write the data
-	vram->Write(tempAddressData, data.GetByteFromBottomUp(0), accessTarget);
+		//Flag that the sprite cache has been modified within this timeslice, so that the
+		//render thread knows its sprite line list can't be used while it's rendering it.
+		if(!timesliceRenderInfoListUncommitted.empty())
+		{
+			timesliceRenderInfoListUncommitted.rbegin()->spriteCacheWritten = true;
+		}
+	}
 }
 
 //----------------------------------------------------------------------------------------
@@ -3153,6 +3387,13 @@ void S315_5313::M5WriteCRAM(const Data& address, const Data& data, const RAMAcce
 	//Write the masked data to CRAM
 	cram->Write(tempAddress, tempData.GetByteFromBottomUp(1), accessTarget);
 	cram->Write(tempAddress+1, tempData.GetByteFromBottomUp(0), accessTarget);
+
+	//Flag that CRAM has been modified within this timeslice, so that the render thread
+	//knows its copy of CRAM for the layer compositor needs to be refreshed.
+	if(!timesliceRenderInfoListUncommitted.empty())
+	{
+		timesliceRenderInfoListUncommitted.rbegin()->cramWritten = true;
+	}
 }
 
 //----------------------------------------------------------------------------------------
@@ -3192,11 +3433,9 @@ void S315_5313::M5WriteVSRAM(const Data& address, const Data& data, const RAMAcc
 //----------------------------------------------------------------------------------------
 bool S315_5313::GetScreenshot(IImage& targetImage) const
 {
-	//Determine the index of the current image plane that is being used for display
-	unsigned int displayingImageBufferPlane = GetImageCompletedBufferPlaneNo();
-
-	//Obtain a read lock on the image buffer
-	imageBufferLock[displayingImageBufferPlane].ObtainReadLock();
+	//Acquire the most recently completed image plane
+	unsigned int frameToken;
+	unsigned int displayingImageBufferPlane = AcquireCompletedImageBufferPlane(frameToken);
 
 	//Calculate the width and height of the output image. We take the line width of the
 	//first line as the width of the output image, but it should be noted that the width
@@ -3221,7 +3460,7 @@ bool S315_5313::GetScreenshot(IImage& targetImage) const
 			Image lineImage(lineWidth, 1, IImage::PIXELFORMAT_RGB, IImage::DATAFORMAT_8BIT);
 			for(unsigned int xpos = 0; xpos < lineWidth; ++xpos)
 			{
-				ImageBufferColorEntry& imageBufferEntry = *((ImageBufferColorEntry*)&imageBuffer[drawingImageBufferPlane][((ypos * imageBufferWidth) + xpos) * 4]);
+				ImageBufferColorEntry& imageBufferEntry = *((ImageBufferColorEntry*)&imageBuffer[displayingImageBufferPlane][((ypos * imageBufferWidth) + xpos) * 4]);
 				lineImage.WritePixelData(xpos, ypos, 0, imageBufferEntry.r);
 				lineImage.WritePixelData(xpos, ypos, 1, imageBufferEntry.g);
 				lineImage.WritePixelData(xpos, ypos, 2, imageBufferEntry.b);
@@ -3244,7 +3483,7 @@ bool S315_5313::GetScreenshot(IImage& targetImage) const
 		{
 			for(unsigned int xpos = 0; xpos < imageWidth; ++xpos)
 			{
-				ImageBufferColorEntry& imageBufferEntry = *((ImageBufferColorEntry*)&imageBuffer[drawingImageBufferPlane][((ypos * imageBufferWidth) + xpos) * 4]);
+				ImageBufferColorEntry& imageBufferEntry = *((ImageBufferColorEntry*)&imageBuffer[displayingImageBufferPlane][((ypos * imageBufferWidth) + xpos) * 4]);
 				targetImage.WritePixelData(xpos, ypos, 0, imageBufferEntry.r);
 				targetImage.WritePixelData(xpos, ypos, 1, imageBufferEntry.g);
 				targetImage.WritePixelData(xpos, ypos, 2, imageBufferEntry.b);
@@ -3252,8 +3491,8 @@ bool S315_5313::GetScreenshot(IImage& targetImage) const
 		}
 	}
 
-	//Release the read lock on the image buffer
-	imageBufferLock[displayingImageBufferPlane].ReleaseReadLock();
+	//Release the image plane
+	ReleaseImageBufferPlane(displayingImageBufferPlane);
 
 	return true;
 }
@@ -3496,6 +3735,10 @@ void S315_5313::LoadState(IHierarchicalStorageNode& node)
 		}
 	}
 
+	//Rebuild the sprite line list from the restored sprite cache contents
+	renderSpriteLineListStale = true;
+	renderSpriteLineListActive = false;
+
 	Device::LoadState(node);
 }
 
@@ -3705,10 +3948,19 @@ void S315_5313::LoadSettingsState(IHierarchicalStorageNode& node)
 				else if(registerName == L"VideoFixedAspectRatio")    videoFixedAspectRatio = (*i)->ExtractData<bool>();
 				else if(registerName == L"VideoShowStatusBar")       videoShowStatusBar = (*i)->ExtractData<bool>();
 				else if(registerName == L"VideoEnableLineSmoothing") videoEnableLineSmoothing = (*i)->ExtractData<bool>();
+				else if(registerName == L"VideoFrameSkip")           videoFrameSkip = (*i)->ExtractData<unsigned int>();
+				else if(registerName == L"VideoFrameSkipAuto")       videoFrameSkipAuto = (*i)->ExtractData<bool>();
 			}
 		}
 	}
 
+	//Limit the frame skip count to the range accepted through the data interface, in
+	//case the settings have been edited by hand or saved by a different build.
+	if(videoFrameSkip > frameSkipMaxCount)
+	{
+		videoFrameSkip = frameSkipMaxCount;
+	}
+
 	Device::LoadSettingsState(node);
 }
 
@@ -3719,6 +3971,8 @@ void S315_5313::SaveSettingsState(IHierarchicalStorageNode& node) const
 	node.CreateChild(L"Register", videoFixedAspectRatio).CreateAttribute(L"name", L"VideoFixedAspectRatio");
 	node.CreateChild(L"Register", videoShowStatusBar).CreateAttribute(L"name", L"VideoShowStatusBar");
 	node.CreateChild(L"Register", videoEnableLineSmoothing).CreateAttribute(L"name", L"VideoEnableLineSmoothing");
+	node.CreateChild(L"Register", videoFrameSkip).CreateAttribute(L"name", L"VideoFrameSkip");
+	node.CreateChild(L"Register", videoFrameSkipAuto).CreateAttribute(L"name", L"VideoFrameSkipAuto");
 
 	Device::SaveSettingsState(node);
 }
@@ -4039,6 +4293,10 @@ bool S315_5313::ReadGenericData(unsigned int dataID, const DataContext* dataCont
 		return dataValue.SetValue(videoShowStatusBar);
 	case IS315_5313DataSource::SettingsVideoEnableLineSmoothing:
 		return dataValue.SetValue(videoEnableLineSmoothing);
+	case IS315_5313DataSource::SettingsVideoFrameSkip:
+		return dataValue.SetValue(videoFrameSkip);
+	case IS315_5313DataSource::SettingsVideoFrameSkipAuto:
+		return dataValue.SetValue(videoFrameSkipAuto);
 	case IS315_5313DataSource::SettingsCurrentRenderPosOnScreen:
 		return dataValue.SetValue(currentRenderPosOnScreen);
 	case IS315_5313DataSource::SettingsCurrentRenderPosScreenX:
@@ -4735,6 +4993,16 @@ bool S315_5313::WriteGenericData(unsigned int dataID, const DataContext* dataCon
 		IGenericAccessDataValueBool& dataValueAsBool = (IGenericAccessDataValueBool&)dataValue;
 		videoEnableLineSmoothing = dataValueAsBool.GetValue();
 		return true;}
+	case IS315_5313DataSource::SettingsVideoFrameSkip:{
+		if(dataType != IGenericAccessDataValue::DataType::UInt) return false;
+		IGenericAccessDataValueUInt& dataValueAsUInt = (IGenericAccessDataValueUInt&)dataValue;
+		videoFrameSkip = (dataValueAsUInt.GetValue() > frameSkipMaxCount)? frameSkipMaxCount: dataValueAsUInt.GetValue();
+		return true;}
+	case IS315_5313DataSource::SettingsVideoFrameSkipAuto:{
+		if(dataType != IGenericAccessDataValue::DataType::Bool) return false;
+		IGenericAccessDataValueBool& dataValueAsBool = (IGenericAccessDataValueBool&)dataValue;
+		videoFrameSkipAuto = dataValueAsBool.GetValue();
+		return true;}
 	case IS315_5313DataSource::SettingsCurrentRenderPosOnScreen:{
 		if(dataType != IGenericAccessDataValue::DataType::Bool) return false;
 		IGenericAccessDataValueBool& dataValueAsBool = (IGenericAccessDataValueBool&)dataValue;
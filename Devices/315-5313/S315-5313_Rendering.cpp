@@ -66,8 +66,7 @@ unsigned int S315_5313::GetImageLastRenderedFrameToken() const
 //----------------------------------------------------------------------------------------
 unsigned int S315_5313::GetImageCompletedBufferPlaneNo() const
 {
-	unsigned int displayingImageBufferPlane = videoSingleBuffering? drawingImageBufferPlane: ((drawingImageBufferPlane + imageBufferPlanes) - 1) % imageBufferPlanes;
-	return displayingImageBufferPlane;
+	return imageBufferCompletedPlane;
 }
 
 //----------------------------------------------------------------------------------------
@@ -77,15 +76,33 @@ unsigned int S315_5313::GetImageDrawingBufferPlaneNo() const
 }
 
 //----------------------------------------------------------------------------------------
-void S315_5313::LockImageBufferData(unsigned int planeNo)
+//Completed frames are handed over to consumers without locking. The render thread
+//publishes each completed plane by storing its index in imageBufferCompletedPlane, and
+//consumers register as a reader of a plane before using its contents. When a frame is
+//completed, the render thread only moves on to a plane which isn't the current
+//completed plane and has no registered readers, so it never has to wait on a consumer.
+//A consumer can briefly register on a plane it then fails to acquire, but since it
+//checks the completed plane again after registering, and backs out if it changed, it
+//never reads from a plane the render thread has started drawing into.
+//----------------------------------------------------------------------------------------
+unsigned int S315_5313::AcquireCompletedImageBufferPlane(unsigned int& frameToken) const
 {
-	imageBufferLock[planeNo].ObtainReadLock();
+	unsigned int planeNo = imageBufferCompletedPlane;
+	++imageBufferPlaneReaderCount[planeNo];
+	while(imageBufferCompletedPlane != planeNo)
+	{
+		--imageBufferPlaneReaderCount[planeNo];
+		planeNo = imageBufferCompletedPlane;
+		++imageBufferPlaneReaderCount[planeNo];
+	}
+	frameToken = imageBufferFrameToken[planeNo];
+	return planeNo;
 }
 
 //----------------------------------------------------------------------------------------
-void S315_5313::UnlockImageBufferData(unsigned int planeNo)
+void S315_5313::ReleaseImageBufferPlane(unsigned int planeNo) const
 {
-	imageBufferLock[planeNo].ReleaseReadLock();
+	--imageBufferPlaneReaderCount[planeNo];
 }
 
 //----------------------------------------------------------------------------------------
@@ -95,20 +112,66 @@ const unsigned char* S315_5313::GetImageBufferData(unsigned int planeNo) const
 }
 
 //----------------------------------------------------------------------------------------
-const S315_5313::ImageBufferInfo* S315_5313::GetImageBufferInfo(unsigned int planeNo) const
+void S315_5313::RequestImageBufferInfo(unsigned int posX, unsigned int posY, unsigned int width, unsigned int height)
 {
-	return &imageBufferInfo[planeNo][0];
+	//Clamp the requested region to the bounds of the image buffer
+	posX = (posX > imageBufferWidth)? imageBufferWidth: posX;
+	posY = (posY > imageBufferHeight)? imageBufferHeight: posY;
+	width = (width > (imageBufferWidth - posX))? (imageBufferWidth - posX): width;
+	height = (height > (imageBufferHeight - posY))? (imageBufferHeight - posY): height;
+
+	//Record the requested region. Info will be captured for this region over the next
+	//complete frame which is rendered.
+	std::unique_lock<std::mutex> lock(imageBufferInfoMutex);
+	imageBufferInfoRequested = true;
+	imageBufferInfoRequestPosX = posX;
+	imageBufferInfoRequestPosY = posY;
+	imageBufferInfoRequestWidth = width;
+	imageBufferInfoRequestHeight = height;
 }
 
 //----------------------------------------------------------------------------------------
-const S315_5313::ImageBufferInfo* S315_5313::GetImageBufferInfo(unsigned int planeNo, unsigned int lineNo, unsigned int pixelNo) const
+bool S315_5313::GetImageBufferInfo(unsigned int planeNo, unsigned int lineNo, unsigned int pixelNo, ImageBufferInfo& pixelInfo) const
 {
-	if((lineNo >= imageBufferHeight) || (pixelNo >= imageBufferWidth))
+	//If info hasn't been captured for the target pixel in the target frame, abort any
+	//further processing.
+	std::unique_lock<std::mutex> lock(imageBufferInfoMutex);
+	if(planeNo >= imageBufferPlanes)
 	{
-		return 0;
+		return false;
 	}
-	unsigned int index = (lineNo * imageBufferWidth) + pixelNo;
-	return &imageBufferInfo[planeNo][index];
+	const ImageBufferInfoCapture& capture = imageBufferInfoCapture[planeNo];
+	unsigned int regionPixelNo = pixelNo - capture.regionPosX;
+	unsigned int regionLineNo = lineNo - capture.regionPosY;
+	if(!capture.captureComplete || (regionPixelNo >= capture.regionWidth) || (regionLineNo >= capture.regionHeight))
+	{
+		return false;
+	}
+
+	//Rebuild the pixel info structure from the captured data
+	unsigned int index = (regionLineNo * capture.regionWidth) + regionPixelNo;
+	pixelInfo.pixelSource = (PixelSource)capture.pixelSource[index];
+	pixelInfo.hcounter = capture.hcounter[index];
+	pixelInfo.vcounter = capture.vcounter[index];
+	pixelInfo.paletteRow = capture.paletteRow[index];
+	pixelInfo.paletteEntry = capture.paletteEntry[index];
+	pixelInfo.shadowHighlightEnabled = (capture.shadowHighlightFlags[index] & 0x01) != 0;
+	pixelInfo.pixelIsShadowed = (capture.shadowHighlightFlags[index] & 0x02) != 0;
+	pixelInfo.pixelIsHighlighted = (capture.shadowHighlightFlags[index] & 0x04) != 0;
+	pixelInfo.colorComponentR = capture.colorComponentR[index];
+	pixelInfo.colorComponentG = capture.colorComponentG[index];
+	pixelInfo.colorComponentB = capture.colorComponentB[index];
+	pixelInfo.mappingVRAMAddress = capture.mappingVRAMAddress[index];
+	pixelInfo.mappingData = capture.mappingData[index];
+	pixelInfo.patternRowNo = capture.patternRowNo[index];
+	pixelInfo.patternColumnNo = capture.patternColumnNo[index];
+	pixelInfo.spriteTableEntryNo = capture.spriteTableEntryNo[index];
+	pixelInfo.spriteTableEntryAddress = capture.spriteTableEntryAddress[index];
+	pixelInfo.spriteCellWidth = capture.spriteCellWidth[index];
+	pixelInfo.spriteCellHeight = capture.spriteCellHeight[index];
+	pixelInfo.spriteCellPosX = capture.spriteCellPosX[index];
+	pixelInfo.spriteCellPosY = capture.spriteCellPosY[index];
+	return true;
 }
 
 //----------------------------------------------------------------------------------------
@@ -215,6 +278,17 @@ void S315_5313::RenderThread()
 			continue;
 		}
 
+		//If the sprite cache was written to during this timeslice, the sprite line list
+		//can't be trusted while we render it, since writes will be committed as we go.
+		//Any line being rendered falls back to walking the sprite cache directly, and the
+		//list is rebuilt at the first line which begins after this timeslice.
+		renderSpriteLineListTimesliceWritten = timesliceRenderInfo.spriteCacheWritten;
+		if(renderSpriteLineListTimesliceWritten)
+		{
+			renderSpriteLineListStale = true;
+			renderSpriteLineListActive = false;
+		}
+
 		//Begin advance sessions for each of our timed buffers
 		reg.BeginAdvanceSession(regSession, regTimesliceCopy, false);
 		vram->BeginAdvanceSession(vramSession, vramTimesliceCopy, false);
@@ -260,7 +334,21 @@ void S315_5313::RenderThread()
 			vsram->FreeTimesliceReference(vsramTimesliceCopy);
 			spriteCache->FreeTimesliceReference(spriteCacheTimesliceCopy);
 		}
+
+		//If CRAM was written to during this timeslice, any writes which fell after the
+		//last pixel we rendered have now been committed, so the next layer compositor
+		//block needs to take a new snapshot of CRAM. If CRAM wasn't written to, the
+		//current snapshot is still valid, and the current block can continue into the
+		//next timeslice.
+		if(timesliceRenderInfo.cramWritten)
+		{
+			EndCompositorPixelBlock();
+			renderCompositorCRAMSnapshotStale = true;
+		}
 	}
+
+	//Wait for all pending render bands to be written to the image buffer
+	WaitForRenderBandsComplete();
 	renderThreadStopped.notify_all();
 }
 
@@ -571,6 +659,23 @@ void S315_5313::PerformInternalRenderOperation(const AccessTarget& accessTarget,
 		renderSpriteDisplayCellCacheCurrentIndex = 0;
 		renderSpriteDisplayCacheCurrentIndex = 0;
 
+		//If the sprite cache can't change while this line is being rendered, search for
+		//sprites using the sprite line list rather than walking the sprite cache. The list
+		//is only rebuilt if the contents of the sprite cache or the relevant screen mode
+		//settings have changed since it was last built.
+		renderSpriteLineListActive = false;
+		if(!renderSpriteLineListTimesliceWritten)
+		{
+			bool interlaceMode2Active = renderDigitalInterlaceEnabledActive && renderDigitalInterlaceDoubleActive;
+			if(renderSpriteLineListStale || (renderSpriteLineListInterlaceMode2 != interlaceMode2Active) || (renderSpriteLineListScreenModeRS1 != renderDigitalScreenModeRS1Active))
+			{
+				DigitalRenderBuildSpriteLineList(interlaceMode2Active, renderDigitalScreenModeRS1Active);
+			}
+			renderSpriteLineListActive = true;
+			renderSpriteLineListChainIndex = 0;
+			renderSpriteLineListRowEntryIndex = 0;
+		}
+
 		//Clear the contents of the sprite pixel buffer for this line. Note that most
 		//likely in the real VDP, the analog render process would do this for us as it
 		//pulls sprite data out of the buffer. We don't want to rely on the render process
@@ -594,8 +699,21 @@ void S315_5313::PerformInternalRenderOperation(const AccessTarget& accessTarget,
 		//Determine if interlace mode 2 is currently active
 		bool interlaceMode2Active = renderDigitalInterlaceEnabledActive && renderDigitalInterlaceDoubleActive;
 
-		//Read the next entry out of the sprite cache
-		DigitalRenderBuildSpriteList(renderSpriteNextSpriteRow, interlaceMode2Active, renderDigitalScreenModeRS1Active, renderSpriteNextAttributeTableEntryToRead, renderSpriteSearchComplete, renderSpriteOverflow, renderSpriteDisplayCacheEntryCount, renderSpriteDisplayCache);
+		//Process the next entry in the sprite list. If the screen mode has changed since
+		//the search for this line began, we can't use the sprite line list, and we need
+		//to revert to reading from the sprite cache directly for the rest of the line.
+		if(renderSpriteLineListActive && ((renderSpriteLineListInterlaceMode2 != interlaceMode2Active) || (renderSpriteLineListScreenModeRS1 != renderDigitalScreenModeRS1Active)))
+		{
+			renderSpriteLineListActive = false;
+		}
+		if(renderSpriteLineListActive)
+		{
+			DigitalRenderBuildSpriteListFromLineList(renderSpriteNextSpriteRow, interlaceMode2Active, renderDigitalScreenModeRS1Active, renderSpriteNextAttributeTableEntryToRead, renderSpriteSearchComplete, renderSpriteOverflow, renderSpriteDisplayCacheEntryCount, renderSpriteDisplayCache);
+		}
+		else
+		{
+			DigitalRenderBuildSpriteList(renderSpriteNextSpriteRow, interlaceMode2Active, renderDigitalScreenModeRS1Active, renderSpriteNextAttributeTableEntryToRead, renderSpriteSearchComplete, renderSpriteOverflow, renderSpriteDisplayCacheEntryCount, renderSpriteDisplayCache);
+		}
 		break;}
 	}
 }
@@ -1134,17 +1252,60 @@ void S315_5313::UpdateAnalogRenderProcess(const AccessTarget& accessTarget, cons
 	}
 	else if((renderDigitalHCounterPos == hscanSettings.vcounterIncrementPoint) && (renderDigitalVCounterPos == vscanSettings.vsyncClearedPoint))
 	{
-		//Calculate the image buffer plane to use for the next frame
-		unsigned int newDrawingImageBufferPlane = videoSingleBuffering? drawingImageBufferPlane: (drawingImageBufferPlane + 1) % imageBufferPlanes;
+		//Wait for all pending render bands to be written to the image buffer, so that the
+		//frame we're about to hand over is complete.
+		WaitForRenderBandsComplete();
+
+		//Rebuild the sprite line list at least once per frame. This ensures any changes
+		//made to the sprite cache outside the normal timeslice process, such as from the
+		//debugger, are picked up.
+		renderSpriteLineListStale = true;
+
+		//Select the image buffer plane to use for the next frame. We need a plane which
+		//isn't the current completed plane, and which isn't being read by any consumer.
+		//If every other plane is still in use, we drop the frame we just completed, and
+		//render the next frame into the same plane again, rather than waiting for a
+		//consumer to release a plane. When single buffering is enabled, we always render
+		//into the same plane. If the frame we just completed was skipped, nothing was
+		//written to the plane, so we keep it and don't publish anything.
+		unsigned int newDrawingImageBufferPlane = drawingImageBufferPlane;
+		bool publishCompletedFrame = videoSingleBuffering && !renderFrameSkipActive;
+		if(!videoSingleBuffering && !renderFrameSkipActive)
+		{
+			unsigned int previousCompletedPlane = imageBufferCompletedPlane;
+			for(unsigned int i = 1; i < imageBufferPlanes; ++i)
+			{
+				unsigned int candidatePlane = (drawingImageBufferPlane + i) % imageBufferPlanes;
+				if((candidatePlane != previousCompletedPlane) && (imageBufferPlaneReaderCount[candidatePlane] == 0))
+				{
+					newDrawingImageBufferPlane = candidatePlane;
+					publishCompletedFrame = true;
+					break;
+				}
+			}
+		}
 
-		//Obtain a write lock on the new drawing image buffer plane
-		imageBufferLock[newDrawingImageBufferPlane].ObtainWriteLock();
+		//Now that we've completed another frame, advance the last rendered frame token,
+		//and publish the completed plane to consumers.
+		if(!renderFrameSkipActive)
+		{
+			++lastRenderedFrameToken;
+		}
+		if(publishCompletedFrame)
+		{
+			imageBufferFrameToken[drawingImageBufferPlane] = lastRenderedFrameToken;
+			imageBufferCompletedPlane = drawingImageBufferPlane;
+		}
 
 		//Advance the drawing image buffer to the next plane
 		drawingImageBufferPlane = newDrawingImageBufferPlane;
 
-		//Now that we've completed another frame, advance the last rendered frame token.
-		++lastRenderedFrameToken;
+		//Begin capturing pixel info for the new frame if it has been requested
+		BeginImageBufferInfoCapture(newDrawingImageBufferPlane, publishCompletedFrame);
+
+		//Decide whether pixel output will be skipped for the new frame
+		renderFrameSkipActive = SelectFrameSkipState();
+		renderFrameSkipCount = (renderFrameSkipActive)? renderFrameSkipCount + 1: 0;
 
 		//Record the odd interlace frame flag
 		imageBufferLineCount[drawingImageBufferPlane] = renderDigitalOddFlagSet;
@@ -1159,9 +1320,18 @@ void S315_5313::UpdateAnalogRenderProcess(const AccessTarget& accessTarget, cons
 		//Clear the cache of sprite boundary lines in this frame
 		std::unique_lock<std::mutex> spriteLock(spriteBoundaryMutex[drawingImageBufferPlane]);
 		imageBufferSpriteBoundaryLines[drawingImageBufferPlane].clear();
+	}
 
-		//Release the write lock on the image buffer plane
-		imageBufferLock[newDrawingImageBufferPlane].ReleaseWriteLock();
+	//If pixel output is being skipped for this frame, there's nothing more to do here
+	//other than committing any CRAM writes as they fall due. Note that the digital render
+	//process still runs in full, so the sprite collision and overflow flags are
+	//unaffected. Since the compositor hasn't seen any of these CRAM writes, the next
+	//compositor block needs to take a new snapshot of CRAM.
+	if(renderFrameSkipActive)
+	{
+		cram->AdvanceBySession(renderDigitalMclkCycleProgress, cramSession, cramTimesliceCopy);
+		renderCompositorCRAMSnapshotStale = true;
+		return;
 	}
 
 	//Read the display enable register. If this register is cleared, the output for this
@@ -1182,11 +1352,12 @@ void S315_5313::UpdateAnalogRenderProcess(const AccessTarget& accessTarget, cons
 	//Clean up these comments, and ensure we're not doing anything to affect rendering
 	//based on this register state.
 
-	//Set the initial data for this pixel info entry
+	//If pixel info is being captured for this frame, and this pixel lies within the
+	//requested region, set the initial data for this pixel info entry.
 	ImageBufferInfo* imageBufferInfoEntry = 0;
-	if(videoEnableFullImageBufferInfo && insidePixelBufferRegion)
+	if((renderImageBufferInfoCapture != 0) && insidePixelBufferRegion && ((renderAnalogCurrentPixel - renderImageBufferInfoCapture->regionPosX) < renderImageBufferInfoCapture->regionWidth) && ((renderAnalogCurrentRow - renderImageBufferInfoCapture->regionPosY) < renderImageBufferInfoCapture->regionHeight))
 	{
-		imageBufferInfoEntry = &imageBufferInfo[drawingImageBufferPlane][(renderAnalogCurrentRow * imageBufferWidth) + renderAnalogCurrentPixel];
+		imageBufferInfoEntry = &renderImageBufferInfoEntry;
 		imageBufferInfoEntry->hcounter = renderDigitalHCounterPos;
 		imageBufferInfoEntry->vcounter = renderDigitalVCounterPos;
 		imageBufferInfoEntry->mappingData = 0;
@@ -1199,6 +1370,10 @@ void S315_5313::UpdateAnalogRenderProcess(const AccessTarget& accessTarget, cons
 	bool highlight = false;
 	unsigned int paletteLine = 0;
 	unsigned int paletteIndex = 0;
+	bool compositePixelInBlock = false;
+	unsigned int compositorLayerFlags = 0;
+	unsigned int compositorShadowHighlightEnabled = 0;
+	unsigned int compositorPaletteEntries[4];
 	if(outputNothing)
 	{
 		//If a pixel is being forced to black, we currently don't have anything to do
@@ -1357,7 +1532,7 @@ void S315_5313::UpdateAnalogRenderProcess(const AccessTarget& accessTarget, cons
 		//unsigned int layerIndex;
 		//bool shadow;
 		//bool highlight;
-		//CalculateLayerPriorityIndex(layerIndex, shadow, highlight, shadowHighlightEnabled, spriteIsShadowOperator, spriteIsHighlightOperator, foundSpritePixel, foundLayerAPixel, foundLayerBPixel, prioritySprite, priorityLayerA, priorityLayerB);
+		//LayerCompositor::CalculateLayerPriorityIndex(layerIndex, shadow, highlight, shadowHighlightEnabled, spriteIsShadowOperator, spriteIsHighlightOperator, foundSpritePixel, foundLayerAPixel, foundLayerBPixel, prioritySprite, priorityLayerA, priorityLayerB);
 
 		//Encode the parameters for the layer priority calculation into an index value for
 		//the priority lookup table.
@@ -1372,24 +1547,38 @@ void S315_5313::UpdateAnalogRenderProcess(const AccessTarget& accessTarget, cons
 		priorityIndex |= (unsigned int)layerPriority[LAYERINDEX_LAYERA] << 1;
 		priorityIndex |= (unsigned int)layerPriority[LAYERINDEX_LAYERB];
 
-		//Lookup the pre-calculated layer priority from the lookup table. We use a lookup
-		//table to eliminate branching, which should yield a significant performance
-		//boost.
-		unsigned int layerSelectionResult = layerPriorityLookupTable[priorityIndex];
-
-		//Extract the layer index, shadow, and highlight data from the combined result
-		//returned from the layer priority lookup table.
-		unsigned int layerIndex = layerSelectionResult & 0x03;
-		shadow = (layerSelectionResult & 0x08) != 0;
-		highlight = (layerSelectionResult & 0x04) != 0;
-
-		//Read the palette line and index to use for the selected layer
-		paletteLine = paletteLineData[layerIndex];
-		paletteIndex = paletteIndexData[layerIndex];
-
-		//Record the source layer for this pixel
-		if(imageBufferInfoEntry != 0)
+		//If we're not collecting full pixel info for this pixel, defer the layer priority
+		//calculation to the layer compositor, which resolves the priority for a block of
+		//pixels at once using vector instructions where they're available. The pixel is
+		//added to the pending block once we've handled CRAM write flicker below.
+		if(imageBufferInfoEntry == 0)
 		{
+			compositePixelInBlock = true;
+			compositorLayerFlags = priorityIndex & 0xFF;
+			compositorShadowHighlightEnabled = priorityIndex >> 8;
+			for(unsigned int layerNo = 0; layerNo < 4; ++layerNo)
+			{
+				compositorPaletteEntries[layerNo] = (paletteLineData[layerNo] << 4) | paletteIndexData[layerNo];
+			}
+		}
+		else
+		{
+			//Lookup the pre-calculated layer priority from the lookup table. We use a
+			//lookup table to eliminate branching, which should yield a significant
+			//performance boost.
+			unsigned int layerSelectionResult = layerPriorityLookupTable[priorityIndex];
+
+			//Extract the layer index, shadow, and highlight data from the combined
+			//result returned from the layer priority lookup table.
+			unsigned int layerIndex = layerSelectionResult & 0x03;
+			shadow = (layerSelectionResult & 0x08) != 0;
+			highlight = (layerSelectionResult & 0x04) != 0;
+
+			//Read the palette line and index to use for the selected layer
+			paletteLine = paletteLineData[layerIndex];
+			paletteIndex = paletteIndexData[layerIndex];
+
+			//Record the source layer for this pixel
 			switch(layerIndex)
 			{
 			case LAYERINDEX_SPRITE:
@@ -1446,6 +1635,15 @@ void S315_5313::UpdateAnalogRenderProcess(const AccessTarget& accessTarget, cons
 	//	spritePixelBuffer[renderSpritePixelBufferAnalogRenderPlane][activeScanPixelIndex].entryWritten = false;
 	//}
 
+	//If a CRAM write is about to be committed, close the current layer compositor block,
+	//and flag that the next block needs to take a new snapshot of CRAM. Pending pixels
+	//need to be output using the contents of CRAM at the time they were generated.
+	if(renderDigitalMclkCycleProgress >= cramSession.nextWriteTime)
+	{
+		EndCompositorPixelBlock();
+		renderCompositorCRAMSnapshotStale = true;
+	}
+
 	//##TODO## Write a much longer comment here
 	//##FIX## This comment doesn't actually reflect what we do right now
 	//If a CRAM write has occurred at the same time as we're outputting this next
@@ -1465,6 +1663,7 @@ void S315_5313::UpdateAnalogRenderProcess(const AccessTarget& accessTarget, cons
 	//##TODO## As part of the above, consider solving this issue more permanently, with an
 	//upgrade to our timed buffers to roll writes past the end of a timeslice into the
 	//next timeslice.
+	unsigned int compositorPaletteEntryOverride = compositorNoPaletteEntryOverride;
 	if(cramSession.writeInfo.exists && (cramSession.nextWriteTime <= renderDigitalMclkCycleProgress))
 	{
 		static const unsigned int paletteEntriesPerLine = 16;
@@ -1472,6 +1671,7 @@ void S315_5313::UpdateAnalogRenderProcess(const AccessTarget& accessTarget, cons
 		unsigned int cramWriteAddress = cramSession.writeInfo.writeAddress;
 		paletteLine = (cramWriteAddress / paletteEntrySize) / paletteEntriesPerLine;
 		paletteIndex = (cramWriteAddress / paletteEntrySize) % paletteEntriesPerLine;
+		compositorPaletteEntryOverride = (paletteLine << 4) | paletteIndex;
 
 		//Record the source layer for this pixel
 		if(imageBufferInfoEntry != 0)
@@ -1495,9 +1695,30 @@ void S315_5313::UpdateAnalogRenderProcess(const AccessTarget& accessTarget, cons
 	//same time as this pixel was being drawn, it will now have been committed to CRAM.
 	cram->AdvanceBySession(renderDigitalMclkCycleProgress, cramSession, cramTimesliceCopy);
 
+	//If this pixel is being resolved by the layer compositor, add it to the current
+	//block in the current render band. Note that the palette select bit is latched here,
+	//since hardware tests have shown changes to this register take effect immediately.
+	if(compositePixelInBlock)
+	{
+		CompositorPixelBlock& block = (renderCompositorBlock != 0)? *renderCompositorBlock: BeginCompositorPixelBlock(renderAnalogCurrentRow);
+		unsigned int blockIndex = block.pixelCount++;
+		block.layerFlags[blockIndex] = (unsigned char)compositorLayerFlags;
+		block.shadowHighlightEnabled[blockIndex] = (unsigned char)compositorShadowHighlightEnabled;
+		for(unsigned int layerNo = 0; layerNo < 4; ++layerNo)
+		{
+			block.paletteEntries[(layerNo * compositorBlockPixelCount) + blockIndex] = (unsigned char)compositorPaletteEntries[layerNo];
+		}
+		block.paletteEntryOverride[blockIndex] = (unsigned char)compositorPaletteEntryOverride;
+		block.reducedPalette[blockIndex] = !RegGetPS(accessTarget);
+		block.outputEntry[blockIndex] = (ImageBufferColorEntry*)&imageBuffer[drawingImageBufferPlane][((renderAnalogCurrentRow * imageBufferWidth) + renderAnalogCurrentPixel) * 4];
+		if(block.pixelCount >= compositorBlockPixelCount)
+		{
+			EndCompositorPixelBlock();
+		}
+	}
 	//If we're drawing a pixel which is within the area of the screen we're rendering
 	//pixel data for, output the pixel data to the image buffer.
-	if(insidePixelBufferRegion)
+	else if(insidePixelBufferRegion)
 	{
 		//Constants
 		static const unsigned int paletteEntriesPerLine = 16;
@@ -1571,16 +1792,145 @@ void S315_5313::UpdateAnalogRenderProcess(const AccessTarget& accessTarget, cons
 			imageBufferEntry.a = 0xFF;
 		}
 
-		//Record information on the output colour for this pixel
+		//Record information on the output colour for this pixel, and store the completed
+		//pixel info entry.
 		if(imageBufferInfoEntry != 0)
 		{
 			imageBufferInfoEntry->colorComponentR = colorIntensityR;
 			imageBufferInfoEntry->colorComponentG = colorIntensityG;
 			imageBufferInfoEntry->colorComponentB = colorIntensityB;
+			RecordImageBufferInfo(renderAnalogCurrentRow, renderAnalogCurrentPixel, *imageBufferInfoEntry);
 		}
 	}
 }
 
+//----------------------------------------------------------------------------------------
+bool S315_5313::SelectFrameSkipState() const
+{
+	//Never skip a frame which pixel info has been requested for, otherwise the request
+	//would never be satisfied.
+	if(renderImageBufferInfoCapture != 0)
+	{
+		return false;
+	}
+
+	//If a fixed frame skip count has been set, skip that many frames after each frame we
+	//render.
+	if(renderFrameSkipCount < videoFrameSkip)
+	{
+		return true;
+	}
+
+	//If automatic frame skip is enabled, skip the next frame if the render thread has
+	//fallen behind the execution of the system, using the number of timeslices waiting
+	//to be rendered as a measure of host load. We limit the number of frames which can be
+	//skipped in a row, so that the display is still updated at a reasonable rate.
+	if(videoFrameSkipAuto && (renderFrameSkipCount < frameSkipAutoMaxCount))
+	{
+		std::unique_lock<std::mutex> timesliceLock(timesliceMutex);
+		return (timesliceRenderInfoList.size() > frameSkipAutoPendingTimesliceThreshold);
+	}
+	return false;
+}
+
+//----------------------------------------------------------------------------------------
+void S315_5313::BeginImageBufferInfoCapture(unsigned int planeNo, bool completedFramePublished)
+{
+	std::unique_lock<std::mutex> lock(imageBufferInfoMutex);
+
+	//If we were capturing pixel info for the frame we just completed, and that frame has
+	//been published, flag that the captured info is now complete. If the frame wasn't
+	//published, its plane is about to be drawn over again, so the captured info will
+	//never match a visible frame. In this case we restore the request so that capture
+	//restarts on the new frame. If a newer request arrived while the frame was being
+	//drawn, the request region already holds it, otherwise it still holds the region we
+	//latched for this capture.
+	if(renderImageBufferInfoCapture != 0)
+	{
+		if(completedFramePublished)
+		{
+			renderImageBufferInfoCapture->captureComplete = true;
+		}
+		else
+		{
+			imageBufferInfoRequested = true;
+		}
+		renderImageBufferInfoCapture = 0;
+	}
+
+	//Invalidate any info previously captured for the target image buffer plane
+	ImageBufferInfoCapture& capture = imageBufferInfoCapture[planeNo];
+	capture.captureComplete = false;
+
+	//If no pixel info has been requested since the last frame began, or pixel info
+	//capture is disabled, abort any further processing. Pixel info is only captured for
+	//frames which have been explicitly requested, so that normal rendering never has to
+	//generate it.
+	if(!imageBufferInfoRequested || !videoEnableFullImageBufferInfo)
+	{
+		return;
+	}
+	imageBufferInfoRequested = false;
+
+	//Latch the requested region, and size the capture buffers to match. Note that the
+	//capture buffers only ever grow, so repeated requests for the same region don't
+	//require any further allocations.
+	capture.regionPosX = imageBufferInfoRequestPosX;
+	capture.regionPosY = imageBufferInfoRequestPosY;
+	capture.regionWidth = imageBufferInfoRequestWidth;
+	capture.regionHeight = imageBufferInfoRequestHeight;
+	unsigned int entryCount = capture.regionWidth * capture.regionHeight;
+	if(capture.pixelSource.size() < entryCount)
+	{
+		capture.pixelSource.resize(entryCount);
+		capture.hcounter.resize(entryCount);
+		capture.vcounter.resize(entryCount);
+		capture.paletteRow.resize(entryCount);
+		capture.paletteEntry.resize(entryCount);
+		capture.shadowHighlightFlags.resize(entryCount);
+		capture.colorComponentR.resize(entryCount);
+		capture.colorComponentG.resize(entryCount);
+		capture.colorComponentB.resize(entryCount);
+		capture.mappingVRAMAddress.resize(entryCount);
+		capture.mappingData.resize(entryCount);
+		capture.patternRowNo.resize(entryCount);
+		capture.patternColumnNo.resize(entryCount);
+		capture.spriteTableEntryNo.resize(entryCount);
+		capture.spriteTableEntryAddress.resize(entryCount);
+		capture.spriteCellWidth.resize(entryCount);
+		capture.spriteCellHeight.resize(entryCount);
+		capture.spriteCellPosX.resize(entryCount);
+		capture.spriteCellPosY.resize(entryCount);
+	}
+	renderImageBufferInfoCapture = &capture;
+}
+
+//----------------------------------------------------------------------------------------
+void S315_5313::RecordImageBufferInfo(unsigned int lineNo, unsigned int pixelNo, const ImageBufferInfo& pixelInfo)
+{
+	ImageBufferInfoCapture& capture = *renderImageBufferInfoCapture;
+	unsigned int index = ((lineNo - capture.regionPosY) * capture.regionWidth) + (pixelNo - capture.regionPosX);
+	capture.pixelSource[index] = (unsigned char)pixelInfo.pixelSource;
+	capture.hcounter[index] = (unsigned short)pixelInfo.hcounter;
+	capture.vcounter[index] = (unsigned short)pixelInfo.vcounter;
+	capture.paletteRow[index] = (unsigned char)pixelInfo.paletteRow;
+	capture.paletteEntry[index] = (unsigned char)pixelInfo.paletteEntry;
+	capture.shadowHighlightFlags[index] = (pixelInfo.shadowHighlightEnabled? 0x01: 0x00) | (pixelInfo.pixelIsShadowed? 0x02: 0x00) | (pixelInfo.pixelIsHighlighted? 0x04: 0x00);
+	capture.colorComponentR[index] = (unsigned char)pixelInfo.colorComponentR;
+	capture.colorComponentG[index] = (unsigned char)pixelInfo.colorComponentG;
+	capture.colorComponentB[index] = (unsigned char)pixelInfo.colorComponentB;
+	capture.mappingVRAMAddress[index] = pixelInfo.mappingVRAMAddress;
+	capture.mappingData[index] = (unsigned short)pixelInfo.mappingData.GetData();
+	capture.patternRowNo[index] = (unsigned char)pixelInfo.patternRowNo;
+	capture.patternColumnNo[index] = (unsigned char)pixelInfo.patternColumnNo;
+	capture.spriteTableEntryNo[index] = (unsigned char)pixelInfo.spriteTableEntryNo;
+	capture.spriteTableEntryAddress[index] = pixelInfo.spriteTableEntryAddress;
+	capture.spriteCellWidth[index] = (unsigned char)pixelInfo.spriteCellWidth;
+	capture.spriteCellHeight[index] = (unsigned char)pixelInfo.spriteCellHeight;
+	capture.spriteCellPosX[index] = (unsigned char)pixelInfo.spriteCellPosX;
+	capture.spriteCellPosY[index] = (unsigned char)pixelInfo.spriteCellPosY;
+}
+
 //----------------------------------------------------------------------------------------
 void S315_5313::DigitalRenderReadHscrollData(unsigned int screenRowNumber, unsigned int hscrollDataBase, bool hscrState, bool lscrState, unsigned int& layerAHscrollPatternDisplacement, unsigned int& layerBHscrollPatternDisplacement, unsigned int& layerAHscrollMappingDisplacement, unsigned int& layerBHscrollMappingDisplacement) const
 {
@@ -1949,6 +2299,138 @@ void S315_5313::DigitalRenderBuildSpriteList(unsigned int screenRowNumber, bool
 	}
 }
 
+//----------------------------------------------------------------------------------------
+//The sprite line list holds the result of walking the sprite cache link chain, along
+//with a list for each row in sprite space of the positions in the chain of all sprites
+//which fall on that row. Since the SPRITECACHE render operations visit one link in the
+//chain each, the list can be advanced one chain position per operation, producing
+//exactly the same sprite display cache, sprite count limit and overflow behaviour as
+//walking the sprite cache directly, without needing to re-read and re-test every sprite
+//on every line.
+//----------------------------------------------------------------------------------------
+void S315_5313::DigitalRenderBuildSpriteLineList(bool interlaceMode2Active, bool screenModeRS1Active)
+{
+	static const unsigned int spriteCacheEntrySize = 4;
+	const unsigned int spriteAttributeTableSize = (screenModeRS1Active)? 80: 64;
+	const unsigned int spritePosBitCountV = (interlaceMode2Active)? 10: 9;
+	const unsigned int rowsPerTile = (!interlaceMode2Active)? 8: 16;
+
+	//Remove all entries from the previous list from the row lists
+	for(unsigned int chainIndex = 0; chainIndex < renderSpriteLineListChainLength; ++chainIndex)
+	{
+		const SpriteLineListEntry& entry = renderSpriteLineListChain[chainIndex];
+		for(unsigned int row = entry.firstRow; row < entry.lastRow; ++row)
+		{
+			renderSpriteLineListRows[row].clear();
+		}
+	}
+
+	//Walk the link chain in the sprite cache, in the same order as the sprite search
+	//process, recording each sprite we visit and the rows it covers. Note that the number
+	//of sprites searched per line is limited to the size of the sprite attribute table,
+	//so we stop at that point even if the link data forms a loop.
+	renderSpriteLineListChainLength = 0;
+	unsigned int nextTableEntryToRead = 0;
+	bool spriteSearchComplete = false;
+	while(!spriteSearchComplete && (renderSpriteLineListChainLength < spriteAttributeTableSize))
+	{
+		//Read all available data on the next sprite from the sprite cache
+		unsigned int spriteCacheAddress = (nextTableEntryToRead * spriteCacheEntrySize);
+		SpriteLineListEntry& entry = renderSpriteLineListChain[renderSpriteLineListChainLength];
+		entry.spriteTableIndex = nextTableEntryToRead;
+		entry.vposData = ((unsigned int)spriteCache->ReadCommitted(spriteCacheAddress+0) << 8) | (unsigned int)spriteCache->ReadCommitted(spriteCacheAddress+1);
+		entry.sizeAndLinkData = ((unsigned int)spriteCache->ReadCommitted(spriteCacheAddress+2) << 8) | (unsigned int)spriteCache->ReadCommitted(spriteCacheAddress+3);
+
+		//Calculate the range of rows covered by this sprite. Note that the end position of
+		//the sprite is calculated with the same bit count as the vertical position, so if
+		//the end of the sprite wraps around, the sprite never appears on any row.
+		unsigned int spriteHeightInCells = ((entry.sizeAndLinkData >> 8) & 0x3) + 1;
+		unsigned int spritePosMaskV = (1 << spritePosBitCountV) - 1;
+		entry.vpos = entry.vposData & spritePosMaskV;
+		unsigned int spriteEndPos = entry.vpos + (spriteHeightInCells * rowsPerTile);
+		entry.firstRow = entry.vpos;
+		entry.lastRow = (spriteEndPos > spritePosMaskV)? entry.vpos: spriteEndPos;
+		for(unsigned int row = entry.firstRow; row < entry.lastRow; ++row)
+		{
+			renderSpriteLineListRows[row].push_back(renderSpriteLineListChainLength);
+		}
+		++renderSpriteLineListChainLength;
+
+		//Follow the link data to the next sprite
+		nextTableEntryToRead = entry.sizeAndLinkData & 0x7F;
+		spriteSearchComplete = (nextTableEntryToRead == 0) || (nextTableEntryToRead >= spriteAttributeTableSize);
+	}
+
+	//Record the settings this list was built for
+	renderSpriteLineListInterlaceMode2 = interlaceMode2Active;
+	renderSpriteLineListScreenModeRS1 = screenModeRS1Active;
+	renderSpriteLineListStale = false;
+}
+
+//----------------------------------------------------------------------------------------
+void S315_5313::DigitalRenderBuildSpriteListFromLineList(unsigned int screenRowNumber, bool interlaceMode2Active, bool screenModeRS1Active, unsigned int& nextTableEntryToRead, bool& spriteSearchComplete, bool& spriteOverflow, unsigned int& spriteDisplayCacheEntryCount, std::vector<SpriteDisplayCacheEntry>& spriteDisplayCache)
+{
+	if(!spriteSearchComplete && !spriteOverflow)
+	{
+		const unsigned int spriteAttributeTableSize = (screenModeRS1Active)? 80: 64;
+		const unsigned int spritePosScreenStartV = (interlaceMode2Active)? 0x100: 0x80;
+		const unsigned int renderSpriteDisplayCacheSize = (screenModeRS1Active)? 20: 16;
+
+		//If we've somehow run past the end of the list, revert to reading from the
+		//sprite cache directly.
+		if(renderSpriteLineListChainIndex >= renderSpriteLineListChainLength)
+		{
+			renderSpriteLineListActive = false;
+			DigitalRenderBuildSpriteList(screenRowNumber, interlaceMode2Active, screenModeRS1Active, nextTableEntryToRead, spriteSearchComplete, spriteOverflow, spriteDisplayCacheEntryCount, spriteDisplayCache);
+			return;
+		}
+
+		//Calculate the relative position of the current active display line in sprite
+		//space. See DigitalRenderBuildSpriteList for further info.
+		unsigned int currentScreenRowInSpriteSpace = screenRowNumber + spritePosScreenStartV;
+		if(interlaceMode2Active)
+		{
+			currentScreenRowInSpriteSpace = (screenRowNumber * 2) + spritePosScreenStartV;
+			if(renderDigitalOddFlagSet)
+			{
+				currentScreenRowInSpriteSpace += 1;
+			}
+		}
+
+		//If the sprite at the current position in the chain is the next sprite listed for
+		//this row, add it to the list of sprites to display on this line.
+		const SpriteLineListEntry& entry = renderSpriteLineListChain[renderSpriteLineListChainIndex];
+		if(currentScreenRowInSpriteSpace < spriteLineListRowCount)
+		{
+			const std::vector<unsigned int>& rowEntries = renderSpriteLineListRows[currentScreenRowInSpriteSpace];
+			if((renderSpriteLineListRowEntryIndex < rowEntries.size()) && (rowEntries[renderSpriteLineListRowEntryIndex] == renderSpriteLineListChainIndex))
+			{
+				++renderSpriteLineListRowEntryIndex;
+				if(spriteDisplayCacheEntryCount < renderSpriteDisplayCacheSize)
+				{
+					spriteDisplayCache[spriteDisplayCacheEntryCount].spriteTableIndex = entry.spriteTableIndex;
+					spriteDisplayCache[spriteDisplayCacheEntryCount].spriteRowIndex = (currentScreenRowInSpriteSpace - entry.vpos);
+					spriteDisplayCache[spriteDisplayCacheEntryCount].vpos = entry.vposData;
+					spriteDisplayCache[spriteDisplayCacheEntryCount].sizeAndLinkData = entry.sizeAndLinkData;
+					++spriteDisplayCacheEntryCount;
+				}
+				else
+				{
+					spriteOverflow = true;
+				}
+			}
+		}
+
+		//Advance to the next sprite in the chain
+		++renderSpriteLineListChainIndex;
+		nextTableEntryToRead = entry.sizeAndLinkData & 0x7F;
+		if((nextTableEntryToRead == 0) || (nextTableEntryToRead >= spriteAttributeTableSize))
+		{
+			spriteSearchComplete = true;
+		}
+	}
+}
+
 //----------------------------------------------------------------------------------------
 void S315_5313::DigitalRenderBuildSpriteCellList(const HScanSettings& hscanSettings, const VScanSettings& vscanSettings, unsigned int spriteDisplayCacheIndex, unsigned int spriteTableBaseAddress, bool interlaceMode2Active, bool screenModeRS1Active, bool& spriteDotOverflow, SpriteDisplayCacheEntry& spriteDisplayCacheEntry, unsigned int& spriteCellDisplayCacheEntryCount, std::vector<SpriteCellDisplayCacheEntry>& spriteCellDisplayCache) const
 {
@@ -2143,155 +2625,6 @@ unsigned int S315_5313::DigitalRenderReadPixelIndex(const Data& patternRow, bool
 	}
 }
 
-//----------------------------------------------------------------------------------------
-void S315_5313::CalculateLayerPriorityIndex(unsigned int& layerIndex, bool& shadow, bool& highlight, bool shadowHighlightEnabled, bool spriteIsShadowOperator, bool spriteIsHighlightOperator, bool foundSpritePixel, bool foundLayerAPixel, bool foundLayerBPixel, bool prioritySprite, bool priorityLayerA, bool priorityLayerB) const
-{
-	//Initialize the shadow/highlight flags
-	shadow = false;
-	highlight = false;
-
-	//Perform layer priority calculations
-	if(!shadowHighlightEnabled)
-	{
-		//Perform standard layer priority calculations
-		if(foundSpritePixel && prioritySprite)
-		{
-			layerIndex = LAYERINDEX_SPRITE;
-		}
-		else if(foundLayerAPixel && priorityLayerA)
-		{
-			layerIndex = LAYERINDEX_LAYERA;
-		}
-		else if(foundLayerBPixel && priorityLayerB)
-		{
-			layerIndex = LAYERINDEX_LAYERB;
-		}
-		else if(foundSpritePixel)
-		{
-			layerIndex = LAYERINDEX_SPRITE;
-		}
-		else if(foundLayerAPixel)
-		{
-			layerIndex = LAYERINDEX_LAYERA;
-		}
-		else if(foundLayerBPixel)
-		{
-			layerIndex = LAYERINDEX_LAYERB;
-		}
-		else
-		{
-			layerIndex = LAYERINDEX_BACKGROUND;
-		}
-	}
-	else
-	{
-		//Perform shadow/highlight mode layer priority calculations. Note that some
-		//illustrations in the official documentation from Sega demonstrating the
-		//behaviour of shadow/highlight mode are incorrect. In particular, the third and
-		//fifth illustrations on page 64 of the "Genesis Software Manual", showing layers
-		//B and A being shadowed when a shadow sprite operator is at a lower priority, are
-		//incorrect. If any layer is above an operator sprite pixel, the sprite operator
-		//is ignored, and the higher priority pixel is output without the sprite operator
-		//being applied. This has been confirmed through hardware tests. All other
-		//illustrations describing the operation of shadow/highlight mode in relation to
-		//layer priority settings appear to be correct.
-		if(foundSpritePixel && prioritySprite && !spriteIsShadowOperator && !spriteIsHighlightOperator)
-		{
-			layerIndex = LAYERINDEX_SPRITE;
-		}
-		else if(foundLayerAPixel && priorityLayerA)
-		{
-			layerIndex = LAYERINDEX_LAYERA;
-			if(prioritySprite && spriteIsShadowOperator)
-			{
-				shadow = true;
-			}
-			else if(prioritySprite && spriteIsHighlightOperator)
-			{
-				highlight = true;
-			}
-		}
-		else if(foundLayerBPixel && priorityLayerB)
-		{
-			layerIndex = LAYERINDEX_LAYERB;
-			if(prioritySprite && spriteIsShadowOperator)
-			{
-				shadow = true;
-			}
-			else if(prioritySprite && spriteIsHighlightOperator)
-			{
-				highlight = true;
-			}
-		}
-		else if(foundSpritePixel && !spriteIsShadowOperator && !spriteIsHighlightOperator)
-		{
-			layerIndex = LAYERINDEX_SPRITE;
-			if(!priorityLayerA && !priorityLayerB)
-			{
-				shadow = true;
-			}
-		}
-		else if(foundLayerAPixel)
-		{
-			layerIndex = LAYERINDEX_LAYERA;
-			if(!priorityLayerA && !priorityLayerB)
-			{
-				shadow = true;
-			}
-			if(spriteIsShadowOperator)
-			{
-				shadow = true;
-			}
-			else if(spriteIsHighlightOperator)
-			{
-				highlight = true;
-			}
-		}
-		else if(foundLayerBPixel)
-		{
-			layerIndex = LAYERINDEX_LAYERB;
-			if(!priorityLayerA && !priorityLayerB)
-			{
-				shadow = true;
-			}
-			if(spriteIsShadowOperator)
-			{
-				shadow = true;
-			}
-			else if(spriteIsHighlightOperator)
-			{
-				highlight = true;
-			}
-		}
-		else
-		{
-			layerIndex = LAYERINDEX_BACKGROUND;
-			if(!priorityLayerA && !priorityLayerB)
-			{
-				shadow = true;
-			}
-			if(spriteIsShadowOperator)
-			{
-				shadow = true;
-			}
-			else if(spriteIsHighlightOperator)
-			{
-				highlight = true;
-			}
-		}
-
-		//If shadow and highlight are both set, they cancel each other out. This is why a
-		//sprite acting as a highlight operator is unable to highlight layer A, B, or the
-		//background, if layers A and B both have their priority bits unset. This has been
-		//confirmed on the hardware.
-		if(shadow && highlight)
-		{
-			shadow = false;
-			highlight = false;
-		}
-	}
-}
-
 //----------------------------------------------------------------------------------------
 unsigned int S315_5313::CalculatePatternDataRowNumber(unsigned int patternRowNumberNoFlip, bool interlaceMode2Active, const Data& mappingData) const
 {
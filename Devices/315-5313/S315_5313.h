@@ -50,6 +50,9 @@ References:
 -http://mamedev.emulab.it/haze/2006/08/09/mirror-mirror/
 \*--------------------------------------------------------------------------------------*/
 #include "IS315_5313.h"
+#include "LayerCompositor.h"
+#include "DMAFillCopyBlock.h"
+#include "HVCounterTiming.h"
 #ifndef __S315_5313_H__
 #define __S315_5313_H__
 #include "Device/Device.pkg"
@@ -61,12 +64,15 @@ References:
 #include <map>
 #include <mutex>
 #include <condition_variable>
+#include <thread>
+#include <atomic>
 
-class S315_5313 :public Device, public GenericAccessBase<IS315_5313>
+class S315_5313 :public Device, public GenericAccessBase<IS315_5313>, private HVCounterTiming
 {
 public:
 	//Constructors
 	S315_5313(const std::wstring& aimplementationName, const std::wstring& ainstanceName, unsigned int amoduleID);
+	~S315_5313();
 
 	//Interface version functions
 	virtual unsigned int GetIS315_5313Version() const;
@@ -163,10 +169,9 @@ private:
 	enum class AccessContext;
 
 	//Structures
-	struct HScanSettings;
-	struct VScanSettings;
 	struct TimesliceRenderInfo;
 	struct SpriteDisplayCacheEntry;
+	struct SpriteLineListEntry;
 	struct SpriteCellDisplayCacheEntry;
 	struct SpritePixelBufferEntry;
 	struct VRAMRenderOp;
@@ -174,11 +179,15 @@ private:
 	struct FIFOBufferEntry;
 	struct HVCounterAdvanceSession;
 	struct ImageBufferColorEntry;
+	struct CompositorPixelBlock;
+	struct RenderBandJob;
+	struct ImageBufferInfoCapture;
 
 	//Typedefs
 	typedef RandomTimeAccessBuffer<Data, unsigned int> RegBuffer;
 	typedef RegBuffer::AccessTarget AccessTarget;
 	typedef ITimedBufferInt::AccessTarget RAMAccessTarget;
+	typedef LayerCompositor::CompositorFunction LayerCompositorFunction;
 
 	//Render constants
 	static const unsigned int renderDigitalBlockPixelSizeY = 8;
@@ -197,20 +206,6 @@ private:
 	static const unsigned int hintIPLLineState = 4;
 	static const unsigned int vintIPLLineState = 6;
 
-	//Horizontal scan timing settings
-	static const HScanSettings h32ScanSettingsStatic;
-	static const HScanSettings h40ScanSettingsStatic;
-
-	//Vertical scan timing settings
-	static const VScanSettings v28PalNoIntScanSettingsStatic;
-	static const VScanSettings v28PalIntEnScanSettingsStatic;
-	static const VScanSettings v30PalNoIntScanSettingsStatic;
-	static const VScanSettings v30PalIntEnScanSettingsStatic;
-	static const VScanSettings v28NtscNoIntScanSettingsStatic;
-	static const VScanSettings v28NtscIntEnScanSettingsStatic;
-	static const VScanSettings v30NtscNoIntScanSettingsStatic;
-	static const VScanSettings v30NtscIntEnScanSettingsStatic;
-
 private:
 	//Line functions
 	unsigned int GetNewIPLLineState();
@@ -229,11 +224,11 @@ private:
 	virtual unsigned int GetImageLastRenderedFrameToken() const;
 	virtual unsigned int GetImageCompletedBufferPlaneNo() const;
 	virtual unsigned int GetImageDrawingBufferPlaneNo() const;
-	virtual void LockImageBufferData(unsigned int planeNo);
-	virtual void UnlockImageBufferData(unsigned int planeNo);
+	virtual unsigned int AcquireCompletedImageBufferPlane(unsigned int& frameToken) const;
+	virtual void ReleaseImageBufferPlane(unsigned int planeNo) const;
 	virtual const unsigned char* GetImageBufferData(unsigned int planeNo) const;
-	virtual const ImageBufferInfo* GetImageBufferInfo(unsigned int planeNo) const;
-	virtual const ImageBufferInfo* GetImageBufferInfo(unsigned int planeNo, unsigned int lineNo, unsigned int pixelNo) const;
+	virtual void RequestImageBufferInfo(unsigned int posX, unsigned int posY, unsigned int width, unsigned int height);
+	virtual bool GetImageBufferInfo(unsigned int planeNo, unsigned int lineNo, unsigned int pixelNo, ImageBufferInfo& pixelInfo) const;
 	virtual bool GetImageBufferOddInterlaceFrame(unsigned int planeNo) const;
 	virtual unsigned int GetImageBufferLineCount(unsigned int planeNo) const;
 	virtual unsigned int GetImageBufferLineWidth(unsigned int planeNo, unsigned int lineNo) const;
@@ -250,13 +245,17 @@ private:
 	void PerformInternalRenderOperation(const AccessTarget& accessTarget, const HScanSettings& hscanSettings, const VScanSettings& vscanSettings, const InternalRenderOp& nextOperation, int renderDigitalCurrentRow);
 	void PerformVRAMRenderOperation(const AccessTarget& accessTarget, const HScanSettings& hscanSettings, const VScanSettings& vscanSettings, const VRAMRenderOp& nextOperation, int renderDigitalCurrentRow);
 	void UpdateAnalogRenderProcess(const AccessTarget& accessTarget, const HScanSettings& hscanSettings, const VScanSettings& vscanSettings);
+	void BeginImageBufferInfoCapture(unsigned int planeNo, bool completedFramePublished);
+	bool SelectFrameSkipState() const;
+	void RecordImageBufferInfo(unsigned int lineNo, unsigned int pixelNo, const ImageBufferInfo& pixelInfo);
 	virtual void DigitalRenderReadHscrollData(unsigned int screenRowNumber, unsigned int hscrollDataBase, bool hscrState, bool lscrState, unsigned int& layerAHscrollPatternDisplacement, unsigned int& layerBHscrollPatternDisplacement, unsigned int& layerAHscrollMappingDisplacement, unsigned int& layerBHscrollMappingDisplacement) const;
 	virtual void DigitalRenderReadVscrollData(unsigned int screenColumnNumber, unsigned int layerNumber, bool vscrState, bool interlaceMode2Active, unsigned int& layerVscrollPatternDisplacement, unsigned int& layerVscrollMappingDisplacement, Data& vsramReadCache) const;
 	static unsigned int DigitalRenderCalculateMappingVRAMAddess(unsigned int screenRowNumber, unsigned int screenColumnNumber, bool interlaceMode2Active, unsigned int nameTableBaseAddress, unsigned int layerHscrollMappingDisplacement, unsigned int layerVscrollMappingDisplacement, unsigned int layerVscrollPatternDisplacement, unsigned int hszState, unsigned int vszState);
 	void DigitalRenderBuildSpriteList(unsigned int screenRowNumber, bool interlaceMode2Active, bool screenModeRS1Active, unsigned int& nextTableEntryToRead, bool& spriteSearchComplete, bool& spriteOverflow, unsigned int& spriteDisplayCacheEntryCount, std::vector<SpriteDisplayCacheEntry>& spriteDisplayCache) const;
+	void DigitalRenderBuildSpriteLineList(bool interlaceMode2Active, bool screenModeRS1Active);
+	void DigitalRenderBuildSpriteListFromLineList(unsigned int screenRowNumber, bool interlaceMode2Active, bool screenModeRS1Active, unsigned int& nextTableEntryToRead, bool& spriteSearchComplete, bool& spriteOverflow, unsigned int& spriteDisplayCacheEntryCount, std::vector<SpriteDisplayCacheEntry>& spriteDisplayCache);
 	void DigitalRenderBuildSpriteCellList(const HScanSettings& hscanSettings, const VScanSettings& vscanSettings, unsigned int spriteDisplayCacheIndex, unsigned int spriteTableBaseAddress, bool interlaceMode2Active, bool screenModeRS1Active, bool& spriteDotOverflow, SpriteDisplayCacheEntry& spriteDisplayCacheEntry, unsigned int& spriteCellDisplayCacheEntryCount, std::vector<SpriteCellDisplayCacheEntry>& spriteCellDisplayCache) const;
 	unsigned int DigitalRenderReadPixelIndex(const Data& patternRow, bool horizontalFlip, unsigned int pixelIndex) const;
-	void CalculateLayerPriorityIndex(unsigned int& layerIndex, bool& shadow, bool& highlight, bool shadowHighlightEnabled, bool spriteIsShadowOperator, bool spriteIsHighlightOperator, bool foundSpritePixel, bool foundLayerAPixel, bool foundLayerBPixel, bool prioritySprite, bool priorityLayerA, bool priorityLayerB) const;
 	virtual unsigned int CalculatePatternDataRowNumber(unsigned int patternRowNumberNoFlip, bool interlaceMode2Active, const Data& mappingData) const;
 	virtual unsigned int CalculatePatternDataRowAddress(unsigned int patternRowNumber, unsigned int patternCellOffset, bool interlaceMode2Active, const Data& mappingData) const;
 	virtual void CalculateEffectiveCellScrollSize(unsigned int hszState, unsigned int vszState, unsigned int& effectiveScrollWidth, unsigned int& effectiveScrollHeight) const;
@@ -264,6 +263,16 @@ private:
 	virtual unsigned char ColorValueTo8BitValue(unsigned int colorValue, bool shadow, bool highlight) const;
 	virtual MarshalSupport::Marshal::Ret<std::list<SpriteBoundaryLineEntry>> GetSpriteBoundaryLines(unsigned int planeNo) const;
 
+	//Render band functions
+	void StartRenderBandWorkers();
+	void StopRenderBandWorkers();
+	void RenderBandWorkerThread();
+	CompositorPixelBlock& BeginCompositorPixelBlock(unsigned int currentRow);
+	void EndCompositorPixelBlock();
+	void SubmitRenderBand();
+	void WaitForRenderBandsComplete();
+	void CompositeRenderBand(const RenderBandJob& renderBandJob) const;
+
 	//Sprite list debugging functions
 	virtual SpriteMappingTableEntry GetSpriteMappingTableEntry(unsigned int spriteTableBaseAddress, unsigned int entryNo) const;
 	virtual void SetSpriteMappingTableEntry(unsigned int spriteTableBaseAddress, unsigned int entryNo, const SpriteMappingTableEntry& entry, bool useSeparatedData);
@@ -293,30 +302,9 @@ private:
 	virtual void ClearPortMonitorLog();
 	void RecordPortMonitorEntry(const PortMonitorEntry& entry);
 
-	//HV counter internal/linear conversion
-	static unsigned int HCounterValueFromVDPInternalToLinear(const HScanSettings& hscanSettings, unsigned int hcounterCurrent);
-	static unsigned int VCounterValueFromVDPInternalToLinear(const VScanSettings& vscanSettings, unsigned int vcounterCurrent, bool oddFlagSet);
-	static unsigned int HCounterValueFromLinearToVDPInternal(const HScanSettings& hscanSettings, unsigned int hcounterCurrent);
-	static unsigned int VCounterValueFromLinearToVDPInternal(const VScanSettings& vscanSettings, unsigned int vcounterCurrent, bool oddFlagSet);
-
-	//Video scan settings functions
-	//##TODO## Consider removing the RS0 parameter here. We only need the RS1 bit.
-	static const HScanSettings& GetHScanSettings(bool screenModeRS0Active, bool screenModeRS1Active);
-	static const VScanSettings& GetVScanSettings(bool screenModeV30Active, bool palModeActive, bool interlaceActive);
-
-	//HV counter comparison functions
-	static bool EventOccursWithinCounterRange(const HScanSettings& hscanSettings, unsigned int hcounterStart, unsigned int vcounterStart, unsigned int hcounterEnd, unsigned int vcounterEnd, unsigned int hcounterEventPos, unsigned int vcounterEventPos);
-	static unsigned int GetPixelClockStepsBetweenHVCounterValues(bool advanceIfValuesMatch, const HScanSettings& hscanSettings, unsigned int hcounterCurrent, unsigned int hcounterTarget, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool oddFlagSet, unsigned int vcounterCurrent, unsigned int vcounterTarget);
-	static unsigned int GetPixelClockStepsBetweenHCounterValues(const HScanSettings& hscanSettings, unsigned int hcounterCurrent, unsigned int hcounterTarget);
-	static unsigned int GetPixelClockStepsBetweenVCounterValues(const HScanSettings& hscanSettings, unsigned int hcounterCurrent, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool oddFlagSet, unsigned int vcounterCurrent, unsigned int vcounterTarget);
-
 	//HV counter advancement functions
 	void BeginHVCounterAdvanceSessionFromCurrentState(HVCounterAdvanceSession& advanceSession);
 	static bool AdvanceHVCounterSession(HVCounterAdvanceSession& advanceSession, unsigned int hcounterTarget, unsigned int vcounterTarget, bool advanceIfValuesMatch);
-	static unsigned int AddStepsToHCounter(const HScanSettings& hscanSettings, unsigned int hcounterCurrent, unsigned int hcounterStepsToAdd);
-	static unsigned int AddStepsToVCounter(const HScanSettings& hscanSettings, unsigned int hcounterCurrent, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool oddFlagSet, unsigned int vcounterCurrent, unsigned int vcounterStepsToAdd);
-	static void AdvanceHVCounters(const HScanSettings& hscanSettings, unsigned int& hcounterCurrent, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool& oddFlagSet, unsigned int& vcounterCurrent, unsigned int pixelClockSteps);
-	static void AdvanceHVCountersOneStep(const HScanSettings& hscanSettings, unsigned int& hcounterCurrent, const VScanSettings& vscanSettings, bool interlaceIsEnabled, bool& oddFlagSet, unsigned int& vcounterCurrent);
 
 	//Pixel clock functions
 	//##TODO## Move these functions somewhere more appropriate
@@ -335,11 +323,15 @@ private:
 	bool AdvanceProcessorState(unsigned int mclkCyclesTarget, bool stopAtNextAccessSlot, bool allowAdvancePastTargetForAccessSlot);
 	void PerformReadCacheOperation();
 	void PerformFIFOWriteOperation();
-	void PerformDMACopyOperation();
-	void PerformDMAFillOperation();
+	void PerformDMACopyOperation(unsigned int mclkTime);
+	void PerformDMAFillOperation(unsigned int mclkTime);
+	bool DMAFillCopyBlockAdvanceAllowed(bool stopWhenFifoEmpty, bool stopWhenFifoFull, bool stopWhenFifoNotFull, bool stopWhenReadDataAvailable, bool allowAdvancePastCycleTarget) const;
+	void AdvanceDMAFillCopyBlock(unsigned int mclkCyclesTarget);
+	void PerformDMAFillBlock(unsigned int stepCount);
+	void PerformDMACopyBlock(unsigned int stepCount);
 	void CacheDMATransferReadData(unsigned int mclkTime);
 	void PerformDMATransferOperation();
-	void AdvanceDMAState();
+	void AdvanceDMAState(unsigned int stepCount);
 	bool TargetProcessorStateReached(bool stopWhenFifoEmpty, bool stopWhenFifoFull, bool stopWhenFifoNotFull, bool stopWhenReadDataAvailable, bool stopWhenNoDMAOperationInProgress);
 	double GetProcessorStateTime() const;
 	unsigned int GetProcessorStateMclkCurrent() const;
@@ -356,6 +348,7 @@ private:
 	void M5ReadCRAM(const Data& address, Data& data, const RAMAccessTarget& accessTarget);
 	void M5ReadVSRAM(const Data& address, Data& data, const RAMAccessTarget& accessTarget);
 	void M5WriteVRAM8Bit(const Data& address, const Data& data, const RAMAccessTarget& accessTarget);
+	void M5WriteSpriteCache(unsigned int vramAddress, unsigned char data, const RAMAccessTarget& accessTarget);
 	void M5WriteCRAM(const Data& address, const Data& data, const RAMAccessTarget& accessTarget);
 	void M5WriteVSRAM(const Data& address, const Data& data, const RAMAccessTarget& accessTarget);
 
@@ -554,6 +547,8 @@ private:
 	volatile bool videoFixedAspectRatio;
 	volatile bool videoShowStatusBar;
 	volatile bool videoEnableLineSmoothing;
+	volatile unsigned int videoFrameSkip;
+	volatile bool videoFrameSkipAuto;
 	volatile bool currentRenderPosOnScreen;
 	volatile unsigned int currentRenderPosScreenX;
 	volatile unsigned int currentRenderPosScreenY;
@@ -809,7 +804,7 @@ private:
 	ITimedBufferInt::AdvanceSession vsramSession;
 	ITimedBufferInt::AdvanceSession spriteCacheSession;
 	unsigned int mclkCycleRenderProgress;
-	static const unsigned int layerPriorityLookupTableSize = 0x200;
+	static const unsigned int layerPriorityLookupTableSize = LayerCompositor::lookupTableSize;
 	std::vector<unsigned int> layerPriorityLookupTable;
 
 	static const unsigned int maxPendingRenderOperationCount = 4;
@@ -836,6 +831,8 @@ private:
 	static const unsigned int maxCellsPerRow = 42;
 	static const unsigned int maxSpriteDisplayCacheSize = 20;
 	static const unsigned int maxSpriteDisplayCellCacheSize = 40;
+	static const unsigned int maxSpriteLineListChainLength = 80;
+	static const unsigned int spriteLineListRowCount = 0x400;
 	static const unsigned int spritePixelBufferSize = maxCellsPerRow*8;
 	static const unsigned int renderSpritePixelBufferPlaneCount = 2;
 	unsigned int renderDigitalHCounterPos;
@@ -873,6 +870,16 @@ private:
 	bool renderSpriteSearchComplete;
 	bool renderSpriteOverflow;
 	unsigned int renderSpriteNextAttributeTableEntryToRead;
+	std::vector<SpriteLineListEntry> renderSpriteLineListChain;
+	unsigned int renderSpriteLineListChainLength;
+	std::vector<std::vector<unsigned int>> renderSpriteLineListRows;
+	bool renderSpriteLineListStale;
+	bool renderSpriteLineListTimesliceWritten;
+	bool renderSpriteLineListInterlaceMode2;
+	bool renderSpriteLineListScreenModeRS1;
+	bool renderSpriteLineListActive;
+	unsigned int renderSpriteLineListChainIndex;
+	unsigned int renderSpriteLineListRowEntryIndex;
 	std::vector<SpriteCellDisplayCacheEntry> renderSpriteDisplayCellCache;
 	unsigned int renderSpriteDisplayCellCacheEntryCount;
 	unsigned int renderSpriteDisplayCellCacheCurrentIndex;
@@ -886,13 +893,52 @@ private:
 	bool renderSpriteCollision;
 	Data renderVSRAMCachedRead;
 
+	//Layer compositor data buffers
+	static const unsigned int compositorBlockPixelCount = LayerCompositor::blockPixelCount;
+	static const unsigned char compositorNoPaletteEntryOverride = 0xFF;
+	LayerCompositorFunction layerCompositor;
+	CompositorPixelBlock* renderCompositorBlock;
+	bool renderCompositorCRAMSnapshotStale;
+
+	//Render band worker properties
+	static const unsigned int renderBandLineCount = 16;
+	static const unsigned int renderBandMaxWorkerCount = 4;
+	std::mutex renderBandMutex;
+	std::condition_variable renderBandWorkerUpdate;
+	std::condition_variable renderBandJobsComplete;
+	bool renderBandWorkersActive;
+	unsigned int renderBandRunningWorkerCount;
+	std::vector<std::thread> renderBandWorkerThreads;
+	unsigned int renderBandOutstandingJobCount;
+	RenderBandJob* renderBandCurrentJob;
+	std::list<RenderBandJob*> renderBandPendingJobs;
+	std::list<RenderBandJob*> renderBandFreeJobs;
+	std::list<RenderBandJob*> renderBandAllocatedJobs;
+
+	//Image buffer info capture properties
+	mutable std::mutex imageBufferInfoMutex;
+	bool imageBufferInfoRequested;
+	unsigned int imageBufferInfoRequestPosX;
+	unsigned int imageBufferInfoRequestPosY;
+	unsigned int imageBufferInfoRequestWidth;
+	unsigned int imageBufferInfoRequestHeight;
+	std::vector<ImageBufferInfoCapture> imageBufferInfoCapture;
+	ImageBufferInfoCapture* renderImageBufferInfoCapture;
+	ImageBufferInfo renderImageBufferInfoEntry;
+
 	//Analog render data buffers
 	mutable std::mutex imageBufferMutex;
 	unsigned int drawingImageBufferPlane;
 	volatile unsigned int lastRenderedFrameToken;
-	mutable ReadWriteLock imageBufferLock[imageBufferPlanes];
+	static const unsigned int frameSkipMaxCount = 9;
+	static const unsigned int frameSkipAutoMaxCount = 4;
+	static const unsigned int frameSkipAutoPendingTimesliceThreshold = 8;
+	bool renderFrameSkipActive;
+	unsigned int renderFrameSkipCount;
+	std::atomic<unsigned int> imageBufferCompletedPlane;
+	mutable std::atomic<unsigned int> imageBufferPlaneReaderCount[imageBufferPlanes];
+	unsigned int imageBufferFrameToken[imageBufferPlanes];
 	unsigned char imageBuffer[imageBufferPlanes][imageBufferHeight * imageBufferWidth * 4];
-	ImageBufferInfo imageBufferInfo[imageBufferPlanes][imageBufferHeight * imageBufferWidth];
 	bool imageBufferOddInterlaceFrame[imageBufferPlanes];
 	unsigned int imageBufferLineCount[imageBufferPlanes];
 	unsigned int imageBufferLineWidth[imageBufferPlanes][imageBufferHeight];
@@ -934,6 +980,14 @@ private:
 	Data bdmaTransferInvalidPortWriteDataCache;
 	volatile bool dmaAdvanceUntilDMAComplete;
 
+	//DMA fill and copy block state
+	std::vector<unsigned int> dmaBlockWriteTimes;
+	std::vector<unsigned int> dmaBlockWriteAddresses;
+	std::vector<unsigned char> dmaBlockWriteData;
+	std::vector<unsigned int> dmaBlockReadAddresses;
+	std::vector<unsigned char> dmaBlockReadData;
+	std::vector<unsigned int> dmaBlockLatestWriteIndex;
+
 	//External interrupt settings
 	bool externalInterruptVideoTriggerPointPending;
 	bool bexternalInterruptVideoTriggerPointPending;
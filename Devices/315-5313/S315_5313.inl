@@ -38,10 +38,10 @@ enum class S315_5313::ClockID
 //----------------------------------------------------------------------------------------
 enum S315_5313::LayerIndex :unsigned int
 {
-	LAYERINDEX_SPRITE = 0,
-	LAYERINDEX_LAYERA = 1,
-	LAYERINDEX_LAYERB = 2,
-	LAYERINDEX_BACKGROUND = 3
+	LAYERINDEX_SPRITE = LayerCompositor::LAYERINDEX_SPRITE,
+	LAYERINDEX_LAYERA = LayerCompositor::LAYERINDEX_LAYERA,
+	LAYERINDEX_LAYERB = LayerCompositor::LAYERINDEX_LAYERB,
+	LAYERINDEX_BACKGROUND = LayerCompositor::LAYERINDEX_BACKGROUND
 };
 
 //----------------------------------------------------------------------------------------
@@ -57,190 +57,20 @@ enum class S315_5313::AccessContext
 
 //----------------------------------------------------------------------------------------
 //Structures
-//----------------------------------------------------------------------------------------
-struct S315_5313::HScanSettings
-{
-	HScanSettings(unsigned int ahcounterActiveScanMaxValue,
-	              unsigned int ahcounterBlankingInitialValue,
-	              unsigned int avcounterIncrementPoint,
-	              unsigned int ahblankSetPoint,
-	              unsigned int ahblankClearedPoint,
-	              unsigned int afflagSetPoint,
-	              unsigned int aoddFlagTogglePoint,
-	              unsigned int ahcounterMaxValue,
-	              unsigned int avintFlagged,
-	              unsigned int ahsyncAsserted,
-	              unsigned int ahsyncNegated,
-	              unsigned int aactiveDisplayHCounterFirstValue,
-	              unsigned int aactiveDisplayHCounterLastValue,
-	              unsigned int aactiveDisplayPixelCount,
-	              unsigned int aleftBorderHCounterFirstValue,
-	              unsigned int aleftBorderHCounterLastValue,
-	              unsigned int aleftBorderPixelCount,
-	              unsigned int arightBorderHCounterFirstValue,
-	              unsigned int arightBorderHCounterLastValue,
-	              unsigned int arightBorderPixelCount,
-	              unsigned int aleftBlankingHCounterFirstValue,
-	              unsigned int aleftBlankingHCounterLastValue,
-	              unsigned int aleftBlankingPixelCount,
-	              unsigned int arightBlankingHCounterFirstValue,
-	              unsigned int arightBlankingHCounterLastValue,
-	              unsigned int arightBlankingPixelCount)
-	:hcounterActiveScanMaxValue(ahcounterActiveScanMaxValue),
-	 hcounterBlankingInitialValue(ahcounterBlankingInitialValue),
-	 vcounterIncrementPoint(avcounterIncrementPoint),
-	 hblankSetPoint(ahblankSetPoint),
-	 hblankClearedPoint(ahblankClearedPoint),
-	 fflagSetPoint(afflagSetPoint),
-	 oddFlagTogglePoint(aoddFlagTogglePoint),
-	 hcounterMaxValue(ahcounterMaxValue),
-	 vintFlagged(avintFlagged),
-	 hsyncAsserted(ahsyncAsserted),
-	 hsyncNegated(ahsyncNegated),
-	 activeDisplayHCounterFirstValue(aactiveDisplayHCounterFirstValue),
-	 activeDisplayHCounterLastValue(aactiveDisplayHCounterLastValue),
-	 activeDisplayPixelCount(aactiveDisplayPixelCount),
-	 leftBorderHCounterFirstValue(aleftBorderHCounterFirstValue),
-	 leftBorderHCounterLastValue(aleftBorderHCounterLastValue),
-	 leftBorderPixelCount(aleftBorderPixelCount),
-	 rightBorderHCounterFirstValue(arightBorderHCounterFirstValue),
-	 rightBorderHCounterLastValue(arightBorderHCounterLastValue),
-	 rightBorderPixelCount(arightBorderPixelCount),
-	 leftBlankingHCounterFirstValue(aleftBlankingHCounterFirstValue),
-	 leftBlankingHCounterLastValue(aleftBlankingHCounterLastValue),
-	 leftBlankingPixelCount(aleftBlankingPixelCount),
-	 rightBlankingHCounterFirstValue(arightBlankingHCounterFirstValue),
-	 rightBlankingHCounterLastValue(arightBlankingHCounterLastValue),
-	 rightBlankingPixelCount(arightBlankingPixelCount),
-	 hcounterStepsPerIteration(ahcounterActiveScanMaxValue + 1 + ((ahcounterMaxValue + 1) - ahcounterBlankingInitialValue))
-	{}
-
-	unsigned int hcounterActiveScanMaxValue;
-	unsigned int hcounterBlankingInitialValue;
-	unsigned int vcounterIncrementPoint;
-	unsigned int hblankSetPoint;
-	unsigned int hblankClearedPoint;
-	unsigned int fflagSetPoint;
-	unsigned int oddFlagTogglePoint;
-	unsigned int hcounterMaxValue;
-	unsigned int hcounterStepsPerIteration;
-	unsigned int hintTriggerPoint;
-	unsigned int vintFlagged;
-	unsigned int hsyncAsserted;
-	unsigned int hsyncNegated;
-
-	unsigned int activeDisplayPixelCount;
-	unsigned int leftBorderPixelCount;
-	unsigned int rightBorderPixelCount;
-	unsigned int leftBlankingPixelCount;
-	unsigned int rightBlankingPixelCount;
-	unsigned int activeDisplayHCounterFirstValue;
-	unsigned int activeDisplayHCounterLastValue;
-	unsigned int leftBorderHCounterFirstValue;
-	unsigned int leftBorderHCounterLastValue;
-	unsigned int rightBorderHCounterFirstValue;
-	unsigned int rightBorderHCounterLastValue;
-	unsigned int leftBlankingHCounterFirstValue;
-	unsigned int leftBlankingHCounterLastValue;
-	unsigned int rightBlankingHCounterFirstValue;
-	unsigned int rightBlankingHCounterLastValue;
-};
-
-//----------------------------------------------------------------------------------------
-struct S315_5313::VScanSettings
-{
-	VScanSettings(unsigned int avcounterActiveScanMaxValue,
-	              unsigned int avcounterBlankingInitialValue,
-	              unsigned int avcounterBlankingInitialValueOddFlag,
-	              unsigned int avblankSetPoint,
-	              unsigned int avblankClearedPoint,
-	              unsigned int avcounterMaxValue,
-	              unsigned int avsyncAssertedPoint,
-	              unsigned int avsyncClearedPoint,
-	              unsigned int alinesPerFrame,
-	              unsigned int aactiveDisplayVCounterFirstValue,
-	              unsigned int aactiveDisplayVCounterLastValue,
-	              unsigned int aactiveDisplayLineCount,
-	              unsigned int atopBorderVCounterFirstValue,
-	              unsigned int atopBorderVCounterLastValue,
-	              unsigned int atopBorderLineCount,
-	              unsigned int abottomBorderVCounterFirstValue,
-	              unsigned int abottomBorderVCounterLastValue,
-	              unsigned int abottomBorderLineCount,
-	              unsigned int atopBlankingVCounterFirstValue,
-	              unsigned int atopBlankingVCounterLastValue,
-	              unsigned int atopBlankingLineCount,
-	              unsigned int abottomBlankingVCounterFirstValue,
-	              unsigned int abottomBlankingVCounterLastValue,
-	              unsigned int abottomBlankingLineCount)
-	:vcounterActiveScanMaxValue(avcounterActiveScanMaxValue),
-	 vcounterBlankingInitialValue(avcounterBlankingInitialValue),
-	 vcounterBlankingInitialValueOddFlag(avcounterBlankingInitialValueOddFlag),
-	 vblankSetPoint(avblankSetPoint),
-	 vblankClearedPoint(avblankClearedPoint),
-	 vcounterMaxValue(avcounterMaxValue),
-	 vsyncAssertedPoint(avsyncAssertedPoint),
-	 vsyncClearedPoint(avsyncClearedPoint),
-	 linesPerFrame(alinesPerFrame),
-	 activeDisplayVCounterFirstValue(aactiveDisplayVCounterFirstValue),
-	 activeDisplayVCounterLastValue(aactiveDisplayVCounterLastValue),
-	 activeDisplayLineCount(aactiveDisplayLineCount),
-	 topBorderVCounterFirstValue(atopBorderVCounterFirstValue),
-	 topBorderVCounterLastValue(atopBorderVCounterLastValue),
-	 topBorderLineCount(atopBorderLineCount),
-	 bottomBorderVCounterFirstValue(abottomBorderVCounterFirstValue),
-	 bottomBorderVCounterLastValue(abottomBorderVCounterLastValue),
-	 bottomBorderLineCount(abottomBorderLineCount),
-	 topBlankingVCounterFirstValue(atopBlankingVCounterFirstValue),
-	 topBlankingVCounterLastValue(atopBlankingVCounterLastValue),
-	 topBlankingLineCount(atopBlankingLineCount),
-	 bottomBlankingVCounterFirstValue(abottomBlankingVCounterFirstValue),
-	 bottomBlankingVCounterLastValue(abottomBlankingVCounterLastValue),
-	 bottomBlankingLineCount(abottomBlankingLineCount),
-	 vcounterStepsPerIteration(avcounterActiveScanMaxValue + 1 + ((avcounterMaxValue + 1) - avcounterBlankingInitialValue)),
-	 vcounterStepsPerIterationOddFlag(avcounterActiveScanMaxValue + 1 + ((avcounterMaxValue + 1) - avcounterBlankingInitialValueOddFlag))
-	{}
-
-	unsigned int vcounterActiveScanMaxValue;
-	unsigned int vcounterBlankingInitialValue;
-	unsigned int vcounterBlankingInitialValueOddFlag;
-	unsigned int vblankSetPoint;
-	unsigned int vblankClearedPoint;
-	unsigned int vcounterMaxValue;
-	unsigned int vcounterStepsPerIteration;
-	unsigned int vcounterStepsPerIterationOddFlag;
-	unsigned int vsyncAssertedPoint;
-	unsigned int vsyncClearedPoint;
-	unsigned int linesPerFrame;
-
-	unsigned int activeDisplayVCounterFirstValue;
-	unsigned int activeDisplayVCounterLastValue;
-	unsigned int activeDisplayLineCount;
-	unsigned int topBorderVCounterFirstValue;
-	unsigned int topBorderVCounterLastValue;
-	unsigned int topBorderLineCount;
-	unsigned int bottomBorderVCounterFirstValue;
-	unsigned int bottomBorderVCounterLastValue;
-	unsigned int bottomBorderLineCount;
-	unsigned int topBlankingLineCount;
-	unsigned int topBlankingVCounterFirstValue;
-	unsigned int topBlankingVCounterLastValue;
-	unsigned int bottomBlankingLineCount;
-	unsigned int bottomBlankingVCounterFirstValue;
-	unsigned int bottomBlankingVCounterLastValue;
-};
-
 //----------------------------------------------------------------------------------------
 struct S315_5313::TimesliceRenderInfo
 {
 	TimesliceRenderInfo()
+	:spriteCacheWritten(false), cramWritten(false)
 	{}
 	TimesliceRenderInfo(unsigned int atimesliceStartPosition)
-	:timesliceStartPosition(atimesliceStartPosition)
+	:timesliceStartPosition(atimesliceStartPosition), spriteCacheWritten(false), cramWritten(false)
 	{}
 
 	unsigned int timesliceStartPosition;
 	unsigned int timesliceEndPosition;
+	bool spriteCacheWritten;
+	bool cramWritten;
 };
 
 //----------------------------------------------------------------------------------------
@@ -258,6 +88,17 @@ struct S315_5313::SpriteDisplayCacheEntry
 	Data hpos;
 };
 
+//----------------------------------------------------------------------------------------
+struct S315_5313::SpriteLineListEntry
+{
+	unsigned int spriteTableIndex;
+	unsigned int vposData;
+	unsigned int vpos;
+	unsigned int sizeAndLinkData;
+	unsigned int firstRow;
+	unsigned int lastRow;
+};
+
 //----------------------------------------------------------------------------------------
 struct S315_5313::SpriteCellDisplayCacheEntry
 {
@@ -410,6 +251,69 @@ struct S315_5313::ImageBufferColorEntry
 	unsigned char a;
 };
 
+//----------------------------------------------------------------------------------------
+struct S315_5313::CompositorPixelBlock
+{
+	unsigned int pixelCount;
+	unsigned int cramSnapshotIndex;
+	unsigned char layerFlags[compositorBlockPixelCount];
+	unsigned char shadowHighlightEnabled[compositorBlockPixelCount];
+	unsigned char paletteEntries[4 * compositorBlockPixelCount];
+	unsigned char paletteEntryOverride[compositorBlockPixelCount];
+	bool reducedPalette[compositorBlockPixelCount];
+	ImageBufferColorEntry* outputEntry[compositorBlockPixelCount];
+};
+
+//----------------------------------------------------------------------------------------
+struct S315_5313::RenderBandJob
+{
+	RenderBandJob()
+	:firstRow(0), blockCount(0), cramSnapshotCount(0)
+	{}
+
+	unsigned int firstRow;
+	unsigned int blockCount;
+	unsigned int cramSnapshotCount;
+	std::vector<CompositorPixelBlock> blocks;
+	std::vector<unsigned char> cramSnapshots;
+};
+
+//----------------------------------------------------------------------------------------
+struct S315_5313::ImageBufferInfoCapture
+{
+	ImageBufferInfoCapture()
+	:captureComplete(false), regionPosX(0), regionPosY(0), regionWidth(0), regionHeight(0)
+	{}
+
+	bool captureComplete;
+	unsigned int regionPosX;
+	unsigned int regionPosY;
+	unsigned int regionWidth;
+	unsigned int regionHeight;
+
+	std::vector<unsigned char> pixelSource;
+	std::vector<unsigned short> hcounter;
+	std::vector<unsigned short> vcounter;
+	std::vector<unsigned char> paletteRow;
+	std::vector<unsigned char> paletteEntry;
+	std::vector<unsigned char> shadowHighlightFlags;
+	std::vector<unsigned char> colorComponentR;
+	std::vector<unsigned char> colorComponentG;
+	std::vector<unsigned char> colorComponentB;
+
+	std::vector<unsigned int> mappingVRAMAddress;
+	std::vector<unsigned short> mappingData;
+	std::vector<unsigned char> patternRowNo;
+	std::vector<unsigned char> patternColumnNo;
+
+	std::vector<unsigned char> spriteTableEntryNo;
+	std::vector<unsigned int> spriteTableEntryAddress;
+	std::vector<unsigned char> spriteCellWidth;
+	std::vector<unsigned char> spriteCellHeight;
+	std::vector<unsigned char> spriteCellPosX;
+	std::vector<unsigned char> spriteCellPosY;
+};
+
 //----------------------------------------------------------------------------------------
 //Status register functions
 //----------------------------------------------------------------------------------------
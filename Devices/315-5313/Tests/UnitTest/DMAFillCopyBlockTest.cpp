@@ -0,0 +1,227 @@
+#include "catch.hpp"
+#include "DMAFillCopyBlock.h"
+#include <chrono>
+#include <random>
+#include <sstream>
+
+//----------------------------------------------------------------------------------------
+//Reference implementations
+//----------------------------------------------------------------------------------------
+//These functions perform a DMA fill or copy one step at a time, in the same manner as
+//S315_5313::PerformDMAFillOperation and S315_5313::PerformDMACopyOperation, and record
+//each write they make. They act as the oracle for the block functions.
+//----------------------------------------------------------------------------------------
+static void ReferenceFill(std::vector<unsigned char>& vram, unsigned int targetAddress, unsigned int autoIncrement, unsigned char fillData, unsigned int stepCount, std::vector<unsigned int>& writeAddresses)
+{
+	writeAddresses.clear();
+	for(unsigned int i = 0; i < stepCount; ++i)
+	{
+		targetAddress = (targetAddress + autoIncrement) & 0xFFFF;
+		unsigned int targetAddressByteswapped = targetAddress ^ 0x1;
+		vram[targetAddressByteswapped] = fillData;
+		writeAddresses.push_back(targetAddressByteswapped);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+static void ReferenceCopy(std::vector<unsigned char>& vram, unsigned int sourceAddress, unsigned int targetAddress, unsigned int autoIncrement, unsigned int stepCount, std::vector<unsigned int>& writeAddresses)
+{
+	writeAddresses.clear();
+	for(unsigned int i = 0; i < stepCount; ++i)
+	{
+		unsigned int targetAddressByteswapped = targetAddress ^ 0x1;
+		vram[targetAddressByteswapped] = vram[sourceAddress ^ 0x1];
+		writeAddresses.push_back(targetAddressByteswapped);
+		sourceAddress = (sourceAddress + 1) & 0xFFFF;
+		targetAddress = (targetAddress + autoIncrement) & 0xFFFF;
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Block implementations
+//----------------------------------------------------------------------------------------
+static void BlockFill(std::vector<unsigned char>& vram, unsigned int targetAddress, unsigned int autoIncrement, unsigned char fillData, unsigned int stepCount, std::vector<unsigned int>& writeAddresses, std::vector<unsigned char>& writeData)
+{
+	writeAddresses.resize(stepCount);
+	writeData.resize(stepCount);
+	DMAFillCopyBlock::BuildFillWrites(targetAddress + autoIncrement, autoIncrement, fillData, stepCount, &writeAddresses[0], &writeData[0]);
+	for(unsigned int i = 0; i < stepCount; ++i)
+	{
+		vram[writeAddresses[i]] = writeData[i];
+	}
+}
+
+//----------------------------------------------------------------------------------------
+static void BlockCopy(std::vector<unsigned char>& vram, unsigned int sourceAddress, unsigned int targetAddress, unsigned int autoIncrement, unsigned int stepCount, std::vector<unsigned int>& readAddresses, std::vector<unsigned char>& readData, std::vector<unsigned int>& writeAddresses, std::vector<unsigned char>& writeData, std::vector<unsigned int>& latestWriteIndex)
+{
+	readAddresses.resize(stepCount);
+	readData.resize(stepCount);
+	writeAddresses.resize(stepCount);
+	writeData.resize(stepCount);
+	DMAFillCopyBlock::BuildCopyReadAddresses(sourceAddress, stepCount, &readAddresses[0]);
+	for(unsigned int i = 0; i < stepCount; ++i)
+	{
+		readData[i] = vram[readAddresses[i]];
+	}
+	DMAFillCopyBlock::BuildCopyWrites(targetAddress, autoIncrement, stepCount, &readAddresses[0], &readData[0], &writeAddresses[0], &writeData[0], latestWriteIndex);
+	for(unsigned int i = 0; i < stepCount; ++i)
+	{
+		vram[writeAddresses[i]] = writeData[i];
+	}
+}
+
+//----------------------------------------------------------------------------------------
+static void FillRandom(std::mt19937& randomGenerator, std::vector<unsigned char>& vram)
+{
+	std::uniform_int_distribution<unsigned int> byteValue(0, 0xFF);
+	for(unsigned int i = 0; i < (unsigned int)vram.size(); ++i)
+	{
+		vram[i] = (unsigned char)byteValue(randomGenerator);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Tests
+//----------------------------------------------------------------------------------------
+TEST_CASE("DMAFillCopyBlock::BuildFillWrites", "")
+{
+	static const unsigned int autoIncrementValues[] = {0, 1, 2, 3, 0x20, 0x80, 0xFF};
+	std::mt19937 randomGenerator(0x5313);
+	std::uniform_int_distribution<unsigned int> address(0, 0xFFFF);
+	std::uniform_int_distribution<unsigned int> stepCount(1, 0x10000);
+	std::vector<unsigned char> vramReference(DMAFillCopyBlock::vramSize);
+	std::vector<unsigned char> vramBlock(DMAFillCopyBlock::vramSize);
+	std::vector<unsigned int> writeAddressesReference;
+	std::vector<unsigned int> writeAddressesBlock;
+	std::vector<unsigned char> writeData;
+	for(unsigned int runNo = 0; runNo < 200; ++runNo)
+	{
+		unsigned int targetAddress = address(randomGenerator);
+		unsigned int autoIncrement = autoIncrementValues[runNo % (sizeof(autoIncrementValues) / sizeof(autoIncrementValues[0]))];
+		unsigned int steps = ((runNo % 4) == 0)? 0x10000: stepCount(randomGenerator) % 0x800;
+		steps = (steps == 0)? 1: steps;
+		unsigned char fillData = (unsigned char)address(randomGenerator);
+		FillRandom(randomGenerator, vramReference);
+		vramBlock = vramReference;
+
+		ReferenceFill(vramReference, targetAddress, autoIncrement, fillData, steps, writeAddressesReference);
+		BlockFill(vramBlock, targetAddress, autoIncrement, fillData, steps, writeAddressesBlock, writeData);
+		INFO("Run " << runNo << ": target 0x" << std::hex << targetAddress << ", increment 0x" << autoIncrement << ", steps 0x" << steps);
+		REQUIRE(writeAddressesBlock == writeAddressesReference);
+		REQUIRE(vramBlock == vramReference);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+TEST_CASE("DMAFillCopyBlock::BuildCopyWrites", "")
+{
+	static const unsigned int autoIncrementValues[] = {0, 1, 2, 3, 0x20, 0x80, 0xFF};
+	std::mt19937 randomGenerator(0x5313);
+	std::uniform_int_distribution<unsigned int> address(0, 0xFFFF);
+	std::uniform_int_distribution<unsigned int> stepCount(1, 0x800);
+	std::uniform_int_distribution<unsigned int> overlapOffset(0, 8);
+	std::vector<unsigned char> vramReference(DMAFillCopyBlock::vramSize);
+	std::vector<unsigned char> vramBlock(DMAFillCopyBlock::vramSize);
+	std::vector<unsigned int> writeAddressesReference;
+	std::vector<unsigned int> readAddresses;
+	std::vector<unsigned char> readData;
+	std::vector<unsigned int> writeAddressesBlock;
+	std::vector<unsigned char> writeData;
+	std::vector<unsigned int> latestWriteIndex(DMAFillCopyBlock::vramSize, 0);
+
+	SECTION("Separate", "")
+	{
+		for(unsigned int runNo = 0; runNo < 200; ++runNo)
+		{
+			unsigned int sourceAddress = address(randomGenerator);
+			unsigned int targetAddress = address(randomGenerator);
+			unsigned int autoIncrement = autoIncrementValues[runNo % (sizeof(autoIncrementValues) / sizeof(autoIncrementValues[0]))];
+			unsigned int steps = ((runNo % 8) == 0)? 0x10000: stepCount(randomGenerator);
+			FillRandom(randomGenerator, vramReference);
+			vramBlock = vramReference;
+
+			ReferenceCopy(vramReference, sourceAddress, targetAddress, autoIncrement, steps, writeAddressesReference);
+			BlockCopy(vramBlock, sourceAddress, targetAddress, autoIncrement, steps, readAddresses, readData, writeAddressesBlock, writeData, latestWriteIndex);
+			INFO("Run " << runNo << ": source 0x" << std::hex << sourceAddress << ", target 0x" << targetAddress << ", increment 0x" << autoIncrement << ", steps 0x" << steps);
+			REQUIRE(writeAddressesBlock == writeAddressesReference);
+			REQUIRE(vramBlock == vramReference);
+		}
+	}
+	SECTION("Overlapping", "")
+	{
+		//Place the target just before or after the source, so that later steps read back
+		//bytes written by earlier steps in the same block.
+		for(unsigned int runNo = 0; runNo < 400; ++runNo)
+		{
+			unsigned int sourceAddress = address(randomGenerator);
+			unsigned int offset = overlapOffset(randomGenerator);
+			unsigned int targetAddress = ((runNo % 2) == 0)? (sourceAddress + offset) & 0xFFFF: (sourceAddress - offset) & 0xFFFF;
+			unsigned int autoIncrement = autoIncrementValues[runNo % (sizeof(autoIncrementValues) / sizeof(autoIncrementValues[0]))];
+			unsigned int steps = stepCount(randomGenerator);
+			FillRandom(randomGenerator, vramReference);
+			vramBlock = vramReference;
+
+			ReferenceCopy(vramReference, sourceAddress, targetAddress, autoIncrement, steps, writeAddressesReference);
+			BlockCopy(vramBlock, sourceAddress, targetAddress, autoIncrement, steps, readAddresses, readData, writeAddressesBlock, writeData, latestWriteIndex);
+			INFO("Run " << runNo << ": source 0x" << std::hex << sourceAddress << ", target 0x" << targetAddress << ", increment 0x" << autoIncrement << ", steps 0x" << steps);
+			REQUIRE(writeAddressesBlock == writeAddressesReference);
+			REQUIRE(vramBlock == vramReference);
+		}
+	}
+
+	//Confirm the write index buffer has been returned to its initial state
+	REQUIRE(latestWriteIndex == std::vector<unsigned int>(DMAFillCopyBlock::vramSize, 0));
+}
+
+//----------------------------------------------------------------------------------------
+//Benchmarks
+//----------------------------------------------------------------------------------------
+//This benchmark times the block functions against the per-step reference loops above,
+//for a full 0x10000 byte fill and copy. The reference loops write straight into an
+//array, so they're a lower bound on the per-step cost rather than a model of it. In the
+//VDP core each step also goes through the DMA operation functions and a virtual VRAM
+//write under a lock, none of which is included here.
+//----------------------------------------------------------------------------------------
+TEST_CASE("DMAFillCopyBlock benchmark", "[.][benchmark]")
+{
+	static const unsigned int stepCount = 0x10000;
+	static const unsigned int iterationCount = 200;
+	std::mt19937 randomGenerator(0x5313);
+	std::vector<unsigned char> vram(DMAFillCopyBlock::vramSize);
+	FillRandom(randomGenerator, vram);
+	std::vector<unsigned int> readAddresses;
+	std::vector<unsigned char> readData;
+	std::vector<unsigned int> writeAddresses;
+	std::vector<unsigned char> writeData;
+	std::vector<unsigned int> latestWriteIndex(DMAFillCopyBlock::vramSize, 0);
+	writeAddresses.reserve(stepCount);
+
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+	for(unsigned int i = 0; i < iterationCount; ++i)
+	{
+		ReferenceFill(vram, i, 1, (unsigned char)i, stepCount, writeAddresses);
+	}
+	std::chrono::high_resolution_clock::time_point referenceFillEndTime = std::chrono::high_resolution_clock::now();
+	for(unsigned int i = 0; i < iterationCount; ++i)
+	{
+		BlockFill(vram, i, 1, (unsigned char)i, stepCount, writeAddresses, writeData);
+	}
+	std::chrono::high_resolution_clock::time_point blockFillEndTime = std::chrono::high_resolution_clock::now();
+	for(unsigned int i = 0; i < iterationCount; ++i)
+	{
+		ReferenceCopy(vram, i, i + 0x8000, 1, stepCount, writeAddresses);
+	}
+	std::chrono::high_resolution_clock::time_point referenceCopyEndTime = std::chrono::high_resolution_clock::now();
+	for(unsigned int i = 0; i < iterationCount; ++i)
+	{
+		BlockCopy(vram, i, i + 0x8000, 1, stepCount, readAddresses, readData, writeAddresses, writeData, latestWriteIndex);
+	}
+	std::chrono::high_resolution_clock::time_point blockCopyEndTime = std::chrono::high_resolution_clock::now();
+
+	std::stringstream result;
+	result << "Fill per step: " << std::chrono::duration_cast<std::chrono::microseconds>(referenceFillEndTime - startTime).count() / iterationCount << "us, "
+	       << "fill block: " << std::chrono::duration_cast<std::chrono::microseconds>(blockFillEndTime - referenceFillEndTime).count() / iterationCount << "us, "
+	       << "copy per step: " << std::chrono::duration_cast<std::chrono::microseconds>(referenceCopyEndTime - blockFillEndTime).count() / iterationCount << "us, "
+	       << "copy block: " << std::chrono::duration_cast<std::chrono::microseconds>(blockCopyEndTime - referenceCopyEndTime).count() / iterationCount << "us";
+	WARN(result.str());
+}
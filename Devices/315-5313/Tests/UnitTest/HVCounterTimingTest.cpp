@@ -0,0 +1,349 @@
+#include "catch.hpp"
+#include "HVCounterTiming.h"
+#include <chrono>
+#include <random>
+#include <sstream>
+
+//----------------------------------------------------------------------------------------
+//Screen modes
+//----------------------------------------------------------------------------------------
+struct ScanMode
+{
+	const HVCounterTiming::HScanSettings* hscanSettings;
+	const HVCounterTiming::VScanSettings* vscanSettings;
+	bool interlaceIsEnabled;
+	std::string name;
+};
+
+//----------------------------------------------------------------------------------------
+static std::vector<ScanMode> GetScanModes()
+{
+	static const char* hscanNames[] = {"H32", "H40"};
+	static const char* vscanNames[] = {"V28 PAL", "V28 PAL interlaced", "V30 PAL", "V30 PAL interlaced", "V28 NTSC", "V28 NTSC interlaced", "V30 NTSC", "V30 NTSC interlaced"};
+	const HVCounterTiming::HScanSettings* hscanSettings[] = {&HVCounterTiming::h32ScanSettingsStatic, &HVCounterTiming::h40ScanSettingsStatic};
+	const HVCounterTiming::VScanSettings* vscanSettings[] = {&HVCounterTiming::v28PalNoIntScanSettingsStatic, &HVCounterTiming::v28PalIntEnScanSettingsStatic, &HVCounterTiming::v30PalNoIntScanSettingsStatic, &HVCounterTiming::v30PalIntEnScanSettingsStatic, &HVCounterTiming::v28NtscNoIntScanSettingsStatic, &HVCounterTiming::v28NtscIntEnScanSettingsStatic, &HVCounterTiming::v30NtscNoIntScanSettingsStatic, &HVCounterTiming::v30NtscIntEnScanSettingsStatic};
+	std::vector<ScanMode> scanModes;
+	for(unsigned int hscanIndex = 0; hscanIndex < HVCounterTiming::hscanSettingsCount; ++hscanIndex)
+	{
+		for(unsigned int vscanIndex = 0; vscanIndex < HVCounterTiming::vscanSettingsCount; ++vscanIndex)
+		{
+			//Each set of vertical scan settings is tested with interlacing both enabled
+			//and disabled, since the interlace setting is latched separately.
+			for(unsigned int interlaceIndex = 0; interlaceIndex < 2; ++interlaceIndex)
+			{
+				ScanMode scanMode;
+				scanMode.hscanSettings = hscanSettings[hscanIndex];
+				scanMode.vscanSettings = vscanSettings[vscanIndex];
+				scanMode.interlaceIsEnabled = (interlaceIndex != 0);
+				scanMode.name = std::string(hscanNames[hscanIndex]) + " " + vscanNames[vscanIndex] + (scanMode.interlaceIsEnabled? ", interlace enabled": ", interlace disabled");
+				scanModes.push_back(scanMode);
+			}
+		}
+	}
+	return scanModes;
+}
+
+//----------------------------------------------------------------------------------------
+//Helper functions
+//----------------------------------------------------------------------------------------
+static std::string FormatCounters(unsigned int hcounter, unsigned int vcounter, bool oddFlagSet)
+{
+	std::stringstream stream;
+	stream << std::hex << "H=0x" << hcounter << " V=0x" << vcounter << " odd=" << oddFlagSet;
+	return stream.str();
+}
+
+//----------------------------------------------------------------------------------------
+//Returns true if the position is on the line the odd flag is toggled in, but before the
+//toggle point. The calculated form of AdvanceHVCounters treats these positions as being
+//after the toggle point, so they're excluded when comparing against it.
+//----------------------------------------------------------------------------------------
+static bool PositionPrecedesOddFlagToggle(const ScanMode& scanMode, const HVCounterTiming::FrameTable& frameTable, unsigned int hcounter, unsigned int vcounter)
+{
+	return (vcounter == scanMode.vscanSettings->vblankSetPoint) && (frameTable.hcounterToLineOffset[hcounter] < frameTable.oddFlagToggleLineOffset);
+}
+
+//----------------------------------------------------------------------------------------
+//Tests
+//----------------------------------------------------------------------------------------
+//This test steps through every position in every field using AdvanceHVCountersOneStep,
+//and confirms the frame table holds the same counter values at each position, and maps
+//those counter values back to the same position.
+//----------------------------------------------------------------------------------------
+TEST_CASE("HVCounterTiming::GetFrameTable", "")
+{
+	std::vector<ScanMode> scanModes = GetScanModes();
+	for(unsigned int modeNo = 0; modeNo < (unsigned int)scanModes.size(); ++modeNo)
+	{
+		const ScanMode& scanMode = scanModes[modeNo];
+		const HVCounterTiming::FrameTable& frameTable = HVCounterTiming::GetFrameTable(*scanMode.hscanSettings, *scanMode.vscanSettings, scanMode.interlaceIsEnabled);
+		for(unsigned int fieldNo = 0; fieldNo < 2; ++fieldNo)
+		{
+			INFO(scanMode.name << ", field " << fieldNo);
+			unsigned int fieldPixelClockSteps = frameTable.fieldPixelClockSteps[fieldNo];
+			REQUIRE((unsigned int)frameTable.positionToHVCounter[fieldNo].size() == fieldPixelClockSteps);
+			REQUIRE((fieldPixelClockSteps % scanMode.hscanSettings->hcounterStepsPerIteration) == 0);
+
+			bool oddFlagSet = (fieldNo != 0);
+			unsigned int hcounter = scanMode.hscanSettings->oddFlagTogglePoint;
+			unsigned int vcounter = scanMode.vscanSettings->vblankSetPoint;
+			unsigned int mismatchCount = 0;
+			std::string firstMismatch;
+			for(unsigned int position = 0; position < fieldPixelClockSteps; ++position)
+			{
+				unsigned int hvcounter = frameTable.positionToHVCounter[fieldNo][position];
+				unsigned int tablePosition = HVCounterTiming::GetFramePosition(frameTable, hcounter, vcounter, oddFlagSet);
+				if(((hvcounter & 0xFFFF) != hcounter) || ((hvcounter >> 16) != vcounter) || (tablePosition != position))
+				{
+					if(mismatchCount++ == 0)
+					{
+						std::stringstream stream;
+						stream << "position " << position << ": " << FormatCounters(hcounter, vcounter, oddFlagSet);
+						firstMismatch = stream.str();
+					}
+				}
+				HVCounterTiming::AdvanceHVCountersOneStep(*scanMode.hscanSettings, hcounter, *scanMode.vscanSettings, scanMode.interlaceIsEnabled, oddFlagSet, vcounter);
+			}
+			INFO(firstMismatch);
+			REQUIRE(mismatchCount == 0);
+
+			//Confirm the field ends at the next odd flag toggle point
+			REQUIRE(hcounter == scanMode.hscanSettings->oddFlagTogglePoint);
+			REQUIRE(vcounter == scanMode.vscanSettings->vblankSetPoint);
+			REQUIRE(oddFlagSet == (scanMode.interlaceIsEnabled && (fieldNo == 0)));
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------
+TEST_CASE("HVCounterTiming::AdvanceHVCounters", "")
+{
+	std::vector<ScanMode> scanModes = GetScanModes();
+	std::mt19937 randomGenerator(0x5313);
+
+	SECTION("Calculated", "")
+	{
+		//Compare against the calculated form from every position in every field, for
+		//advances which pass at most one odd flag toggle point. The calculated form
+		//doesn't handle advances past a second toggle point, or positions which come just
+		//before the toggle point, as noted above.
+		for(unsigned int modeNo = 0; modeNo < (unsigned int)scanModes.size(); ++modeNo)
+		{
+			const ScanMode& scanMode = scanModes[modeNo];
+			const HVCounterTiming::FrameTable& frameTable = HVCounterTiming::GetFrameTable(*scanMode.hscanSettings, *scanMode.vscanSettings, scanMode.interlaceIsEnabled);
+			unsigned int mismatchCount = 0;
+			unsigned int comparisonCount = 0;
+			std::string firstMismatch;
+			for(unsigned int fieldNo = 0; fieldNo < 2; ++fieldNo)
+			{
+				unsigned int nextFieldNo = (scanMode.interlaceIsEnabled && (fieldNo == 0))? 1: 0;
+				for(unsigned int position = 0; position < frameTable.fieldPixelClockSteps[fieldNo]; ++position)
+				{
+					unsigned int hvcounter = frameTable.positionToHVCounter[fieldNo][position];
+					unsigned int hcounterInitial = hvcounter & 0xFFFF;
+					unsigned int vcounterInitial = hvcounter >> 16;
+					if(PositionPrecedesOddFlagToggle(scanMode, frameTable, hcounterInitial, vcounterInitial))
+					{
+						continue;
+					}
+
+					unsigned int maxPixelClockSteps = (frameTable.fieldPixelClockSteps[fieldNo] - position) + frameTable.fieldPixelClockSteps[nextFieldNo] - 1;
+					std::uniform_int_distribution<unsigned int> pixelClockStepsDistribution(0, maxPixelClockSteps);
+					unsigned int pixelClockStepsList[] = {0, 1, scanMode.hscanSettings->hcounterStepsPerIteration, maxPixelClockSteps, pixelClockStepsDistribution(randomGenerator)};
+					for(unsigned int i = 0; i < (sizeof(pixelClockStepsList) / sizeof(pixelClockStepsList[0])); ++i)
+					{
+						unsigned int hcounterTable = hcounterInitial;
+						unsigned int vcounterTable = vcounterInitial;
+						bool oddFlagSetTable = (fieldNo != 0);
+						HVCounterTiming::AdvanceHVCounters(*scanMode.hscanSettings, hcounterTable, *scanMode.vscanSettings, scanMode.interlaceIsEnabled, oddFlagSetTable, vcounterTable, pixelClockStepsList[i]);
+						unsigned int hcounterCalculated = hcounterInitial;
+						unsigned int vcounterCalculated = vcounterInitial;
+						bool oddFlagSetCalculated = (fieldNo != 0);
+						HVCounterTiming::AdvanceHVCountersCalculated(*scanMode.hscanSettings, hcounterCalculated, *scanMode.vscanSettings, scanMode.interlaceIsEnabled, oddFlagSetCalculated, vcounterCalculated, pixelClockStepsList[i]);
+						++comparisonCount;
+						if((hcounterTable != hcounterCalculated) || (vcounterTable != vcounterCalculated) || (oddFlagSetTable != oddFlagSetCalculated))
+						{
+							if(mismatchCount++ == 0)
+							{
+								std::stringstream stream;
+								stream << FormatCounters(hcounterInitial, vcounterInitial, (fieldNo != 0)) << " + " << pixelClockStepsList[i] << " steps: table " << FormatCounters(hcounterTable, vcounterTable, oddFlagSetTable) << ", calculated " << FormatCounters(hcounterCalculated, vcounterCalculated, oddFlagSetCalculated);
+								firstMismatch = stream.str();
+							}
+						}
+					}
+				}
+			}
+			INFO(scanMode.name << ": " << firstMismatch);
+			REQUIRE(comparisonCount > 0);
+			REQUIRE(mismatchCount == 0);
+		}
+	}
+	SECTION("Stepped", "")
+	{
+		//Compare against stepping the counters manually, from random positions including
+		//those just before the odd flag toggle point, for advances spanning several fields.
+		for(unsigned int modeNo = 0; modeNo < (unsigned int)scanModes.size(); ++modeNo)
+		{
+			const ScanMode& scanMode = scanModes[modeNo];
+			const HVCounterTiming::FrameTable& frameTable = HVCounterTiming::GetFrameTable(*scanMode.hscanSettings, *scanMode.vscanSettings, scanMode.interlaceIsEnabled);
+			for(unsigned int runNo = 0; runNo < 4; ++runNo)
+			{
+				unsigned int fieldNo = runNo % 2;
+				unsigned int fieldPixelClockSteps = frameTable.fieldPixelClockSteps[fieldNo];
+				unsigned int position = ((runNo / 2) == 0)? fieldPixelClockSteps - 1: std::uniform_int_distribution<unsigned int>(0, fieldPixelClockSteps - 1)(randomGenerator);
+				unsigned int pixelClockSteps = std::uniform_int_distribution<unsigned int>(fieldPixelClockSteps, fieldPixelClockSteps * 3)(randomGenerator);
+				unsigned int hvcounter = frameTable.positionToHVCounter[fieldNo][position];
+
+				unsigned int hcounterTable = hvcounter & 0xFFFF;
+				unsigned int vcounterTable = hvcounter >> 16;
+				bool oddFlagSetTable = (fieldNo != 0);
+				HVCounterTiming::AdvanceHVCounters(*scanMode.hscanSettings, hcounterTable, *scanMode.vscanSettings, scanMode.interlaceIsEnabled, oddFlagSetTable, vcounterTable, pixelClockSteps);
+				unsigned int hcounterStepped = hvcounter & 0xFFFF;
+				unsigned int vcounterStepped = hvcounter >> 16;
+				bool oddFlagSetStepped = (fieldNo != 0);
+				for(unsigned int i = 0; i < pixelClockSteps; ++i)
+				{
+					HVCounterTiming::AdvanceHVCountersOneStep(*scanMode.hscanSettings, hcounterStepped, *scanMode.vscanSettings, scanMode.interlaceIsEnabled, oddFlagSetStepped, vcounterStepped);
+				}
+				INFO(scanMode.name << ": " << FormatCounters(hvcounter & 0xFFFF, hvcounter >> 16, (fieldNo != 0)) << " + " << pixelClockSteps << " steps");
+				REQUIRE(FormatCounters(hcounterTable, vcounterTable, oddFlagSetTable) == FormatCounters(hcounterStepped, vcounterStepped, oddFlagSetStepped));
+			}
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------
+TEST_CASE("HVCounterTiming::GetPixelClockStepsBetweenHVCounterValues", "")
+{
+	//Search from every position in every field for a random target position, and confirm
+	//that advancing the counters by the returned number of steps reaches the target. Where
+	//the calculated form returns a step count which also reaches the target, confirm both
+	//forms agree. The calculated form works with linear counter values from the current
+	//field, so it doesn't always find targets across an odd flag toggle point, and like
+	//the calculated form of AdvanceHVCounters, it places positions just before the toggle
+	//point after it.
+	std::vector<ScanMode> scanModes = GetScanModes();
+	std::mt19937 randomGenerator(0x5313);
+	for(unsigned int modeNo = 0; modeNo < (unsigned int)scanModes.size(); ++modeNo)
+	{
+		const ScanMode& scanMode = scanModes[modeNo];
+		const HVCounterTiming::FrameTable& frameTable = HVCounterTiming::GetFrameTable(*scanMode.hscanSettings, *scanMode.vscanSettings, scanMode.interlaceIsEnabled);
+		unsigned int mismatchCount = 0;
+		unsigned int comparisonCount = 0;
+		std::string firstMismatch;
+		for(unsigned int fieldNo = 0; fieldNo < 2; ++fieldNo)
+		{
+			bool oddFlagSet = (fieldNo != 0);
+			for(unsigned int position = 0; position < frameTable.fieldPixelClockSteps[fieldNo]; ++position)
+			{
+				unsigned int hvcounter = frameTable.positionToHVCounter[fieldNo][position];
+				unsigned int hcounterCurrent = hvcounter & 0xFFFF;
+				unsigned int vcounterCurrent = hvcounter >> 16;
+				unsigned int targetFieldNo = randomGenerator() % 2;
+				unsigned int targetPosition = ((position % 16) == 0)? position: std::uniform_int_distribution<unsigned int>(0, frameTable.fieldPixelClockSteps[targetFieldNo] - 1)(randomGenerator);
+				unsigned int targetHVCounter = frameTable.positionToHVCounter[((position % 16) == 0)? fieldNo: targetFieldNo][targetPosition];
+				unsigned int hcounterTarget = targetHVCounter & 0xFFFF;
+				unsigned int vcounterTarget = targetHVCounter >> 16;
+				unsigned int targetPositionInField = HVCounterTiming::GetFramePosition(frameTable, hcounterTarget, vcounterTarget, oddFlagSet);
+				bool targetRecurs = scanMode.interlaceIsEnabled || (HVCounterTiming::GetFramePosition(frameTable, hcounterTarget, vcounterTarget, false) != HVCounterTiming::invalidFramePosition);
+				for(unsigned int advanceIfValuesMatch = 0; advanceIfValuesMatch < 2; ++advanceIfValuesMatch)
+				{
+					//With interlacing disabled, values which only occur in an odd field can't
+					//be reached once the current field ends, so skip them if they're not
+					//ahead of us in this field.
+					if(!targetRecurs && ((targetPositionInField == HVCounterTiming::invalidFramePosition) || (targetPositionInField < position) || ((targetPositionInField == position) && (advanceIfValuesMatch != 0))))
+					{
+						continue;
+					}
+
+					unsigned int pixelClockStepsTable = HVCounterTiming::GetPixelClockStepsBetweenHVCounterValues((advanceIfValuesMatch != 0), *scanMode.hscanSettings, hcounterCurrent, hcounterTarget, *scanMode.vscanSettings, scanMode.interlaceIsEnabled, oddFlagSet, vcounterCurrent, vcounterTarget);
+					unsigned int pixelClockStepsCalculated = HVCounterTiming::GetPixelClockStepsBetweenHVCounterValuesCalculated((advanceIfValuesMatch != 0), *scanMode.hscanSettings, hcounterCurrent, hcounterTarget, *scanMode.vscanSettings, scanMode.interlaceIsEnabled, oddFlagSet, vcounterCurrent, vcounterTarget);
+
+					unsigned int hcounterTable = hcounterCurrent;
+					unsigned int vcounterTable = vcounterCurrent;
+					bool oddFlagSetTable = oddFlagSet;
+					HVCounterTiming::AdvanceHVCounters(*scanMode.hscanSettings, hcounterTable, *scanMode.vscanSettings, scanMode.interlaceIsEnabled, oddFlagSetTable, vcounterTable, pixelClockStepsTable);
+					unsigned int hcounterCalculated = hcounterCurrent;
+					unsigned int vcounterCalculated = vcounterCurrent;
+					bool oddFlagSetCalculated = oddFlagSet;
+					HVCounterTiming::AdvanceHVCountersCalculated(*scanMode.hscanSettings, hcounterCalculated, *scanMode.vscanSettings, scanMode.interlaceIsEnabled, oddFlagSetCalculated, vcounterCalculated, pixelClockStepsCalculated);
+
+					bool tableReachedTarget = (hcounterTable == hcounterTarget) && (vcounterTable == vcounterTarget) && ((pixelClockStepsTable > 0) || (advanceIfValuesMatch == 0));
+					bool calculatedReachedTarget = (hcounterCalculated == hcounterTarget) && (vcounterCalculated == vcounterTarget);
+					++comparisonCount;
+					bool calculatedComparable = calculatedReachedTarget && !PositionPrecedesOddFlagToggle(scanMode, frameTable, hcounterCurrent, vcounterCurrent);
+					if(!tableReachedTarget || (calculatedComparable && (pixelClockStepsTable != pixelClockStepsCalculated)))
+					{
+						if(mismatchCount++ == 0)
+						{
+							std::stringstream stream;
+							stream << FormatCounters(hcounterCurrent, vcounterCurrent, oddFlagSet) << " to H=0x" << std::hex << hcounterTarget << " V=0x" << vcounterTarget << std::dec << ", advance " << advanceIfValuesMatch << ": table " << pixelClockStepsTable << ", calculated " << pixelClockStepsCalculated;
+							firstMismatch = stream.str();
+						}
+					}
+				}
+			}
+		}
+		INFO(scanMode.name << ": " << firstMismatch);
+		REQUIRE(comparisonCount > 0);
+		REQUIRE(mismatchCount == 0);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Benchmarks
+//----------------------------------------------------------------------------------------
+TEST_CASE("HVCounterTiming benchmark", "[.][benchmark]")
+{
+	static const unsigned int iterationCount = 2000000;
+	const HVCounterTiming::HScanSettings& hscanSettings = HVCounterTiming::h40ScanSettingsStatic;
+	const HVCounterTiming::VScanSettings& vscanSettings = HVCounterTiming::v28NtscIntEnScanSettingsStatic;
+	const HVCounterTiming::FrameTable& frameTable = HVCounterTiming::GetFrameTable(hscanSettings, vscanSettings, true);
+	std::mt19937 randomGenerator(0x5313);
+	std::uniform_int_distribution<unsigned int> positionDistribution(0, frameTable.fieldPixelClockSteps[0] - 1);
+	std::uniform_int_distribution<unsigned int> pixelClockStepsDistribution(1, 4000);
+	std::vector<unsigned int> startHVCounters(iterationCount);
+	std::vector<unsigned int> targetHVCounters(iterationCount);
+	std::vector<unsigned int> pixelClockSteps(iterationCount);
+	for(unsigned int i = 0; i < iterationCount; ++i)
+	{
+		startHVCounters[i] = frameTable.positionToHVCounter[0][positionDistribution(randomGenerator)];
+		targetHVCounters[i] = frameTable.positionToHVCounter[0][positionDistribution(randomGenerator)];
+		pixelClockSteps[i] = pixelClockStepsDistribution(randomGenerator);
+	}
+
+	unsigned int checksum = 0;
+	std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+	for(unsigned int i = 0; i < iterationCount; ++i)
+	{
+		unsigned int hcounter = startHVCounters[i] & 0xFFFF;
+		unsigned int vcounter = startHVCounters[i] >> 16;
+		bool oddFlagSet = false;
+		HVCounterTiming::AdvanceHVCounters(hscanSettings, hcounter, vscanSettings, true, oddFlagSet, vcounter, pixelClockSteps[i]);
+		checksum += hcounter + vcounter;
+	}
+	std::chrono::high_resolution_clock::time_point tableAdvanceTime = std::chrono::high_resolution_clock::now();
+	for(unsigned int i = 0; i < iterationCount; ++i)
+	{
+		unsigned int hcounter = startHVCounters[i] & 0xFFFF;
+		unsigned int vcounter = startHVCounters[i] >> 16;
+		bool oddFlagSet = false;
+		HVCounterTiming::AdvanceHVCountersCalculated(hscanSettings, hcounter, vscanSettings, true, oddFlagSet, vcounter, pixelClockSteps[i]);
+		checksum += hcounter + vcounter;
+	}
+	std::chrono::high_resolution_clock::time_point calculatedAdvanceTime = std::chrono::high_resolution_clock::now();
+	for(unsigned int i = 0; i < iterationCount; ++i)
+	{
+		checksum += HVCounterTiming::GetPixelClockStepsBetweenHVCounterValues(false, hscanSettings, startHVCounters[i] & 0xFFFF, targetHVCounters[i] & 0xFFFF, vscanSettings, true, false, startHVCounters[i] >> 16, targetHVCounters[i] >> 16);
+	}
+	std::chrono::high_resolution_clock::time_point tableStepsTime = std::chrono::high_resolution_clock::now();
+	for(unsigned int i = 0; i < iterationCount; ++i)
+	{
+		checksum += HVCounterTiming::GetPixelClockStepsBetweenHVCounterValuesCalculated(false, hscanSettings, startHVCounters[i] & 0xFFFF, targetHVCounters[i] & 0xFFFF, vscanSettings, true, false, startHVCounters[i] >> 16, targetHVCounters[i] >> 16);
+	}
+	std::chrono::high_resolution_clock::time_point calculatedStepsTime = std::chrono::high_resolution_clock::now();
+
+	WARN("AdvanceHVCounters: table " << std::chrono::duration_cast<std::chrono::microseconds>(tableAdvanceTime - startTime).count() << "us, calculated " << std::chrono::duration_cast<std::chrono::microseconds>(calculatedAdvanceTime - tableAdvanceTime).count() << "us for " << iterationCount << " calls");
+	WARN("GetPixelClockStepsBetweenHVCounterValues: table " << std::chrono::duration_cast<std::chrono::microseconds>(tableStepsTime - calculatedAdvanceTime).count() << "us, calculated " << std::chrono::duration_cast<std::chrono::microseconds>(calculatedStepsTime - tableStepsTime).count() << "us for " << iterationCount << " calls");
+	REQUIRE(checksum != 0);
+}
@@ -0,0 +1,222 @@
+#include "catch.hpp"
+#include "LayerCompositor.h"
+#include "WindowsSupport/WindowsSupport.pkg"
+#include <random>
+
+//----------------------------------------------------------------------------------------
+//Test line generation
+//----------------------------------------------------------------------------------------
+//Each test line holds the layer state for every pixel in one output line, in the form the
+//renderer hands it to the layer compositor. Layers A and B are built from 8-pixel tiles
+//with a priority bit and palette line for each tile, and a proportion of transparent
+//pixels. Sprites are laid over the line in runs, and some of them use the shadow and
+//highlight operator colours. Shadow/highlight mode is enabled on some lines, and toggled
+//part way through others.
+//----------------------------------------------------------------------------------------
+struct TestLinePixel
+{
+	bool shadowHighlightEnabled;
+	unsigned int paletteLine[4];
+	unsigned int paletteIndex[4];
+	bool priority[4];
+};
+
+//----------------------------------------------------------------------------------------
+static std::vector<TestLinePixel> GenerateTestLine(std::mt19937& randomGenerator, unsigned int lineWidth)
+{
+	std::uniform_int_distribution<unsigned int> percent(0, 99);
+	std::uniform_int_distribution<unsigned int> paletteLine(0, 3);
+	std::uniform_int_distribution<unsigned int> paletteIndex(1, 15);
+	std::vector<TestLinePixel> line(lineWidth);
+
+	//Build the background and scroll layers
+	unsigned int backgroundPaletteLine = paletteLine(randomGenerator);
+	unsigned int backgroundPaletteIndex = paletteIndex(randomGenerator);
+	bool shadowHighlightEnabled = (percent(randomGenerator) < 50);
+	unsigned int shadowHighlightTogglePos = (percent(randomGenerator) < 20)? (percent(randomGenerator) * lineWidth) / 100: lineWidth;
+	for(unsigned int tileBase = 0; tileBase < lineWidth; tileBase += 8)
+	{
+		for(unsigned int layerNo = LayerCompositor::LAYERINDEX_LAYERA; layerNo <= LayerCompositor::LAYERINDEX_LAYERB; ++layerNo)
+		{
+			bool tilePriority = (percent(randomGenerator) < 30);
+			unsigned int tilePaletteLine = paletteLine(randomGenerator);
+			unsigned int tileTransparency = (percent(randomGenerator) < 25)? 100: 30;
+			for(unsigned int pixelNo = tileBase; (pixelNo < (tileBase + 8)) && (pixelNo < lineWidth); ++pixelNo)
+			{
+				line[pixelNo].priority[layerNo] = tilePriority;
+				line[pixelNo].paletteLine[layerNo] = tilePaletteLine;
+				line[pixelNo].paletteIndex[layerNo] = (percent(randomGenerator) < tileTransparency)? 0: paletteIndex(randomGenerator);
+			}
+		}
+	}
+	for(unsigned int pixelNo = 0; pixelNo < lineWidth; ++pixelNo)
+	{
+		TestLinePixel& pixel = line[pixelNo];
+		pixel.shadowHighlightEnabled = (pixelNo < shadowHighlightTogglePos)? shadowHighlightEnabled: !shadowHighlightEnabled;
+		pixel.priority[LayerCompositor::LAYERINDEX_SPRITE] = false;
+		pixel.paletteLine[LayerCompositor::LAYERINDEX_SPRITE] = 0;
+		pixel.paletteIndex[LayerCompositor::LAYERINDEX_SPRITE] = 0;
+		pixel.priority[LayerCompositor::LAYERINDEX_BACKGROUND] = false;
+		pixel.paletteLine[LayerCompositor::LAYERINDEX_BACKGROUND] = backgroundPaletteLine;
+		pixel.paletteIndex[LayerCompositor::LAYERINDEX_BACKGROUND] = backgroundPaletteIndex;
+	}
+
+	//Lay sprites over the line. Sprites are 8 to 32 pixels wide. About a quarter of them
+	//use palette line 3, where the last two colours act as shadow and highlight operators.
+	unsigned int spriteCount = percent(randomGenerator) / 5;
+	for(unsigned int spriteNo = 0; spriteNo < spriteCount; ++spriteNo)
+	{
+		unsigned int spriteWidth = 8 * (1 + (percent(randomGenerator) % 4));
+		unsigned int spritePos = (percent(randomGenerator) * lineWidth) / 100;
+		bool spritePriority = (percent(randomGenerator) < 40);
+		bool operatorSprite = (percent(randomGenerator) < 25);
+		unsigned int spritePaletteLine = operatorSprite? 3: paletteLine(randomGenerator);
+		for(unsigned int pixelNo = spritePos; (pixelNo < (spritePos + spriteWidth)) && (pixelNo < lineWidth); ++pixelNo)
+		{
+			TestLinePixel& pixel = line[pixelNo];
+			if(pixel.paletteIndex[LayerCompositor::LAYERINDEX_SPRITE] != 0)
+			{
+				continue;
+			}
+			unsigned int spritePaletteIndex = (percent(randomGenerator) < 20)? 0: paletteIndex(randomGenerator);
+			if(operatorSprite && (spritePaletteIndex != 0) && (percent(randomGenerator) < 60))
+			{
+				spritePaletteIndex = (percent(randomGenerator) < 50)? 14: 15;
+			}
+			pixel.priority[LayerCompositor::LAYERINDEX_SPRITE] = spritePriority;
+			pixel.paletteLine[LayerCompositor::LAYERINDEX_SPRITE] = spritePaletteLine;
+			pixel.paletteIndex[LayerCompositor::LAYERINDEX_SPRITE] = spritePaletteIndex;
+		}
+	}
+	return line;
+}
+
+//----------------------------------------------------------------------------------------
+//Compares a compositor function against CalculateLayerPriorityIndex for every pixel in a
+//set of generated lines. Lines are split into blocks the same way the renderer splits
+//them. Most blocks are full, but some are closed early, as happens when a CRAM write is
+//committed part way through a line, so partial blocks of every length are covered.
+//----------------------------------------------------------------------------------------
+static unsigned int CompareCompositorWithPriorityCalculation(LayerCompositor::CompositorFunction compositorFunction, const std::vector<unsigned int>& layerPriorityLookupTable, unsigned int lineCount)
+{
+	std::mt19937 randomGenerator(0x5313);
+	std::uniform_int_distribution<unsigned int> blockLength(1, LayerCompositor::blockPixelCount);
+	std::uniform_int_distribution<unsigned int> percent(0, 99);
+	unsigned int mismatchCount = 0;
+	for(unsigned int lineNo = 0; lineNo < lineCount; ++lineNo)
+	{
+		unsigned int lineWidth = ((lineNo % 2) == 0)? 320: 256;
+		std::vector<TestLinePixel> line = GenerateTestLine(randomGenerator, lineWidth);
+		unsigned int blockStart = 0;
+		while(blockStart < lineWidth)
+		{
+			//Build the compositor input for this block
+			unsigned int pixelCount = (percent(randomGenerator) < 80)? LayerCompositor::blockPixelCount: blockLength(randomGenerator);
+			pixelCount = ((blockStart + pixelCount) > lineWidth)? lineWidth - blockStart: pixelCount;
+			unsigned char layerFlags[LayerCompositor::blockPixelCount];
+			unsigned char shadowHighlightEnabled[LayerCompositor::blockPixelCount];
+			unsigned char paletteEntries[4 * LayerCompositor::blockPixelCount];
+			for(unsigned int i = 0; i < pixelCount; ++i)
+			{
+				const TestLinePixel& pixel = line[blockStart + i];
+				bool spriteIsShadowOperator = (pixel.paletteLine[LayerCompositor::LAYERINDEX_SPRITE] == 3) && (pixel.paletteIndex[LayerCompositor::LAYERINDEX_SPRITE] == 15);
+				bool spriteIsHighlightOperator = (pixel.paletteLine[LayerCompositor::LAYERINDEX_SPRITE] == 3) && (pixel.paletteIndex[LayerCompositor::LAYERINDEX_SPRITE] == 14);
+				unsigned int flags = 0;
+				flags |= (unsigned int)spriteIsShadowOperator << 7;
+				flags |= (unsigned int)spriteIsHighlightOperator << 6;
+				flags |= (unsigned int)(pixel.paletteIndex[LayerCompositor::LAYERINDEX_SPRITE] != 0) << 5;
+				flags |= (unsigned int)(pixel.paletteIndex[LayerCompositor::LAYERINDEX_LAYERA] != 0) << 4;
+				flags |= (unsigned int)(pixel.paletteIndex[LayerCompositor::LAYERINDEX_LAYERB] != 0) << 3;
+				flags |= (unsigned int)pixel.priority[LayerCompositor::LAYERINDEX_SPRITE] << 2;
+				flags |= (unsigned int)pixel.priority[LayerCompositor::LAYERINDEX_LAYERA] << 1;
+				flags |= (unsigned int)pixel.priority[LayerCompositor::LAYERINDEX_LAYERB];
+				layerFlags[i] = (unsigned char)flags;
+				shadowHighlightEnabled[i] = pixel.shadowHighlightEnabled? 1: 0;
+				for(unsigned int layerNo = 0; layerNo < 4; ++layerNo)
+				{
+					paletteEntries[(layerNo * LayerCompositor::blockPixelCount) + i] = (unsigned char)((pixel.paletteLine[layerNo] << 4) | pixel.paletteIndex[layerNo]);
+				}
+			}
+
+			//Resolve the block, and check each pixel against the per-pixel calculation
+			unsigned char selectedPaletteEntries[LayerCompositor::blockPixelCount];
+			unsigned char layerSelections[LayerCompositor::blockPixelCount];
+			compositorFunction(pixelCount, &layerFlags[0], &shadowHighlightEnabled[0], &paletteEntries[0], &selectedPaletteEntries[0], &layerSelections[0], &layerPriorityLookupTable[0]);
+			for(unsigned int i = 0; i < pixelCount; ++i)
+			{
+				unsigned int flags = layerFlags[i];
+				unsigned int layerIndex;
+				bool shadow;
+				bool highlight;
+				LayerCompositor::CalculateLayerPriorityIndex(layerIndex, shadow, highlight, shadowHighlightEnabled[i] != 0, (flags & 0x80) != 0, (flags & 0x40) != 0, (flags & 0x20) != 0, (flags & 0x10) != 0, (flags & 0x08) != 0, (flags & 0x04) != 0, (flags & 0x02) != 0, (flags & 0x01) != 0);
+				unsigned int expectedLayerSelection = layerIndex | (shadow? 0x08: 0) | (highlight? 0x04: 0);
+				unsigned int expectedPaletteEntry = paletteEntries[(layerIndex * LayerCompositor::blockPixelCount) + i];
+				if((layerSelections[i] != expectedLayerSelection) || (selectedPaletteEntries[i] != expectedPaletteEntry))
+				{
+					++mismatchCount;
+				}
+			}
+			blockStart += pixelCount;
+		}
+	}
+	return mismatchCount;
+}
+
+//----------------------------------------------------------------------------------------
+//Tests
+//----------------------------------------------------------------------------------------
+TEST_CASE("LayerCompositor::BuildLayerPriorityLookupTable", "")
+{
+	std::vector<unsigned int> layerPriorityLookupTable;
+	LayerCompositor::BuildLayerPriorityLookupTable(layerPriorityLookupTable);
+	REQUIRE(layerPriorityLookupTable.size() == LayerCompositor::lookupTableSize);
+
+	//Spot check the hardware behaviour the shadow/highlight rules are based on. A high
+	//priority shadow operator over a high priority layer A pixel shadows layer A, while
+	//a highlight operator can't highlight anything when both layers are low priority.
+	//Index bits: STE|SO|HO|fS|fA|fB|pS|pA|pB
+	CHECK(layerPriorityLookupTable[0x1B6] == (LayerCompositor::LAYERINDEX_LAYERA | 0x08));
+	CHECK(layerPriorityLookupTable[0x174] == LayerCompositor::LAYERINDEX_LAYERA);
+	CHECK(layerPriorityLookupTable[0x000] == LayerCompositor::LAYERINDEX_BACKGROUND);
+	CHECK(layerPriorityLookupTable[0x100] == (LayerCompositor::LAYERINDEX_BACKGROUND | 0x08));
+}
+
+//----------------------------------------------------------------------------------------
+TEST_CASE("LayerCompositor::CompositeLayerPixels", "")
+{
+	static const unsigned int testLineCount = 4000;
+	std::vector<unsigned int> layerPriorityLookupTable;
+	LayerCompositor::BuildLayerPriorityLookupTable(layerPriorityLookupTable);
+
+	SECTION("Scalar", "")
+	{
+		REQUIRE(CompareCompositorWithPriorityCalculation(LayerCompositor::CompositeLayerPixelsScalar, layerPriorityLookupTable, testLineCount) == 0);
+	}
+	SECTION("SSE2", "")
+	{
+		if(ProcessorSupportsSSE2())
+		{
+			REQUIRE(CompareCompositorWithPriorityCalculation(LayerCompositor::CompositeLayerPixelsSSE2, layerPriorityLookupTable, testLineCount) == 0);
+		}
+		else
+		{
+			WARN("SSE2 not supported by this processor, test skipped");
+		}
+	}
+	SECTION("AVX2", "")
+	{
+		if(ProcessorSupportsAVX2())
+		{
+			REQUIRE(CompareCompositorWithPriorityCalculation(LayerCompositor::CompositeLayerPixelsAVX2, layerPriorityLookupTable, testLineCount) == 0);
+		}
+		else
+		{
+			WARN("AVX2 not supported by this processor, test skipped");
+		}
+	}
+	SECTION("Selected", "")
+	{
+		LayerCompositor::CompositorFunction compositorFunction = LayerCompositor::SelectCompositorFunction(layerPriorityLookupTable);
+		REQUIRE(CompareCompositorWithPriorityCalculation(compositorFunction, layerPriorityLookupTable, testLineCount) == 0);
+	}
+}
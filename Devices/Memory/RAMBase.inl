@@ -189,15 +189,19 @@ template<class T> void RAMBase<T>::WriteArrayValueWithLockCheckAndRollback(unsig
 //----------------------------------------------------------------------------------------
 template<class T> void RAMBase<T>::LoadState(IHierarchicalStorageNode& node)
 {
-	std::vector<T> savedMemoryData(memoryArraySize, 0);
-	node.ExtractBinaryData(savedMemoryData);
-	unsigned int savedMemoryDataSize = (unsigned int)savedMemoryData.size();
+	//Read the saved memory contents from the node directly into our memory array, without
+	//going through an intermediate buffer.
+	Stream::IStream& dataStream = node.GetBinaryDataBufferStream();
+	dataStream.SetStreamPos(0);
+	unsigned int savedMemoryDataSize = (unsigned int)(dataStream.Size() / sizeof(T));
 	unsigned int entriesToLoad = (savedMemoryDataSize <= memoryArraySize)? savedMemoryDataSize: memoryArraySize;
 	unsigned int entriesToFill = memoryArraySize - entriesToLoad;
-	if(entriesToLoad > 0)
+	if((entriesToLoad > 0) && !dataStream.ReadData(&memoryArray[0], entriesToLoad))
 	{
-		memcpy(&memoryArray[0], &savedMemoryData[0], (entriesToLoad * sizeof(T)));
+		entriesToFill = memoryArraySize;
+		entriesToLoad = 0;
 	}
+	dataStream.SetStreamPos(0);
 	if(entriesToFill > 0)
 	{
 		memset(&memoryArray[entriesToLoad], 0, (entriesToFill * sizeof(T)));
@@ -209,7 +213,17 @@ template<class T> void RAMBase<T>::LoadState(IHierarchicalStorageNode& node)
 //----------------------------------------------------------------------------------------
 template<class T> void RAMBase<T>::SaveState(IHierarchicalStorageNode& node) const
 {
-	node.InsertBinaryData(memoryArray, memoryArraySize, GetFullyQualifiedDeviceInstanceName(), false);
+	//Byte-sized memory is saved in exactly the same form it's held in our memory array,
+	//so in this case we store a reference to our memory array in the node rather than
+	//copying the data. The system doesn't resume execution until the tree has been saved.
+	if(sizeof(T) == sizeof(unsigned char))
+	{
+		node.InsertBinaryDataReference((const unsigned char*)memoryArray, memoryArraySize, GetFullyQualifiedDeviceInstanceName(), false);
+	}
+	else
+	{
+		node.InsertBinaryData(memoryArray, memoryArraySize, GetFullyQualifiedDeviceInstanceName(), false);
+	}
 
 	MemoryWrite::SaveState(node);
 }
@@ -219,15 +233,17 @@ template<class T> void RAMBase<T>::LoadPersistentState(IHierarchicalStorageNode&
 {
 	if(dataIsPersistent)
 	{
-		std::vector<T> savedMemoryData(memoryArraySize, 0);
-		node.ExtractBinaryData(savedMemoryData);
-		unsigned int savedMemoryDataSize = (unsigned int)savedMemoryData.size();
+		Stream::IStream& dataStream = node.GetBinaryDataBufferStream();
+		dataStream.SetStreamPos(0);
+		unsigned int savedMemoryDataSize = (unsigned int)(dataStream.Size() / sizeof(T));
 		unsigned int entriesToLoad = (savedMemoryDataSize <= memoryArraySize)? savedMemoryDataSize: memoryArraySize;
 		unsigned int entriesToFill = memoryArraySize - entriesToLoad;
-		if(entriesToLoad > 0)
+		if((entriesToLoad > 0) && !dataStream.ReadData(&memoryArray[0], entriesToLoad))
 		{
-			memcpy(&memoryArray[0], &savedMemoryData[0], (entriesToLoad * sizeof(T)));
+			entriesToFill = memoryArraySize;
+			entriesToLoad = 0;
 		}
+		dataStream.SetStreamPos(0);
 		if(entriesToFill > 0)
 		{
 			memset(&memoryArray[entriesToLoad], 0, (entriesToFill * sizeof(T)));
@@ -242,7 +258,14 @@ template<class T> void RAMBase<T>::SavePersistentState(IHierarchicalStorageNode&
 {
 	if(dataIsPersistent)
 	{
-		node.InsertBinaryData(memoryArray, memoryArraySize, GetFullyQualifiedDeviceInstanceName(), false);
+		if(sizeof(T) == sizeof(unsigned char))
+		{
+			node.InsertBinaryDataReference((const unsigned char*)memoryArray, memoryArraySize, GetFullyQualifiedDeviceInstanceName(), false);
+		}
+		else
+		{
+			node.InsertBinaryData(memoryArray, memoryArraySize, GetFullyQualifiedDeviceInstanceName(), false);
+		}
 	}
 
 	MemoryWrite::SavePersistentState(node);
@@ -1,4 +1,5 @@
 #include "SharedRAM.h"
+#include <cstring>
 
 //----------------------------------------------------------------------------------------
 //Constructors
@@ -201,9 +202,16 @@ bool SharedRAM::IsAddressLocked(unsigned int location) const
 //----------------------------------------------------------------------------------------
 void SharedRAM::LoadState(IHierarchicalStorageNode& node)
 {
+	//Copy the saved memory contents directly from the node into our memory buffer
 	size_t memorySize = memory.size();
-	Stream::IStream::SizeType readCount = (node.GetBinaryDataBufferStream().Size() / (Stream::IStream::SizeType)sizeof(unsigned char));
-	node.ExtractBinaryData(memory);
+	const unsigned char* savedMemoryData;
+	size_t savedMemoryDataSize;
+	node.GetBinaryDataView(savedMemoryData, savedMemoryDataSize);
+	size_t readCount = (savedMemoryDataSize < memorySize)? savedMemoryDataSize: memorySize;
+	if(readCount > 0)
+	{
+		memcpy(&memory[0], savedMemoryData, readCount);
+	}
 	for(size_t i = readCount; i < memorySize; ++i)
 	{
 		memory[i] = 0;
@@ -213,5 +221,5 @@ void SharedRAM::LoadState(IHierarchicalStorageNode& node)
 //----------------------------------------------------------------------------------------
 void SharedRAM::SaveState(IHierarchicalStorageNode& node) const
 {
-	node.InsertBinaryData(memory, GetFullyQualifiedDeviceInstanceName(), false);
+	node.InsertBinaryDataReference(memory.empty()? 0: &memory[0], memory.size(), GetFullyQualifiedDeviceInstanceName(), false);
 }
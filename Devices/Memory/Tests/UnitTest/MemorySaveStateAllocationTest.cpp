@@ -0,0 +1,260 @@
+#include "catch.hpp"
+#include "RAM8.h"
+#include "SharedRAM.h"
+#include "HierarchicalStorage/HierarchicalStorage.pkg"
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+//----------------------------------------------------------------------------------------
+//Allocation counting
+//----------------------------------------------------------------------------------------
+//We replace the global allocation functions for this test, so that we can measure the
+//heap allocations made while a memory device saves or loads its state. Allocations are
+//only counted while counting is enabled. Nothing else runs while a device saves or loads
+//its state here, so all counted allocations come from the device and the node.
+//----------------------------------------------------------------------------------------
+static bool allocationCountingEnabled = false;
+static size_t allocationCount = 0;
+static size_t allocatedByteCount = 0;
+static size_t largestAllocationSize = 0;
+
+//----------------------------------------------------------------------------------------
+void* operator new(size_t size)
+{
+	if(allocationCountingEnabled)
+	{
+		++allocationCount;
+		allocatedByteCount += size;
+		largestAllocationSize = (size > largestAllocationSize)? size: largestAllocationSize;
+	}
+	void* allocation = std::malloc((size > 0)? size: 1);
+	if(allocation == 0)
+	{
+		throw std::bad_alloc();
+	}
+	return allocation;
+}
+
+//----------------------------------------------------------------------------------------
+void operator delete(void* allocation) throw()
+{
+	std::free(allocation);
+}
+
+//----------------------------------------------------------------------------------------
+static void BeginAllocationCount()
+{
+	allocationCount = 0;
+	allocatedByteCount = 0;
+	largestAllocationSize = 0;
+	allocationCountingEnabled = true;
+}
+
+//----------------------------------------------------------------------------------------
+static void EndAllocationCount()
+{
+	allocationCountingEnabled = false;
+}
+
+//----------------------------------------------------------------------------------------
+//Test helpers
+//----------------------------------------------------------------------------------------
+//Provides the device context functions a memory device uses while saving and loading
+//its state, without a system to run the device in.
+//----------------------------------------------------------------------------------------
+class TestDeviceContext :public IDeviceContext
+{
+public:
+	//Constructors
+	TestDeviceContext(IDevice& adevice)
+	:device(adevice)
+	{}
+
+	//Interface version functions
+	virtual unsigned int GetIDeviceContextVersion() const { return ThisIDeviceContextVersion(); }
+
+	//Timing functions
+	virtual double GetCurrentTimesliceProgress() const { return 0; }
+	virtual void SetCurrentTimesliceProgress(double executionProgress) {}
+
+	//Control functions
+	virtual bool DeviceEnabled() const { return true; }
+	virtual void SetDeviceEnabled(bool state) {}
+
+	//Device interface
+	virtual IDevice& GetTargetDevice() const { return device; }
+	virtual unsigned int GetDeviceIndexNo() const { return 0; }
+
+	//System message functions
+	virtual void WriteLogEvent(const ILogEntry& entry) {}
+	virtual void FlagStopSystem() {}
+	virtual void StopSystem() {}
+	virtual void RunSystem() {}
+	virtual void ExecuteDeviceStep() {}
+	virtual MarshalSupport::Marshal::Ret<std::wstring> GetFullyQualifiedDeviceInstanceName() const { return std::wstring(L"Test.Memory"); }
+	virtual MarshalSupport::Marshal::Ret<std::wstring> GetModuleDisplayName() const { return std::wstring(L"Test"); }
+	virtual MarshalSupport::Marshal::Ret<std::wstring> GetModuleInstanceName() const { return std::wstring(L"Test"); }
+
+	//Suspend functions
+	virtual bool UsesExecuteSuspend() const { return false; }
+	virtual bool UsesTransientExecution() const { return false; }
+	virtual bool TimesliceExecutionSuspended() const { return false; }
+	virtual void SuspendTimesliceExecution() {}
+	virtual void WaitForTimesliceExecutionResume() const {}
+	virtual void ResumeTimesliceExecution() {}
+	virtual bool TimesliceSuspensionDisabled() const { return false; }
+	virtual bool TransientExecutionActive() const { return false; }
+	virtual void SetTransientExecutionActive(bool state) {}
+	virtual bool TimesliceExecutionCompleted() const { return true; }
+
+	//Dependent device functions
+	virtual void SetDeviceDependencyEnable(IDeviceContext* targetDevice, bool state) {}
+
+private:
+	IDevice& device;
+};
+
+//----------------------------------------------------------------------------------------
+static bool ConstructMemoryDevice(MemoryRead& memoryDevice, unsigned int memoryEntryCount)
+{
+	HierarchicalStorageNode constructionNode(L"Device");
+	constructionNode.CreateAttributeHex(L"MemoryEntryCount", memoryEntryCount, 8);
+	return memoryDevice.Construct(constructionNode);
+}
+
+//----------------------------------------------------------------------------------------
+static std::vector<unsigned char> BuildMemoryData(unsigned int memoryEntryCount)
+{
+	std::vector<unsigned char> memoryData(memoryEntryCount);
+	for(unsigned int i = 0; i < memoryEntryCount; ++i)
+	{
+		memoryData[i] = (unsigned char)((i * 7) ^ (i >> 9));
+	}
+	return memoryData;
+}
+
+//----------------------------------------------------------------------------------------
+static unsigned int CountMemoryMismatches(const MemoryRead& memoryDevice, const std::vector<unsigned char>& memoryData)
+{
+	unsigned int mismatchCount = 0;
+	for(unsigned int i = 0; i < (unsigned int)memoryData.size(); ++i)
+	{
+		mismatchCount += (memoryDevice.ReadMemoryEntry(i) != memoryData[i])? 1: 0;
+	}
+	return mismatchCount;
+}
+
+//----------------------------------------------------------------------------------------
+static unsigned int CountNodeDataMismatches(const IHierarchicalStorageNode& node, const std::vector<unsigned char>& memoryData)
+{
+	const unsigned char* nodeData;
+	size_t nodeDataSize;
+	node.GetBinaryDataView(nodeData, nodeDataSize);
+	if(nodeDataSize != memoryData.size())
+	{
+		return (unsigned int)memoryData.size();
+	}
+	unsigned int mismatchCount = 0;
+	for(size_t i = 0; i < nodeDataSize; ++i)
+	{
+		mismatchCount += (nodeData[i] != memoryData[i])? 1: 0;
+	}
+	return mismatchCount;
+}
+
+//----------------------------------------------------------------------------------------
+//Savestate allocation tests
+//----------------------------------------------------------------------------------------
+//Byte-sized memory is saved by storing a reference to the memory array in the node, and
+//loaded by copying straight from the node into the memory array, so neither direction
+//should allocate anything close to the size of the memory. We use a 4MB memory, so that
+//any full copy of the memory stands out clearly from the small allocations made for the
+//node names.
+//----------------------------------------------------------------------------------------
+TEST_CASE("RAMBase::SaveState", "")
+{
+	const unsigned int memoryEntryCount = 4 * 1024 * 1024;
+	std::vector<unsigned char> memoryData = BuildMemoryData(memoryEntryCount);
+	RAM8 memoryDevice(L"RAM8", L"Memory", 0);
+	TestDeviceContext deviceContext(memoryDevice);
+	memoryDevice.BindToDeviceContext(&deviceContext);
+	REQUIRE(ConstructMemoryDevice(memoryDevice, memoryEntryCount));
+	for(unsigned int i = 0; i < memoryEntryCount; ++i)
+	{
+		memoryDevice.WriteMemoryEntry(i, memoryData[i]);
+	}
+
+	SECTION("Saving byte memory doesn't copy the memory")
+	{
+		HierarchicalStorageTree tree;
+		IHierarchicalStorageNode& node = tree.GetRootNode().CreateChild(L"Device");
+		BeginAllocationCount();
+		memoryDevice.SaveState(node);
+		EndAllocationCount();
+		INFO("Allocations: " << allocationCount << ", bytes: " << allocatedByteCount << ", largest: " << largestAllocationSize);
+		REQUIRE(allocatedByteCount < (memoryEntryCount / 64));
+		REQUIRE(CountNodeDataMismatches(node, memoryData) == 0);
+	}
+
+	SECTION("Loading byte memory doesn't copy the memory")
+	{
+		HierarchicalStorageTree tree;
+		IHierarchicalStorageNode& node = tree.GetRootNode().CreateChild(L"Device");
+		node.InsertBinaryData(memoryData, L"Test.Memory", false);
+		RAM8 loadedMemoryDevice(L"RAM8", L"Memory", 0);
+		TestDeviceContext loadedDeviceContext(loadedMemoryDevice);
+		loadedMemoryDevice.BindToDeviceContext(&loadedDeviceContext);
+		REQUIRE(ConstructMemoryDevice(loadedMemoryDevice, memoryEntryCount));
+		BeginAllocationCount();
+		loadedMemoryDevice.LoadState(node);
+		EndAllocationCount();
+		INFO("Allocations: " << allocationCount << ", bytes: " << allocatedByteCount << ", largest: " << largestAllocationSize);
+		REQUIRE(allocatedByteCount < (memoryEntryCount / 64));
+		REQUIRE(CountMemoryMismatches(loadedMemoryDevice, memoryData) == 0);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+TEST_CASE("SharedRAM::SaveState", "")
+{
+	const unsigned int memoryEntryCount = 4 * 1024 * 1024;
+	std::vector<unsigned char> memoryData = BuildMemoryData(memoryEntryCount);
+	SharedRAM memoryDevice(L"SharedRAM", L"Memory", 0);
+	TestDeviceContext deviceContext(memoryDevice);
+	memoryDevice.BindToDeviceContext(&deviceContext);
+	REQUIRE(ConstructMemoryDevice(memoryDevice, memoryEntryCount));
+	for(unsigned int i = 0; i < memoryEntryCount; ++i)
+	{
+		memoryDevice.WriteMemoryEntry(i, memoryData[i]);
+	}
+
+	SECTION("Saving shared memory doesn't copy the memory")
+	{
+		HierarchicalStorageTree tree;
+		IHierarchicalStorageNode& node = tree.GetRootNode().CreateChild(L"Device");
+		BeginAllocationCount();
+		memoryDevice.SaveState(node);
+		EndAllocationCount();
+		INFO("Allocations: " << allocationCount << ", bytes: " << allocatedByteCount << ", largest: " << largestAllocationSize);
+		REQUIRE(allocatedByteCount < (memoryEntryCount / 64));
+		REQUIRE(CountNodeDataMismatches(node, memoryData) == 0);
+	}
+
+	SECTION("Loading shared memory doesn't copy the memory")
+	{
+		HierarchicalStorageTree tree;
+		IHierarchicalStorageNode& node = tree.GetRootNode().CreateChild(L"Device");
+		node.InsertBinaryData(memoryData, L"Test.Memory", false);
+		SharedRAM loadedMemoryDevice(L"SharedRAM", L"Memory", 0);
+		TestDeviceContext loadedDeviceContext(loadedMemoryDevice);
+		loadedMemoryDevice.BindToDeviceContext(&loadedDeviceContext);
+		REQUIRE(ConstructMemoryDevice(loadedMemoryDevice, memoryEntryCount));
+		BeginAllocationCount();
+		loadedMemoryDevice.LoadState(node);
+		EndAllocationCount();
+		INFO("Allocations: " << allocationCount << ", bytes: " << allocatedByteCount << ", largest: " << largestAllocationSize);
+		REQUIRE(allocatedByteCount < (memoryEntryCount / 64));
+		REQUIRE(CountMemoryMismatches(loadedMemoryDevice, memoryData) == 0);
+	}
+}
@@ -84,6 +84,27 @@ void TimedBufferInt::GetLatestBufferCopy(DataType* buffer, unsigned int bufferSi
 	memory.GetLatestBufferCopy(buffer, bufferSize);
 }
 
+//----------------------------------------------------------------------------------------
+//Block access functions
+//----------------------------------------------------------------------------------------
+void TimedBufferInt::WriteBlock(unsigned int writeCount, const unsigned int* addresses, const TimesliceType* writeTimes, const DataType* data)
+{
+	//If any byte targeted by this block is locked, we fall back to performing each write
+	//individually, so that writes to locked bytes are discarded.
+	for(unsigned int i = 0; i < writeCount; ++i)
+	{
+		if(IsByteLocked(addresses[i]))
+		{
+			for(unsigned int writeNo = 0; writeNo < writeCount; ++writeNo)
+			{
+				Write(addresses[writeNo], writeTimes[writeNo], data[writeNo]);
+			}
+			return;
+		}
+	}
+	memory.WriteBlock(writeCount, addresses, writeTimes, data);
+}
+
 //----------------------------------------------------------------------------------------
 //Time management functions
 //----------------------------------------------------------------------------------------
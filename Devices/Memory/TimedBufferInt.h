@@ -54,6 +54,10 @@ protected:
 	//Access functions
 	virtual void GetLatestBufferCopy(DataType* buffer, unsigned int bufferSize) const;
 
+public:
+	//Block access functions
+	virtual void WriteBlock(unsigned int writeCount, const unsigned int* addresses, const TimesliceType* writeTimes, const DataType* data);
+
 private:
 	RandomTimeAccessBuffer<DataType, TimesliceType> memory;
 	std::vector<bool> memoryLocked;
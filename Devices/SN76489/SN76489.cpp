@@ -1,16 +1,17 @@
 #include "SN76489.h"
 #include <sstream>
+#include <cmath>
 #include <thread>
 
 //----------------------------------------------------------------------------------------
 //Constructors
 //----------------------------------------------------------------------------------------
 SN76489::SN76489(const std::wstring& aimplementationName, const std::wstring& ainstanceName, unsigned int amoduleID)
-:Device(aimplementationName, ainstanceName, amoduleID), reg(channelCount * 2, false, Data(toneRegisterBitCount))
+:Device(aimplementationName, ainstanceName, amoduleID), reg(channelCount * 2, false, Data(toneRegisterBitCount)), outputSink(0), wavLogWriter(wavLogCount)
 {
-	//Initialize the audio output stream
+	//Set the audio output sample rate. Note that the output stream is opened against the
+	//system audio output sink once we've been bound to the system.
 	outputSampleRate = 48000;	//44100;
-	outputStream.Open(1, 16, outputSampleRate, outputSampleRate/4, outputSampleRate/20);
 
 	//Initialize the locked register state
 	for(unsigned int i = 0; i < channelCount; ++i)
@@ -31,6 +32,17 @@ SN76489::SN76489(const std::wstring& aimplementationName, const std::wstring& ai
 	noisePeriodicTappedBitMask = 0x0001;
 }
 
+//----------------------------------------------------------------------------------------
+SN76489::~SN76489()
+{
+	//Close our audio output stream, and return the sink to the system.
+	outputStream.Close();
+	if(outputSink != 0)
+	{
+		GetSystemInterface().CloseAudioOutputSink(outputSink);
+	}
+}
+
 //----------------------------------------------------------------------------------------
 //Interface version functions
 //----------------------------------------------------------------------------------------
@@ -44,6 +56,18 @@ unsigned int SN76489::GetISN76489Version() const
 //----------------------------------------------------------------------------------------
 bool SN76489::BuildDevice()
 {
+	//Open our audio output stream against the sink provided by the system. The system
+	//decides where the audio is sent, and can redirect it without the stream being
+	//reopened.
+	if(outputSink == 0)
+	{
+		outputSink = GetSystemInterface().OpenAudioOutputSink(GetDeviceContext());
+		if(outputSink != 0)
+		{
+			outputStream.Open(*outputSink, 1, 16, outputSampleRate);
+		}
+	}
+
 	//Initialize the wave logging state
 	std::wstring captureFolder = GetSystemInterface().GetCapturePath();
 	wavLoggingEnabled = false;
@@ -189,6 +213,13 @@ void SN76489::Initialize()
 	noiseShiftRegister = shiftRegisterDefaultValue;
 	noiseOutputMasked = true;
 	outputBuffer.clear();
+	outputStepBuffer.Clear();
+	for(unsigned int i = 0; i < channelCount; ++i)
+	{
+		channelOutputLevel[i] = 0;
+		channelLogOutputLevel[i] = 0;
+		channelLogStepBufferActive[i] = false;
+	}
 
 	//Initialize the register block, and set the correct register sizes for each entry.
 	reg.Initialize();
@@ -443,9 +474,29 @@ void SN76489::RenderThread()
 			continue;
 		}
 
+		//Update the rates of the band-limited step buffers, in case the clock rate has
+		//changed.
+		double internalClockRate = externalClockRate / externalClockDivider;
+		outputStepBuffer.SetRates(internalClockRate, outputSampleRate);
+		for(unsigned int channelNo = 0; channelNo < channelCount; ++channelNo)
+		{
+			channelLogStepBuffer[channelNo].SetRates(internalClockRate, outputSampleRate);
+
+			//If wave logging has been enabled for this channel since the last timeslice,
+			//restart the band-limited step buffer for the channel. We set the current
+			//output level of the channel as the initial step in the buffer, so that the
+			//logged output starts from the correct level.
+			bool channelLoggingEnabled = wavLoggingChannelEnabled[channelNo];
+			if(channelLoggingEnabled && !channelLogStepBufferActive[channelNo])
+			{
+				channelLogStepBuffer[channelNo].Clear();
+				channelLogStepBuffer[channelNo].AddDelta(0, channelLogOutputLevel[channelNo]);
+			}
+			channelLogStepBufferActive[channelNo] = channelLoggingEnabled;
+		}
+
 		//Render the audio output
-		size_t outputBufferPos = outputBuffer.size();
-		double outputFrequency = externalClockRate / externalClockDivider;
+		unsigned int frameClockCount = 0;
 		bool moreSamplesRemaining = true;
 		while(moreSamplesRemaining)
 		{
@@ -456,46 +507,19 @@ void SN76489::RenderThread()
 			//remainingRenderTime isn't negative before attempting to generate an output.
 			remainingRenderTime += reg.GetNextWriteTime(regTimesliceCopy);
 
-			//Calculate the output sample count. Note that remainingRenderTime may be
-			//negative, but we catch that below before using outputSampleCount.
-			unsigned int outputSampleCount = (unsigned int)(remainingRenderTime * (outputFrequency / 1000000000.0));
+			//Calculate the number of internal clock cycles to advance. Note that
+			//remainingRenderTime may be negative, but we catch that below before using
+			//clockCount.
+			unsigned int clockCount = (unsigned int)(remainingRenderTime * (internalClockRate / 1000000000.0));
 
-			//If we have one or more output samples to generate before the next settings
-			//change or the end of the target timeslice, generate and output the samples.
-			if((remainingRenderTime > 0) && (outputSampleCount > 0))
+			//If we have one or more internal clock cycles to run before the next settings
+			//change or the end of the target timeslice, record the transitions in the
+			//output of each channel over this period.
+			if((remainingRenderTime > 0) && (clockCount > 0))
 			{
-				//Resize the output buffer to fit the samples we're about to add
-				outputBuffer.resize(outputBuffer.size() + outputSampleCount);
-
-				//For each channel, calculate the output data for the elapsed time
-				std::vector<float> channelBuffer[channelCount];
 				for(unsigned int channelNo = 0; channelNo < channelCount; ++channelNo)
 				{
-					channelBuffer[channelNo].resize(outputSampleCount);
-					UpdateChannel(channelNo, outputSampleCount, channelBuffer[channelNo]);
-
-					//Output the channel wave log
-					if(wavLoggingChannelEnabled[channelNo])
-					{
-						std::unique_lock<std::mutex> lock(waveLoggingMutex);
-						for(unsigned int i = 0; i < channelBuffer[channelNo].size(); ++i)
-						{
-							short sample = (short)(channelBuffer[channelNo][i] * (32767.0f/channelCount));
-							wavLogChannel[channelNo].WriteData(sample);
-						}
-					}
-				}
-
-				//Mix the output from each channel into a combined output buffer
-				for(unsigned int sampleNo = 0; sampleNo < outputSampleCount; ++sampleNo)
-				{
-					float mixedSample = 0.0;
-					for(unsigned int channelNo = 0; channelNo < channelCount; ++channelNo)
-					{
-						mixedSample += channelBuffer[channelNo][sampleNo];
-					}
-					mixedSample /= channelCount;
-					outputBuffer[outputBufferPos++] = (short)(mixedSample * (32767.0f / 6.0f));
+					UpdateChannel(channelNo, frameClockCount, clockCount);
 				}
 
 				RandomTimeAccessBuffer<Data, double>::WriteInfo writeInfo = reg.GetWriteInfo(0, regTimesliceCopy);
@@ -510,33 +534,55 @@ void SN76489::RenderThread()
 				}
 
 				//Adjust the remainingRenderTime variable to remove the time we just
-				//consumed generating the output samples.
-				remainingRenderTime -= (double)outputSampleCount * (1000000000.0 / outputFrequency);
+				//consumed running the internal clock cycles.
+				remainingRenderTime -= (double)clockCount * (1000000000.0 / internalClockRate);
+				frameClockCount += clockCount;
 			}
 
 			//Advance to the next write operation, or the end of the current timeslice.
 			moreSamplesRemaining = reg.AdvanceByStep(regTimesliceCopy);
 		}
 
-		//Output the mixed channel wave log
+		//Synthesize the output samples which have been completed by this timeslice
+		size_t outputBufferPos = outputBuffer.size();
+		outputStepBuffer.EndFrame(frameClockCount);
+		outputStepBuffer.ReadSamples(outputBuffer, outputStepBuffer.GetSamplesAvailable());
+
+		//Output the mixed channel wave log. Log data is passed to the log writer, which
+		//writes it to disk on its own thread.
 		if(wavLoggingEnabled)
 		{
+			wavLogBuffer.assign(outputBuffer.begin() + outputBufferPos, outputBuffer.end());
 			std::unique_lock<std::mutex> lock(waveLoggingMutex);
-			wavLog.WriteData(outputBuffer);
+			wavLogWriter.WriteSamples(wavLogNoMixed, wavLogBuffer);
+		}
+
+		//Output the channel wave logs
+		for(unsigned int channelNo = 0; channelNo < channelCount; ++channelNo)
+		{
+			if(channelLogStepBufferActive[channelNo])
+			{
+				channelLogBuffer.clear();
+				channelLogStepBuffer[channelNo].EndFrame(frameClockCount);
+				channelLogStepBuffer[channelNo].ReadSamples(channelLogBuffer, channelLogStepBuffer[channelNo].GetSamplesAvailable());
+				std::unique_lock<std::mutex> lock(waveLoggingMutex);
+				wavLogWriter.WriteSamples(wavLogNoChannelBase + channelNo, channelLogBuffer);
+			}
 		}
 
 		//Play the mixed audio stream. Note that we fold samples from successive render
 		//operations together, ensuring that we only send data to the output audio stream
-		//when we have a significant number of samples to send.
-		size_t minimumSamplesToOutput = (size_t)(outputFrequency / 60.0);
+		//when we have a significant number of samples to send. Since the output has been
+		//synthesized directly at the output sample rate, no sample rate conversion is
+		//required.
+		size_t minimumSamplesToOutput = (size_t)(outputSampleRate / 60);
 		if(outputBuffer.size() >= minimumSamplesToOutput)
 		{
-			unsigned int internalSampleCount = (unsigned int)outputBuffer.size();
-			unsigned int outputSampleCount = (unsigned int)((double)internalSampleCount * ((double)outputSampleRate / outputFrequency));
+			unsigned int outputSampleCount = (unsigned int)outputBuffer.size();
 			AudioStream::AudioBuffer* outputBufferFinal = outputStream.CreateAudioBuffer(outputSampleCount, 1);
 			if(outputBufferFinal != 0)
 			{
-				outputStream.ConvertSampleRate(outputBuffer, internalSampleCount, 1, outputBufferFinal->buffer, outputSampleCount);
+				outputBufferFinal->buffer.assign(outputBuffer.begin(), outputBuffer.end());
 				outputStream.PlayBuffer(outputBufferFinal);
 			}
 			outputBuffer.clear();
@@ -553,7 +599,12 @@ void SN76489::RenderThread()
 }
 
 //----------------------------------------------------------------------------------------
-void SN76489::UpdateChannel(unsigned int channelNo, unsigned int outputSampleCount, std::vector<float>& outputBuffer)
+//The UpdateChannel function advances the specified channel by clockCount internal clock
+//cycles, and records each change in the output level of the channel in the band-limited
+//step buffers. The clockOffset argument is the number of internal clock cycles between
+//the start of the current timeslice and the start of this update.
+//----------------------------------------------------------------------------------------
+void SN76489::UpdateChannel(unsigned int channelNo, unsigned int clockOffset, unsigned int clockCount)
 {
 	ChannelRenderData* renderData = &channelRenderData[channelNo];
 
@@ -611,9 +662,10 @@ void SN76489::UpdateChannel(unsigned int channelNo, unsigned int outputSampleCou
 	}
 
 	//If we were partway through a cycle on this channel when we rendered the last step,
-	//resume the last cycle.
-	unsigned int samplesWritten = 0;
-	while((renderData->remainingToneCycles > 0) && (samplesWritten < outputSampleCount))
+	//resume the last cycle. Note that the amplitude may have changed since the last step,
+	//so we update the output level at the start of this step.
+	unsigned int clocksRendered = 0;
+	if(renderData->remainingToneCycles > 0)
 	{
 		//If we're starting the output on a negative cycle, negate the output data.
 		float writeData = (renderData->polarityNegative)? -amplitude: amplitude;
@@ -626,9 +678,10 @@ void SN76489::UpdateChannel(unsigned int channelNo, unsigned int outputSampleCou
 			writeData = (noiseOutputMasked)? 0: amplitude;
 		}
 
-		//Write the sample to the output buffer
-		outputBuffer[samplesWritten++] = writeData;
-		--renderData->remainingToneCycles;
+		//Record the output level, and advance through the remainder of the cycle.
+		SetChannelOutputLevel(channelNo, clockOffset, writeData);
+		clocksRendered = (renderData->remainingToneCycles < clockCount)? renderData->remainingToneCycles: clockCount;
+		renderData->remainingToneCycles -= clocksRendered;
 	}
 
 	//##NOTE## Hardware tests on the SEGA integrated chip have shown that when the tone
@@ -650,7 +703,7 @@ void SN76489::UpdateChannel(unsigned int channelNo, unsigned int outputSampleCou
 	}
 
 	//Output repeating oscillations of the wave at the target frequency and amplitude
-	while(samplesWritten < outputSampleCount)
+	while(clocksRendered < clockCount)
 	{
 		unsigned int samplesToWrite = toneRegisterData.GetData();
 
@@ -682,21 +735,47 @@ void SN76489::UpdateChannel(unsigned int channelNo, unsigned int outputSampleCou
 			writeData = (noiseOutputMasked)? 0: amplitude;
 		}
 
-		if(samplesToWrite > (outputSampleCount - samplesWritten))
+		if(samplesToWrite > (clockCount - clocksRendered))
 		{
 			//If we don't have enough samples remaining in this step to complete
 			//the next cycle, clamp the number of samples to write, and save the
 			//number of additional samples we need to complete for the next step.
 			renderData->initialToneCycles = samplesToWrite;
-			renderData->remainingToneCycles = samplesToWrite - (outputSampleCount - samplesWritten);
-			samplesToWrite = (outputSampleCount - samplesWritten);
+			renderData->remainingToneCycles = samplesToWrite - (clockCount - clocksRendered);
+			samplesToWrite = (clockCount - clocksRendered);
 		}
 
-		//Write a block of samples to the output buffer
-		for(unsigned int i = 0; i < samplesToWrite; ++i)
+		//Record the output level for this cycle
+		SetChannelOutputLevel(channelNo, clockOffset + clocksRendered, writeData);
+		clocksRendered += samplesToWrite;
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void SN76489::SetChannelOutputLevel(unsigned int channelNo, unsigned int clockTime, float outputLevel)
+{
+	//Convert the output level into the scale of the mixed output, and record a step in
+	//the mixed output if the level has changed. Each channel contributes an equal share of
+	//the mixed output, which is then scaled down to leave headroom for mixing with
+	//other sound devices.
+	int mixedOutputLevel = (int)std::floor((outputLevel * (32767.0f / (6.0f * channelCount))) + 0.5f);
+	if(mixedOutputLevel != channelOutputLevel[channelNo])
+	{
+		outputStepBuffer.AddDelta(clockTime, mixedOutputLevel - channelOutputLevel[channelNo]);
+		channelOutputLevel[channelNo] = mixedOutputLevel;
+	}
+
+	//Convert the output level into the scale of the channel wave log, and record a step
+	//in the channel log if the level has changed. We track the level for the channel log
+	//even when logging is disabled, so that it can be started from the correct level.
+	int logOutputLevel = (int)std::floor((outputLevel * (32767.0f / channelCount)) + 0.5f);
+	if(logOutputLevel != channelLogOutputLevel[channelNo])
+	{
+		if(channelLogStepBufferActive[channelNo])
 		{
-			outputBuffer[samplesWritten++] = writeData;
+			channelLogStepBuffer[channelNo].AddDelta(clockTime, logOutputLevel - channelLogOutputLevel[channelNo]);
 		}
+		channelLogOutputLevel[channelNo] = logOutputLevel;
 	}
 }
 
@@ -1234,13 +1313,11 @@ void SN76489::SetAudioLoggingEnabled(bool state)
 	{
 		if(state)
 		{
-			double outputFrequency = externalClockRate / externalClockDivider;
-			wavLog.SetDataFormat(1, 16, (unsigned int)outputFrequency);
-			wavLog.Open(wavLoggingPath, Stream::WAVFile::OpenMode::WriteOnly, Stream::WAVFile::CreateMode::Create);
+			wavLogWriter.OpenLog(wavLogNoMixed, wavLoggingPath, 1, 16, outputSampleRate);
 		}
 		else
 		{
-			wavLog.Close();
+			wavLogWriter.CloseLog(wavLogNoMixed);
 		}
 		wavLoggingEnabled = state;
 	}
@@ -1254,13 +1331,11 @@ void SN76489::SetChannelAudioLoggingEnabled(unsigned int channelNo, bool state)
 	{
 		if(state)
 		{
-			double outputFrequency = externalClockRate / externalClockDivider;
-			wavLogChannel[channelNo].SetDataFormat(1, 16, (unsigned int)outputFrequency);
-			wavLogChannel[channelNo].Open(wavLoggingChannelPath[channelNo], Stream::WAVFile::OpenMode::WriteOnly, Stream::WAVFile::CreateMode::Create);
+			wavLogWriter.OpenLog(wavLogNoChannelBase + channelNo, wavLoggingChannelPath[channelNo], 1, 16, outputSampleRate);
 		}
 		else
 		{
-			wavLogChannel[channelNo].Close();
+			wavLogWriter.CloseLog(wavLogNoChannelBase + channelNo);
 		}
 		wavLoggingChannelEnabled[channelNo] = state;
 	}
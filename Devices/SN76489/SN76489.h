@@ -1,9 +1,13 @@
 /*--------------------------------------------------------------------------------------*\
 Description:
 This core emulates the SN76489 Programmable Sound Generator (PSG), and is designed to
-produce a sample-accurate output. Each channel is generated and mixed at the correct
-internal sample rate, and all known aspects and behaviour of this device are faithfully
-emulated.
+produce a sample-accurate output. Each channel is stepped at the correct internal sample
+rate, and every change in the output level of each channel is recorded at the exact
+internal clock cycle it occurs on. The output is synthesized directly at the output
+sample rate from these transitions using band-limited steps, so the cost of rendering
+depends on the output rate and the number of transitions rather than the internal sample
+rate, and the output is free from aliasing. All known aspects and behaviour of this
+device are faithfully emulated.
 
 Things to do:
 -Get a final answer on the conversion from attenuation to linear power, and document it
@@ -57,6 +61,7 @@ class SN76489 :public Device, public GenericAccessBase<ISN76489>
 public:
 	//Constructors
 	SN76489(const std::wstring& aimplementationName, const std::wstring& ainstanceName, unsigned int amoduleID);
+	~SN76489();
 
 	//Interface version functions
 	virtual unsigned int GetISN76489Version() const;
@@ -117,7 +122,8 @@ private:
 private:
 	//Render functions
 	void RenderThread();
-	void UpdateChannel(unsigned int channelNo, unsigned int outputSampleCount, std::vector<float>& outputBuffer);
+	void UpdateChannel(unsigned int channelNo, unsigned int clockOffset, unsigned int clockCount);
+	void SetChannelOutputLevel(unsigned int channelNo, unsigned int clockTime, float outputLevel);
 
 	//Raw register functions
 	inline Data GetVolumeRegister(unsigned int channelNo, const AccessTarget& accessTarget) const;
@@ -153,11 +159,18 @@ private:
 	std::list<RandomTimeAccessBuffer<Data, double>::Timeslice> regTimesliceListUncommitted;
 	double remainingRenderTime;
 	unsigned int outputSampleRate;
+	IAudioSink* outputSink;
 	AudioStream outputStream;
 	std::vector<short> outputBuffer;
+	BandLimitedStepBuffer outputStepBuffer;
+	BandLimitedStepBuffer channelLogStepBuffer[channelCount];
+	bool channelLogStepBufferActive[channelCount];
+	std::vector<short> channelLogBuffer;
 
 	//Render data
 	ChannelRenderData channelRenderData[channelCount];
+	int channelOutputLevel[channelCount];
+	int channelLogOutputLevel[channelCount];
 	unsigned int noiseShiftRegister;
 	bool noiseOutputMasked;
 
@@ -182,8 +195,11 @@ private:
 	bool wavLoggingChannelEnabled[channelCount];
 	std::wstring wavLoggingPath;
 	std::wstring wavLoggingChannelPath[channelCount];
-	Stream::WAVFile wavLog;
-	Stream::WAVFile wavLogChannel[channelCount];
+	static const unsigned int wavLogNoMixed = 0;
+	static const unsigned int wavLogNoChannelBase = 1;
+	static const unsigned int wavLogCount = wavLogNoChannelBase + channelCount;
+	WAVLogWriter wavLogWriter;
+	std::vector<short> wavLogBuffer;
 };
 
 #include "SN76489.inl"
@@ -0,0 +1,255 @@
+#include "PhaseGenerator.h"
+
+//----------------------------------------------------------------------------------------
+//This table is derived from the detune table given in the YM2608 Application Manual,
+//page 26. The negative inverse of the table (detune 4-7) is generated in code.
+//----------------------------------------------------------------------------------------
+const unsigned int PhaseGenerator::detunePhaseIncrementTable[1 << keyCodeBitCount][1 << (detuneBitCount - 1)] = {
+//	   Detune        Key-Code
+//	 0  1  2  3
+	{0, 0, 1, 2},  //0  (0x00)
+	{0, 0, 1, 2},  //1  (0x01)
+	{0, 0, 1, 2},  //2  (0x02)
+	{0, 0, 1, 2},  //3  (0x03)
+	{0, 1, 2, 2},  //4  (0x04)
+	{0, 1, 2, 3},  //5  (0x05)
+	{0, 1, 2, 3},  //6  (0x06)
+	{0, 1, 2, 3},  //7  (0x07)
+	{0, 1, 2, 4},  //8  (0x08)
+	{0, 1, 3, 4},  //9  (0x09)
+	{0, 1, 3, 4},  //10 (0x0A)
+	{0, 1, 3, 5},  //11 (0x0B)
+	{0, 2, 4, 5},  //12 (0x0C)
+	{0, 2, 4, 6},  //13 (0x0D)
+	{0, 2, 4, 6},  //14 (0x0E)
+	{0, 2, 5, 7},  //15 (0x0F)
+	{0, 2, 5, 8},  //16 (0x10)
+	{0, 3, 6, 8},  //17 (0x11)
+	{0, 3, 6, 9},  //18 (0x12)
+	{0, 3, 7,10},  //19 (0x13)
+	{0, 4, 8,11},  //20 (0x14)
+	{0, 4, 8,12},  //21 (0x15)
+	{0, 4, 9,13},  //22 (0x16)
+	{0, 5,10,14},  //23 (0x17)
+	{0, 5,11,16},  //24 (0x18)
+	{0, 6,12,17},  //25 (0x19)
+	{0, 6,13,19},  //26 (0x1A)
+	{0, 7,14,20},  //27 (0x1B)
+	{0, 8,16,22},  //28 (0x1C)
+	{0, 8,16,22},  //29 (0x1D)
+	{0, 8,16,22},  //30 (0x1E)
+	{0, 8,16,22}}; //31 (0x1F)
+
+//----------------------------------------------------------------------------------------
+const unsigned int PhaseGenerator::phaseModIncrementTable[1 << pmsBitCount][1 << (phaseModIndexBitCount - 2)] = {
+	{0, 0, 0, 0, 0, 0, 0, 0},  //0
+	{0, 0, 0, 0, 1, 1, 1, 1},  //1
+	{0, 0, 0, 1, 1, 1, 2, 2},  //2
+	{0, 0, 1, 1, 2, 2, 3, 3},  //3
+	{0, 0, 1, 2, 2, 2, 3, 4},  //4
+	{0, 0, 2, 3, 4, 4, 5, 6},  //5
+	{0, 0, 4, 6, 8, 8,10,12},  //6
+	{0, 0, 8,12,16,16,20,24}}; //7
+
+//----------------------------------------------------------------------------------------
+//Phase increment functions
+//----------------------------------------------------------------------------------------
+//This function calculates the value which is added to the phase counter of an operator
+//each FM clock cycle. The result depends only on the register values passed in, and the
+//current LFO counter, so callers only need to recalculate it when one of the registers
+//identified by RegisterAffectsPhaseIncrement is written, or when the result of
+//GetPhaseModulationIndex changes.
+//----------------------------------------------------------------------------------------
+unsigned int PhaseGenerator::CalculatePhaseIncrement(unsigned int frequencyData, unsigned int blockData, unsigned int detuneData, unsigned int multipleData, unsigned int pmSensitivity, unsigned int lfoCounter)
+{
+	//This algorithm is primarily based on the F-Number calculation given in the YM2608
+	//manual, page 24. That formula is as follows:
+	//F-Number = (144 * fnote * 2^20 / M) / 2^(B-1)
+	//Additional tests were performed on hardware to answer all remaining questions about
+	//the update process.
+
+	//Apply frequency modulation to fnum
+	//  ---------------------------------
+	//  |          LFO Counter          |
+	//  |-------------------------------|
+	//  |...| 6 | 5 | 4 | 3 | 2 | 1 | 0 |
+	//  ----=====================--------
+	//      | Phase Modulation  |
+	//      |   Index (5-bit)   |
+	//      |-------------------|
+	//      | 4 | 3 | 2 | 1 | 0 |
+	//      ---------------------
+	unsigned int pmCounter = GetPhaseModulationIndex(lfoCounter);
+	if((pmCounter != 0) && (pmSensitivity != 0))
+	{
+		bool pmInverted = ((pmCounter >> (phaseModIndexBitCount - 1)) & 0x1) != 0;
+		bool pmSlopeNegative = ((pmCounter >> (phaseModIndexBitCount - 2)) & 0x1) != 0;
+		unsigned int quarterPhase = pmCounter & ((1 << (phaseModIndexBitCount - 2)) - 1);
+		if(pmSlopeNegative)
+		{
+			quarterPhase = ~quarterPhase & ((1 << (phaseModIndexBitCount - 2)) - 1);
+		}
+
+		//##TODO## Run a test where the upper 6 bits of fnum are 0, and see if the
+		//inverted frequency modulation wave will create a measurable, effective 1-bit
+		//frequency modulation due to sign-extension.
+		//##TODO## Determine whether all 11 bits of fnum are used to calculate the
+		//frequency modulation value. It's possible that all 11 bits of fnum are used to
+		//build a frequency modulation value, and that value is calculated at full
+		//precision, without any loss. That value is then sign-extended, and added to
+		//fnum, but lower bits of the frequency modulation value are discarded. If this
+		//is the case, the sign-extension behaviour will mean that a 1-bit modulation
+		//value is present, even when only the LSB of fnum is set. It would also mean
+		//that we would be able to detect the results of carry operations in the addition
+		//for the increment values for each bit, below the level of the LSB of fnum.
+
+		int pmIncrement = 0;
+		for(unsigned int i = 0; i < fnumDataBitCount; ++i)
+		{
+			if((frequencyData & (1 << i)) != 0)
+			{
+				unsigned int pmIncrementValue = phaseModIncrementTable[pmSensitivity][quarterPhase];
+				pmIncrement += (int)(pmIncrementValue << i);
+			}
+		}
+		if(pmInverted)
+		{
+			pmIncrement = -pmIncrement;
+		}
+		pmIncrement >>= 9;
+		frequencyData += (unsigned int)pmIncrement;
+
+		////Calculate the frequency modulation value based on the upper 6 bits of fnum
+		//const unsigned int fnumModulationBits = 6;
+		//unsigned int pmSensitivity = GetPMSData(channelNo, accessTarget);
+		//unsigned int pmIncrement = 0;
+		//unsigned int frequencyDataUpperBits = frequencyData >> (fnumDataBitCount - fnumModulationBits);
+		//for(unsigned int i = 0; i < fnumModulationBits; ++i)
+		//{
+		//	if((frequencyDataUpperBits & (1 << i)) != 0)
+		//	{
+		//		unsigned int pmIncrementValue = phaseModIncrementTable[pmSensitivity][quarterPhase.GetData()];
+		//		unsigned int pmIncrementForBit = (pmIncrementValue << 1) >> ((fnumModulationBits - 1) - i);
+		//		pmIncrement += pmIncrementForBit;
+		//	}
+		//}
+
+		//if(pmInverted)
+		//{
+		//	frequencyData -= pmIncrement;
+		//}
+		//else
+		//{
+		//	frequencyData += pmIncrement;
+		//}
+
+		//Clamp the adjusted fnum value to an 11-bit result.
+		frequencyData &= ((1 << fnumDataBitCount) - 1);
+	}
+
+	//Adjust the fnum data by the block shift data, to calculate the initial phase
+	//increment value. The block data applies a shift to fnum in the following way:
+	//-------------------------------------------------
+	//|  0  |  1  |  2  |  3  |  4  |  5  |  6  |  7  |
+	//|-----------------------------------------------|
+	//| >>1 |  -  | <<1 | <<2 | <<3 | <<4 | <<5 | <<6 |
+	//-------------------------------------------------
+	//Note the loss of precision when block=0. The LSB of fnum is discarded when block=0.
+	//This has been confirmed through hardware tests.
+	unsigned int phaseIncrement;
+	if(blockData == 0)
+	{
+		phaseIncrement = (frequencyData >> 1);
+	}
+	else
+	{
+		phaseIncrement = frequencyData << (blockData - 1);
+	}
+
+	//Apply detune to the phase increment value. Note that the detune adjustment is
+	//applied before the frequency multiplier.
+	unsigned int keyCode = CalculateKeyCode(blockData, frequencyData);
+	bool detuneNegative = ((detuneData >> (detuneBitCount - 1)) & 0x1) != 0;
+	unsigned int detuneIndex = detuneData & ((1 << (detuneBitCount - 1)) - 1);
+	unsigned int detuneIncrement = detunePhaseIncrementTable[keyCode][detuneIndex];
+	if(detuneNegative)
+	{
+		phaseIncrement -= detuneIncrement;
+	}
+	else
+	{
+		phaseIncrement += detuneIncrement;
+	}
+
+	//Clamp the intermediate phase increment to a 17-bit result. This is necessary in
+	//order to accurately emulate overflows caused by the detune adjustment.
+	const unsigned int intermediatePhaseIncrementBitCount = 17;
+	phaseIncrement &= ((1 << intermediatePhaseIncrementBitCount) - 1);
+
+	//Apply the frequency multiplier to the phase increment value
+	if(multipleData == 0)
+	{
+		phaseIncrement /= 2;
+	}
+	else
+	{
+		phaseIncrement *= multipleData;
+	}
+
+	//Return the phase increment value to apply to the phase counter
+	return phaseIncrement;
+}
+
+//----------------------------------------------------------------------------------------
+//This function implements the KeyCode formula as described on page 25 of the YM2608
+//documentation. Result is a 5-bit number with the following structure:
+// ---------------------
+// | 4 | 3 | 2 | 1 | 0 |
+// |-------------------|
+// |   Block   |N4 |N3 |
+// ---------------------
+//Where Block is the 3-bit block data, and N4/N3 are built from fnumber as follows:
+// N4=F11
+// N3=F11&(F10|F9|F8) | !F11&F10&F9&F8
+//Where FXX indicates bit XX from fnumber, starting with the LSB as 1.
+//----------------------------------------------------------------------------------------
+unsigned int PhaseGenerator::CalculateKeyCode(unsigned int block, unsigned int fnumber)
+{
+	bool f11 = ((fnumber >> 10) & 0x1) != 0;
+	bool f10 = ((fnumber >> 9) & 0x1) != 0;
+	bool f9 = ((fnumber >> 8) & 0x1) != 0;
+	bool f8 = ((fnumber >> 7) & 0x1) != 0;
+	bool n4 = f11;
+	bool n3 = (f11 && (f10 || f9 || f8)) || (!f11 && (f10 && f9 && f8));
+	return ((block & ((1 << blockDataBitCount) - 1)) << 2) | ((n4? 1: 0) << 1) | (n3? 1: 0);
+}
+
+//----------------------------------------------------------------------------------------
+//Phase modulation from the LFO is driven by bits 2-6 of the LFO counter. The phase
+//increment of an operator can only change with the LFO when this index changes.
+//----------------------------------------------------------------------------------------
+unsigned int PhaseGenerator::GetPhaseModulationIndex(unsigned int lfoCounter)
+{
+	return (lfoCounter >> 2) & ((1 << phaseModIndexBitCount) - 1);
+}
+
+//----------------------------------------------------------------------------------------
+//This function returns true if a write to the target register can change the phase
+//increment of any operator. Location is a full register number, with the second
+//register part at 0x100-0x1FF. The registers which feed the phase increment are:
+//-27H:      Channel 3 mode, which selects the per-operator frequency for channel 3
+//-30H-3FH:  Detune and multiple for each operator
+//-A0H-AFH:  Frequency and block for each channel, and for each channel 3 operator
+//-B4H-B7H:  Phase modulation sensitivity for each channel
+//----------------------------------------------------------------------------------------
+bool PhaseGenerator::RegisterAffectsPhaseIncrement(unsigned int location)
+{
+	if(location == 0x27)
+	{
+		return true;
+	}
+	unsigned int partRegisterNo = location & 0xFF;
+	return ((partRegisterNo >= 0x30) && (partRegisterNo <= 0x3F))
+	    || ((partRegisterNo >= 0xA0) && (partRegisterNo <= 0xAF))
+	    || ((partRegisterNo >= 0xB4) && (partRegisterNo <= 0xB7));
+}
@@ -0,0 +1,30 @@
+#ifndef __PHASEGENERATOR_H__
+#define __PHASEGENERATOR_H__
+
+class PhaseGenerator
+{
+public:
+	//Constants
+	static const unsigned int fnumDataBitCount = 11;
+	static const unsigned int blockDataBitCount = 3;
+	static const unsigned int keyCodeBitCount = 5;
+	static const unsigned int pmsBitCount = 3;
+	static const unsigned int phaseModIndexBitCount = 5;
+	static const unsigned int detuneBitCount = 3;
+	static const unsigned int phaseCounterBitCount = 20;
+	static const unsigned int phaseGeneratorOutputBitCount = 10;
+
+public:
+	//Phase increment functions
+	static unsigned int CalculatePhaseIncrement(unsigned int frequencyData, unsigned int blockData, unsigned int detuneData, unsigned int multipleData, unsigned int pmSensitivity, unsigned int lfoCounter);
+	static unsigned int CalculateKeyCode(unsigned int block, unsigned int fnumber);
+	static unsigned int GetPhaseModulationIndex(unsigned int lfoCounter);
+	static bool RegisterAffectsPhaseIncrement(unsigned int location);
+
+private:
+	//Constants
+	static const unsigned int phaseModIncrementTable[1 << pmsBitCount][1 << (phaseModIndexBitCount - 2)];
+	static const unsigned int detunePhaseIncrementTable[1 << keyCodeBitCount][1 << (detuneBitCount - 1)];
+};
+
+#endif
@@ -0,0 +1,323 @@
+#include "catch.hpp"
+#include "PhaseGenerator.h"
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <vector>
+
+//----------------------------------------------------------------------------------------
+//Register file model
+//----------------------------------------------------------------------------------------
+//This model decodes the inputs to the phase increment calculation from a raw register
+//file, following the register map given in the YM2608 Application Manual. It is
+//independent of PhaseGenerator::RegisterAffectsPhaseIncrement, so that it can be used to
+//confirm that function identifies every register which feeds the phase increments.
+//----------------------------------------------------------------------------------------
+static const unsigned int channelCount = 6;
+static const unsigned int operatorCount = 4;
+static const unsigned int operatorSlotCount = channelCount * operatorCount;
+static const unsigned int registerCountTotal = 0x200;
+
+//----------------------------------------------------------------------------------------
+static unsigned int CalculatePhaseIncrementFromRegisters(const unsigned char* registers, unsigned int channelNo, unsigned int operatorNo, unsigned int lfoCounter)
+{
+	//Operators 1-4 are mapped to register offsets 0, 8, 4, and C within each block
+	static const unsigned int operatorRegisterOffsets[operatorCount] = {0x0, 0x8, 0x4, 0xC};
+	//In channel 3 special mode, operators 1-3 take their frequency from registers
+	//A8H-AEH, while operator 4 uses the normal channel 3 frequency registers.
+	static const unsigned int channel3FrequencyRegisters[operatorCount][2] = {{0xA9, 0xAD}, {0xAA, 0xAE}, {0xA8, 0xAC}, {0xA2, 0xA6}};
+
+	unsigned int partBase = (channelNo / 3) * 0x100;
+	unsigned int channelOffset = channelNo % 3;
+	unsigned int frequencyRegisterLow = partBase + 0xA0 + channelOffset;
+	unsigned int frequencyRegisterHigh = partBase + 0xA4 + channelOffset;
+	bool channel3SpecialMode = ((registers[0x27] >> 6) & 0x3) != 0;
+	if((channelNo == 2) && channel3SpecialMode)
+	{
+		frequencyRegisterLow = channel3FrequencyRegisters[operatorNo][0];
+		frequencyRegisterHigh = channel3FrequencyRegisters[operatorNo][1];
+	}
+	unsigned int frequencyData = (unsigned int)registers[frequencyRegisterLow] | (((unsigned int)registers[frequencyRegisterHigh] & 0x7) << 8);
+	unsigned int blockData = ((unsigned int)registers[frequencyRegisterHigh] >> 3) & 0x7;
+	unsigned int detuneMultipleRegister = registers[partBase + 0x30 + channelOffset + operatorRegisterOffsets[operatorNo]];
+	unsigned int detuneData = (detuneMultipleRegister >> 4) & 0x7;
+	unsigned int multipleData = detuneMultipleRegister & 0xF;
+	unsigned int pmSensitivity = (unsigned int)registers[partBase + 0xB4 + channelOffset] & 0x7;
+	return PhaseGenerator::CalculatePhaseIncrement(frequencyData, blockData, detuneData, multipleData, pmSensitivity, lfoCounter);
+}
+
+//----------------------------------------------------------------------------------------
+static void CalculateAllPhaseIncrements(const unsigned char* registers, unsigned int lfoCounter, unsigned int* phaseIncrements)
+{
+	for(unsigned int channelNo = 0; channelNo < channelCount; ++channelNo)
+	{
+		for(unsigned int operatorNo = 0; operatorNo < operatorCount; ++operatorNo)
+		{
+			phaseIncrements[(channelNo * operatorCount) + operatorNo] = CalculatePhaseIncrementFromRegisters(registers, channelNo, operatorNo, lfoCounter);
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Register stream generation
+//----------------------------------------------------------------------------------------
+//Register streams are weighted towards the frequency, detune/multiple, PMS, and channel 3
+//mode registers, so that the phase increments change frequently, but still include
+//writes to every other register.
+//----------------------------------------------------------------------------------------
+static unsigned int RandomRegisterNo(std::mt19937& randomGenerator)
+{
+	std::uniform_int_distribution<unsigned int> registerGroup(0, 7);
+	std::uniform_int_distribution<unsigned int> partSelect(0, 1);
+	std::uniform_int_distribution<unsigned int> anyRegister(0, registerCountTotal - 1);
+	std::uniform_int_distribution<unsigned int> registerInBlock(0, 0xF);
+	std::uniform_int_distribution<unsigned int> registerInChannelBlock(0, 0x3);
+	unsigned int partBase = partSelect(randomGenerator) * 0x100;
+	switch(registerGroup(randomGenerator))
+	{
+	case 0:
+		return 0x27;
+	case 1:
+		return partBase + 0x30 + registerInBlock(randomGenerator);
+	case 2:
+		return partBase + 0xA0 + registerInBlock(randomGenerator);
+	case 3:
+		return partBase + 0xB4 + registerInChannelBlock(randomGenerator);
+	default:
+		return anyRegister(randomGenerator);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Tests
+//----------------------------------------------------------------------------------------
+TEST_CASE("PhaseGenerator::CalculatePhaseIncrement", "")
+{
+	SECTION("KeyCode", "")
+	{
+		REQUIRE(PhaseGenerator::CalculateKeyCode(0, 0) == 0);
+		REQUIRE(PhaseGenerator::CalculateKeyCode(4, 0x400) == 18);
+		REQUIRE(PhaseGenerator::CalculateKeyCode(4, 0x380) == 17);
+		REQUIRE(PhaseGenerator::CalculateKeyCode(4, 0x300) == 16);
+		REQUIRE(PhaseGenerator::CalculateKeyCode(7, 0x7FF) == 31);
+	}
+
+	SECTION("BlockDetuneMultiple", "")
+	{
+		//Block 4 shifts fnum left by 3. Block 0 discards the LSB of fnum.
+		REQUIRE(PhaseGenerator::CalculatePhaseIncrement(0x400, 4, 0, 1, 0, 0) == 0x2000);
+		REQUIRE(PhaseGenerator::CalculatePhaseIncrement(0x401, 0, 0, 1, 0, 0) == 0x200);
+		//A multiple of 0 halves the phase increment
+		REQUIRE(PhaseGenerator::CalculatePhaseIncrement(0x400, 4, 0, 0, 0, 0) == 0x1000);
+		REQUIRE(PhaseGenerator::CalculatePhaseIncrement(0x400, 4, 0, 3, 0, 0) == 0x6000);
+		//Key code 18 with detune 1 and 5 adds and subtracts 3
+		REQUIRE(PhaseGenerator::CalculatePhaseIncrement(0x400, 4, 1, 1, 0, 0) == 0x2003);
+		REQUIRE(PhaseGenerator::CalculatePhaseIncrement(0x400, 4, 5, 1, 0, 0) == 0x1FFD);
+	}
+
+	SECTION("PhaseModulation", "")
+	{
+		//Phase modulation has no effect when PMS is 0, or when the phase modulation
+		//index is 0.
+		REQUIRE(PhaseGenerator::CalculatePhaseIncrement(0x400, 4, 0, 1, 0, 0x7F) == 0x2000);
+		REQUIRE(PhaseGenerator::CalculatePhaseIncrement(0x400, 4, 0, 1, 7, 0x03) == 0x2000);
+		//The two halves of the phase modulation wave are mirror images
+		for(unsigned int lfoCounter = 0; lfoCounter < 0x40; ++lfoCounter)
+		{
+			unsigned int phaseIncrementPositive = PhaseGenerator::CalculatePhaseIncrement(0x400, 4, 0, 1, 7, lfoCounter);
+			unsigned int phaseIncrementNegative = PhaseGenerator::CalculatePhaseIncrement(0x400, 4, 0, 1, 7, lfoCounter + 0x40);
+			INFO("LFO counter " << lfoCounter);
+			REQUIRE((phaseIncrementPositive - 0x2000) == (0x2000 - phaseIncrementNegative));
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------
+TEST_CASE("PhaseGenerator::RegisterAffectsPhaseIncrement", "")
+{
+	SECTION("UnflaggedRegisters", "")
+	{
+		//Confirm that writing any value to a register which isn't flagged never changes
+		//the phase increment of any operator, from a range of initial register states
+		//and LFO positions.
+		std::mt19937 randomGenerator(1);
+		std::uniform_int_distribution<unsigned int> byteValue(0, 0xFF);
+		std::uniform_int_distribution<unsigned int> lfoCounterValue(0, 0x7F);
+		unsigned int mismatchCount = 0;
+		std::string firstMismatch;
+		for(unsigned int stateNo = 0; stateNo < 0x10; ++stateNo)
+		{
+			unsigned char registers[registerCountTotal];
+			for(unsigned int registerNo = 0; registerNo < registerCountTotal; ++registerNo)
+			{
+				registers[registerNo] = (unsigned char)byteValue(randomGenerator);
+			}
+			unsigned int lfoCounter = lfoCounterValue(randomGenerator);
+			unsigned int expectedPhaseIncrements[operatorSlotCount];
+			CalculateAllPhaseIncrements(registers, lfoCounter, expectedPhaseIncrements);
+			for(unsigned int registerNo = 0; registerNo < registerCountTotal; ++registerNo)
+			{
+				if(PhaseGenerator::RegisterAffectsPhaseIncrement(registerNo))
+				{
+					continue;
+				}
+				unsigned char originalValue = registers[registerNo];
+				for(unsigned int value = 0; value < 0x100; ++value)
+				{
+					registers[registerNo] = (unsigned char)value;
+					unsigned int actualPhaseIncrements[operatorSlotCount];
+					CalculateAllPhaseIncrements(registers, lfoCounter, actualPhaseIncrements);
+					for(unsigned int operatorSlotNo = 0; operatorSlotNo < operatorSlotCount; ++operatorSlotNo)
+					{
+						if(actualPhaseIncrements[operatorSlotNo] != expectedPhaseIncrements[operatorSlotNo])
+						{
+							if(mismatchCount == 0)
+							{
+								std::stringstream stream;
+								stream << std::hex << "Register " << registerNo << " value " << value << " slot " << operatorSlotNo;
+								firstMismatch = stream.str();
+							}
+							++mismatchCount;
+						}
+					}
+				}
+				registers[registerNo] = originalValue;
+			}
+		}
+		INFO(firstMismatch);
+		REQUIRE(mismatchCount == 0);
+	}
+
+	SECTION("RegisterStream", "")
+	{
+		//Run a register write stream through two models of the phase increments. The
+		//reference model recalculates every phase increment after every write and LFO
+		//step. The cached model only recalculates when a write is flagged by
+		//RegisterAffectsPhaseIncrement, or when the phase modulation index changes, in
+		//the same way as YM2612::UpdatePhaseIncrements. The phase increments from both
+		//models must match at every step.
+		std::mt19937 randomGenerator(2);
+		std::uniform_int_distribution<unsigned int> byteValue(0, 0xFF);
+		std::uniform_int_distribution<unsigned int> lfoStep(0, 7);
+		unsigned char registers[registerCountTotal] = {};
+		unsigned int lfoCounter = 0;
+		unsigned int cachedPhaseIncrements[operatorSlotCount];
+		CalculateAllPhaseIncrements(registers, lfoCounter, cachedPhaseIncrements);
+		unsigned int cachedPMIndex = PhaseGenerator::GetPhaseModulationIndex(lfoCounter);
+		bool cachedPhaseIncrementsStale = false;
+		unsigned int recalculationCount = 0;
+		unsigned int mismatchCount = 0;
+		std::string firstMismatch;
+		const unsigned int stepCount = 200000;
+		for(unsigned int stepNo = 0; stepNo < stepCount; ++stepNo)
+		{
+			//Apply the next register write
+			unsigned int registerNo = RandomRegisterNo(randomGenerator);
+			registers[registerNo] = (unsigned char)byteValue(randomGenerator);
+			if(PhaseGenerator::RegisterAffectsPhaseIncrement(registerNo))
+			{
+				cachedPhaseIncrementsStale = true;
+			}
+
+			//Advance the LFO. The LFO counter is occasionally forced back to 0, as it is
+			//when the LFO is disabled.
+			unsigned int lfoStepValue = lfoStep(randomGenerator);
+			lfoCounter = (lfoStepValue == 0)? 0: (lfoCounter + ((lfoStepValue < 4)? 1: 0));
+
+			//Update the cached model
+			unsigned int pmIndex = PhaseGenerator::GetPhaseModulationIndex(lfoCounter);
+			if(cachedPhaseIncrementsStale || (pmIndex != cachedPMIndex))
+			{
+				CalculateAllPhaseIncrements(registers, lfoCounter, cachedPhaseIncrements);
+				cachedPhaseIncrementsStale = false;
+				cachedPMIndex = pmIndex;
+				++recalculationCount;
+			}
+
+			//Compare against the reference model
+			unsigned int expectedPhaseIncrements[operatorSlotCount];
+			CalculateAllPhaseIncrements(registers, lfoCounter, expectedPhaseIncrements);
+			for(unsigned int operatorSlotNo = 0; operatorSlotNo < operatorSlotCount; ++operatorSlotNo)
+			{
+				if(cachedPhaseIncrements[operatorSlotNo] != expectedPhaseIncrements[operatorSlotNo])
+				{
+					if(mismatchCount == 0)
+					{
+						std::stringstream stream;
+						stream << std::hex << "Step " << stepNo << " register " << registerNo << " slot " << operatorSlotNo << " expected " << expectedPhaseIncrements[operatorSlotNo] << " actual " << cachedPhaseIncrements[operatorSlotNo];
+						firstMismatch = stream.str();
+					}
+					++mismatchCount;
+				}
+			}
+		}
+		INFO(firstMismatch);
+		REQUIRE(mismatchCount == 0);
+		REQUIRE(recalculationCount < stepCount);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+TEST_CASE("PhaseGenerator::RegisterAffectsPhaseIncrement benchmark", "[.][benchmark]")
+{
+	//Compare recalculating the phase increments every FM clock cycle against only
+	//recalculating them when a flagged register is written or the phase modulation index
+	//changes, for a stream with one register write every 64 FM clock cycles.
+	std::mt19937 randomGenerator(3);
+	std::uniform_int_distribution<unsigned int> byteValue(0, 0xFF);
+	const unsigned int clockCount = 2000000;
+	const unsigned int clocksPerWrite = 64;
+	const unsigned int clocksPerLFOIncrement = 108;
+	std::vector<unsigned int> writeRegisters(clockCount / clocksPerWrite);
+	std::vector<unsigned char> writeValues(clockCount / clocksPerWrite);
+	for(unsigned int i = 0; i < (unsigned int)writeRegisters.size(); ++i)
+	{
+		writeRegisters[i] = RandomRegisterNo(randomGenerator);
+		writeValues[i] = (unsigned char)byteValue(randomGenerator);
+	}
+
+	unsigned char registers[registerCountTotal] = {};
+	unsigned int phaseIncrements[operatorSlotCount];
+	unsigned int checksumEveryClock = 0;
+	std::chrono::high_resolution_clock::time_point everyClockStartTime = std::chrono::high_resolution_clock::now();
+	for(unsigned int clockNo = 0; clockNo < clockCount; ++clockNo)
+	{
+		if((clockNo % clocksPerWrite) == 0)
+		{
+			registers[writeRegisters[clockNo / clocksPerWrite]] = writeValues[clockNo / clocksPerWrite];
+		}
+		CalculateAllPhaseIncrements(registers, clockNo / clocksPerLFOIncrement, phaseIncrements);
+		checksumEveryClock += phaseIncrements[clockNo % operatorSlotCount];
+	}
+	std::chrono::high_resolution_clock::time_point everyClockEndTime = std::chrono::high_resolution_clock::now();
+
+	unsigned char cachedRegisters[registerCountTotal] = {};
+	unsigned int cachedPhaseIncrements[operatorSlotCount];
+	CalculateAllPhaseIncrements(cachedRegisters, 0, cachedPhaseIncrements);
+	unsigned int cachedPMIndex = PhaseGenerator::GetPhaseModulationIndex(0);
+	bool cachedPhaseIncrementsStale = false;
+	unsigned int checksumCached = 0;
+	std::chrono::high_resolution_clock::time_point cachedStartTime = std::chrono::high_resolution_clock::now();
+	for(unsigned int clockNo = 0; clockNo < clockCount; ++clockNo)
+	{
+		if((clockNo % clocksPerWrite) == 0)
+		{
+			unsigned int registerNo = writeRegisters[clockNo / clocksPerWrite];
+			cachedRegisters[registerNo] = writeValues[clockNo / clocksPerWrite];
+			cachedPhaseIncrementsStale |= PhaseGenerator::RegisterAffectsPhaseIncrement(registerNo);
+		}
+		unsigned int lfoCounter = clockNo / clocksPerLFOIncrement;
+		unsigned int pmIndex = PhaseGenerator::GetPhaseModulationIndex(lfoCounter);
+		if(cachedPhaseIncrementsStale || (pmIndex != cachedPMIndex))
+		{
+			CalculateAllPhaseIncrements(cachedRegisters, lfoCounter, cachedPhaseIncrements);
+			cachedPhaseIncrementsStale = false;
+			cachedPMIndex = pmIndex;
+		}
+		checksumCached += cachedPhaseIncrements[clockNo % operatorSlotCount];
+	}
+	std::chrono::high_resolution_clock::time_point cachedEndTime = std::chrono::high_resolution_clock::now();
+
+	REQUIRE(checksumCached == checksumEveryClock);
+	WARN("Every clock: " << std::chrono::duration_cast<std::chrono::microseconds>(everyClockEndTime - everyClockStartTime).count() << "us, cached: " << std::chrono::duration_cast<std::chrono::microseconds>(cachedEndTime - cachedStartTime).count() << "us");
+}
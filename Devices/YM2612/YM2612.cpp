@@ -1,7 +1,11 @@
 #include "YM2612.h"
 #include "DataConversion/DataConversion.pkg"
+#include "WindowsSupport/WindowsSupport.pkg"
 #include <functional>
+#include <cmath>
 #include <thread>
+#include <emmintrin.h>
+#include <immintrin.h>
 //##DEBUG##
 //#include <iostream>
 
@@ -47,57 +51,6 @@ const unsigned int YM2612::attenuationIncrementTable[1 << rateBitCount][8] = {
 	{4,4,4,4,4,4,4,4}, {4,4,4,8,4,4,4,8}, {4,8,4,8,4,8,4,8}, {4,8,8,8,4,8,8,8},  //56-59  (0x38-0x3B)
 	{8,8,8,8,8,8,8,8}, {8,8,8,8,8,8,8,8}, {8,8,8,8,8,8,8,8}, {8,8,8,8,8,8,8,8}}; //60-63  (0x3C-0x3F)
 
-//----------------------------------------------------------------------------------------
-//This table is derived from the detune table given in the YM2608 Application Manual,
-//page 26. The negative inverse of the table (detune 4-7) is generated in code.
-//----------------------------------------------------------------------------------------
-const unsigned int YM2612::detunePhaseIncrementTable[1 << keyCodeBitCount][1 << (detuneBitCount - 1)] = {
-//	   Detune        Key-Code
-//	 0  1  2  3
-	{0, 0, 1, 2},  //0  (0x00)
-	{0, 0, 1, 2},  //1  (0x01)
-	{0, 0, 1, 2},  //2  (0x02)
-	{0, 0, 1, 2},  //3  (0x03)
-	{0, 1, 2, 2},  //4  (0x04)
-	{0, 1, 2, 3},  //5  (0x05)
-	{0, 1, 2, 3},  //6  (0x06)
-	{0, 1, 2, 3},  //7  (0x07)
-	{0, 1, 2, 4},  //8  (0x08)
-	{0, 1, 3, 4},  //9  (0x09)
-	{0, 1, 3, 4},  //10 (0x0A)
-	{0, 1, 3, 5},  //11 (0x0B)
-	{0, 2, 4, 5},  //12 (0x0C)
-	{0, 2, 4, 6},  //13 (0x0D)
-	{0, 2, 4, 6},  //14 (0x0E)
-	{0, 2, 5, 7},  //15 (0x0F)
-	{0, 2, 5, 8},  //16 (0x10)
-	{0, 3, 6, 8},  //17 (0x11)
-	{0, 3, 6, 9},  //18 (0x12)
-	{0, 3, 7,10},  //19 (0x13)
-	{0, 4, 8,11},  //20 (0x14)
-	{0, 4, 8,12},  //21 (0x15)
-	{0, 4, 9,13},  //22 (0x16)
-	{0, 5,10,14},  //23 (0x17)
-	{0, 5,11,16},  //24 (0x18)
-	{0, 6,12,17},  //25 (0x19)
-	{0, 6,13,19},  //26 (0x1A)
-	{0, 7,14,20},  //27 (0x1B)
-	{0, 8,16,22},  //28 (0x1C)
-	{0, 8,16,22},  //29 (0x1D)
-	{0, 8,16,22},  //30 (0x1E)
-	{0, 8,16,22}}; //31 (0x1F)
-
-//----------------------------------------------------------------------------------------
-const unsigned int YM2612::phaseModIncrementTable[1 << pmsBitCount][1 << (phaseModIndexBitCount - 2)] = {
-	{0, 0, 0, 0, 0, 0, 0, 0},  //0
-	{0, 0, 0, 0, 1, 1, 1, 1},  //1
-	{0, 0, 0, 1, 1, 1, 2, 2},  //2
-	{0, 0, 1, 1, 2, 2, 3, 3},  //3
-	{0, 0, 1, 2, 2, 2, 3, 4},  //4
-	{0, 0, 2, 3, 4, 4, 5, 6},  //5
-	{0, 0, 4, 6, 8, 8,10,12},  //6
-	{0, 0, 8,12,16,16,20,24}}; //7
-
 //----------------------------------------------------------------------------------------
 const unsigned int YM2612::channelAddressOffsets[channelCount] = {
 	0,                         //Channel 1
@@ -129,7 +82,8 @@ YM2612::YM2612(const std::wstring& aimplementationName, const std::wstring& ains
 status(8), bstatus(8), reg(registerCountTotal, false, Data(8)),
 latchedFrequencyData(channelCount, Data(8)), blatchedFrequencyData(channelCount, Data(8)),
 latchedFrequencyDataCH3(3, Data(8)), blatchedFrequencyDataCH3(3, Data(8)),
-timerAOverflowTimes(false)
+timerAOverflowTimes(false),
+outputSink(0), wavLogWriter(wavLogCount)
 {
 	//Bus interface
 	memoryBus = 0;
@@ -143,9 +97,14 @@ timerAOverflowTimes(false)
 	timerAClockDivider = 1;
 	timerBClockDivider = 16;
 
-	//Initialize the audio output stream
+	//Initialize the phase generator state
+	phaseGenerator = AdvancePhaseGeneratorsScalar;
+	operatorPhaseIncrementsStale = true;
+	operatorPhaseIncrementsPMIndex = 0;
+
+	//Set the audio output sample rate. Note that the output stream is opened against the
+	//system audio output sink once we've been bound to the system.
 	outputSampleRate = 48000;	//44100;
-	outputStream.Open(2, 16, outputSampleRate, outputSampleRate/4, outputSampleRate/20);
 
 	//Initialize the raw register locking state
 	for(unsigned int registerNo = 0; registerNo < registerCountTotal; ++registerNo)
@@ -175,6 +134,17 @@ timerAOverflowTimes(false)
 	timerBStateLocking.counter = false;
 }
 
+//----------------------------------------------------------------------------------------
+YM2612::~YM2612()
+{
+	//Close our audio output stream, and return the sink to the system.
+	outputStream.Close();
+	if(outputSink != 0)
+	{
+		GetSystemInterface().CloseAudioOutputSink(outputSink);
+	}
+}
+
 //----------------------------------------------------------------------------------------
 //Interface version functions
 //----------------------------------------------------------------------------------------
@@ -253,6 +223,22 @@ bool YM2612::BuildDevice()
 		powTable[i] = result;
 	}
 
+	//Select the phase generator implementation to use for this processor. Any vector
+	//implementation is verified against the scalar implementation before it's selected.
+	phaseGenerator = SelectPhaseGenerator();
+
+	//Open our audio output stream against the sink provided by the system. The system
+	//decides where the audio is sent, and can redirect it without the stream being
+	//reopened.
+	if(outputSink == 0)
+	{
+		outputSink = GetSystemInterface().OpenAudioOutputSink(GetDeviceContext());
+		if(outputSink != 0)
+		{
+			outputStream.Open(*outputSink, 2, 16, outputSampleRate);
+		}
+	}
+
 	//Initialize the wave logging state
 	std::wstring captureFolder = GetSystemInterface().GetCapturePath();
 	wavLoggingEnabled = false;
@@ -434,8 +420,9 @@ void YM2612::Initialize()
 	irqLineState = false;
 
 	//Initialize the render thread properties
-	remainingRenderTime = 0;
+	remainingExternalClockCycles = 0;
 	egRemainingRenderCycles = 0;
+	outputSampleRemainder = 0;
 	outputBuffer.clear();
 
 	//Clear all register latch data
@@ -454,19 +441,26 @@ void YM2612::Initialize()
 	envelopeCycleCounter = 0;
 	cyclesUntilLFOIncrement = 0;
 	currentLFOCounter = 0;
-	for(unsigned int channelNo = 0; channelNo < channelCount; ++channelNo)
+	for(unsigned int operatorSlotNo = 0; operatorSlotNo < operatorSlotCount; ++operatorSlotNo)
 	{
-		for(unsigned int operatorNo = 0; operatorNo < operatorCount; ++operatorNo)
-		{
-			operatorData[channelNo][operatorNo].phase = OperatorData::ADSR_RELEASE;
-			operatorData[channelNo][operatorNo].keyonPrevious = false;
-			operatorData[channelNo][operatorNo].keyon = false;
-			operatorData[channelNo][operatorNo].csmKeyOn = false;
-			operatorData[channelNo][operatorNo].attenuation = (1 << attenuationBitCount) - 1;
-			operatorData[channelNo][operatorNo].ssgOutputInverted = false;
-		}
+		operatorADSRPhase[operatorSlotNo] = ADSRPhase::Release;
+		operatorKeyOnPrevious[operatorSlotNo] = false;
+		operatorKeyOn[operatorSlotNo] = false;
+		operatorCSMKeyOn[operatorSlotNo] = false;
+		operatorAttenuation[operatorSlotNo] = (1 << attenuationBitCount) - 1;
+		operatorSSGOutputInverted[operatorSlotNo] = false;
 	}
 
+	//Initialize the phase generator state
+	for(unsigned int operatorSlotNo = 0; operatorSlotNo < operatorSlotCount; ++operatorSlotNo)
+	{
+		operatorPhaseCounter[operatorSlotNo] = 0;
+		operatorPhaseIncrement[operatorSlotNo] = 0;
+		operatorPhaseOutput[operatorSlotNo] = 0;
+	}
+	operatorPhaseIncrementsStale = true;
+	operatorPhaseIncrementsPMIndex = 0;
+
 	//Fix any locked registers at their set value
 	std::unique_lock<std::mutex> lock2(registerLockMutex);
 	for(std::map<unsigned int, std::list<RegisterLocking>>::const_iterator lockedRegisterStateIterator = lockedRegisterState.begin(); lockedRegisterStateIterator != lockedRegisterState.end(); ++lockedRegisterStateIterator)
@@ -934,6 +928,19 @@ void YM2612::RenderThread()
 		double fmClock = (externalClockRate / fmClockDivider) / outputClockDivider;
 		double fmClockPeriod = 1000000000 / fmClock;
 
+		//The render position is tracked as an integer count of external clock cycles.
+		//The time of each register write within the timeslice is converted into the
+		//nearest whole external clock cycle from the start of the timeslice, rather than
+		//converting the time between each write, so that conversion errors never
+		//accumulate. Any external clock cycles left over after the last whole FM clock
+		//cycle in the timeslice are carried forward into the next timeslice, so the number
+		//of samples generated doesn't drift.
+		unsigned int externalClockCyclesPerFMClock = fmClockDivider * outputClockDivider;
+		double externalClockCyclesPerNanosecond = externalClockRate / 1000000000.0;
+		double timesliceProgress = 0;
+		long long timesliceTargetExternalClockCycles = (long long)remainingExternalClockCycles;
+		long long timesliceRenderedExternalClockCycles = 0;
+
 		//Render the YM2612 output
 		size_t outputBufferPos = outputBuffer.size();
 //		unsigned int outputBufferMultiplexedPos = 0;
@@ -941,39 +948,91 @@ void YM2612::RenderThread()
 		bool moreSamplesRemaining = true;
 		while(moreSamplesRemaining)
 		{
-			//Determine the time of the next write. Note that currently, this may be
+			//Determine the time of the next write, and convert it into a position in
+			//external clock cycles. Note that currently, the time to the next write may be
 			//negative under certain circumstances, in particular when a write occurs past
 			//the end of a timeslice. Negative times won't cause writes to be processed at
-			//the incorrect time under the current model, but we do need to ensure that
-			//remainingRenderTime isn't negative before attempting to generate an output.
-			remainingRenderTime += reg.GetNextWriteTime(regTimesliceCopy);
+			//the incorrect time under the current model, but we do need to ensure we
+			//don't attempt to generate an output when the target position is behind the
+			//rendered position.
+			timesliceProgress += reg.GetNextWriteTime(regTimesliceCopy);
+			timesliceTargetExternalClockCycles = (long long)remainingExternalClockCycles + (long long)std::floor((timesliceProgress * externalClockCyclesPerNanosecond) + 0.5);
 
 			//##DEBUG##
-//			std::wcout << "YM2612 Buffer:\t" << remainingRenderTime << '\t' << outputBuffer.size() << '\t' << ((unsigned int)(remainingRenderTime / fmClockPeriod) * 2) << '\n';
+//			std::wcout << "YM2612 Buffer:\t" << timesliceTargetExternalClockCycles << '\t' << outputBuffer.size() << '\n';
 
-			//Calculate the output sample count. Note that remainingRenderTime may be
-			//negative, but we catch that below before using outputSampleCount.
-			unsigned int outputSampleCount = ((unsigned int)(remainingRenderTime / fmClockPeriod) * 2);
+			//Calculate the number of whole FM clock cycles to run before the next
+			//settings change or the end of the target timeslice
+			long long pendingExternalClockCycles = timesliceTargetExternalClockCycles - timesliceRenderedExternalClockCycles;
+			unsigned int fmClockCyclesToRender = (pendingExternalClockCycles > 0)? (unsigned int)(pendingExternalClockCycles / externalClockCyclesPerFMClock): 0;
 
 			//If we have one or more output samples to generate before the next settings
 			//change or the end of the target timeslice, generate and output the samples.
-			if((remainingRenderTime > 0) && (outputSampleCount > 0))
+			if(fmClockCyclesToRender > 0)
 			{
 				//Resize the output buffer to fit the samples we're about to add
+				unsigned int outputSampleCount = fmClockCyclesToRender * 2;
 				outputBuffer.resize(outputBuffer.size() + outputSampleCount);
 	//			outputBufferMultiplexed.resize(outputBufferMultiplexed.size() + (outputSampleCount * channelCount));
 
-				//##TODO## Change the way we advance the render thread so that the update
-				//steps are driven by integer cycle numbers, rather than timeslice values.
-				//Refer to the timer update function.
-				while(remainingRenderTime >= fmClockPeriod)
+				//Bring the phase increments up to date with the register state. The phase
+				//increment for each operator only depends on the register state and the
+				//current LFO phase modulation index. Register changes are only committed
+				//between each of these render steps, and only flag the phase increments as
+				//stale when they write a register which feeds them, so the phase
+				//increments only need to be checked again within this step when the LFO
+				//counter changes.
+				UpdatePhaseIncrements();
+
+				//Read the register state which is used by every cycle in this render step.
+				//Since register changes are only committed between each render step, these
+				//values are fixed for the whole step, so we only need to decode them once
+				//here rather than on every FM clock cycle.
+				const unsigned int lfoIncrementValues[8] = {108, 77, 71, 67, 62, 44, 8, 5};
+				bool csmModeActive = (GetCH3Mode(accessTarget) == 2);
+				bool lfoEnabled = GetLFOEnabled(accessTarget);
+				unsigned int lfoIncrementPeriod = lfoIncrementValues[GetLFOData(accessTarget)];
+				bool dacEnabled = GetDACEnabled(accessTarget);
+				unsigned int dacData = GetDACData(accessTarget);
+				unsigned int channelAlgorithm[channelCount];
+				unsigned int channelFeedback[channelCount];
+				bool channelOutputLeftEnabled[channelCount];
+				bool channelOutputRightEnabled[channelCount];
+				for(unsigned int channelNo = 0; channelNo < channelCount; ++channelNo)
+				{
+					unsigned int channelAddressOffset = GetChannelBlockAddressOffset(channelNo);
+					channelAlgorithm[channelNo] = GetAlgorithmData(channelAddressOffset, accessTarget);
+					channelFeedback[channelNo] = GetFeedbackData(channelAddressOffset, accessTarget);
+					channelOutputLeftEnabled[channelNo] = GetOutputLeft(channelAddressOffset, accessTarget);
+					channelOutputRightEnabled[channelNo] = GetOutputRight(channelAddressOffset, accessTarget);
+				}
+
+				//Resize the channel output buffer to hold the panned output of each channel
+				//for every cycle in this render step. The channels are mixed together in a
+				//separate pass once all the cycles in this step have been generated.
+				renderChannelOutputBuffer.resize(fmClockCyclesToRender * channelCount * 2);
+				int* nextChannelOutput = &renderChannelOutputBuffer[0];
+
+				//Extend the wave log buffer for each enabled operator log to fit the
+				//samples for this render step, so that each sample can be written
+				//directly to its final position.
+				short* nextOperatorLogSample[channelCount][operatorCount];
+				for(unsigned int channelNo = 0; channelNo < channelCount; ++channelNo)
+				{
+					for(unsigned int operatorNo = 0; operatorNo < operatorCount; ++operatorNo)
+					{
+						nextOperatorLogSample[channelNo][operatorNo] = wavLoggingOperatorEnabled[channelNo][operatorNo]? ExtendAudioLogBuffer(wavLogNoOperatorBase + (channelNo * operatorCount) + operatorNo, fmClockCyclesToRender): 0;
+					}
+				}
+
+				for(unsigned int fmClockCycleNo = 0; fmClockCycleNo < fmClockCyclesToRender; ++fmClockCycleNo)
 				{
 					//If CSM mode is active, advance the timer A overflow buffer by one step.
 					//We make this conditional as an optimization, to prevent the need to
 					//advance the timer A overflow buffer at such a fine resolution every
 					//update cycle, for such a rarely used feature. We use a larger update
 					//step later on for cases where CSM mode is inactive.
-					if(GetCH3Mode(accessTarget) == 2)
+					if(csmModeActive)
 					{
 						//Reset the committed state. We do this before each update, as we use
 						//the overflow value as a signal line which is only asserted when an
@@ -996,7 +1055,7 @@ void YM2612::RenderThread()
 						updateEnvelopeGenerator = true;
 					}
 
-					//Update the state of the envelope and phase generators for each operator
+					//Update the state of the envelope generator for each operator
 					for(unsigned int channelNo = 0; channelNo < channelCount; ++channelNo)
 					{
 						for(unsigned int operatorNo = 0; operatorNo < operatorCount; ++operatorNo)
@@ -1005,26 +1064,31 @@ void YM2612::RenderThread()
 						}
 					}
 
+					//Update the phase generators for all operators together. Note that the
+					//phase generator update is always the last step in updating each
+					//operator, so performing it as a separate pass here gives the same
+					//result as updating each operator in turn.
+					phaseGenerator(operatorSlotCount, &operatorPhaseCounter[0], &operatorPhaseIncrement[0], &operatorPhaseOutput[0]);
+
 					//Update the LFO
-					if(GetLFOEnabled(accessTarget))
+					if(lfoEnabled)
 					{
 						--cyclesUntilLFOIncrement;
 						if(cyclesUntilLFOIncrement <= 0)
 						{
-							const unsigned int lfoIncrementValues[8] = {108, 77, 71, 67, 62, 44, 8, 5};
-							unsigned int lfoData = GetLFOData(accessTarget);
-							cyclesUntilLFOIncrement = lfoIncrementValues[lfoData];
+							cyclesUntilLFOIncrement = lfoIncrementPeriod;
 							++currentLFOCounter;
+							UpdatePhaseIncrements();
 						}
 					}
-					else
+					else if(currentLFOCounter != 0)
 					{
 						//If the LFO is disabled, the LFO counter is forced to 0
 						currentLFOCounter = 0;
+						UpdatePhaseIncrements();
 					}
 
 					//Calculate the FM output for each channel in the YM2612 for this sample
-					int channelOutput[channelCount][2];
 					for(unsigned int channelNo = 0; channelNo < channelCount; ++channelNo)
 					{
 						//Calculate the address offset for all channel registers for the
@@ -1032,7 +1096,7 @@ void YM2612::RenderThread()
 						unsigned int channelAddressOffset = GetChannelBlockAddressOffset(channelNo);
 
 						//Read the current algorithm selection for the channel
-						unsigned int algorithmNo = GetAlgorithmData(channelAddressOffset, accessTarget);
+						unsigned int algorithmNo = channelAlgorithm[channelNo];
 
 						//Calculate the output for each operator in the channel
 						for(unsigned int operatorNo = 0; operatorNo < operatorCount; ++operatorNo)
@@ -1097,7 +1161,7 @@ void YM2612::RenderThread()
 							//for phase modulation.
 							if(operatorNo == OPERATOR1)
 							{
-								unsigned int feedback = GetFeedbackData(channelAddressOffset, accessTarget);
+								unsigned int feedback = channelFeedback[channelNo];
 								if(feedback > 0)
 								{
 									phaseModulation = feedbackBuffer[channelNo][0] + feedbackBuffer[channelNo][1];
@@ -1126,15 +1190,14 @@ void YM2612::RenderThread()
 							}
 
 							//Write to the wav log
-							if(wavLoggingOperatorEnabled[channelNo][operatorNo])
+							if(nextOperatorLogSample[channelNo][operatorNo] != 0)
 							{
-								std::unique_lock<std::mutex> lock(waveLoggingMutex);
 								short outputSample;
 								float operatorOutputNormalized = (float)operatorOutput[channelNo][operatorNo] / ((1 << (operatorOutputBitCount - 1)) - 1);
 								//We halve the amplitude of the operator output just to
 								//make it a little easier to work with.
 								outputSample = (short)(operatorOutputNormalized * (32767.0f/2));
-								wavLogOperator[channelNo][operatorNo].WriteData(outputSample);
+								*(nextOperatorLogSample[channelNo][operatorNo]++) = outputSample;
 							}
 						}
 
@@ -1220,14 +1283,13 @@ void YM2612::RenderThread()
 						}
 
 						//DAC support
-						if((channelNo == CHANNEL6) && GetDACEnabled(accessTarget))
+						if((channelNo == CHANNEL6) && dacEnabled)
 						{
 							const unsigned int dacDataBitCount = 8;
 							//The DAC data is written as an unsigned value. We convert it to
 							//a signed value here.
 							//##TODO## It's possible the DAC data uses a primitive sign bit.
 							//Perform a test to determine whether this is the case.
-							unsigned int dacData = GetDACData(accessTarget);
 							int dacResult = (int)dacData - 0x80;
 							//Convert from the 8-bit signed DAC data value to a 14-bit signed
 							//operator output. The DAC data is mapped to the upper 8 bits of
@@ -1261,31 +1323,45 @@ void YM2612::RenderThread()
 						}
 
 						//Pan Left/Right
-						channelOutput[channelNo][0] = GetOutputLeft(channelAddressOffset, accessTarget)? combinedChannelOutput: 0;
-						channelOutput[channelNo][1] = GetOutputRight(channelAddressOffset, accessTarget)? combinedChannelOutput: 0;
+						*(nextChannelOutput++) = channelOutputLeftEnabled[channelNo]? combinedChannelOutput: 0;
+						*(nextChannelOutput++) = channelOutputRightEnabled[channelNo]? combinedChannelOutput: 0;
+					}
+				}
 
-						//Write to the wave log
-						if(wavLoggingChannelEnabled[channelNo])
+				//Write the output of each channel for this render step to the wave logs
+				for(unsigned int channelNo = 0; channelNo < channelCount; ++channelNo)
+				{
+					if(wavLoggingChannelEnabled[channelNo])
+					{
+						const int* channelOutput = &renderChannelOutputBuffer[channelNo * 2];
+						short* nextLogSample = ExtendAudioLogBuffer(wavLogNoChannelBase + channelNo, fmClockCyclesToRender * 2);
+						for(unsigned int fmClockCycleNo = 0; fmClockCycleNo < fmClockCyclesToRender; ++fmClockCycleNo)
 						{
-							std::unique_lock<std::mutex> lock(waveLoggingMutex);
 							short outputSampleLeft;
 							short outputSampleRight;
-							float channelOutputLeftNormalized = (float)channelOutput[channelNo][0] / ((1 << (accumulatorOutputBitCount - 1)) - 1);
-							float channelOutputRightNormalized = (float)channelOutput[channelNo][1] / ((1 << (accumulatorOutputBitCount - 1)) - 1);
+							float channelOutputLeftNormalized = (float)channelOutput[0] / ((1 << (accumulatorOutputBitCount - 1)) - 1);
+							float channelOutputRightNormalized = (float)channelOutput[1] / ((1 << (accumulatorOutputBitCount - 1)) - 1);
 							//We halve the amplitude of the channel output just to
 							//make it a little easier to work with.
 							outputSampleLeft = (short)(channelOutputLeftNormalized * (32767.0f/2));
 							outputSampleRight = (short)(channelOutputRightNormalized * (32767.0f/2));
-							wavLogChannel[channelNo].WriteData(outputSampleLeft);
-							wavLogChannel[channelNo].WriteData(outputSampleRight);
+							*(nextLogSample++) = outputSampleLeft;
+							*(nextLogSample++) = outputSampleRight;
+							channelOutput += channelCount * 2;
 						}
 					}
+				}
 
+				//Mix the channel outputs for each cycle in this render step
+				const int* channelOutput = &renderChannelOutputBuffer[0];
+				short* nextLogSample = wavLoggingEnabled? ExtendAudioLogBuffer(wavLogNoMixed, fmClockCyclesToRender * 2): 0;
+				for(unsigned int fmClockCycleNo = 0; fmClockCycleNo < fmClockCyclesToRender; ++fmClockCycleNo)
+				{
 					//##FIX##
 					//Run the combined channel output from the accumulator through the
 					//embedded YM3016 DAC. Note that we perform this calculation in the 2's
 					//compliment mode for the DAC.
-	//				Data channelOutputLeft(16, channelOutput[channelNo][0]);
+	//				Data channelOutputLeft(16, channelOutput[(channelNo * 2) + 0]);
 
 					//Calculate the shift value
 	//				unsigned int shiftLeft = 6;
@@ -1315,8 +1391,8 @@ void YM2612::RenderThread()
 					double finalOutputRight = 0;
 					for(unsigned int i = 0; i < channelCount; ++i)
 					{
-						float channelOutputLeftNormalized = (float)channelOutput[i][0] / ((1 << (accumulatorOutputBitCount - 1)) - 1);
-						float channelOutputRightNormalized = (float)channelOutput[i][1] / ((1 << (accumulatorOutputBitCount - 1)) - 1);
+						float channelOutputLeftNormalized = (float)channelOutput[(i * 2) + 0] / ((1 << (accumulatorOutputBitCount - 1)) - 1);
+						float channelOutputRightNormalized = (float)channelOutput[(i * 2) + 1] / ((1 << (accumulatorOutputBitCount - 1)) - 1);
 						finalOutputLeft += (channelOutputLeftNormalized / channelCount);
 						finalOutputRight += (channelOutputRightNormalized / channelCount);
 					}
@@ -1324,21 +1400,20 @@ void YM2612::RenderThread()
 					short outputSampleRight = (short)(32767.0f * finalOutputRight);
 					outputBuffer[outputBufferPos++] = outputSampleLeft;
 					outputBuffer[outputBufferPos++] = outputSampleRight;
+					channelOutput += channelCount * 2;
 
 					//Write to the wave log
-					if(wavLoggingEnabled)
+					if(nextLogSample != 0)
 					{
-						std::unique_lock<std::mutex> lock(waveLoggingMutex);
-						Stream::ViewBinary wavlogStream(wavLog);
-						wavlogStream << outputSampleLeft;
-						wavlogStream << outputSampleRight;
+						*(nextLogSample++) = outputSampleLeft;
+						*(nextLogSample++) = outputSampleRight;
 					}
 
 					////Calculate the true multiplexed output for the YM2612
 					//for(unsigned int i = 0; i < channelCount; ++i)
 					//{
-					//	float channelOutputLeftNormalized = (float)channelOutput[i][0] / ((1 << (accumulatorOutputBitCount - 1)) - 1);
-					//	float channelOutputRightNormalized = (float)channelOutput[i][1] / ((1 << (accumulatorOutputBitCount - 1)) - 1);
+					//	float channelOutputLeftNormalized = (float)channelOutput[(i * 2) + 0] / ((1 << (accumulatorOutputBitCount - 1)) - 1);
+					//	float channelOutputRightNormalized = (float)channelOutput[(i * 2) + 1] / ((1 << (accumulatorOutputBitCount - 1)) - 1);
 					//	short outputSampleLeft = (short)(32767.0f * channelOutputLeftNormalized);
 					//	short outputSampleRight = (short)(32767.0f * channelOutputRightNormalized);
 					//	outputBufferMultiplexed[outputBufferMultiplexedPos++] = outputSampleLeft;
@@ -1352,14 +1427,23 @@ void YM2612::RenderThread()
 					//		wavLog.WriteData(outputSampleRight);
 					//	}
 					//}
-
-					remainingRenderTime -= fmClockPeriod;
 				}
+
+				//Advance the render position past the FM clock cycles we've just run
+				timesliceRenderedExternalClockCycles += (long long)fmClockCyclesToRender * (long long)externalClockCyclesPerFMClock;
 			}
 
 			RandomTimeAccessBuffer<Data, double>::WriteInfo writeInfo = reg.GetWriteInfo(0, regTimesliceCopy);
 			if(writeInfo.exists)
 			{
+				//If this write changes a register which feeds the phase increment
+				//calculation, flag that the phase increments need to be recalculated
+				//once the write has been committed.
+				if(RegisterAffectsPhaseIncrement(writeInfo.writeAddress))
+				{
+					operatorPhaseIncrementsStale = true;
+				}
+
 				//Handle any special case register changes
 				switch(writeInfo.writeAddress)
 				{
@@ -1410,19 +1494,19 @@ void YM2612::RenderThread()
 						{
 							if(!keyStateLocking[channelNo][OPERATOR4])
 							{
-								operatorData[channelNo][OPERATOR4].keyon = op4KeyState;
+								operatorKeyOn[GetOperatorSlotNo(channelNo, OPERATOR4)] = op4KeyState;
 							}
 							if(!keyStateLocking[channelNo][OPERATOR3])
 							{
-								operatorData[channelNo][OPERATOR3].keyon = op3KeyState;
+								operatorKeyOn[GetOperatorSlotNo(channelNo, OPERATOR3)] = op3KeyState;
 							}
 							if(!keyStateLocking[channelNo][OPERATOR2])
 							{
-								operatorData[channelNo][OPERATOR2].keyon = op2KeyState;
+								operatorKeyOn[GetOperatorSlotNo(channelNo, OPERATOR2)] = op2KeyState;
 							}
 							if(!keyStateLocking[channelNo][OPERATOR1])
 							{
-								operatorData[channelNo][OPERATOR1].keyon = op1KeyState;
+								operatorKeyOn[GetOperatorSlotNo(channelNo, OPERATOR1)] = op1KeyState;
 							}
 						}
 					}
@@ -1442,6 +1526,13 @@ void YM2612::RenderThread()
 			moreSamplesRemaining = reg.AdvanceByStep(regTimesliceCopy);
 		}
 
+		//Save the external clock cycles we haven't rendered yet, to be carried forward
+		//into the next timeslice.
+		remainingExternalClockCycles = (int)(timesliceTargetExternalClockCycles - timesliceRenderedExternalClockCycles);
+
+		//Pass the logged sample data for this timeslice to the log writer
+		SubmitAudioLogData();
+
 		//Play the mixed audio stream. Note that we fold samples from successive render
 		//operations together, ensuring that we only send data to the output audio stream
 		//when we have a significant number of samples to send.
@@ -1449,12 +1540,17 @@ void YM2612::RenderThread()
 		size_t minimumSamplesToOutput = (size_t)(outputFrequency / 60);
 		if(outputBuffer.size() >= minimumSamplesToOutput)
 		{
+			//Calculate the number of output samples to generate from our internal samples.
+			//We carry the remainder of this calculation forward to the next output
+			//buffer, so that the total number of output samples doesn't drift over time.
 			unsigned int internalSampleCount = (unsigned int)outputBuffer.size() / 2;
-			unsigned int outputSampleCount = (unsigned int)((double)internalSampleCount * ((double)outputSampleRate / (double)outputFrequency));
+			unsigned long long scaledOutputSampleCount = ((unsigned long long)internalSampleCount * (unsigned long long)outputSampleRate) + (unsigned long long)outputSampleRemainder;
+			unsigned int outputSampleCount = (unsigned int)(scaledOutputSampleCount / outputFrequency);
+			outputSampleRemainder = (unsigned int)(scaledOutputSampleCount % outputFrequency);
 			AudioStream::AudioBuffer* outputBufferFinal = outputStream.CreateAudioBuffer(outputSampleCount, 2);
 			if(outputBufferFinal != 0)
 			{
-				outputStream.ConvertSampleRate(outputBuffer, internalSampleCount, 2, outputBufferFinal->buffer, outputSampleCount);
+				outputStream.ResampleBuffer(outputBuffer, internalSampleCount, 2, outputBufferFinal->buffer, outputSampleCount);
 				outputStream.PlayBuffer(outputBufferFinal);
 			}
 			outputBuffer.clear();
@@ -1495,7 +1591,7 @@ void YM2612::UpdateOperator(unsigned int channelNo, unsigned int operatorNo, boo
 {
 	AccessTarget accessTarget;
 	accessTarget.AccessCommitted();
-	OperatorData* state = &operatorData[channelNo][operatorNo];
+	unsigned int operatorSlotNo = GetOperatorSlotNo(channelNo, operatorNo);
 
 	//Calculate the address offsets for all channel and operator registers for the target
 	//channel and operator.
@@ -1510,30 +1606,30 @@ void YM2612::UpdateOperator(unsigned int channelNo, unsigned int operatorNo, boo
 	//Update the CSM key-on state
 	if(channelNo == CHANNEL3)
 	{
-		state->csmKeyOn = (GetCH3Mode(accessTarget) == 2) && timerAOverflowTimes.ReadCommitted();
+		operatorCSMKeyOn[operatorSlotNo] = (GetCH3Mode(accessTarget) == 2) && timerAOverflowTimes.ReadCommitted();
 	}
 
 	//Respond to any key on/off changes
-	bool keyonState = state->keyon || state->csmKeyOn;
-	if(keyonState != state->keyonPrevious)
+	bool keyonState = operatorKeyOn[operatorSlotNo] || operatorCSMKeyOn[operatorSlotNo];
+	if(keyonState != operatorKeyOnPrevious[operatorSlotNo])
 	{
 		if(keyonState)
 		{
 			//Key-on
-			SetADSRPhase(channelNo, operatorNo, channelAddressOffset, operatorAddressOffset, OperatorData::ADSR_ATTACK);
+			SetADSRPhase(channelNo, operatorNo, channelAddressOffset, operatorAddressOffset, ADSRPhase::Attack);
 
 			//Restart the phase counter. Hardware tests have shown that the phase counter
 			//is always reset to 0 when key-on occurs. Note that this does include cases
 			//where key-on is triggered automatically by CSM mode.
-			state->phaseCounter = 0;
+			operatorPhaseCounter[operatorSlotNo] = 0;
 
 			//Reset the SSG-EG output inversion flag
-			state->ssgOutputInverted = false;
+			operatorSSGOutputInverted[operatorSlotNo] = false;
 		}
 		else
 		{
 			//Key-off
-			SetADSRPhase(channelNo, operatorNo, channelAddressOffset, operatorAddressOffset, OperatorData::ADSR_RELEASE);
+			SetADSRPhase(channelNo, operatorNo, channelAddressOffset, operatorAddressOffset, ADSRPhase::Release);
 
 			//If SSG-EG is enabled and the output is currently inverted, convert the
 			//current attenuation value into an equivalent non-inverted value. This
@@ -1541,12 +1637,12 @@ void YM2612::UpdateOperator(unsigned int channelNo, unsigned int operatorNo, boo
 			//not alter the output inversion flag here. Output inversion is ignored
 			//during the release phase. The output inversion flag is cleared when key-on
 			//occurs.
-			if(GetSSGEnabled(operatorAddressOffset, accessTarget) && (state->ssgOutputInverted ^ GetSSGAttack(operatorAddressOffset, accessTarget)))
+			if(GetSSGEnabled(operatorAddressOffset, accessTarget) && (operatorSSGOutputInverted[operatorSlotNo] ^ GetSSGAttack(operatorAddressOffset, accessTarget)))
 			{
-				state->attenuation = Data(attenuationBitCount, 0x200) - state->attenuation;
+				operatorAttenuation[operatorSlotNo] = (0x200 - operatorAttenuation[operatorSlotNo]) & ((1 << attenuationBitCount) - 1);
 			}
 		}
-		state->keyonPrevious = keyonState;
+		operatorKeyOnPrevious[operatorSlotNo] = keyonState;
 	}
 
 	//If SSG-EG is enabled, and the current internal attenuation level of the envelope
@@ -1560,17 +1656,17 @@ void YM2612::UpdateOperator(unsigned int channelNo, unsigned int operatorNo, boo
 	//same cycle. This can allow a single sample to be output at an attenuation level of
 	//0x200 before these update steps are applied.
 	if(GetSSGEnabled(operatorAddressOffset, accessTarget)	//SSG-EG mode is enabled
-		&& (state->attenuation >= 0x200))	//The internal attenuation value has reached the magic 0x200 threshold
+		&& (operatorAttenuation[operatorSlotNo] >= 0x200))	//The internal attenuation value has reached the magic 0x200 threshold
 	{
 		if(GetSSGAlternate(operatorAddressOffset, accessTarget)	//SSG-EG is set to an alternating pattern
-			&& (!GetSSGHold(operatorAddressOffset, accessTarget) || !state->ssgOutputInverted))	//Hold mode is disabled, or the current inversion state matches the initial inversion state at key-on
+			&& (!GetSSGHold(operatorAddressOffset, accessTarget) || !operatorSSGOutputInverted[operatorSlotNo]))	//Hold mode is disabled, or the current inversion state matches the initial inversion state at key-on
 		{
 			//Toggle the current inversion state of the envelope generator output. Note
 			//that extensive hardware tests have been performed on SSG-EG output
 			//inversion. This implementation has been shown to always produce the correct
 			//output, even under unusual circumstances such as when an attack phase is
 			//present, and/or changes are made to the SSG-EG mode at critical points.
-			state->ssgOutputInverted = !state->ssgOutputInverted;
+			operatorSSGOutputInverted[operatorSlotNo] = !operatorSSGOutputInverted[operatorSlotNo];
 
 			//Note that if the hold bit is set, the inversion state is only toggled if
 			//the current inversion state matches the initial inversion state. Under
@@ -1597,12 +1693,12 @@ void YM2612::UpdateOperator(unsigned int channelNo, unsigned int operatorNo, boo
 			//hardware. Note that the phase counter really is held at 0, not simply set
 			//to 0 at a particular point in time. This can create silence gaps between
 			//repetitions of the SSG-EG envelope where an attack phase exists.
-			state->phaseCounter = 0;
+			operatorPhaseCounter[operatorSlotNo] = 0;
 		}
 
-		if(state->phase != OperatorData::ADSR_ATTACK)
+		if(operatorADSRPhase[operatorSlotNo] != ADSRPhase::Attack)
 		{
-			if((state->phase != OperatorData::ADSR_RELEASE)
+			if((operatorADSRPhase[operatorSlotNo] != ADSRPhase::Release)
 				&& !GetSSGHold(operatorAddressOffset, accessTarget))
 			{
 				//If SSG-EG is enabled, we're in either the decay or sustain phase, and
@@ -1611,7 +1707,7 @@ void YM2612::UpdateOperator(unsigned int channelNo, unsigned int operatorNo, boo
 				//envelope again.
 
 				//Switch back to the attack phase
-				SetADSRPhase(channelNo, operatorNo, channelAddressOffset, operatorAddressOffset, OperatorData::ADSR_ATTACK);
+				SetADSRPhase(channelNo, operatorNo, channelAddressOffset, operatorAddressOffset, ADSRPhase::Attack);
 
 				//Note that we've confirmed that the attenuation is not clamped to 0x200
 				//in SSG-EG mode when the ADSR envelope loops. By toggling DR during the
@@ -1620,10 +1716,10 @@ void YM2612::UpdateOperator(unsigned int channelNo, unsigned int operatorNo, boo
 				//begins its decay from this final attenuation value. Don't uncomment the
 				//line below, it is incorrect. It is only provided as an example of what
 				//NOT to do.
-				//state->attenuation = 0x200;
+				//operatorAttenuation[operatorSlotNo] = 0x200;
 			}
-			else if((state->phase == OperatorData::ADSR_RELEASE)
-				|| !(state->ssgOutputInverted ^ GetSSGAttack(operatorAddressOffset, accessTarget)))	//If the output is not currently inverted
+			else if((operatorADSRPhase[operatorSlotNo] == ADSRPhase::Release)
+				|| !(operatorSSGOutputInverted[operatorSlotNo] ^ GetSSGAttack(operatorAddressOffset, accessTarget)))	//If the output is not currently inverted
 			{
 				//If the output is not currently inverted, and we've reached an internal
 				//attenuation level of 0x200 in one of the decay phases (either the
@@ -1638,7 +1734,7 @@ void YM2612::UpdateOperator(unsigned int channelNo, unsigned int operatorNo, boo
 				//both the hold and alternate bits are set, and the attack bit is clear.
 
 				//Force the internal attenuation value to 0x3FF
-				state->attenuation = 0x3FF;
+				operatorAttenuation[operatorSlotNo] = 0x3FF;
 
 				//Note that this behaviour can be observed when switching from an
 				//inverted hold pattern to a low-hold pattern, then back again after the
@@ -1656,202 +1752,67 @@ void YM2612::UpdateOperator(unsigned int channelNo, unsigned int operatorNo, boo
 		}
 	}
 
-	//Update the Envelope Generator
+	//Update the Envelope Generator. Note that the phase generator for each operator is
+	//updated separately, after this function has been called for all operators.
 	if(updateEnvelopeGenerator)
 	{
 		UpdateEnvelopeGenerator(channelNo, operatorNo, channelAddressOffset, operatorAddressOffset);
 	}
-
-	//Update the Phase Generator
-	UpdatePhaseGenerator(channelNo, operatorNo, channelAddressOffset, operatorAddressOffset);
 }
 
 //----------------------------------------------------------------------------------------
-//This function implements the KeyCode formula as described on page 25 of the YM2608
-//documentation. Result is a 5-bit number with the following structure:
-// ---------------------
-// | 4 | 3 | 2 | 1 | 0 |
-// |-------------------|
-// |   Block   |N4 |N3 |
-// ---------------------
-//Where Block is the 3-bit block data, and N4/N3 are built from fnumber as follows:
-// N4=F11
-// N3=F11&(F10|F9|F8) | !F11&F10&F9&F8
-//Where FXX indicates bit XX from fnumber, starting with the LSB as 1.
+//Phase generator functions
 //----------------------------------------------------------------------------------------
-unsigned int YM2612::CalculateKeyCode(unsigned int block, unsigned int fnumber) const
+void YM2612::UpdatePhaseIncrements()
 {
-	Data keyCode(keyCodeBitCount);
-	Data fnumberData(fnumDataBitCount, fnumber);
-	keyCode.SetDataSegment(2, 3, block);
-	keyCode.SetBit(1, fnumberData.GetBit(10));
-	keyCode.SetBit(0, (fnumberData.GetBit(10) && (fnumberData.GetBit(9) || fnumberData.GetBit(8) || fnumberData.GetBit(7))) || (!fnumberData.GetBit(10) && (fnumberData.GetBit(9) && fnumberData.GetBit(8) && fnumberData.GetBit(7))));
-	return keyCode.GetData();
+	//If no register which feeds the phase increments has been written, and the LFO
+	//hasn't moved to a new phase modulation index, the phase increment values from the
+	//last update are still valid.
+	unsigned int pmIndex = GetPhaseModulationIndex(currentLFOCounter);
+	if(!operatorPhaseIncrementsStale && (pmIndex == operatorPhaseIncrementsPMIndex))
+	{
+		return;
+	}
+
+	//Recalculate the phase increment value for each operator. Note that we clear the
+	//stale flag before reading the register state, so that a register change made
+	//through the debugger while we're recalculating isn't lost.
+	operatorPhaseIncrementsStale = false;
+	operatorPhaseIncrementsPMIndex = pmIndex;
+	for(unsigned int channelNo = 0; channelNo < channelCount; ++channelNo)
+	{
+		unsigned int channelAddressOffset = GetChannelBlockAddressOffset(channelNo);
+		for(unsigned int operatorNo = 0; operatorNo < operatorCount; ++operatorNo)
+		{
+			unsigned int operatorAddressOffset = GetOperatorBlockAddressOffset(channelNo, operatorNo);
+			operatorPhaseIncrement[GetOperatorSlotNo(channelNo, operatorNo)] = CalculatePhaseIncrement(channelNo, operatorNo, channelAddressOffset, operatorAddressOffset);
+		}
+	}
 }
 
 //----------------------------------------------------------------------------------------
-//Phase generator functions
-//----------------------------------------------------------------------------------------
-void YM2612::UpdatePhaseGenerator(unsigned int channelNo, unsigned int operatorNo, unsigned int channelAddressOffset, unsigned int operatorAddressOffset)
+unsigned int YM2612::CalculatePhaseIncrement(unsigned int channelNo, unsigned int operatorNo, unsigned int channelAddressOffset, unsigned int operatorAddressOffset) const
 {
 	AccessTarget accessTarget;
 	accessTarget.AccessCommitted();
-	OperatorData* state = &operatorData[channelNo][operatorNo];
 
-	//This algorithm is primarily based on the F-Number calculation given in the YM2608
-	//manual, page 24. That formula is as follows:
-	//F-Number = (144 * fnote * 2^20 / M) / 2^(B-1)
-	//Additional tests were performed on hardware to answer all remaining questions about
-	//the update process.
-
-	//Read the frequency and block data
+	//Read the register data which feeds the phase increment for the operator, and
+	//calculate the phase increment at the current LFO position.
 	unsigned int frequencyData = GetFrequencyData(channelNo, operatorNo, channelAddressOffset, accessTarget);
 	unsigned int blockData = GetBlockData(channelNo, operatorNo, channelAddressOffset, accessTarget);
-
-	//Apply frequency modulation to fnum
-	//  ---------------------------------
-	//  |          LFO Counter          |
-	//  |-------------------------------|
-	//  |...| 6 | 5 | 4 | 3 | 2 | 1 | 0 |
-	//  ----=====================--------
-	//      | Phase Modulation  |
-	//      |   Index (5-bit)   |
-	//      |-------------------|
-	//      | 4 | 3 | 2 | 1 | 0 |
-	//      ---------------------
-	Data pmCounter(phaseModIndexBitCount, currentLFOCounter >> 2);
+	unsigned int detuneData = GetDetuneData(operatorAddressOffset, accessTarget);
+	unsigned int multipleData = GetMultipleData(operatorAddressOffset, accessTarget);
 	unsigned int pmSensitivity = GetPMSData(channelAddressOffset, accessTarget);
-	if((pmCounter != 0) && (pmSensitivity != 0))
-	{
-		bool pmInverted = pmCounter.GetBit(phaseModIndexBitCount - 1);
-		bool pmSlopeNegative = pmCounter.GetBit(phaseModIndexBitCount - 2);
-		Data quarterPhase(phaseModIndexBitCount - 2, pmCounter.GetData());
-		if(pmSlopeNegative)
-		{
-			quarterPhase = ~quarterPhase;
-		}
-
-		//##TODO## Run a test where the upper 6 bits of fnum are 0, and see if the
-		//inverted frequency modulation wave will create a measurable, effective 1-bit
-		//frequency modulation due to sign-extension.
-		//##TODO## Determine whether all 11 bits of fnum are used to calculate the
-		//frequency modulation value. It's possible that all 11 bits of fnum are used to
-		//build a frequency modulation value, and that value is calculated at full
-		//precision, without any loss. That value is then sign-extended, and added to
-		//fnum, but lower bits of the frequency modulation value are discarded. If this
-		//is the case, the sign-extension behaviour will mean that a 1-bit modulation
-		//value is present, even when only the LSB of fnum is set. It would also mean
-		//that we would be able to detect the results of carry operations in the addition
-		//for the increment values for each bit, below the level of the LSB of fnum.
-
-		int pmIncrement = 0;
-		for(unsigned int i = 0; i < fnumDataBitCount; ++i)
-		{
-			if((frequencyData & (1 << i)) != 0)
-			{
-				unsigned int pmIncrementValue = phaseModIncrementTable[pmSensitivity][quarterPhase.GetData()];
-				pmIncrement += (int)(pmIncrementValue << i);
-			}
-		}
-		if(pmInverted)
-		{
-			pmIncrement = -pmIncrement;
-		}
-		pmIncrement >>= 9;
-		frequencyData += (unsigned int)pmIncrement;
-
-		////Calculate the frequency modulation value based on the upper 6 bits of fnum
-		//const unsigned int fnumModulationBits = 6;
-		//unsigned int pmSensitivity = GetPMSData(channelNo, accessTarget);
-		//unsigned int pmIncrement = 0;
-		//unsigned int frequencyDataUpperBits = frequencyData >> (fnumDataBitCount - fnumModulationBits);
-		//for(unsigned int i = 0; i < fnumModulationBits; ++i)
-		//{
-		//	if((frequencyDataUpperBits & (1 << i)) != 0)
-		//	{
-		//		unsigned int pmIncrementValue = phaseModIncrementTable[pmSensitivity][quarterPhase.GetData()];
-		//		unsigned int pmIncrementForBit = (pmIncrementValue << 1) >> ((fnumModulationBits - 1) - i);
-		//		pmIncrement += pmIncrementForBit;
-		//	}
-		//}
-
-		//if(pmInverted)
-		//{
-		//	frequencyData -= pmIncrement;
-		//}
-		//else
-		//{
-		//	frequencyData += pmIncrement;
-		//}
-
-		//Clamp the adjusted fnum value to an 11-bit result.
-		frequencyData &= ((1 << fnumDataBitCount) - 1);
-	}
-
-	//Adjust the fnum data by the block shift data, to calculate the initial phase
-	//increment value. The block data applies a shift to fnum in the following way:
-	//-------------------------------------------------
-	//|  0  |  1  |  2  |  3  |  4  |  5  |  6  |  7  |
-	//|-----------------------------------------------|
-	//| >>1 |  -  | <<1 | <<2 | <<3 | <<4 | <<5 | <<6 |
-	//-------------------------------------------------
-	//Note the loss of precision when block=0. The LSB of fnum is discarded when block=0.
-	//This has been confirmed through hardware tests.
-	unsigned int phaseIncrement;
-	if(blockData == 0)
-	{
-		phaseIncrement = (frequencyData >> 1);
-	}
-	else
-	{
-		phaseIncrement = frequencyData << (blockData - 1);
-	}
-
-	//Apply detune to the phase increment value. Note that the detune adjustment is
-	//applied before the frequency multiplier.
-	unsigned int keyCode = CalculateKeyCode(blockData, frequencyData);
-	Data detuneData(detuneBitCount, GetDetuneData(operatorAddressOffset, accessTarget));
-	bool detuneNegative = detuneData.GetBit(detuneBitCount - 1);
-	unsigned int detuneIndex = detuneData.GetDataSegment(0, 2);
-	unsigned int detuneIncrement = detunePhaseIncrementTable[keyCode][detuneIndex];
-	if(detuneNegative)
-	{
-		phaseIncrement -= detuneIncrement;
-	}
-	else
-	{
-		phaseIncrement += detuneIncrement;
-	}
-
-	//Clamp the intermediate phase increment to a 17-bit result. This is necessary in
-	//order to accurately emulate overflows caused by the detune adjustment.
-	const unsigned int intermediatePhaseIncrementBitCount = 17;
-	phaseIncrement &= ((1 << intermediatePhaseIncrementBitCount) - 1);
-
-	//Apply the frequency multiplier to the phase increment value
-	unsigned int mul = GetMultipleData(operatorAddressOffset, accessTarget);
-	if(mul == 0)
-	{
-		phaseIncrement /= 2;
-	}
-	else
-	{
-		phaseIncrement *= mul;
-	}
-
-	//Apply the phase increment to the phase counter
-	state->phaseCounter += phaseIncrement;
+	return PhaseGenerator::CalculatePhaseIncrement(frequencyData, blockData, detuneData, multipleData, pmSensitivity, currentLFOCounter);
 }
 
 //----------------------------------------------------------------------------------------
 unsigned int YM2612::GetCurrentPhase(unsigned int channelNo, unsigned int operatorNo) const
 {
-	const OperatorData* state = &operatorData[channelNo][operatorNo];
 	//This function returns the 10-bit output from the phase generator, which is used by
 	//the operator unit. This 10-bit output represents the upper 10 bits of the internal
-	//phase counter. We extract the upper 10 bits of the internal phase counter here, to
-	//build that 10-bit output.
-	return state->phaseCounter.GetDataSegment(state->phaseCounter.GetBitCount() - 10, 10);
+	//phase counter, which is extracted when the phase generators are advanced.
+	return operatorPhaseOutput[GetOperatorSlotNo(channelNo, operatorNo)];
 }
 
 //----------------------------------------------------------------------------------------
@@ -1893,25 +1854,25 @@ void YM2612::UpdateEnvelopeGenerator(unsigned int channelNo, unsigned int operat
 {
 	AccessTarget accessTarget;
 	accessTarget.AccessCommitted();
-	OperatorData* state = &operatorData[channelNo][operatorNo];
+	unsigned int operatorSlotNo = GetOperatorSlotNo(channelNo, operatorNo);
 
 	//Check if we need to progress to a different phase of the ADSR envelope
-	if(state->phase == OperatorData::ADSR_ATTACK)
+	if(operatorADSRPhase[operatorSlotNo] == ADSRPhase::Attack)
 	{
 		//If we're in the attack phase and attenuation has hit minimum, switch to the
 		//decay phase.
-		if(state->attenuation == 0)
+		if(operatorAttenuation[operatorSlotNo] == 0)
 		{
-			SetADSRPhase(channelNo, operatorNo, channelAddressOffset, operatorAddressOffset, OperatorData::ADSR_DECAY);
+			SetADSRPhase(channelNo, operatorNo, channelAddressOffset, operatorAddressOffset, ADSRPhase::Decay);
 		}
 	}
-	else if(state->phase == OperatorData::ADSR_DECAY)
+	else if(operatorADSRPhase[operatorSlotNo] == ADSRPhase::Decay)
 	{
 		unsigned int sustainLevelAsAttenuation = ConvertSustainLevelToAttenuation(GetSustainLevelData(operatorAddressOffset, accessTarget));
 
 		//If we're in the decay phase and attenuation has passed SL, switch to the
 		//sustain phase.
-		if(state->attenuation >= sustainLevelAsAttenuation)
+		if(operatorAttenuation[operatorSlotNo] >= sustainLevelAsAttenuation)
 		{
 			//We have confirmed that the current internal attenuation number is NOT
 			//clamped to SL when the decay phase passes SL. This can't happen under normal
@@ -1925,14 +1886,14 @@ void YM2612::UpdateEnvelopeGenerator(unsigned int channelNo, unsigned int operat
 			//confirmed both under normal mode and when SSG-EG is active. Don't uncomment
 			//the line below, it is incorrect. It is only provided as an example of what
 			//NOT to do.
-			//state->attenuation = sustainLevelAsAttenuation;
+			//operatorAttenuation[operatorSlotNo] = sustainLevelAsAttenuation;
 
 			//Switch from the decay phase to the sustain phase. Note that we have
 			//confirmed that changing SL after the sustain phase has been entered can't
 			//cause the operator to re-enter the decay phase. The switch from decay to
 			//sustain is a one-way process. The selection between the decay or sustain
 			//phases is not based on the current attenuation value relative to SL.
-			SetADSRPhase(channelNo, operatorNo, channelAddressOffset, operatorAddressOffset, OperatorData::ADSR_SUSTAIN);
+			SetADSRPhase(channelNo, operatorNo, channelAddressOffset, operatorAddressOffset, ADSRPhase::Sustain);
 		}
 	}
 
@@ -1941,18 +1902,18 @@ void YM2612::UpdateEnvelopeGenerator(unsigned int channelNo, unsigned int operat
 	//current phase of the envelope generator take effect immediately.
 	unsigned int rateKeyScale = CalculateRateKeyScale(GetKeyScaleData(operatorAddressOffset, accessTarget), CalculateKeyCode(GetBlockData(channelNo, operatorNo, channelAddressOffset, accessTarget), GetFrequencyData(channelNo, operatorNo, channelAddressOffset, accessTarget)));
 	unsigned int rate = 0;
-	switch(state->phase)
+	switch(operatorADSRPhase[operatorSlotNo])
 	{
-	case OperatorData::ADSR_ATTACK:
+	case ADSRPhase::Attack:
 		rate = CalculateRate(GetAttackRateData(operatorAddressOffset, accessTarget), rateKeyScale);
 		break;
-	case OperatorData::ADSR_DECAY:
+	case ADSRPhase::Decay:
 		rate = CalculateRate(GetDecayRateData(operatorAddressOffset, accessTarget), rateKeyScale);
 		break;
-	case OperatorData::ADSR_SUSTAIN:
+	case ADSRPhase::Sustain:
 		rate = CalculateRate(GetSustainRateData(operatorAddressOffset, accessTarget), rateKeyScale);
 		break;
-	case OperatorData::ADSR_RELEASE:{
+	case ADSRPhase::Release:{
 		//Note that we pass the 4-bit release rate data as a 5-bit number, with the LSB
 		//fixed to 1. This is based on the information given in the YM2608 Application
 		//Manual, page 30, which states that the release rate data is passed as
@@ -1974,8 +1935,8 @@ void YM2612::UpdateEnvelopeGenerator(unsigned int channelNo, unsigned int operat
 		unsigned int attenuationIncrement = attenuationIncrementTable[rate][updateCycle];
 
 		//Update the attenuation
-		unsigned int newAttenuation = state->attenuation.GetData();
-		if(state->phase == OperatorData::ADSR_ATTACK)
+		unsigned int newAttenuation = operatorAttenuation[operatorSlotNo];
+		if(operatorADSRPhase[operatorSlotNo] == ADSRPhase::Attack)
 		{
 			//If the attack rate is less than 62, advance the attack curve. Attack rate
 			//values of 62 and 63 have special case handling when the attack phase is
@@ -2045,20 +2006,20 @@ void YM2612::UpdateEnvelopeGenerator(unsigned int channelNo, unsigned int operat
 		}
 
 		//Write the new attenuation value to the envelope generator state
-		state->attenuation = newAttenuation;
+		operatorAttenuation[operatorSlotNo] = newAttenuation & ((1 << attenuationBitCount) - 1);
 	}
 }
 
 //----------------------------------------------------------------------------------------
-void YM2612::SetADSRPhase(unsigned int channelNo, unsigned int operatorNo, unsigned int channelAddressOffset, unsigned int operatorAddressOffset, OperatorData::ADSRPhase phase)
+void YM2612::SetADSRPhase(unsigned int channelNo, unsigned int operatorNo, unsigned int channelAddressOffset, unsigned int operatorAddressOffset, ADSRPhase phase)
 {
 	AccessTarget accessTarget;
 	accessTarget.AccessCommitted();
-	OperatorData* state = &operatorData[channelNo][operatorNo];
+	unsigned int operatorSlotNo = GetOperatorSlotNo(channelNo, operatorNo);
 
-	if(phase != state->phase)
+	if(phase != operatorADSRPhase[operatorSlotNo])
 	{
-		if(phase == OperatorData::ADSR_ATTACK)
+		if(phase == ADSRPhase::Attack)
 		{
 			//If the rate is greater than or equal to 62, the current attenuation level is
 			//forced directly to 0. This causes the next envelope generator update cycle
@@ -2069,10 +2030,10 @@ void YM2612::SetADSRPhase(unsigned int channelNo, unsigned int operatorNo, unsig
 			unsigned int rate = CalculateRate(GetAttackRateData(operatorAddressOffset, accessTarget), rateKeyScale);
 			if(rate >= 62)
 			{
-				state->attenuation = 0;
+				operatorAttenuation[operatorSlotNo] = 0;
 			}
 		}
-		state->phase = phase;
+		operatorADSRPhase[operatorSlotNo] = phase;
 	}
 }
 
@@ -2081,9 +2042,9 @@ unsigned int YM2612::GetOutputAttenuation(unsigned int channelNo, unsigned int o
 {
 	AccessTarget accessTarget;
 	accessTarget.AccessCommitted();
-	const OperatorData* state = &operatorData[channelNo][operatorNo];
+	unsigned int operatorSlotNo = GetOperatorSlotNo(channelNo, operatorNo);
 
-	unsigned int attenuation = state->attenuation.GetData();
+	unsigned int attenuation = operatorAttenuation[operatorSlotNo];
 
 	//If SSG-EG is enabled and the output is inverted, invert the output data. Note that
 	//extensive testing has been performed on the hardware to build this implementation.
@@ -2094,8 +2055,8 @@ unsigned int YM2612::GetOutputAttenuation(unsigned int channelNo, unsigned int o
 	//immediate inversion of the output. Also note the calculation performed to derive
 	//the "inverted" data. This calculation has been proven to be binary-accurate.
 	if(GetSSGEnabled(operatorAddressOffset, accessTarget)
-		&& (state->phase != OperatorData::ADSR_RELEASE)
-		&& (state->ssgOutputInverted ^ GetSSGAttack(operatorAddressOffset, accessTarget)))
+		&& (operatorADSRPhase[operatorSlotNo] != ADSRPhase::Release)
+		&& (operatorSSGOutputInverted[operatorSlotNo] ^ GetSSGAttack(operatorAddressOffset, accessTarget)))
 	{
 		attenuation = 0x200 - attenuation;
 		attenuation &= 0x3FF;
@@ -2223,6 +2184,124 @@ unsigned int YM2612::ConvertSustainLevelToAttenuation(unsigned int sustainLevel)
 	return sustainLevel;
 }
 
+//----------------------------------------------------------------------------------------
+//Phase generator vector functions
+//----------------------------------------------------------------------------------------
+//The phase generator functions advance the phase counter for a set of operators by their
+//phase increment values, wrapping each counter to 20 bits, and extract the upper 10 bits
+//of each counter as the phase generator output used by the operator unit. The scalar
+//implementation is the reference implementation. The vector implementations must always
+//produce identical results.
+//----------------------------------------------------------------------------------------
+YM2612::PhaseGeneratorFunction YM2612::SelectPhaseGenerator()
+{
+	//Select the widest supported implementation which produces the same results as the
+	//scalar implementation
+	if(ProcessorSupportsAVX2() && VerifyPhaseGenerator(AdvancePhaseGeneratorsAVX2))
+	{
+		return AdvancePhaseGeneratorsAVX2;
+	}
+	if(ProcessorSupportsSSE2() && VerifyPhaseGenerator(AdvancePhaseGeneratorsSSE2))
+	{
+		return AdvancePhaseGeneratorsSSE2;
+	}
+	return AdvancePhaseGeneratorsScalar;
+}
+
+//----------------------------------------------------------------------------------------
+bool YM2612::VerifyPhaseGenerator(PhaseGeneratorFunction phaseGeneratorFunction)
+{
+	//Advance a set of phase counters through both the target implementation and the
+	//scalar implementation over a number of steps, and confirm the results match. We use
+	//phase increment values covering the full range which can be produced by the phase
+	//increment calculation, so that wrapping of the phase counters is exercised. We also
+	//test an odd operator count, to exercise the path for any operators left over after
+	//the vector steps.
+	static const unsigned int stepCount = 0x100;
+	static const unsigned int operatorCountsToTest[2] = {operatorSlotCount, operatorSlotCount - 3};
+	for(unsigned int testNo = 0; testNo < 2; ++testNo)
+	{
+		unsigned int slotCount = operatorCountsToTest[testNo];
+		unsigned int expectedPhaseCounters[operatorSlotCount];
+		unsigned int expectedPhaseOutputs[operatorSlotCount];
+		unsigned int actualPhaseCounters[operatorSlotCount];
+		unsigned int actualPhaseOutputs[operatorSlotCount];
+		unsigned int phaseIncrements[operatorSlotCount];
+		for(unsigned int i = 0; i < operatorSlotCount; ++i)
+		{
+			expectedPhaseCounters[i] = (i * 0x9E37) & ((1 << phaseCounterBitCount) - 1);
+			actualPhaseCounters[i] = expectedPhaseCounters[i];
+			phaseIncrements[i] = ((i + 1) * 0x1F3D7) & ((1 << (phaseCounterBitCount + 1)) - 1);
+		}
+		for(unsigned int stepNo = 0; stepNo < stepCount; ++stepNo)
+		{
+			AdvancePhaseGeneratorsScalar(slotCount, &expectedPhaseCounters[0], &phaseIncrements[0], &expectedPhaseOutputs[0]);
+			phaseGeneratorFunction(slotCount, &actualPhaseCounters[0], &phaseIncrements[0], &actualPhaseOutputs[0]);
+			for(unsigned int i = 0; i < slotCount; ++i)
+			{
+				if((expectedPhaseCounters[i] != actualPhaseCounters[i]) || (expectedPhaseOutputs[i] != actualPhaseOutputs[i]))
+				{
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+void YM2612::AdvancePhaseGeneratorsScalar(unsigned int slotCount, unsigned int* phaseCounters, const unsigned int* phaseIncrements, unsigned int* phaseOutputs)
+{
+	for(unsigned int i = 0; i < slotCount; ++i)
+	{
+		unsigned int phaseCounter = (phaseCounters[i] + phaseIncrements[i]) & ((1 << phaseCounterBitCount) - 1);
+		phaseCounters[i] = phaseCounter;
+		phaseOutputs[i] = phaseCounter >> (phaseCounterBitCount - phaseGeneratorOutputBitCount);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void YM2612::AdvancePhaseGeneratorsSSE2(unsigned int slotCount, unsigned int* phaseCounters, const unsigned int* phaseIncrements, unsigned int* phaseOutputs)
+{
+	//Advance the phase counters for 4 operators at a time
+	const __m128i phaseCounterMask = _mm_set1_epi32((1 << phaseCounterBitCount) - 1);
+	unsigned int i = 0;
+	for(; (i + 4) <= slotCount; i += 4)
+	{
+		__m128i phaseCounter = _mm_loadu_si128((const __m128i*)&phaseCounters[i]);
+		__m128i phaseIncrement = _mm_loadu_si128((const __m128i*)&phaseIncrements[i]);
+		phaseCounter = _mm_and_si128(_mm_add_epi32(phaseCounter, phaseIncrement), phaseCounterMask);
+		_mm_storeu_si128((__m128i*)&phaseCounters[i], phaseCounter);
+		_mm_storeu_si128((__m128i*)&phaseOutputs[i], _mm_srli_epi32(phaseCounter, phaseCounterBitCount - phaseGeneratorOutputBitCount));
+	}
+
+	//Advance any remaining operators using the scalar implementation
+	AdvancePhaseGeneratorsScalar(slotCount - i, phaseCounters + i, phaseIncrements + i, phaseOutputs + i);
+}
+
+//----------------------------------------------------------------------------------------
+void YM2612::AdvancePhaseGeneratorsAVX2(unsigned int slotCount, unsigned int* phaseCounters, const unsigned int* phaseIncrements, unsigned int* phaseOutputs)
+{
+	//Advance the phase counters for 8 operators at a time
+	const __m256i phaseCounterMask = _mm256_set1_epi32((1 << phaseCounterBitCount) - 1);
+	unsigned int i = 0;
+	for(; (i + 8) <= slotCount; i += 8)
+	{
+		__m256i phaseCounter = _mm256_loadu_si256((const __m256i*)&phaseCounters[i]);
+		__m256i phaseIncrement = _mm256_loadu_si256((const __m256i*)&phaseIncrements[i]);
+		phaseCounter = _mm256_and_si256(_mm256_add_epi32(phaseCounter, phaseIncrement), phaseCounterMask);
+		_mm256_storeu_si256((__m256i*)&phaseCounters[i], phaseCounter);
+		_mm256_storeu_si256((__m256i*)&phaseOutputs[i], _mm256_srli_epi32(phaseCounter, phaseCounterBitCount - phaseGeneratorOutputBitCount));
+	}
+
+	//Clear the upper halves of the ymm registers, to avoid a transition penalty when SSE
+	//instructions are next used.
+	_mm256_zeroupper();
+
+	//Advance any remaining operators using the scalar implementation
+	AdvancePhaseGeneratorsScalar(slotCount - i, phaseCounters + i, phaseIncrements + i, phaseOutputs + i);
+}
+
 //----------------------------------------------------------------------------------------
 //Operator unit functions
 //----------------------------------------------------------------------------------------
@@ -2769,9 +2848,22 @@ void YM2612::LoadState(IHierarchicalStorageNode& node)
 		}
 
 		//Render thread properties
+		else if((*i)->GetName() == L"RemainingExternalClockCycles")
+		{
+			(*i)->ExtractData(remainingExternalClockCycles);
+		}
 		else if((*i)->GetName() == L"RemainingRenderTime")
 		{
+			//Savestates created before the render position was tracked in external clock
+			//cycles store the remaining render time in nanoseconds. We convert this
+			//value into the nearest number of external clock cycles here.
+			double remainingRenderTime;
 			(*i)->ExtractData(remainingRenderTime);
+			remainingExternalClockCycles = (int)std::floor((remainingRenderTime * (externalClockRate / 1000000000.0)) + 0.5);
+		}
+		else if((*i)->GetName() == L"OutputSampleRemainder")
+		{
+			(*i)->ExtractData(outputSampleRemainder);
 		}
 		else if((*i)->GetName() == L"EGRemainingRenderCycles")
 		{
@@ -2790,34 +2882,45 @@ void YM2612::LoadState(IHierarchicalStorageNode& node)
 			if((*i)->ExtractAttribute(L"ChannelNo", channelNo) && (channelNo < channelCount) &&
 			   (*i)->ExtractAttribute(L"OperatorNo", operatorNo) && (operatorNo < operatorCount))
 			{
-				OperatorData* state = &operatorData[channelNo][operatorNo];
-				(*i)->ExtractAttributeHex(L"Attenuation", state->attenuation);
-				(*i)->ExtractAttributeHex(L"PhaseCounter", state->phaseCounter);
+				unsigned int operatorSlotNo = GetOperatorSlotNo(channelNo, operatorNo);
+				(*i)->ExtractAttributeHex(L"Attenuation", operatorAttenuation[operatorSlotNo]);
+				operatorAttenuation[operatorSlotNo] &= ((1 << attenuationBitCount) - 1);
+
+				//Restore the phase counter for this operator, and rebuild the phase
+				//generator output from it, so that the operator resumes from the same
+				//phase. The phase increments are recalculated from the restored register
+				//state before they're next used.
+				unsigned int phaseCounter = operatorPhaseCounter[operatorSlotNo];
+				(*i)->ExtractAttributeHex(L"PhaseCounter", phaseCounter);
+				phaseCounter &= ((1 << phaseCounterBitCount) - 1);
+				operatorPhaseCounter[operatorSlotNo] = phaseCounter;
+				operatorPhaseOutput[operatorSlotNo] = phaseCounter >> (phaseCounterBitCount - phaseGeneratorOutputBitCount);
+				operatorPhaseIncrementsStale = true;
 				if(!keyStateLocking[channelNo][operatorNo])
 				{
-					(*i)->ExtractAttribute(L"KeyOn", state->keyon);
+					(*i)->ExtractAttribute(L"KeyOn", operatorKeyOn[operatorSlotNo]);
 				}
-				(*i)->ExtractAttribute(L"CSMKeyOn", state->csmKeyOn);
-				(*i)->ExtractAttribute(L"KeyOnPrevious", state->keyonPrevious);
-				(*i)->ExtractAttribute(L"SSGOutputInverted", state->ssgOutputInverted);
+				(*i)->ExtractAttribute(L"CSMKeyOn", operatorCSMKeyOn[operatorSlotNo]);
+				(*i)->ExtractAttribute(L"KeyOnPrevious", operatorKeyOnPrevious[operatorSlotNo]);
+				(*i)->ExtractAttribute(L"SSGOutputInverted", operatorSSGOutputInverted[operatorSlotNo]);
 
 				std::wstring phaseString;
 				(*i)->ExtractAttribute(L"Phase", phaseString);
 				if(phaseString == L"ADSR_ATTACK")
 				{
-					state->phase = OperatorData::ADSR_ATTACK;
+					operatorADSRPhase[operatorSlotNo] = ADSRPhase::Attack;
 				}
 				else if(phaseString == L"ADSR_DECAY")
 				{
-					state->phase = OperatorData::ADSR_DECAY;
+					operatorADSRPhase[operatorSlotNo] = ADSRPhase::Decay;
 				}
 				else if(phaseString == L"ADSR_SUSTAIN")
 				{
-					state->phase = OperatorData::ADSR_SUSTAIN;
+					operatorADSRPhase[operatorSlotNo] = ADSRPhase::Sustain;
 				}
 				else if(phaseString == L"ADSR_RELEASE")
 				{
-					state->phase = OperatorData::ADSR_RELEASE;
+					operatorADSRPhase[operatorSlotNo] = ADSRPhase::Release;
 				}
 			}
 		}
@@ -2935,8 +3038,9 @@ void YM2612::SaveState(IHierarchicalStorageNode& node) const
 	}
 
 	//Render thread properties
-	node.CreateChild(L"RemainingRenderTime", remainingRenderTime);
+	node.CreateChild(L"RemainingExternalClockCycles", remainingExternalClockCycles);
 	node.CreateChild(L"EGRemainingRenderCycles", egRemainingRenderCycles);
+	node.CreateChild(L"OutputSampleRemainder", outputSampleRemainder);
 
 	//Render data
 	node.CreateChildHex(L"EnvelopeCycleCounter", envelopeCycleCounter, sizeof(envelopeCycleCounter)*2);
@@ -2944,30 +3048,30 @@ void YM2612::SaveState(IHierarchicalStorageNode& node) const
 	{
 		for(unsigned int operatorNo = 0; operatorNo < operatorCount; ++operatorNo)
 		{
-			const OperatorData* state = &operatorData[channelNo][operatorNo];
+			unsigned int operatorSlotNo = GetOperatorSlotNo(channelNo, operatorNo);
 			IHierarchicalStorageNode& renderDataState = node.CreateChild(L"RenderData");
 			renderDataState.CreateAttribute(L"ChannelNo", channelNo);
 			renderDataState.CreateAttribute(L"OperatorNo", operatorNo);
-			renderDataState.CreateAttributeHex(L"Attenuation", state->attenuation, (attenuationBitCount+3)/4);
-			renderDataState.CreateAttributeHex(L"PhaseCounter", state->phaseCounter, (phaseBitCount+3)/4);
-			renderDataState.CreateAttribute(L"KeyOn", state->keyon);
-			renderDataState.CreateAttribute(L"CSMKeyOn", state->csmKeyOn);
-			renderDataState.CreateAttribute(L"KeyOnPrevious", state->keyonPrevious);
-			renderDataState.CreateAttribute(L"SSGOutputInverted", state->ssgOutputInverted);
+			renderDataState.CreateAttributeHex(L"Attenuation", operatorAttenuation[operatorSlotNo], (attenuationBitCount+3)/4);
+			renderDataState.CreateAttributeHex(L"PhaseCounter", operatorPhaseCounter[operatorSlotNo], (phaseCounterBitCount+3)/4);
+			renderDataState.CreateAttribute(L"KeyOn", operatorKeyOn[operatorSlotNo]);
+			renderDataState.CreateAttribute(L"CSMKeyOn", operatorCSMKeyOn[operatorSlotNo]);
+			renderDataState.CreateAttribute(L"KeyOnPrevious", operatorKeyOnPrevious[operatorSlotNo]);
+			renderDataState.CreateAttribute(L"SSGOutputInverted", operatorSSGOutputInverted[operatorSlotNo]);
 
 			std::wstring phaseString;
-			switch(state->phase)
+			switch(operatorADSRPhase[operatorSlotNo])
 			{
-			case OperatorData::ADSR_ATTACK:
+			case ADSRPhase::Attack:
 				phaseString = L"ADSR_ATTACK";
 				break;
-			case OperatorData::ADSR_DECAY:
+			case ADSRPhase::Decay:
 				phaseString = L"ADSR_DECAY";
 				break;
-			case OperatorData::ADSR_SUSTAIN:
+			case ADSRPhase::Sustain:
 				phaseString = L"ADSR_SUSTAIN";
 				break;
-			case OperatorData::ADSR_RELEASE:
+			case ADSRPhase::Release:
 				phaseString = L"ADSR_RELEASE";
 				break;
 			}
@@ -3352,7 +3456,7 @@ bool YM2612::ReadGenericData(unsigned int dataID, const DataContext* dataContext
 		return dataValue.SetValue(GetPMSData(channelAddressOffset, AccessTarget().AccessLatest()));}
 	case IYM2612DataSource::KeyState:{
 		const OperatorDataContext& operatorDataContext = *((OperatorDataContext*)dataContext);
-		return dataValue.SetValue(operatorData[operatorDataContext.channelNo][operatorDataContext.operatorNo].keyon);}
+		return dataValue.SetValue(operatorKeyOn[GetOperatorSlotNo(operatorDataContext.channelNo, operatorDataContext.operatorNo)]);}
 	case IYM2612DataSource::StatusRegister:
 		return dataValue.SetValue(status.GetData());
 	case IYM2612DataSource::BusyFlag:
@@ -3666,7 +3770,7 @@ bool YM2612::WriteGenericData(unsigned int dataID, const DataContext* dataContex
 		if(dataType != IGenericAccessDataValue::DataType::Bool) return false;
 		IGenericAccessDataValueBool& dataValueAsBool = (IGenericAccessDataValueBool&)dataValue;
 		const OperatorDataContext& operatorDataContext = *((OperatorDataContext*)dataContext);
-		operatorData[operatorDataContext.channelNo][operatorDataContext.operatorNo].keyon = dataValueAsBool.GetValue();
+		operatorKeyOn[GetOperatorSlotNo(operatorDataContext.channelNo, operatorDataContext.operatorNo)] = dataValueAsBool.GetValue();
 		return true;}
 	case IYM2612DataSource::StatusRegister:{
 		if(dataType != IGenericAccessDataValue::DataType::UInt) return false;
@@ -4021,41 +4125,66 @@ bool YM2612::SetGenericDataLocked(unsigned int dataID, const DataContext* dataCo
 //----------------------------------------------------------------------------------------
 void YM2612::SetAudioLoggingEnabled(bool state)
 {
+	std::unique_lock<std::mutex> lock(waveLoggingMutex);
 	double fmClock = (externalClockRate / fmClockDivider) / outputClockDivider;
-	ToggleLoggingEnabledState(wavLog, wavLoggingPath, wavLoggingEnabled, state, 2, 16, (unsigned int)fmClock);
+	ToggleLoggingEnabledState(wavLogNoMixed, wavLoggingPath, wavLoggingEnabled, state, 2, 16, (unsigned int)fmClock);
 	wavLoggingEnabled = state;
 }
 
 //----------------------------------------------------------------------------------------
 void YM2612::SetChannelAudioLoggingEnabled(unsigned int channelNo, bool state)
 {
+	std::unique_lock<std::mutex> lock(waveLoggingMutex);
 	double fmClock = (externalClockRate / fmClockDivider) / outputClockDivider;
-	ToggleLoggingEnabledState(wavLogChannel[channelNo], wavLoggingChannelPath[channelNo], wavLoggingChannelEnabled[channelNo], state, 2, 16, (unsigned int)fmClock);
+	ToggleLoggingEnabledState(wavLogNoChannelBase + channelNo, wavLoggingChannelPath[channelNo], wavLoggingChannelEnabled[channelNo], state, 2, 16, (unsigned int)fmClock);
 	wavLoggingChannelEnabled[channelNo] = state;
 }
 
 //----------------------------------------------------------------------------------------
 void YM2612::SetOperatorAudioLoggingEnabled(unsigned int channelNo, unsigned int operatorNo, bool state)
 {
+	std::unique_lock<std::mutex> lock(waveLoggingMutex);
 	double fmClock = (externalClockRate / fmClockDivider) / outputClockDivider;
-	ToggleLoggingEnabledState(wavLogOperator[channelNo][operatorNo], wavLoggingOperatorPath[channelNo][operatorNo], wavLoggingOperatorEnabled[channelNo][operatorNo], state, 1, 16, (unsigned int)fmClock);
+	ToggleLoggingEnabledState(wavLogNoOperatorBase + (channelNo * operatorCount) + operatorNo, wavLoggingOperatorPath[channelNo][operatorNo], wavLoggingOperatorEnabled[channelNo][operatorNo], state, 1, 16, (unsigned int)fmClock);
 	wavLoggingOperatorEnabled[channelNo][operatorNo] = state;
 }
 
 //----------------------------------------------------------------------------------------
-bool YM2612::ToggleLoggingEnabledState(Stream::WAVFile& wavFile, const std::wstring& fileName, bool currentState, bool newState, unsigned int channelCount, unsigned int bitsPerSample, unsigned int samplesPerSec)
+bool YM2612::ToggleLoggingEnabledState(unsigned int logNo, const std::wstring& fileName, bool currentState, bool newState, unsigned int channelCount, unsigned int bitsPerSample, unsigned int samplesPerSec)
 {
 	if(newState != currentState)
 	{
 		if(newState)
 		{
-			wavFile.SetDataFormat(channelCount, bitsPerSample, samplesPerSec);
-			wavFile.Open(fileName, Stream::WAVFile::OpenMode::WriteOnly, Stream::WAVFile::CreateMode::Create);
+			wavLogWriter.OpenLog(logNo, fileName, channelCount, bitsPerSample, samplesPerSec);
 		}
 		else
 		{
-			wavFile.Close();
+			wavLogWriter.CloseLog(logNo);
 		}
 	}
 	return newState;
 }
+
+//----------------------------------------------------------------------------------------
+short* YM2612::ExtendAudioLogBuffer(unsigned int logNo, unsigned int sampleCount)
+{
+	//Note that the log writer hands back the storage from a previously written block each
+	//time we submit data, so once logging has been running for a few timeslices, the
+	//buffers already have enough capacity, and this doesn't allocate.
+	std::vector<short>& buffer = wavLogBuffers[logNo];
+	size_t currentSize = buffer.size();
+	buffer.resize(currentSize + sampleCount);
+	return &buffer[currentSize];
+}
+
+//----------------------------------------------------------------------------------------
+void YM2612::SubmitAudioLogData()
+{
+	//Sample data for each log is collected by the render thread without any locking, and
+	//passed to the log writer in a single batch once per timeslice, which writes it to
+	//disk on its own thread. Note that if a log has been disabled partway through a
+	//timeslice, the log writer discards the data for that log.
+	std::unique_lock<std::mutex> lock(waveLoggingMutex);
+	wavLogWriter.WriteSamples(&wavLogBuffers[0]);
+}
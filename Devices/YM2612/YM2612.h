@@ -48,6 +48,7 @@ References:
 -YM2151	Test Register Notes, Jarek Burczynski
 \*--------------------------------------------------------------------------------------*/
 #include "IYM2612.h"
+#include "PhaseGenerator.h"
 #ifndef __YM2612_H__
 #define __YM2612_H__
 #include "DeviceInterface/DeviceInterface.pkg"
@@ -63,11 +64,12 @@ References:
 #include "AudioStream/AudioStream.pkg"
 #include "Stream/Stream.pkg"
 
-class YM2612 :public Device, public GenericAccessBase<IYM2612>
+class YM2612 :public Device, public GenericAccessBase<IYM2612>, private PhaseGenerator
 {
 public:
 	//Constructors
 	YM2612(const std::wstring& aimplementationName, const std::wstring& ainstanceName, unsigned int amoduleID);
+	~YM2612();
 
 	//Interface version functions
 	virtual unsigned int GetIYM2612Version() const;
@@ -131,30 +133,9 @@ private:
 	enum class LineID;
 	enum class ClockID;
 	enum class AccessContext;
+	enum class ADSRPhase;
 
 	//Structures
-	struct OperatorData
-	{
-		enum ADSRPhase
-		{
-			ADSR_ATTACK,
-			ADSR_DECAY,
-			ADSR_SUSTAIN,
-			ADSR_RELEASE
-		};
-
-		OperatorData()
-		:attenuation(10), phaseCounter(20)
-		{}
-
-		Data attenuation;   //10-bit
-		Data phaseCounter;  //20-bit
-		ADSRPhase phase;
-		bool keyon;
-		bool csmKeyOn;
-		bool keyonPrevious;
-		bool ssgOutputInverted;
-	};
 	struct TimerStateLocking
 	{
 		bool rate;
@@ -199,6 +180,7 @@ private:
 
 	//Typedefs
 	typedef RandomTimeAccessBuffer<Data, double>::AccessTarget AccessTarget;
+	typedef void (*PhaseGeneratorFunction)(unsigned int slotCount, unsigned int* phaseCounters, const unsigned int* phaseIncrements, unsigned int* phaseOutputs);
 
 private:
 	//Execute functions
@@ -206,23 +188,31 @@ private:
 
 	//General operator functions
 	void UpdateOperator(unsigned int channelNo, unsigned int operatorNo, bool updateEnvelopeGenerator);
-	unsigned int CalculateKeyCode(unsigned int block, unsigned int fnumber) const;
+	inline unsigned int GetOperatorSlotNo(unsigned int channelNo, unsigned int operatorNo) const;
 
 	//Phase generator functions
-	void UpdatePhaseGenerator(unsigned int channelNo, unsigned int operatorNo, unsigned int channelAddressOffset, unsigned int operatorAddressOffset);
+	void UpdatePhaseIncrements();
+	unsigned int CalculatePhaseIncrement(unsigned int channelNo, unsigned int operatorNo, unsigned int channelAddressOffset, unsigned int operatorAddressOffset) const;
 	unsigned int GetCurrentPhase(unsigned int channelNo, unsigned int operatorNo) const;
 	unsigned int GetFrequencyData(unsigned int channelNo, unsigned int operatorNo, unsigned int operatorAddressOffset, const AccessTarget& accessTarget) const;
 	unsigned int GetBlockData(unsigned int channelNo, unsigned int operatorNo, unsigned int operatorAddressOffset, const AccessTarget& accessTarget) const;
 
 	//Envelope generator functions
 	void UpdateEnvelopeGenerator(unsigned int channelNo, unsigned int operatorNo, unsigned int channelAddressOffset, unsigned int operatorAddressOffset);
-	void SetADSRPhase(unsigned int channelNo, unsigned int operatorNo, unsigned int channelAddressOffset, unsigned int operatorAddressOffset, OperatorData::ADSRPhase phase);
+	void SetADSRPhase(unsigned int channelNo, unsigned int operatorNo, unsigned int channelAddressOffset, unsigned int operatorAddressOffset, ADSRPhase phase);
 	unsigned int GetOutputAttenuation(unsigned int channelNo, unsigned int operatorNo, unsigned int channelAddressOffset, unsigned int operatorAddressOffset) const;
 	unsigned int CalculateRate(unsigned int rateData, unsigned int rateKeyScale) const;
 	unsigned int CalculateRateKeyScale(unsigned int keyScaleData, unsigned int keyCode) const;
 	unsigned int ConvertTotalLevelToAttenuation(unsigned int totalLevel) const;
 	unsigned int ConvertSustainLevelToAttenuation(unsigned int sustainLevel) const;
 
+	//Phase generator vector functions
+	static PhaseGeneratorFunction SelectPhaseGenerator();
+	static bool VerifyPhaseGenerator(PhaseGeneratorFunction phaseGeneratorFunction);
+	static void AdvancePhaseGeneratorsScalar(unsigned int slotCount, unsigned int* phaseCounters, const unsigned int* phaseIncrements, unsigned int* phaseOutputs);
+	static void AdvancePhaseGeneratorsSSE2(unsigned int slotCount, unsigned int* phaseCounters, const unsigned int* phaseIncrements, unsigned int* phaseOutputs);
+	static void AdvancePhaseGeneratorsAVX2(unsigned int slotCount, unsigned int* phaseCounters, const unsigned int* phaseIncrements, unsigned int* phaseOutputs);
+
 	//Operator unit functions
 	unsigned int InversePow2(unsigned int num) const;
 	int CalculateOperator(unsigned int phase, int phaseModulation, unsigned int attenuation) const;
@@ -340,7 +330,9 @@ private:
 	void SetAudioLoggingEnabled(bool state);
 	void SetChannelAudioLoggingEnabled(unsigned int channelNo, bool state);
 	void SetOperatorAudioLoggingEnabled(unsigned int channelNo, unsigned int operatorNo, bool state);
-	static bool ToggleLoggingEnabledState(Stream::WAVFile& wavFile, const std::wstring& fileName, bool currentState, bool newState, unsigned int channelCount, unsigned int bitsPerSample, unsigned int samplesPerSec);
+	bool ToggleLoggingEnabledState(unsigned int logNo, const std::wstring& fileName, bool currentState, bool newState, unsigned int channelCount, unsigned int bitsPerSample, unsigned int samplesPerSec);
+	short* ExtendAudioLogBuffer(unsigned int logNo, unsigned int sampleCount);
+	void SubmitAudioLogData();
 
 private:
 	//Constants
@@ -351,16 +343,13 @@ private:
 	//Envelope generator constants
 	static const unsigned int rateBitCount = 6;
 	static const unsigned int attenuationBitCount = 10;
-	static const unsigned int fnumDataBitCount = 11;
-	static const unsigned int phaseGeneratorOutputBitCount = 10;
-	static const unsigned int keyCodeBitCount = 5;
+	static const unsigned int operatorSlotCount = channelCount * operatorCount;
+	static const unsigned int wavLogNoMixed = 0;
+	static const unsigned int wavLogNoChannelBase = 1;
+	static const unsigned int wavLogNoOperatorBase = wavLogNoChannelBase + channelCount;
+	static const unsigned int wavLogCount = wavLogNoOperatorBase + operatorSlotCount;
 	static const unsigned int counterShiftTable[1 << rateBitCount];
 	static const unsigned int attenuationIncrementTable[1 << rateBitCount][8];
-	static const unsigned int pmsBitCount = 3;
-	static const unsigned int phaseModIndexBitCount = 5;
-	static const unsigned int phaseModIncrementTable[1 << pmsBitCount][1 << (phaseModIndexBitCount - 2)];
-	static const unsigned int detuneBitCount = 3;
-	static const unsigned int detunePhaseIncrementTable[1 << keyCodeBitCount][1 << (detuneBitCount - 1)];
 
 	//Operator unit constants
 	static const unsigned int phaseBitCount = 10;
@@ -454,16 +443,38 @@ private:
 	std::list<RandomTimeAccessValue<bool, double>::Timeslice> timerATimesliceList;
 	std::list<RandomTimeAccessBuffer<Data, double>::Timeslice> regTimesliceListUncommitted;
 	std::list<RandomTimeAccessValue<bool, double>::Timeslice> timerATimesliceListUncommitted;
-	double remainingRenderTime;
+	int remainingExternalClockCycles;
 	int egRemainingRenderCycles;
 	unsigned int outputSampleRate;
+	unsigned int outputSampleRemainder;
+	IAudioSink* outputSink;
 	AudioStream outputStream;
 	std::vector<short> outputBuffer;
+	std::vector<int> renderChannelOutputBuffer;
 
 	//Render data
 	unsigned int envelopeCycleCounter;
-	OperatorData operatorData[channelCount][operatorCount];
 	int operatorOutput[channelCount][operatorCount];
+
+	//Envelope generator state for all operators. As with the phase generator state
+	//below, this state is stored as separate arrays indexed by operator slot number, so
+	//that the state for each field is contiguous across all operators.
+	unsigned int operatorAttenuation[operatorSlotCount];	//10-bit
+	ADSRPhase operatorADSRPhase[operatorSlotCount];
+	bool operatorKeyOn[operatorSlotCount];
+	bool operatorCSMKeyOn[operatorSlotCount];
+	bool operatorKeyOnPrevious[operatorSlotCount];
+	bool operatorSSGOutputInverted[operatorSlotCount];
+
+	//Phase generator state for all operators. This state is stored as separate arrays,
+	//indexed by operator slot number, so that the phase generators for all operators can
+	//be advanced together in a single pass each FM clock cycle.
+	PhaseGeneratorFunction phaseGenerator;
+	unsigned int operatorPhaseCounter[operatorSlotCount];
+	unsigned int operatorPhaseIncrement[operatorSlotCount];
+	unsigned int operatorPhaseOutput[operatorSlotCount];
+	bool operatorPhaseIncrementsStale;
+	unsigned int operatorPhaseIncrementsPMIndex;
 	int feedbackBuffer[channelCount][2];
 	int cyclesUntilLFOIncrement;
 	unsigned int currentLFOCounter;
@@ -484,9 +495,8 @@ private:
 	std::wstring wavLoggingPath;
 	std::wstring wavLoggingChannelPath[channelCount];
 	std::wstring wavLoggingOperatorPath[channelCount][operatorCount];
-	Stream::WAVFile wavLog;
-	Stream::WAVFile wavLogChannel[channelCount];
-	Stream::WAVFile wavLogOperator[channelCount][operatorCount];
+	WAVLogWriter wavLogWriter;
+	std::vector<short> wavLogBuffers[wavLogCount];
 };
 
 #include "YM2612.inl"
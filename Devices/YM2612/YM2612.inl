@@ -19,6 +19,23 @@ enum class YM2612::AccessContext
 	IRQ
 };
 
+//----------------------------------------------------------------------------------------
+enum class YM2612::ADSRPhase
+{
+	Attack,
+	Decay,
+	Sustain,
+	Release
+};
+
+//----------------------------------------------------------------------------------------
+//General operator functions
+//----------------------------------------------------------------------------------------
+unsigned int YM2612::GetOperatorSlotNo(unsigned int channelNo, unsigned int operatorNo) const
+{
+	return (channelNo * operatorCount) + operatorNo;
+}
+
 //----------------------------------------------------------------------------------------
 //Raw register functions
 //----------------------------------------------------------------------------------------
@@ -31,6 +48,15 @@ Data YM2612::GetRegisterData(unsigned int location, const AccessTarget& accessTa
 void YM2612::SetRegisterData(unsigned int location, const Data& data, const AccessTarget& accessTarget)
 {
 	reg.Write(location, data, accessTarget);
+
+	//Writes which aren't made at a point in time, such as changes made through the
+	//debugger, modify the committed register state directly without passing through the
+	//render thread. If this write changes a register which feeds the phase increment
+	//calculation, flag that the phase increments need to be recalculated.
+	if((accessTarget.target != AccessTarget::TARGET_TIME) && RegisterAffectsPhaseIncrement(location))
+	{
+		operatorPhaseIncrementsStale = true;
+	}
 }
 
 //----------------------------------------------------------------------------------------
@@ -83,11 +83,17 @@ ExodusInterface::~ExodusInterface()
 void ExodusInterface::BindToSystem(ISystemGUIInterface* asystem)
 {
 	system = asystem;
+
+	//Subscribe to completion notifications for asynchronous savestates, so that our
+	//savestate slots are refreshed once the file has actually been written.
+	savestateWriteCompleteSubscription.SetBoundCallback(std::bind(std::mem_fn(&ExodusInterface::UpdateSaveSlots), this));
+	system->AsyncSaveStateCompleteNotifyRegister(savestateWriteCompleteSubscription);
 }
 
 //----------------------------------------------------------------------------------------
 void ExodusInterface::UnbindFromSystem()
 {
+	system->AsyncSaveStateCompleteNotifyDeregister(savestateWriteCompleteSubscription);
 	system = 0;
 }
 
@@ -627,7 +633,7 @@ void ExodusInterface::LoadState(const std::wstring& folder, bool debuggerState)
 
 	//Load a state file
 	std::wstring selectedFilePath;
-	if(SelectExistingFile(L"Compressed savestate files|exs;Uncompressed savestate files|xml", L"exs", L"", folder, true, selectedFilePath))
+	if(SelectExistingFile(L"Compressed savestate files|exs;Binary savestate files|exb;Uncompressed savestate files|xml", L"exs", L"", folder, true, selectedFilePath))
 	{
 		//Determine the type of state file being loaded
 		std::wstring fileExtension = PathGetFileExtension(selectedFilePath);
@@ -636,6 +642,10 @@ void ExodusInterface::LoadState(const std::wstring& folder, bool debuggerState)
 		{
 			fileType = ISystemGUIInterface::FileType::XML;
 		}
+		else if(fileExtension == L"exb")
+		{
+			fileType = ISystemGUIInterface::FileType::Binary;
+		}
 
 		//Perform the state load operation
 		LoadStateFromFile(selectedFilePath, fileType, debuggerState);
@@ -661,7 +671,7 @@ void ExodusInterface::SaveState(const std::wstring& folder, bool debuggerState)
 
 	//Save a state file
 	std::wstring selectedFilePath;
-	if(SelectNewFile(L"Compressed savestate files|exs;Uncompressed savestate files|xml", L"exs", L"", folder, selectedFilePath))
+	if(SelectNewFile(L"Compressed savestate files|exs;Binary savestate files|exb;Uncompressed savestate files|xml", L"exs", L"", folder, selectedFilePath))
 	{
 		//Determine the type of state file being saved
 		std::wstring fileExtension = PathGetFileExtension(selectedFilePath);
@@ -670,6 +680,12 @@ void ExodusInterface::SaveState(const std::wstring& folder, bool debuggerState)
 		{
 			fileType = ISystemGUIInterface::FileType::XML;
 		}
+		else if(fileExtension == L"exb")
+		{
+			//Note that binary savestates hold only the state tree, so unlike the other
+			//formats, no screenshot is stored with them.
+			fileType = ISystemGUIInterface::FileType::Binary;
+		}
 
 		//Perform the state save operation
 		SaveStateToFile(selectedFilePath, fileType, debuggerState);
@@ -684,7 +700,10 @@ void ExodusInterface::SaveState(const std::wstring& folder, bool debuggerState)
 //----------------------------------------------------------------------------------------
 void ExodusInterface::SaveStateToFile(const std::wstring& filePath, ISystemGUIInterface::FileType fileType, bool debuggerState)
 {
-	system->SaveState(filePath, fileType, debuggerState);
+	//Capture the state and allow the system to resume immediately, leaving the state to
+	//be encoded and written to the file in the background. Our savestate slots are
+	//refreshed when the write completes.
+	system->SaveStateAsync(filePath, fileType, debuggerState);
 }
 
 //----------------------------------------------------------------------------------------
@@ -740,7 +759,6 @@ void ExodusInterface::QuickSaveState(bool debuggerState)
 		std::wstring workspaceFilePath = PathCombinePaths(prefs.pathSavestates, workspaceFileName);
 		SaveWorkspaceToFile(workspaceFilePath);
 	}
-	PostMessage(cell[selectedSaveCell].hwnd, WM_USER, 0, (LPARAM)this);
 }
 
 //----------------------------------------------------------------------------------------
@@ -2864,6 +2882,21 @@ LRESULT CALLBACK ExodusInterface::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LP
 		case ID_SYSTEM_TOGGLETHROTTLE:
 			state->system->SetThrottlingState(!state->system->GetThrottlingState());
 			break;
+		case ID_SYSTEM_TOGGLEREWIND:
+			state->system->SetRewindEnabled(!state->system->GetRewindEnabled());
+			break;
+		case ID_SYSTEM_STEPREWINDBACKWARD:
+			state->system->StepRewindBackward();
+			break;
+		case ID_AUDIOOUTPUT_SPEAKERS:
+			state->system->SetAudioOutputTarget(ISystemGUIInterface::AudioOutputTarget::Speakers);
+			break;
+		case ID_AUDIOOUTPUT_WAVFILE:
+			state->system->SetAudioOutputTarget(ISystemGUIInterface::AudioOutputTarget::WAVFile);
+			break;
+		case ID_AUDIOOUTPUT_NONE:
+			state->system->SetAudioOutputTarget(ISystemGUIInterface::AudioOutputTarget::None);
+			break;
 		case ID_FILE_LOADMODULE:
 			state->LoadModule(state->prefs.pathModules);
 			break;
@@ -3113,27 +3146,25 @@ LRESULT CALLBACK ExodusInterface::WndSavestateCellProc(HWND hwnd, UINT msg, WPAR
 			Stream::File source;
 			if(source.Open(filePath, Stream::File::OpenMode::ReadOnly, Stream::File::CreateMode::Open))
 			{
-				//Load the ZIP header structure
-				ZIPArchive archive;
-				if(archive.LoadFromStream(source))
+				//Load the screenshot file entry from the archive. The screenshot is
+				//placed near the start of the archive, so we seek directly to it
+				//rather than loading the full archive.
+				ZIPFileEntry entry;
+				if(ZIPArchive::LoadFileEntryFromStream(source, stateInfo.screenshotFilename, entry))
 				{
 					//Decompress the screenshot file to memory
-					ZIPFileEntry* entry = archive.GetFileEntry(stateInfo.screenshotFilename);
-					if(entry != 0)
+					Stream::Buffer buffer(0);
+					if(entry.Decompress(buffer))
 					{
-						Stream::Buffer buffer(0);
-						if(entry->Decompress(buffer))
+						//Decode the image file from the memory buffer. Note that we use
+						//the generic image load function, so the image can be stored in
+						//any recognized format.
+						buffer.SetStreamPos(0);
+						if(state->originalImage.LoadImageFile(buffer))
 						{
-							//Decode the image file from the memory buffer. Note that we
-							//use the generic image load function, so the image can be
-							//stored in any recognized format.
-							buffer.SetStreamPos(0);
-							if(state->originalImage.LoadImageFile(buffer))
-							{
-								state->screenshotPresent = true;
-								state->bitmapWidth = state->originalImage.GetImageWidth();
-								state->bitmapHeight = state->originalImage.GetImageHeight();
-							}
+							state->screenshotPresent = true;
+							state->bitmapWidth = state->originalImage.GetImageWidth();
+							state->bitmapHeight = state->originalImage.GetImageHeight();
 						}
 					}
 				}
@@ -241,6 +241,7 @@ private:
 
 private:
 	ISystemGUIInterface* system;
+	ObserverSubscription savestateWriteCompleteSubscription;
 	HMENU fileMenu;
 	int fileMenuNonDynamicMenuItemCount;
 	HMENU systemMenu;
@@ -246,6 +246,11 @@
 #define ID_SETTINGS_PLATFORMSETTINGS    40114
 #define ID_SETTINGS_DEBUGCONSOLE        40116
 #define ID_WINDOW_CREATEDASHBOARD       40118
+#define ID_SYSTEM_STEPREWINDBACKWARD    40121
+#define ID_SYSTEM_TOGGLEREWIND          40122
+#define ID_AUDIOOUTPUT_SPEAKERS         40123
+#define ID_AUDIOOUTPUT_WAVFILE          40124
+#define ID_AUDIOOUTPUT_NONE             40125
 
 // Next default values for new objects
 // 
@@ -253,7 +258,7 @@
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NO_MFC                     1
 #define _APS_NEXT_RESOURCE_VALUE        176
-#define _APS_NEXT_COMMAND_VALUE         40121
+#define _APS_NEXT_COMMAND_VALUE         40126
 #define _APS_NEXT_CONTROL_VALUE         1482
 #define _APS_NEXT_SYMED_VALUE           101
 #endif
@@ -2,6 +2,7 @@
 #define __ISYSTEMDEVICEINTERFACE_H__
 #include "MarshalSupport/MarshalSupport.pkg"
 #include <string>
+class IAudioSink;
 
 class ISystemDeviceInterface
 {
@@ -16,7 +17,7 @@ public:
 	virtual ~ISystemDeviceInterface() = 0 {}
 
 	//Interface version functions
-	static inline unsigned int ThisISystemDeviceInterfaceVersion() { return 1; }
+	static inline unsigned int ThisISystemDeviceInterfaceVersion() { return 2; }
 	virtual unsigned int GetISystemDeviceInterfaceVersion() const = 0;
 
 	//Path functions
@@ -42,6 +43,10 @@ public:
 	virtual void HandleInputKeyUp(KeyCode keyCode) = 0;
 	virtual void HandleInputAxisUpdate(AxisCode axisCode, float newValue) = 0;
 	virtual void HandleInputScrollUpdate(ScrollCode scrollCode, int scrollTicks) = 0;
+
+	//Audio output functions
+	virtual IAudioSink* OpenAudioOutputSink(IDeviceContext* deviceContext) = 0;
+	virtual void CloseAudioOutputSink(IAudioSink* sink) = 0;
 };
 
 #include "ISystemDeviceInterface.inl"
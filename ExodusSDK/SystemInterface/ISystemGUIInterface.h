@@ -16,6 +16,7 @@ class ISystemGUIInterface :public ISystemExtensionInterface
 public:
 	//Enumerations
 	enum class FileType;
+	enum class AudioOutputTarget;
 
 	//Structures
 	struct StateInfo;
@@ -40,7 +41,7 @@ public:
 
 public:
 	//Interface version functions
-	static inline unsigned int ThisISystemGUIInterfaceVersion() { return 1; }
+	static inline unsigned int ThisISystemGUIInterfaceVersion() { return 2; }
 	virtual unsigned int GetISystemGUIInterfaceVersion() const = 0;
 
 	//Path functions
@@ -77,6 +78,22 @@ public:
 	virtual bool GetEnablePersistentState() const = 0;
 	virtual void SetEnablePersistentState(bool state) = 0;
 
+	//Rewind functions
+	virtual bool GetRewindEnabled() const = 0;
+	virtual void SetRewindEnabled(bool state) = 0;
+	virtual unsigned int GetRewindCaptureIntervalInMilliseconds() const = 0;
+	virtual void SetRewindCaptureIntervalInMilliseconds(unsigned int milliseconds) = 0;
+	virtual unsigned int GetRewindMemoryLimit() const = 0;
+	virtual void SetRewindMemoryLimit(unsigned int sizeInBytes) = 0;
+	virtual bool StepRewindBackward() = 0;
+	virtual unsigned int GetRewindSnapshotCount() const = 0;
+	virtual unsigned int GetRewindMemoryUsage() const = 0;
+	virtual double GetRewindCaptureTimePerSecond() const = 0;
+
+	//Audio output functions
+	virtual AudioOutputTarget GetAudioOutputTarget() const = 0;
+	virtual void SetAudioOutputTarget(AudioOutputTarget target) = 0;
+
 	//Device registration
 	virtual bool RegisterDevice(const IDeviceInfo& entry, AssemblyHandle assemblyHandle) = 0;
 	virtual void UnregisterDevice(const MarshalSupport::Marshal::In<std::wstring>& deviceName) = 0;
@@ -104,6 +121,12 @@ public:
 	//zip file twice.
 	virtual bool LoadState(const MarshalSupport::Marshal::In<std::wstring>& filePath, FileType fileType, bool debuggerState) = 0;
 	virtual bool SaveState(const MarshalSupport::Marshal::In<std::wstring>& filePath, FileType fileType, bool debuggerState) = 0;
+	virtual void SaveStateAsync(const MarshalSupport::Marshal::In<std::wstring>& filePath, FileType fileType, bool debuggerState) = 0;
+	virtual bool AsyncSaveStatePending() const = 0;
+	virtual void AsyncSaveStateCompleteNotifyRegister(IObserverSubscription& observer) = 0;
+	virtual void AsyncSaveStateCompleteNotifyDeregister(IObserverSubscription& observer) = 0;
+	virtual bool GetLastAsyncSaveStateResult() const = 0;
+	virtual MarshalSupport::Marshal::Ret<std::wstring> GetLastAsyncSaveStateFilePath() const = 0;
 	virtual MarshalSupport::Marshal::Ret<StateInfo> GetStateInfo(const MarshalSupport::Marshal::In<std::wstring>& filePath, FileType fileType) const = 0;
 	virtual bool LoadModuleRelationshipsNode(IHierarchicalStorageNode& node, const MarshalSupport::Marshal::Out<ModuleRelationshipMap>& relationshipMap) const = 0;
 	virtual void SaveModuleRelationshipsNode(IHierarchicalStorageNode& node, bool saveFilePathInfo = false, const MarshalSupport::Marshal::In<std::wstring>& relativePathBase = L"") const = 0;
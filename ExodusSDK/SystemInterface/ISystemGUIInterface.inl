@@ -13,7 +13,16 @@
 enum class ISystemGUIInterface::FileType
 {
 	ZIP,
-	XML
+	XML,
+	Binary
+};
+
+//----------------------------------------------------------------------------------------
+enum class ISystemGUIInterface::AudioOutputTarget
+{
+	Speakers,
+	WAVFile,
+	None
 };
 
 //----------------------------------------------------------------------------------------
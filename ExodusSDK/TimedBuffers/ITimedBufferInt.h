@@ -20,6 +20,9 @@ public:
 	//Make sure the object can't be deleted from this base
 	protected: virtual ~ITimedBufferInt() = 0 {} public:
 
+	//Interface version functions
+	static inline unsigned int ThisITimedBufferIntVersion() { return 2; }
+
 	//Size functions
 	virtual unsigned int Size() const = 0;
 
@@ -63,6 +66,13 @@ public:
 protected:
 	//Access functions
 	virtual void GetLatestBufferCopy(DataType* buffer, unsigned int bufferSize) const = 0;
+
+public:
+	//Block access functions
+	//Note that this function was added in version 2 of this interface. Every
+	//implementation of this interface needs to provide it, so modules built against
+	//version 1 are not compatible with this version.
+	virtual void WriteBlock(unsigned int writeCount, const unsigned int* addresses, const TimesliceType* writeTimes, const DataType* data) = 0;
 };
 
 #include "ITimedBufferInt.inl"
@@ -76,6 +76,7 @@ public:
 	inline void Write(unsigned int address, const DataType& data, const TimedBufferAccessTarget<DataType, TimesliceType>* accessTarget);
 	DataType Read(unsigned int address, TimesliceType readTime) const;
 	void Write(unsigned int address, TimesliceType writeTime, const DataType& data);
+	void WriteBlock(unsigned int writeCount, const unsigned int* addresses, const TimesliceType* writeTimes, const DataType* data);
 	inline DataType& ReferenceCommitted(unsigned int address);
 	inline DataType ReadCommitted(unsigned int address) const;
 	DataType ReadCommitted(unsigned int address, TimesliceType readTime) const;
@@ -120,6 +121,9 @@ private:
 	struct TimesliceSaveEntry;
 	struct WriteSaveEntry;
 
+	//Access functions
+	void WriteNoLock(unsigned int address, TimesliceType writeTime, const DataType& data);
+
 	//Time management functions
 	TimesliceType GetNextWriteTimeNoLock(const Timeslice& targetTimeslice) const;
 	void AdvanceBySessionInternal(TimesliceType currentProgress, AdvanceSession& advanceSession, const Timeslice& targetTimeslice);
@@ -225,7 +225,27 @@ template<class DataType, class TimesliceType> DataType RandomTimeAccessBuffer<Da
 template<class DataType, class TimesliceType> void RandomTimeAccessBuffer<DataType, TimesliceType>::Write(unsigned int address, TimesliceType writeTime, const DataType& data)
 {
 	std::unique_lock<std::mutex> lock(accessLock);
+	WriteNoLock(address, writeTime, data);
+}
 
+//----------------------------------------------------------------------------------------
+//This function performs a sequence of timed writes under a single lock. The writes are
+//processed in the order they're given, so where a block contains writes in ascending
+//time order, as is normally the case, each write is simply appended to the end of the
+//write list.
+//----------------------------------------------------------------------------------------
+template<class DataType, class TimesliceType> void RandomTimeAccessBuffer<DataType, TimesliceType>::WriteBlock(unsigned int writeCount, const unsigned int* addresses, const TimesliceType* writeTimes, const DataType* data)
+{
+	std::unique_lock<std::mutex> lock(accessLock);
+	for(unsigned int i = 0; i < writeCount; ++i)
+	{
+		WriteNoLock(addresses[i], writeTimes[i], data[i]);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+template<class DataType, class TimesliceType> void RandomTimeAccessBuffer<DataType, TimesliceType>::WriteNoLock(unsigned int address, TimesliceType writeTime, const DataType& data)
+{
 	WriteEntry entry(address, writeTime, data, latestTimeslice);
 
 	//Find the correct location in the list to insert the new write entry. The writeList
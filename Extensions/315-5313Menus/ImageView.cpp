@@ -416,6 +416,9 @@ LRESULT ImageView::msgRenderWM_MOUSEMOVE(HWND hwnd, WPARAM wparam, LPARAM lparam
 	unsigned int lineWidth = model.GetImageBufferLineWidth(displayingImageBufferPlane, pixelInfoTargetBufferPosY);
 	pixelInfoTargetBufferPosX = (int)((float)(xpos - imageRegionPosX) * ((float)lineWidth / imageRegionWidth));
 
+	//Request info for the target pixel to be captured in the next rendered frame
+	model.RequestImageBufferInfo(pixelInfoTargetBufferPosX, pixelInfoTargetBufferPosY, 1, 1);
+
 	//Retrieve the rectangle representing the work area of the target monitor
 	POINT cursorPoint;
 	cursorPoint.x = xpos;
@@ -523,13 +526,16 @@ void ImageView::UpdateImage()
 		--windowPendingClearCount;
 	}
 
-	//Determine the index of the current image plane that is being used for display
-	unsigned int displayingImageBufferPlane = model.GetImageCompletedBufferPlaneNo();
+	//Acquire the most recently completed image plane for display. The VDP won't render
+	//into this plane until we release it.
+	unsigned int displayingFrameToken;
+	unsigned int displayingImageBufferPlane = model.AcquireCompletedImageBufferPlane(displayingFrameToken);
 
 	//Obtain the number of rows in this frame
 	unsigned int rowCount = model.GetImageBufferLineCount(displayingImageBufferPlane);
 	if(rowCount <= 0)
 	{
+		model.ReleaseImageBufferPlane(displayingImageBufferPlane);
 		return;
 	}
 
@@ -541,17 +547,16 @@ void ImageView::UpdateImage()
 
 	//If a new frame is ready to be displayed, update our image texture with the new
 	//rendered image data.
-	unsigned int latestLastRenderedFrameToken = model.GetImageLastRenderedFrameToken();
-	if(model.GetVideoSingleBuffering() || (lastRenderedFrameTokenCached != latestLastRenderedFrameToken))
+	if(model.GetVideoSingleBuffering() || (lastRenderedFrameTokenCached != displayingFrameToken))
 	{
 		//Copy the contents of the image buffer into our image texture for rendering
-		model.LockImageBufferData(displayingImageBufferPlane);
 		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, model.imageBufferWidth, rowCount, GL_RGBA, GL_UNSIGNED_BYTE, model.GetImageBufferData(displayingImageBufferPlane));
-		model.UnlockImageBufferData(displayingImageBufferPlane);
 
-		//Update our cached last rendered frame token
-		unsigned int framesCompletedDrawing = latestLastRenderedFrameToken - lastRenderedFrameTokenCached;
-		lastRenderedFrameTokenCached = latestLastRenderedFrameToken;
+		//Update our cached last rendered frame token. Note that the frame token counts
+		//every frame the VDP has completed, including any which were never handed over
+		//for display, so the FPS counter still reflects the rate of emulation.
+		unsigned int framesCompletedDrawing = displayingFrameToken - lastRenderedFrameTokenCached;
+		lastRenderedFrameTokenCached = displayingFrameToken;
 
 		//Update the FPS counter if a new frame has been completed
 		if(framesCompletedDrawing > 0)
@@ -758,6 +763,9 @@ void ImageView::UpdateImage()
 		}
 	}
 
+	//Release the image plane now that we're finished with it
+	model.ReleaseImageBufferPlane(displayingImageBufferPlane);
+
 	//Signal the OpenGL drawing operations to start as quickly as possible
 	glFlush();
 }
@@ -969,12 +977,17 @@ INT_PTR ImageView::msgPixelInfoWM_TIMER(HWND hwnd, WPARAM wparam, LPARAM lparam)
 	//Determine the index of the current image plane that is being used for display
 	unsigned int displayingImageBufferPlane = model.GetImageCompletedBufferPlaneNo();
 
-	//Retrieve info for the target pixel
-	const IS315_5313::ImageBufferInfo* pixelInfo = model.GetImageBufferInfo(displayingImageBufferPlane, pixelInfoTargetBufferPosY, pixelInfoTargetBufferPosX);
-	if(pixelInfo == 0)
+	//Retrieve info for the target pixel, and request updated info to be captured in the
+	//next rendered frame. If info for the target pixel hasn't been captured yet, we
+	//leave the current contents of the pixel info window unchanged.
+	IS315_5313::ImageBufferInfo pixelInfoData;
+	bool pixelInfoAvailable = model.GetImageBufferInfo(displayingImageBufferPlane, pixelInfoTargetBufferPosY, pixelInfoTargetBufferPosX, pixelInfoData);
+	model.RequestImageBufferInfo(pixelInfoTargetBufferPosX, pixelInfoTargetBufferPosY, 1, 1);
+	if(!pixelInfoAvailable)
 	{
 		return TRUE;
 	}
+	const IS315_5313::ImageBufferInfo* pixelInfo = &pixelInfoData;
 
 	//Retrieve source-specific settings for this pixel info
 	std::wstring pixelSourceString;
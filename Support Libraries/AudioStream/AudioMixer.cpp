@@ -0,0 +1,86 @@
+#include "AudioMixer.h"
+
+//----------------------------------------------------------------------------------------
+//Constructors
+//----------------------------------------------------------------------------------------
+AudioMixer::AudioMixer(unsigned int achannelCount, unsigned int asamplesPerSec, unsigned int atargetLatencySamples)
+:channelCount(achannelCount), samplesPerSec(asamplesPerSec), targetLatencySamples(atargetLatencySamples)
+{
+	if(targetLatencySamples == 0)
+	{
+		targetLatencySamples = samplesPerSec / 20;
+	}
+}
+
+//----------------------------------------------------------------------------------------
+AudioMixer::~AudioMixer()
+{
+	for(std::list<AudioMixerSource*>::iterator i = sources.begin(); i != sources.end(); ++i)
+	{
+		delete *i;
+	}
+	sources.clear();
+}
+
+//----------------------------------------------------------------------------------------
+//Source management functions
+//----------------------------------------------------------------------------------------
+AudioMixerSource* AudioMixer::CreateSource()
+{
+	std::unique_lock<std::mutex> lock(sourceMutex);
+	AudioMixerSource* source = new AudioMixerSource(*this);
+	sources.push_back(source);
+	return source;
+}
+
+//----------------------------------------------------------------------------------------
+void AudioMixer::DeleteSource(AudioMixerSource* source)
+{
+	std::unique_lock<std::mutex> lock(sourceMutex);
+	for(std::list<AudioMixerSource*>::iterator i = sources.begin(); i != sources.end(); ++i)
+	{
+		if(*i == source)
+		{
+			sources.erase(i);
+			delete source;
+			return;
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Mixing functions
+//----------------------------------------------------------------------------------------
+//Produces the requested number of output samples by combining the buffered data from
+//every open source. This is intended to be called at the rate the host consumes audio
+//data, and each source adjusts the rate at which it consumes its own buffered data
+//slightly, so that the amount of data buffered for each source is held near the target
+//latency regardless of small differences between the emulated and host sample clocks.
+//----------------------------------------------------------------------------------------
+void AudioMixer::MixSamples(std::vector<short>& targetData, unsigned int sampleCount)
+{
+	unsigned int targetValueCount = sampleCount * channelCount;
+	mixBuffer.assign(targetValueCount, 0);
+	targetData.resize(targetValueCount);
+	if(targetValueCount == 0)
+	{
+		return;
+	}
+
+	//Combine the output from each source. Note that sources never take this lock when
+	//submitting sample data, only when they're opened or closed, so producers are never
+	//held up by the mixer.
+	std::unique_lock<std::mutex> lock(sourceMutex);
+	for(std::list<AudioMixerSource*>::iterator i = sources.begin(); i != sources.end(); ++i)
+	{
+		(*i)->MixSamples(&mixBuffer[0], channelCount, samplesPerSec, targetLatencySamples, sampleCount);
+	}
+	lock.unlock();
+
+	//Clamp the mixed sample values to the range of the output
+	for(unsigned int i = 0; i < targetValueCount; ++i)
+	{
+		int sample = mixBuffer[i];
+		targetData[i] = (short)((sample > 32767)? 32767: ((sample < -32768)? -32768: sample));
+	}
+}
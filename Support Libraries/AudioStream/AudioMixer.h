@@ -0,0 +1,47 @@
+#ifndef __AUDIOMIXER_H__
+#define __AUDIOMIXER_H__
+#include "AudioMixerSource.h"
+#include <list>
+#include <vector>
+#include <mutex>
+
+class AudioMixer
+{
+public:
+	//Constructors
+	AudioMixer(unsigned int achannelCount, unsigned int asamplesPerSec, unsigned int atargetLatencySamples);
+	~AudioMixer();
+
+	//Output format functions
+	inline unsigned int GetChannelCount() const;
+	inline unsigned int GetSamplesPerSec() const;
+	inline unsigned int GetTargetLatencySamples() const;
+
+	//Source management functions
+	AudioMixerSource* CreateSource();
+	void DeleteSource(AudioMixerSource* source);
+
+	//Mixing functions
+	void MixSamples(std::vector<short>& targetData, unsigned int sampleCount);
+
+private:
+	//Make sure the AudioMixer object is non-copyable
+	AudioMixer(const AudioMixer& object);
+	AudioMixer& operator=(const AudioMixer& object);
+
+private:
+	friend class AudioMixerSource;
+
+	//Output format
+	unsigned int channelCount;
+	unsigned int samplesPerSec;
+	unsigned int targetLatencySamples;
+
+	//Source data
+	std::mutex sourceMutex;
+	std::list<AudioMixerSource*> sources;
+	std::vector<int> mixBuffer;
+};
+
+#include "AudioMixer.inl"
+#endif
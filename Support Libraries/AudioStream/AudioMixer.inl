@@ -0,0 +1,19 @@
+//----------------------------------------------------------------------------------------
+//Output format functions
+//----------------------------------------------------------------------------------------
+unsigned int AudioMixer::GetChannelCount() const
+{
+	return channelCount;
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int AudioMixer::GetSamplesPerSec() const
+{
+	return samplesPerSec;
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int AudioMixer::GetTargetLatencySamples() const
+{
+	return targetLatencySamples;
+}
@@ -0,0 +1,221 @@
+#include "AudioMixerSource.h"
+#include "AudioMixer.h"
+#include <algorithm>
+
+//----------------------------------------------------------------------------------------
+//Constants
+//----------------------------------------------------------------------------------------
+//The largest fractional change we make to the rate at which buffered data is consumed.
+//At half a percent, the change in pitch is well below what can be heard.
+const double AudioMixerSource::maxRateAdjustment = 0.005;
+//The weight given to each new measurement of the buffer fill level. Sources usually
+//submit data in blocks of a video frame at a time, so the raw fill level is a sawtooth,
+//which we smooth before using it to control the consumption rate.
+const double AudioMixerSource::fillLevelSmoothing = 0.125;
+//The rate at which the long term rate correction is built up, as a fraction of the
+//maximum adjustment per second, while the buffer is at double or empty of its target
+//fill level.
+const double AudioMixerSource::rateCorrectionPerSecond = 0.1;
+
+//----------------------------------------------------------------------------------------
+//Constructors
+//----------------------------------------------------------------------------------------
+AudioMixerSource::AudioMixerSource(AudioMixer& amixer)
+:mixer(amixer), sourceOpen(false), channelCount(1), samplesPerSec(0), ringSampleCount(0), ringWritePos(0), ringReadPos(0), underrunCount(0), overrunCount(0), primed(false), averageFillLevel(0), rateCorrection(0), sourceSampleFraction(0)
+{}
+
+//----------------------------------------------------------------------------------------
+//Sink binding
+//----------------------------------------------------------------------------------------
+bool AudioMixerSource::Open(unsigned int achannelCount, unsigned int abitsPerSample, unsigned int asamplesPerSec)
+{
+	if((achannelCount == 0) || (abitsPerSample != 16) || (asamplesPerSec == 0))
+	{
+		return false;
+	}
+
+	//Build the ring buffer for this source, with enough room to hold several times the
+	//target latency. The ring size is kept at a power of two, so that sample positions
+	//can be mapped into the buffer with a mask, and remain valid as they wrap.
+	std::unique_lock<std::mutex> lock(mixer.sourceMutex);
+	channelCount = achannelCount;
+	samplesPerSec = asamplesPerSec;
+	unsigned int targetFillLevel = (unsigned int)(((unsigned long long)mixer.targetLatencySamples * samplesPerSec) / mixer.samplesPerSec);
+	ringSampleCount = minRingSampleCount;
+	while(ringSampleCount < (targetFillLevel * 4))
+	{
+		ringSampleCount <<= 1;
+	}
+	ringBuffer.assign(ringSampleCount * channelCount, 0);
+	ringWritePos = 0;
+	ringReadPos = 0;
+	underrunCount = 0;
+	overrunCount = 0;
+
+	//Reset the mixing state
+	primed = false;
+	averageFillLevel = 0;
+	rateCorrection = 0;
+	sourceSampleFraction = 0;
+	resampler.Reset();
+	lastSample.assign(channelCount, 0);
+	sourceOpen = true;
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+void AudioMixerSource::Close()
+{
+	std::unique_lock<std::mutex> lock(mixer.sourceMutex);
+	sourceOpen = false;
+}
+
+//----------------------------------------------------------------------------------------
+//Sample output functions
+//----------------------------------------------------------------------------------------
+void AudioMixerSource::WriteSamples(const short* sampleData, unsigned int sampleCount)
+{
+	if(!sourceOpen)
+	{
+		return;
+	}
+
+	//Calculate how much of the supplied data we can hold. If the ring is full, the
+	//remaining data is dropped. With the rate control working this only happens if the
+	//host stops consuming audio data altogether.
+	unsigned int writePos = ringWritePos.load(std::memory_order_relaxed);
+	unsigned int readPos = ringReadPos.load(std::memory_order_acquire);
+	unsigned int freeSampleCount = ringSampleCount - (writePos - readPos);
+	if(sampleCount > freeSampleCount)
+	{
+		sampleCount = freeSampleCount;
+		++overrunCount;
+	}
+
+	//Copy the sample data into the ring, in up to two blocks if it wraps around the end
+	//of the buffer, then publish it to the mixer.
+	unsigned int ringMask = ringSampleCount - 1;
+	unsigned int firstBlockSampleCount = ringSampleCount - (writePos & ringMask);
+	if(firstBlockSampleCount > sampleCount)
+	{
+		firstBlockSampleCount = sampleCount;
+	}
+	if(firstBlockSampleCount > 0)
+	{
+		std::copy(sampleData, sampleData + (firstBlockSampleCount * channelCount), ringBuffer.begin() + ((writePos & ringMask) * channelCount));
+	}
+	if(sampleCount > firstBlockSampleCount)
+	{
+		std::copy(sampleData + (firstBlockSampleCount * channelCount), sampleData + (sampleCount * channelCount), ringBuffer.begin());
+	}
+	ringWritePos.store(writePos + sampleCount, std::memory_order_release);
+}
+
+//----------------------------------------------------------------------------------------
+//Mixing functions
+//----------------------------------------------------------------------------------------
+void AudioMixerSource::MixSamples(int* targetData, unsigned int targetChannelCount, unsigned int targetSamplesPerSec, unsigned int targetLatencySamples, unsigned int targetSampleCount)
+{
+	if(!sourceOpen)
+	{
+		return;
+	}
+
+	//Calculate the current and target number of buffered samples for this source.
+	//Playback of a source is held off until it has buffered the target amount of data,
+	//both when it's first opened, and after an underrun.
+	unsigned int writePos = ringWritePos.load(std::memory_order_acquire);
+	unsigned int readPos = ringReadPos.load(std::memory_order_relaxed);
+	unsigned int availableSampleCount = writePos - readPos;
+	unsigned int targetFillLevel = (unsigned int)(((unsigned long long)targetLatencySamples * samplesPerSec) / targetSamplesPerSec);
+	if(targetFillLevel == 0)
+	{
+		targetFillLevel = 1;
+	}
+	if(!primed)
+	{
+		if(availableSampleCount < targetFillLevel)
+		{
+			return;
+		}
+		primed = true;
+		averageFillLevel = (double)availableSampleCount;
+	}
+
+	//Adjust the rate at which buffered data is consumed based on how far the smoothed
+	//fill level is from the target, up to the maximum adjustment. If data is arriving
+	//faster than we consume it, the fill level rises, and we consume it faster, and vice
+	//versa. The adjustment is made up of a term proportional to the current error, which
+	//responds quickly, and a long term correction built up from the error over time,
+	//which absorbs any constant difference between the emulated and host sample clocks,
+	//so that the fill level settles at the target rather than at an offset from it.
+	averageFillLevel += ((double)availableSampleCount - averageFillLevel) * fillLevelSmoothing;
+	double fillError = (averageFillLevel - (double)targetFillLevel) / (double)targetFillLevel;
+	fillError = (fillError > 1.0)? 1.0: ((fillError < -1.0)? -1.0: fillError);
+	rateCorrection += fillError * maxRateAdjustment * rateCorrectionPerSecond * ((double)targetSampleCount / (double)targetSamplesPerSec);
+	rateCorrection = (rateCorrection > maxRateAdjustment)? maxRateAdjustment: ((rateCorrection < -maxRateAdjustment)? -maxRateAdjustment: rateCorrection);
+	double rateAdjustment = rateCorrection + (fillError * maxRateAdjustment);
+	rateAdjustment = (rateAdjustment > maxRateAdjustment)? maxRateAdjustment: ((rateAdjustment < -maxRateAdjustment)? -maxRateAdjustment: rateAdjustment);
+
+	//Calculate the number of source samples to consume for this block, carrying the
+	//fractional remainder into the next block.
+	double sourceSampleCountExact = (((double)targetSampleCount * (double)samplesPerSec) / (double)targetSamplesPerSec) * (1.0 + rateAdjustment) + sourceSampleFraction;
+	unsigned int sourceSampleCount = (unsigned int)sourceSampleCountExact;
+	sourceSampleFraction = sourceSampleCountExact - (double)sourceSampleCount;
+	if(sourceSampleCount == 0)
+	{
+		return;
+	}
+
+	//Read the source samples from the ring. If there isn't enough data available, we've
+	//underrun. In this case we hold the last sample value for the remainder of the
+	//block, and wait for the target amount of data to be buffered again before
+	//resuming.
+	sourceBlock.resize(sourceSampleCount * channelCount);
+	unsigned int readSampleCount = (availableSampleCount < sourceSampleCount)? availableSampleCount: sourceSampleCount;
+	ReadSamples(&sourceBlock[0], readSampleCount);
+	ringReadPos.store(readPos + readSampleCount, std::memory_order_release);
+	if(readSampleCount > 0)
+	{
+		lastSample.assign(sourceBlock.begin() + ((readSampleCount - 1) * channelCount), sourceBlock.begin() + (readSampleCount * channelCount));
+	}
+	if(readSampleCount < sourceSampleCount)
+	{
+		for(unsigned int sampleNo = readSampleCount; sampleNo < sourceSampleCount; ++sampleNo)
+		{
+			std::copy(lastSample.begin(), lastSample.end(), sourceBlock.begin() + (sampleNo * channelCount));
+		}
+		primed = false;
+		sourceSampleFraction = 0;
+		++underrunCount;
+	}
+
+	//Convert the block to the output sample rate, and add it to the mix. Where the
+	//source has fewer channels than the output, source channels are repeated across the
+	//output channels, so a mono source is played on all outputs.
+	resampledBlock.resize(targetSampleCount * channelCount);
+	resampler.Resample(&sourceBlock[0], sourceSampleCount, channelCount, &resampledBlock[0], targetSampleCount);
+	for(unsigned int sampleNo = 0; sampleNo < targetSampleCount; ++sampleNo)
+	{
+		const short* sourceSample = &resampledBlock[sampleNo * channelCount];
+		int* targetSample = &targetData[sampleNo * targetChannelCount];
+		for(unsigned int channelNo = 0; channelNo < targetChannelCount; ++channelNo)
+		{
+			targetSample[channelNo] += (int)sourceSample[channelNo % channelCount];
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void AudioMixerSource::ReadSamples(short* targetData, unsigned int sampleCount)
+{
+	unsigned int readPos = ringReadPos.load(std::memory_order_relaxed);
+	unsigned int ringMask = ringSampleCount - 1;
+	unsigned int firstBlockSampleCount = ringSampleCount - (readPos & ringMask);
+	if(firstBlockSampleCount > sampleCount)
+	{
+		firstBlockSampleCount = sampleCount;
+	}
+	std::copy(ringBuffer.begin() + ((readPos & ringMask) * channelCount), ringBuffer.begin() + (((readPos & ringMask) + firstBlockSampleCount) * channelCount), targetData);
+	std::copy(ringBuffer.begin(), ringBuffer.begin() + ((sampleCount - firstBlockSampleCount) * channelCount), targetData + (firstBlockSampleCount * channelCount));
+}
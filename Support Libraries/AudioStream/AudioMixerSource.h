@@ -0,0 +1,74 @@
+#ifndef __AUDIOMIXERSOURCE_H__
+#define __AUDIOMIXERSOURCE_H__
+#include "IAudioSink.h"
+#include "AudioResampler.h"
+#include <atomic>
+#include <vector>
+class AudioMixer;
+
+class AudioMixerSource :public IAudioSink
+{
+public:
+	//Constructors
+	AudioMixerSource(AudioMixer& amixer);
+
+	//Sink binding
+	virtual bool Open(unsigned int achannelCount, unsigned int abitsPerSample, unsigned int asamplesPerSec);
+	virtual void Close();
+
+	//Sample output functions
+	virtual void WriteSamples(const short* sampleData, unsigned int sampleCount);
+
+	//Buffer state functions
+	inline unsigned int GetBufferedSampleCount() const;
+	inline unsigned int GetUnderrunCount() const;
+	inline unsigned int GetOverrunCount() const;
+
+private:
+	//Make sure the AudioMixerSource object is non-copyable
+	AudioMixerSource(const AudioMixerSource& object);
+	AudioMixerSource& operator=(const AudioMixerSource& object);
+
+	//Mixing functions
+	friend class AudioMixer;
+	void MixSamples(int* targetData, unsigned int targetChannelCount, unsigned int targetSamplesPerSec, unsigned int targetLatencySamples, unsigned int targetSampleCount);
+	void ReadSamples(short* targetData, unsigned int sampleCount);
+
+private:
+	//Constants
+	static const unsigned int minRingSampleCount = 4096;
+	static const double maxRateAdjustment;
+	static const double fillLevelSmoothing;
+	static const double rateCorrectionPerSecond;
+
+	//Mixer properties
+	AudioMixer& mixer;
+
+	//Source format
+	std::atomic<bool> sourceOpen;
+	unsigned int channelCount;
+	unsigned int samplesPerSec;
+
+	//Sample ring buffer. Sample positions are measured in sample frames, and increase
+	//without bound, wrapping at the limit of the type. The write position is only
+	//advanced by the producer, and the read position only by the mixer.
+	std::vector<short> ringBuffer;
+	unsigned int ringSampleCount;
+	std::atomic<unsigned int> ringWritePos;
+	std::atomic<unsigned int> ringReadPos;
+	std::atomic<unsigned int> underrunCount;
+	std::atomic<unsigned int> overrunCount;
+
+	//Mixing state
+	bool primed;
+	double averageFillLevel;
+	double rateCorrection;
+	double sourceSampleFraction;
+	AudioResampler resampler;
+	std::vector<short> lastSample;
+	std::vector<short> sourceBlock;
+	std::vector<short> resampledBlock;
+};
+
+#include "AudioMixerSource.inl"
+#endif
@@ -0,0 +1,19 @@
+//----------------------------------------------------------------------------------------
+//Buffer state functions
+//----------------------------------------------------------------------------------------
+unsigned int AudioMixerSource::GetBufferedSampleCount() const
+{
+	return ringWritePos.load() - ringReadPos.load();
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int AudioMixerSource::GetUnderrunCount() const
+{
+	return underrunCount.load();
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int AudioMixerSource::GetOverrunCount() const
+{
+	return overrunCount.load();
+}
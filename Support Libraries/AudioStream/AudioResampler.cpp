@@ -0,0 +1,415 @@
+#include "AudioResampler.h"
+#include "KaiserWindow.h"
+#include "WindowsSupport/WindowsSupport.pkg"
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <cmath>
+
+//----------------------------------------------------------------------------------------
+//Constants
+//----------------------------------------------------------------------------------------
+//The filter table is designed for a particular ratio between the source and target sample
+//rates, since the cutoff frequency and the length of the filter both depend on it. The
+//number of samples passed in each call varies slightly from one call to the next, so we
+//only rebuild the filter table when the ratio drifts further than this from the ratio the
+//table was built for.
+const double AudioResampler::filterTableRatioTolerance = 0.02;
+
+//----------------------------------------------------------------------------------------
+//Constructors
+//----------------------------------------------------------------------------------------
+AudioResampler::AudioResampler()
+:quality(Quality::Medium), filterTableBuilt(false), filterTableRatio(0), filterTapCount(0), filterPhaseCount(0), historyChannelCount(0)
+{
+	filterFunction = SelectFilterFunction();
+}
+
+//----------------------------------------------------------------------------------------
+//Sample rate conversion
+//----------------------------------------------------------------------------------------
+void AudioResampler::Reset()
+{
+	historyChannelCount = 0;
+	channelSampleBuffers.clear();
+}
+
+//----------------------------------------------------------------------------------------
+//The resampler uses a polyphase windowed-sinc filter. The filter table holds the
+//coefficients for filterPhaseCount evenly spaced fractional sample positions, and each
+//output sample uses the phase nearest to its exact position in the source stream. Each
+//output sample is formed from filterTapCount source samples centered on its
+//position in the source stream. Since the source samples following the last sample in
+//each buffer aren't available yet, the output stream is delayed by half the length of the
+//filter, and the last filterTapCount source samples for each channel are retained as
+//history for the next call. The number of source and target samples may vary between
+//calls, and each call maps exactly sourceSampleCount source samples onto
+//targetSampleCount target samples.
+//----------------------------------------------------------------------------------------
+void AudioResampler::Resample(const short* sourceData, unsigned int sourceSampleCount, unsigned int achannelCount, short* targetData, unsigned int targetSampleCount)
+{
+	if((sourceSampleCount <= 0) || (targetSampleCount <= 0) || (achannelCount <= 0))
+	{
+		return;
+	}
+
+	//Rebuild the filter table if the quality setting has changed, or if the conversion
+	//ratio has drifted too far from the ratio the current table was designed for. Note
+	//that the sample history is retained if the filter length changes, and is simply
+	//padded or trimmed at the oldest end, so changing quality levels doesn't produce a
+	//gap in the output.
+	Quality currentQuality = quality;
+	double sampleConversionRatio = (double)sourceSampleCount / (double)targetSampleCount;
+	if(!filterTableBuilt || (filterTableQuality != currentQuality) || (std::fabs(sampleConversionRatio - filterTableRatio) > (filterTableRatio * filterTableRatioTolerance)))
+	{
+		BuildFilterTable(currentQuality, sampleConversionRatio);
+	}
+
+	//If the number of channels has changed, discard the sample history.
+	if(historyChannelCount != achannelCount)
+	{
+		historyChannelCount = achannelCount;
+		channelSampleBuffers.assign(achannelCount, std::vector<float>(filterTapCount, 0.0f));
+	}
+
+	//Append the new source samples to the sample history for each channel. After this
+	//step, each channel buffer contains exactly filterTapCount history samples followed
+	//by sourceSampleCount new samples.
+	for(unsigned int channelNo = 0; channelNo < achannelCount; ++channelNo)
+	{
+		std::vector<float>& sampleBuffer = channelSampleBuffers[channelNo];
+		if(sampleBuffer.size() > filterTapCount)
+		{
+			sampleBuffer.erase(sampleBuffer.begin(), sampleBuffer.begin() + (sampleBuffer.size() - filterTapCount));
+		}
+		else if(sampleBuffer.size() < filterTapCount)
+		{
+			sampleBuffer.insert(sampleBuffer.begin(), filterTapCount - sampleBuffer.size(), 0.0f);
+		}
+		sampleBuffer.resize(filterTapCount + sourceSampleCount);
+		float* sampleBufferNew = &sampleBuffer[filterTapCount];
+		for(unsigned int sourceSampleNo = 0; sourceSampleNo < sourceSampleCount; ++sourceSampleNo)
+		{
+			sampleBufferNew[sourceSampleNo] = (float)sourceData[channelNo + (sourceSampleNo * achannelCount)];
+		}
+	}
+
+	//Filter each channel into the target buffer. We track the position in the source
+	//stream as a 32.32 fixed point value, so that the position of each output sample is
+	//calculated exactly. The position of the first output sample is placed halfway
+	//through the history buffer, which delays the output by half the filter length, but
+	//ensures that every source sample the filter needs for the last output sample is
+	//available.
+	unsigned long long sourcePositionStep = ((unsigned long long)sourceSampleCount << 32) / targetSampleCount;
+	unsigned long long sourcePosition = (unsigned long long)(filterTapCount / 2) << 32;
+	for(unsigned int channelNo = 0; channelNo < achannelCount; ++channelNo)
+	{
+		filterFunction(&channelSampleBuffers[channelNo][0], &filterCoefficients[0], filterTapCount, filterPhaseCount, sourcePosition, sourcePositionStep, targetData + channelNo, achannelCount, targetSampleCount);
+	}
+
+	//Trim each channel buffer back to the last filterTapCount samples, to be used as the
+	//history for the next call.
+	for(unsigned int channelNo = 0; channelNo < achannelCount; ++channelNo)
+	{
+		std::vector<float>& sampleBuffer = channelSampleBuffers[channelNo];
+		sampleBuffer.erase(sampleBuffer.begin(), sampleBuffer.begin() + sourceSampleCount);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Filter table functions
+//----------------------------------------------------------------------------------------
+AudioResampler::QualitySettings AudioResampler::GetQualitySettings(Quality quality)
+{
+	//The tap count here is the length of the filter in target samples. When we're
+	//reducing the sample rate, the filter is stretched across a correspondingly larger
+	//number of source samples, so that the width of the transition band stays the same
+	//relative to the target sample rate. The passband scale sets the upper limit of the
+	//passband as a fraction of the lower of the two nyquist frequencies. Longer filters
+	//allow a narrower transition band for the same stopband attenuation, and more phases
+	//reduce the error from rounding each output sample to the nearest phase.
+	QualitySettings settings;
+	switch(quality)
+	{
+	case Quality::Low:
+		settings.tapCount = 12;
+		settings.phaseCount = 256;
+		settings.passbandScale = 0.70;
+		break;
+	default:
+	case Quality::Medium:
+		settings.tapCount = 24;
+		settings.phaseCount = 512;
+		settings.passbandScale = 0.80;
+		break;
+	case Quality::High:
+		settings.tapCount = 48;
+		settings.phaseCount = 1024;
+		settings.passbandScale = 0.86;
+		break;
+	}
+	return settings;
+}
+
+//----------------------------------------------------------------------------------------
+void AudioResampler::BuildFilterTable(Quality aquality, double sampleConversionRatio)
+{
+	const double pi = 3.14159265358979323846;
+	QualitySettings settings = GetQualitySettings(aquality);
+
+	//Calculate the length of the filter in source samples, rounded up to a multiple of
+	//the vector width we use in the filter functions.
+	double stretchFactor = (sampleConversionRatio > 1.0)? sampleConversionRatio: 1.0;
+	unsigned int tapCount = (unsigned int)std::ceil((double)settings.tapCount * stretchFactor);
+	tapCount = ((tapCount + (tapCountAlignment - 1)) / tapCountAlignment) * tapCountAlignment;
+
+	//Calculate the cutoff frequency of the filter as a fraction of the source sample
+	//rate. The transition band runs from the end of the passband up to the lower nyquist
+	//frequency, and the cutoff frequency is placed in the middle of it.
+	double nyquistFrequency = 0.5 / stretchFactor;
+	double passbandEdge = nyquistFrequency * settings.passbandScale;
+	double cutoff = (passbandEdge + nyquistFrequency) / 2.0;
+
+	//Calculate the Kaiser window shape parameter which gives the greatest stopband
+	//attenuation achievable with this filter length and transition width, using the
+	//empirical design formulas given by Kaiser.
+	double transitionWidth = 2.0 * pi * (nyquistFrequency - passbandEdge);
+	double attenuation = (2.285 * transitionWidth * (double)(tapCount - 1)) + 8.0;
+	double kaiserBeta = KaiserWindow::CalculateBeta(attenuation);
+
+	//Build the coefficients for each filter phase. We build one more phase than the
+	//phase count, since positions which round up to the next whole sample use a final
+	//phase which is offset by one full sample. For each phase, the position of the output
+	//sample lies between tap (tapCount/2)-1 and tap tapCount/2, offset from the former by
+	//the fractional position of the phase. Each phase is normalized to unity gain at DC,
+	//so that a constant input produces a constant output regardless of the phase.
+	std::vector<double> phaseCoefficients((settings.phaseCount + 1) * tapCount);
+	double halfWidth = (double)tapCount / 2.0;
+	double besselI0Beta = KaiserWindow::BesselI0(kaiserBeta);
+	for(unsigned int phaseNo = 0; phaseNo <= settings.phaseCount; ++phaseNo)
+	{
+		double phaseOffset = (double)phaseNo / (double)settings.phaseCount;
+		double coefficientSum = 0.0;
+		for(unsigned int tapNo = 0; tapNo < tapCount; ++tapNo)
+		{
+			double x = ((double)tapNo - (halfWidth - 1.0)) - phaseOffset;
+			double sincInput = 2.0 * cutoff * x;
+			double sinc = (sincInput == 0.0)? 1.0: (std::sin(pi * sincInput) / (pi * sincInput));
+			double window = KaiserWindow::CalculateWindow(x / halfWidth, kaiserBeta, besselI0Beta);
+			double coefficient = 2.0 * cutoff * sinc * window;
+			phaseCoefficients[(phaseNo * tapCount) + tapNo] = coefficient;
+			coefficientSum += coefficient;
+		}
+		for(unsigned int tapNo = 0; tapNo < tapCount; ++tapNo)
+		{
+			phaseCoefficients[(phaseNo * tapCount) + tapNo] /= coefficientSum;
+		}
+	}
+
+	//Convert the coefficients into the final table format
+	filterCoefficients.resize(phaseCoefficients.size());
+	for(unsigned int i = 0; i < (unsigned int)phaseCoefficients.size(); ++i)
+	{
+		filterCoefficients[i] = (float)phaseCoefficients[i];
+	}
+
+	//Record the settings this table was built for
+	filterTableBuilt = true;
+	filterTableQuality = aquality;
+	filterTableRatio = sampleConversionRatio;
+	filterTapCount = tapCount;
+	filterPhaseCount = settings.phaseCount;
+}
+
+//----------------------------------------------------------------------------------------
+//Filter functions
+//----------------------------------------------------------------------------------------
+//The filter functions generate targetSampleCount output samples for a single channel.
+//Each output sample is the dot product of tapCount source samples with the filter
+//coefficients for its position in the source stream, starting with the position given
+//by sourcePosition, and advancing by sourcePositionStep for each output sample. The
+//coefficients table contains phaseCount+1 phases, and the phase nearest to the position
+//of each output sample is used. The tapCount argument is always a multiple of
+//tapCountAlignment. Each result is rounded and clamped to the range of a 16-bit sample,
+//and written to targetData, with targetStride samples between each output sample.
+//----------------------------------------------------------------------------------------
+AudioResampler::FilterFunction AudioResampler::SelectFilterFunction()
+{
+	//Select the widest supported filter loop. The vector loops accumulate the filter
+	//products in lanes and sum the lanes at the end, so their floating point results
+	//aren't bit-exact with the scalar loop, only within one step of the rounded output.
+	//VerifyFilterFunction confirms that bound over every supported tap count before a
+	//vector loop is used. This says nothing about the frequency response of the filter
+	//itself, which depends only on the coefficient tables.
+	if(ProcessorSupportsAVX() && VerifyFilterFunction(FilterSamplesAVX))
+	{
+		return FilterSamplesAVX;
+	}
+	if(ProcessorSupportsSSE2() && VerifyFilterFunction(FilterSamplesSSE2))
+	{
+		return FilterSamplesSSE2;
+	}
+	return FilterSamplesScalar;
+}
+
+//----------------------------------------------------------------------------------------
+bool AudioResampler::VerifyFilterFunction(FilterFunction afilterFunction)
+{
+	//Run a range of filter lengths and source positions through both the target function
+	//and the scalar function, using a set of sample and coefficient values which
+	//exercise every lane of the vector registers with a distinct value. We use a stride
+	//of two for the target samples, to confirm the correct target samples are written.
+	const unsigned int maxTapCount = tapCountAlignment * 16;
+	const unsigned int phaseCount = 4;
+	const unsigned int targetSampleCount = 16;
+	const unsigned int targetStride = 2;
+	const unsigned int sampleCount = maxTapCount + targetSampleCount;
+	std::vector<float> samples(sampleCount);
+	std::vector<float> coefficients((phaseCount + 1) * maxTapCount);
+	for(unsigned int i = 0; i < sampleCount; ++i)
+	{
+		samples[i] = (float)((int)((i * 7919) % 65536) - 32768);
+	}
+	for(unsigned int i = 0; i < ((phaseCount + 1) * maxTapCount); ++i)
+	{
+		coefficients[i] = (float)((int)((i * 104729) % 2001) - 1000) / 20000.0f;
+	}
+	for(unsigned int tapCount = tapCountAlignment; tapCount <= maxTapCount; tapCount += tapCountAlignment)
+	{
+		short expectedResults[targetSampleCount * targetStride] = {0};
+		short results[targetSampleCount * targetStride] = {0};
+		unsigned long long sourcePosition = (unsigned long long)(tapCount / 2) << 32;
+		unsigned long long sourcePositionStep = 0x12345678ULL;
+		FilterSamplesScalar(&samples[0], &coefficients[0], tapCount, phaseCount, sourcePosition, sourcePositionStep, expectedResults, targetStride, targetSampleCount);
+		afilterFunction(&samples[0], &coefficients[0], tapCount, phaseCount, sourcePosition, sourcePositionStep, results, targetStride, targetSampleCount);
+		for(unsigned int i = 0; i < (targetSampleCount * targetStride); ++i)
+		{
+			//Since the results are rounded to integers, a small difference in the sum can
+			//move the result across a rounding boundary, so we allow a difference of 1.
+			int difference = (int)results[i] - (int)expectedResults[i];
+			if((difference < -1) || (difference > 1))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+void AudioResampler::FilterSamplesScalar(const float* samples, const float* coefficients, unsigned int tapCount, unsigned int phaseCount, unsigned long long sourcePosition, unsigned long long sourcePositionStep, short* targetData, unsigned int targetStride, unsigned int targetSampleCount)
+{
+	unsigned int halfTapCount = tapCount / 2;
+	for(unsigned int targetSampleNo = 0; targetSampleNo < targetSampleCount; ++targetSampleNo)
+	{
+		//Calculate the first source sample in the filter window, and select the filter
+		//phase nearest to the position of this output sample.
+		unsigned int phaseNo = (unsigned int)((((unsigned long long)(unsigned int)sourcePosition * phaseCount) + 0x80000000ULL) >> 32);
+		const float* windowSamples = samples + (((unsigned int)(sourcePosition >> 32) + 1) - halfTapCount);
+		const float* phaseCoefficients = coefficients + (phaseNo * tapCount);
+
+		float result = 0.0f;
+		for(unsigned int tapNo = 0; tapNo < tapCount; ++tapNo)
+		{
+			result += windowSamples[tapNo] * phaseCoefficients[tapNo];
+		}
+
+		//Round the result and clamp it to the range of the output sample format
+		result = (result > 32767.0f)? 32767.0f: ((result < -32768.0f)? -32768.0f: result);
+		targetData[targetSampleNo * targetStride] = (short)((result >= 0.0f)? (result + 0.5f): (result - 0.5f));
+		sourcePosition += sourcePositionStep;
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void AudioResampler::FilterSamplesSSE2(const float* samples, const float* coefficients, unsigned int tapCount, unsigned int phaseCount, unsigned long long sourcePosition, unsigned long long sourcePositionStep, short* targetData, unsigned int targetStride, unsigned int targetSampleCount)
+{
+	unsigned int halfTapCount = tapCount / 2;
+	for(unsigned int targetSampleNo = 0; targetSampleNo < targetSampleCount; ++targetSampleNo)
+	{
+		unsigned int phaseNo = (unsigned int)((((unsigned long long)(unsigned int)sourcePosition * phaseCount) + 0x80000000ULL) >> 32);
+		const float* windowSamples = samples + (((unsigned int)(sourcePosition >> 32) + 1) - halfTapCount);
+		const float* phaseCoefficients = coefficients + (phaseNo * tapCount);
+
+		//Accumulate into two independent sums, to hide the latency of the add operations.
+		__m128 sum0 = _mm_setzero_ps();
+		__m128 sum1 = _mm_setzero_ps();
+		unsigned int tapNo = 0;
+		while((tapNo + 8) <= tapCount)
+		{
+			sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(windowSamples + tapNo), _mm_loadu_ps(phaseCoefficients + tapNo)));
+			sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(windowSamples + tapNo + 4), _mm_loadu_ps(phaseCoefficients + tapNo + 4)));
+			tapNo += 8;
+		}
+		if(tapNo < tapCount)
+		{
+			sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(windowSamples + tapNo), _mm_loadu_ps(phaseCoefficients + tapNo)));
+		}
+
+		//Sum the four lanes of the combined result, then round the result and clamp it to
+		//the range of the output sample format.
+		__m128 sum = _mm_add_ps(sum0, sum1);
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x55));
+		int result = _mm_cvtss_si32(sum);
+		targetData[targetSampleNo * targetStride] = (short)((result > 32767)? 32767: ((result < -32768)? -32768: result));
+		sourcePosition += sourcePositionStep;
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void AudioResampler::FilterSamplesAVX(const float* samples, const float* coefficients, unsigned int tapCount, unsigned int phaseCount, unsigned long long sourcePosition, unsigned long long sourcePositionStep, short* targetData, unsigned int targetStride, unsigned int targetSampleCount)
+{
+	//We generate output samples in pairs here, so that the horizontal sums for both
+	//samples can be performed together. If there's an odd number of output samples, the
+	//final pair calculates the last sample twice, and only one result is written.
+	unsigned int halfTapCount = tapCount / 2;
+	for(unsigned int targetSampleNo = 0; targetSampleNo < targetSampleCount; targetSampleNo += 2)
+	{
+		bool secondSamplePresent = ((targetSampleNo + 1) < targetSampleCount);
+		unsigned long long secondSourcePosition = secondSamplePresent? (sourcePosition + sourcePositionStep): sourcePosition;
+		unsigned int phaseNo0 = (unsigned int)((((unsigned long long)(unsigned int)sourcePosition * phaseCount) + 0x80000000ULL) >> 32);
+		unsigned int phaseNo1 = (unsigned int)((((unsigned long long)(unsigned int)secondSourcePosition * phaseCount) + 0x80000000ULL) >> 32);
+		const float* windowSamples0 = samples + (((unsigned int)(sourcePosition >> 32) + 1) - halfTapCount);
+		const float* windowSamples1 = samples + (((unsigned int)(secondSourcePosition >> 32) + 1) - halfTapCount);
+		const float* phaseCoefficients0 = coefficients + (phaseNo0 * tapCount);
+		const float* phaseCoefficients1 = coefficients + (phaseNo1 * tapCount);
+
+		__m256 sum0 = _mm256_setzero_ps();
+		__m256 sum1 = _mm256_setzero_ps();
+		unsigned int tapNo = 0;
+		while((tapNo + 8) <= tapCount)
+		{
+			sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(windowSamples0 + tapNo), _mm256_loadu_ps(phaseCoefficients0 + tapNo)));
+			sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(_mm256_loadu_ps(windowSamples1 + tapNo), _mm256_loadu_ps(phaseCoefficients1 + tapNo)));
+			tapNo += 8;
+		}
+
+		//Combine the lanes of both sums, leaving partial sums for the first sample in
+		//lanes 0 and 1, and partial sums for the second sample in lanes 2 and 3.
+		__m256 pairSum = _mm256_hadd_ps(sum0, sum1);
+		__m128 pairSum128 = _mm_add_ps(_mm256_castps256_ps128(pairSum), _mm256_extractf128_ps(pairSum, 1));
+		if(tapNo < tapCount)
+		{
+			__m128 tailSum0 = _mm_mul_ps(_mm_loadu_ps(windowSamples0 + tapNo), _mm_loadu_ps(phaseCoefficients0 + tapNo));
+			__m128 tailSum1 = _mm_mul_ps(_mm_loadu_ps(windowSamples1 + tapNo), _mm_loadu_ps(phaseCoefficients1 + tapNo));
+			pairSum128 = _mm_add_ps(pairSum128, _mm_hadd_ps(tailSum0, tailSum1));
+		}
+
+		//Complete the sums for both samples, then round the results and convert them to
+		//16-bit values. The pack operation clamps the results to the range of the output
+		//sample format.
+		pairSum128 = _mm_hadd_ps(pairSum128, pairSum128);
+		__m128i results = _mm_cvtps_epi32(pairSum128);
+		results = _mm_packs_epi32(results, results);
+		targetData[targetSampleNo * targetStride] = (short)_mm_extract_epi16(results, 0);
+		if(secondSamplePresent)
+		{
+			targetData[(targetSampleNo + 1) * targetStride] = (short)_mm_extract_epi16(results, 1);
+		}
+		sourcePosition += sourcePositionStep * 2;
+	}
+
+	//Clear the upper halves of the YMM registers, to avoid any transition penalty when
+	//legacy SSE instructions are executed after this function returns.
+	_mm256_zeroupper();
+}
@@ -0,0 +1,64 @@
+#ifndef __AUDIORESAMPLER_H__
+#define __AUDIORESAMPLER_H__
+#include <vector>
+
+class AudioResampler
+{
+public:
+	//Enumerations
+	enum class Quality;
+
+	//Constructors
+	AudioResampler();
+
+	//Quality settings
+	inline Quality GetQuality() const;
+	inline void SetQuality(Quality aquality);
+
+	//Sample rate conversion
+	void Reset();
+	void Resample(const short* sourceData, unsigned int sourceSampleCount, unsigned int achannelCount, short* targetData, unsigned int targetSampleCount);
+
+private:
+	//Typedefs
+	typedef void(*FilterFunction)(const float* samples, const float* coefficients, unsigned int tapCount, unsigned int phaseCount, unsigned long long sourcePosition, unsigned long long sourcePositionStep, short* targetData, unsigned int targetStride, unsigned int targetSampleCount);
+
+	//Structures
+	struct QualitySettings;
+
+private:
+	//Filter table functions
+	static QualitySettings GetQualitySettings(Quality quality);
+	void BuildFilterTable(Quality quality, double sampleConversionRatio);
+
+	//Filter functions
+	static FilterFunction SelectFilterFunction();
+	static bool VerifyFilterFunction(FilterFunction afilterFunction);
+	static void FilterSamplesScalar(const float* samples, const float* coefficients, unsigned int tapCount, unsigned int phaseCount, unsigned long long sourcePosition, unsigned long long sourcePositionStep, short* targetData, unsigned int targetStride, unsigned int targetSampleCount);
+	static void FilterSamplesSSE2(const float* samples, const float* coefficients, unsigned int tapCount, unsigned int phaseCount, unsigned long long sourcePosition, unsigned long long sourcePositionStep, short* targetData, unsigned int targetStride, unsigned int targetSampleCount);
+	static void FilterSamplesAVX(const float* samples, const float* coefficients, unsigned int tapCount, unsigned int phaseCount, unsigned long long sourcePosition, unsigned long long sourcePositionStep, short* targetData, unsigned int targetStride, unsigned int targetSampleCount);
+
+private:
+	//Constants
+	static const unsigned int tapCountAlignment = 4;
+	static const double filterTableRatioTolerance;
+
+	//Quality settings
+	volatile Quality quality;
+
+	//Filter table
+	FilterFunction filterFunction;
+	bool filterTableBuilt;
+	Quality filterTableQuality;
+	double filterTableRatio;
+	unsigned int filterTapCount;
+	unsigned int filterPhaseCount;
+	std::vector<float> filterCoefficients;
+
+	//Sample history
+	unsigned int historyChannelCount;
+	std::vector<std::vector<float>> channelSampleBuffers;
+};
+
+#include "AudioResampler.inl"
+#endif
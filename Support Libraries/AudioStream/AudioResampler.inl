@@ -0,0 +1,33 @@
+//----------------------------------------------------------------------------------------
+//Enumerations
+//----------------------------------------------------------------------------------------
+enum class AudioResampler::Quality
+{
+	Low,
+	Medium,
+	High
+};
+
+//----------------------------------------------------------------------------------------
+//Structures
+//----------------------------------------------------------------------------------------
+struct AudioResampler::QualitySettings
+{
+	unsigned int tapCount;
+	unsigned int phaseCount;
+	double passbandScale;
+};
+
+//----------------------------------------------------------------------------------------
+//Quality settings
+//----------------------------------------------------------------------------------------
+AudioResampler::Quality AudioResampler::GetQuality() const
+{
+	return quality;
+}
+
+//----------------------------------------------------------------------------------------
+void AudioResampler::SetQuality(Quality aquality)
+{
+	quality = aquality;
+}
@@ -9,7 +9,7 @@
 //Constructors
 //----------------------------------------------------------------------------------------
 AudioStream::AudioStream()
-:workerThreadRunning(false), completedBufferSlots(0)
+:sink(0), workerThreadRunning(false), completedBufferSlots(0)
 {
 	//Create our critical section object
 	InitializeCriticalSection(&waveMutex);
@@ -87,9 +87,43 @@ bool AudioStream::Open(unsigned int achannelCount, unsigned int abitsPerSample,
 	return true;
 }
 
+//----------------------------------------------------------------------------------------
+bool AudioStream::Open(IAudioSink& asink, unsigned int achannelCount, unsigned int abitsPerSample, unsigned int asamplesPerSec)
+{
+	//If the stream is already open, close it.
+	Close();
+
+	//Set the properties of the audio output stream
+	channelCount = achannelCount;
+	bitsPerSample = abitsPerSample;
+	samplesPerSec = asamplesPerSec;
+
+	//Open the target sink. When a sink is bound, no audio device or worker thread is
+	//used. Buffers are handed to the sink as soon as they're submitted for playback, and
+	//never dropped, so output is produced at whatever rate the caller runs at, and the
+	//sequence of samples the sink receives doesn't depend on timing.
+	if(!asink.Open(channelCount, bitsPerSample, samplesPerSec))
+	{
+		//##DEBUG##
+		std::wcout << "AudioStream Error!:\tFailed to open audio sink!" << '\n';
+		return false;
+	}
+	sink = &asink;
+
+	return true;
+}
+
 //----------------------------------------------------------------------------------------
 void AudioStream::Close()
 {
+	//If an audio sink is bound to this stream, close it. Any buffers it has queued are
+	//flushed before it returns.
+	if(sink != 0)
+	{
+		sink->Close();
+		sink = 0;
+	}
+
 	//If the worker thread is currently marked as running, send a shutdown event
 	//notification, and wait for the worker thread to terminate.
 	if(workerThreadRunning)
@@ -118,6 +152,10 @@ void AudioStream::Close()
 		delete *i;
 	}
 	pendingBuffers.clear();
+
+	//Discard the sample history used for sample rate conversion, so that data from this
+	//stream doesn't carry over if the stream is opened again.
+	resampler.Reset();
 }
 
 //----------------------------------------------------------------------------------------
@@ -127,11 +165,18 @@ AudioStream::AudioBuffer* AudioStream::CreateAudioBuffer(unsigned int sampleCoun
 {
 	//Ensure that the audio output stream has been opened, and that valid number of
 	//samples and channels have been specified for this buffer.
-	if(!workerThreadRunning || (sampleCount <= 0) || (achannelCount <= 0))
+	if((!workerThreadRunning && (sink == 0)) || (sampleCount <= 0) || (achannelCount <= 0))
 	{
 		return 0;
 	}
 
+	//If this stream outputs to an audio sink, buffers are passed straight through, and
+	//never need to be tracked or dropped.
+	if(sink != 0)
+	{
+		return new AudioBuffer(sampleCount * achannelCount);
+	}
+
 	//Create a new AudioBuffer object
 	AudioBuffer* entry = new AudioBuffer(sampleCount * achannelCount);
 
@@ -181,6 +226,13 @@ AudioStream::AudioBuffer* AudioStream::CreateAudioBuffer(unsigned int sampleCoun
 //----------------------------------------------------------------------------------------
 void AudioStream::DeleteAudioBuffer(AudioBuffer* buffer)
 {
+	//Buffers created for an audio sink aren't held in the pending buffer list
+	if(sink != 0)
+	{
+		delete buffer;
+		return;
+	}
+
 	//Find and delete this buffer from the list of pending buffers
 	EnterCriticalSection(&waveMutex);
 	std::list<AudioBuffer*>::iterator pendingBufferIterator = pendingBuffers.begin();
@@ -200,12 +252,48 @@ void AudioStream::DeleteAudioBuffer(AudioBuffer* buffer)
 //----------------------------------------------------------------------------------------
 void AudioStream::PlayBuffer(AudioBuffer* buffer)
 {
+	//If this stream outputs to an audio sink, pass the sample data to the sink now, and
+	//release the buffer.
+	if(sink != 0)
+	{
+		unsigned int sampleCount = (unsigned int)(buffer->buffer.size() / channelCount);
+		if(sampleCount > 0)
+		{
+			sink->WriteSamples(&buffer->buffer[0], sampleCount);
+		}
+		delete buffer;
+		return;
+	}
+
 	EnterCriticalSection(&waveMutex);
 	buffer->playBuffer = true;
 	LeaveCriticalSection(&waveMutex);
 	SetEvent(eventHandles[EVENT_PLAYBUFFER]);
 }
 
+//----------------------------------------------------------------------------------------
+unsigned int AudioStream::GetQueuedSampleCount()
+{
+	//Return the number of samples which have been submitted for playback and haven't yet
+	//been played, including those still held pending. Callers which generate audio on
+	//demand can use this to keep the output stream filled to a fixed depth.
+	if(sink != 0)
+	{
+		return 0;
+	}
+	EnterCriticalSection(&waveMutex);
+	unsigned int queuedSampleCount = currentPlayingSamples;
+	for(std::list<AudioBuffer*>::const_iterator i = pendingBuffers.begin(); i != pendingBuffers.end(); ++i)
+	{
+		if((*i)->playBuffer)
+		{
+			queuedSampleCount += (unsigned int)((*i)->buffer.size() / channelCount);
+		}
+	}
+	LeaveCriticalSection(&waveMutex);
+	return queuedSampleCount;
+}
+
 //----------------------------------------------------------------------------------------
 void AudioStream::AddPendingBuffers(HWAVEOUT deviceHandle)
 {
@@ -617,3 +705,17 @@ void AudioStream::ConvertSampleRate(const std::vector<short>& sourceData, unsign
 		}
 	}
 }
+
+//----------------------------------------------------------------------------------------
+void AudioStream::ResampleBuffer(const std::vector<short>& sourceData, unsigned int sourceSampleCount, unsigned int achannelCount, std::vector<short>& targetData, unsigned int targetSampleCount)
+{
+	//Perform a band-limited resampling of the source sample data using the stateful
+	//resampler for this stream. Unlike ConvertSampleRate, the filter history is carried
+	//over between calls, so this function should only be used with successive buffers
+	//from the same continuous stream of sample data.
+	targetData.resize(targetSampleCount * achannelCount);
+	if((sourceSampleCount > 0) && (targetSampleCount > 0))
+	{
+		resampler.Resample(&sourceData[0], sourceSampleCount, achannelCount, &targetData[0], targetSampleCount);
+	}
+}
@@ -1,6 +1,8 @@
 #ifndef __AUDIOSTREAM_H__
 #define __AUDIOSTREAM_H__
 #include "WindowsSupport/WindowsSupport.pkg"
+#include "AudioResampler.h"
+#include "IAudioSink.h"
 #include <list>
 #include <vector>
 
@@ -16,15 +18,20 @@ public:
 
 	//Audio stream binding
 	bool Open(unsigned int achannelCount, unsigned int abitsPerSample, unsigned int asamplesPerSec, unsigned int amaxPendingSamples = 0, unsigned int aminPlayingSamples = 0);
+	bool Open(IAudioSink& asink, unsigned int achannelCount, unsigned int abitsPerSample, unsigned int asamplesPerSec);
 	void Close();
 
 	//Buffer management functions
 	AudioBuffer* CreateAudioBuffer(unsigned int sampleCount, unsigned int achannelCount);
 	void DeleteAudioBuffer(AudioBuffer* buffer);
 	void PlayBuffer(AudioBuffer* buffer);
+	unsigned int GetQueuedSampleCount();
 
 	//Sample rate conversion
 	static void ConvertSampleRate(const std::vector<short>& sourceData, unsigned int sourceSampleCount, unsigned int achannelCount, std::vector<short>& targetData, unsigned int targetSampleCount);
+	inline AudioResampler::Quality GetResampleQuality() const;
+	inline void SetResampleQuality(AudioResampler::Quality quality);
+	void ResampleBuffer(const std::vector<short>& sourceData, unsigned int sourceSampleCount, unsigned int achannelCount, std::vector<short>& targetData, unsigned int targetSampleCount);
 
 private:
 	//Worker thread functions
@@ -43,6 +50,9 @@ private:
 	unsigned int samplesPerSec;
 	unsigned int maxPendingSamples;
 
+	//Audio sink
+	IAudioSink* sink;
+
 	//Worker thread event information
 	static const unsigned int EVENT_SHUTDOWN = 0;
 	static const unsigned int EVENT_PLAYBUFFER = 1;
@@ -59,6 +69,9 @@ private:
 	std::list<AudioBuffer*> pendingBuffers;
 	std::list<AudioBuffer*> playingBuffers;
 	volatile unsigned int completedBufferSlots;
+
+	//Sample rate conversion
+	AudioResampler resampler;
 };
 
 #include "AudioStream.inl"
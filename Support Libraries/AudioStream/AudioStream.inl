@@ -12,3 +12,17 @@ struct AudioStream::AudioBuffer
 	bool playBuffer;
 	bool bufferSentToAudioDevice;
 };
+
+//----------------------------------------------------------------------------------------
+//Sample rate conversion
+//----------------------------------------------------------------------------------------
+AudioResampler::Quality AudioStream::GetResampleQuality() const
+{
+	return resampler.GetQuality();
+}
+
+//----------------------------------------------------------------------------------------
+void AudioStream::SetResampleQuality(AudioResampler::Quality quality)
+{
+	resampler.SetQuality(quality);
+}
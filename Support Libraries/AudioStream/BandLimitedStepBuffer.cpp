@@ -0,0 +1,147 @@
+#include "BandLimitedStepBuffer.h"
+#include "KaiserWindow.h"
+#include <cmath>
+
+//----------------------------------------------------------------------------------------
+//Constructors
+//----------------------------------------------------------------------------------------
+BandLimitedStepBuffer::BandLimitedStepBuffer()
+:clockRate(0), sampleRate(0), clockStep(0)
+{
+	BuildKernel();
+	Clear();
+}
+
+//----------------------------------------------------------------------------------------
+//Rate functions
+//----------------------------------------------------------------------------------------
+//The clock rate is the rate of the clock used to specify the time of each transition, and
+//the sample rate is the rate of the output samples. The rates may be changed between
+//frames without disturbing the contents of the buffer.
+//----------------------------------------------------------------------------------------
+void BandLimitedStepBuffer::SetRates(double aclockRate, unsigned int asampleRate)
+{
+	if((clockRate == aclockRate) && (sampleRate == asampleRate))
+	{
+		return;
+	}
+	clockRate = aclockRate;
+	sampleRate = asampleRate;
+
+	//Calculate the number of output samples per clock cycle, as a 32.32 fixed point
+	//value.
+	clockStep = (clockRate > 0.0)? (unsigned long long)(((double)sampleRate / clockRate) * 4294967296.0): 0;
+}
+
+//----------------------------------------------------------------------------------------
+//Buffer management functions
+//----------------------------------------------------------------------------------------
+void BandLimitedStepBuffer::Clear()
+{
+	frameStartPosition = 0;
+	samplesAvailable = 0;
+	integrator = 0;
+	sampleBuffer.assign(kernelTapCount, 0);
+}
+
+//----------------------------------------------------------------------------------------
+void BandLimitedStepBuffer::EndFrame(unsigned int clockCount)
+{
+	//Advance the start of the next frame past the end of this frame. Transitions in
+	//later frames can only affect output samples from the sample containing the start of
+	//the next frame onwards, so all samples before that point are now complete.
+	frameStartPosition += (unsigned long long)clockCount * clockStep;
+	samplesAvailable = (unsigned int)(frameStartPosition >> 32);
+	if(sampleBuffer.size() < (samplesAvailable + kernelTapCount))
+	{
+		sampleBuffer.resize(samplesAvailable + kernelTapCount, 0);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void BandLimitedStepBuffer::ReadSamples(std::vector<short>& targetData, unsigned int sampleCount)
+{
+	//Integrate the impulses in the sample buffer to form the output samples, and append
+	//them to the target buffer.
+	if(sampleCount > samplesAvailable)
+	{
+		sampleCount = samplesAvailable;
+	}
+	size_t targetDataPos = targetData.size();
+	targetData.resize(targetDataPos + sampleCount);
+	const int roundingOffset = 1 << (kernelUnitBitCount - 1);
+	for(unsigned int sampleNo = 0; sampleNo < sampleCount; ++sampleNo)
+	{
+		integrator += sampleBuffer[sampleNo];
+		int sample = (integrator + roundingOffset) >> kernelUnitBitCount;
+		targetData[targetDataPos++] = (short)((sample > 32767)? 32767: ((sample < -32768)? -32768: sample));
+	}
+
+	//Remove the samples we've read from the sample buffer. Only the tails of the most
+	//recent impulses remain after this point, so this is a small move.
+	sampleBuffer.erase(sampleBuffer.begin(), sampleBuffer.begin() + sampleCount);
+	frameStartPosition -= (unsigned long long)sampleCount << 32;
+	samplesAvailable -= sampleCount;
+}
+
+//----------------------------------------------------------------------------------------
+//Kernel functions
+//----------------------------------------------------------------------------------------
+//The kernel holds a band-limited impulse for kernelPhaseCount evenly spaced fractional
+//positions within an output sample. Each impulse is a Kaiser-windowed sinc function,
+//which is placed so that the position of the transition lies between tap
+//(kernelTapCount/2)-1 and tap kernelTapCount/2. This delays the output by half the
+//length of the kernel. The taps are stored as integers, and each phase is adjusted so
+//that its taps sum to exactly 1 << kernelUnitBitCount. This ensures that integrating the
+//buffer produces an exact step of the requested size once the impulse has passed, so
+//that no error accumulates in the output level over time.
+//----------------------------------------------------------------------------------------
+void BandLimitedStepBuffer::BuildKernel()
+{
+	//The passband extends to 80% of the nyquist frequency of the output, and the cutoff
+	//frequency is placed in the middle of the transition band between the end of the
+	//passband and the nyquist frequency. The Kaiser window shape parameter is calculated
+	//from the desired transition width using the empirical formulas given by Kaiser.
+	const double pi = 3.14159265358979323846;
+	const double passbandEdge = 0.5 * 0.8;
+	const double cutoff = (passbandEdge + 0.5) / 2.0;
+	double transitionWidth = 2.0 * pi * (0.5 - passbandEdge);
+	double attenuation = (2.285 * transitionWidth * (double)(kernelTapCount - 1)) + 8.0;
+	double kaiserBeta = KaiserWindow::CalculateBeta(attenuation);
+	double besselI0Beta = KaiserWindow::BesselI0(kaiserBeta);
+	double halfWidth = (double)kernelTapCount / 2.0;
+
+	kernel.resize(kernelPhaseCount * kernelTapCount);
+	std::vector<double> phaseKernel(kernelTapCount);
+	for(unsigned int phaseNo = 0; phaseNo < kernelPhaseCount; ++phaseNo)
+	{
+		//Calculate the impulse for this phase
+		double phaseOffset = ((double)phaseNo + 0.5) / (double)kernelPhaseCount;
+		double kernelSum = 0.0;
+		for(unsigned int tapNo = 0; tapNo < kernelTapCount; ++tapNo)
+		{
+			double x = ((double)tapNo - (halfWidth - 1.0)) - phaseOffset;
+			double sincInput = 2.0 * cutoff * x;
+			double sinc = (sincInput == 0.0)? 1.0: (std::sin(pi * sincInput) / (pi * sincInput));
+			double window = KaiserWindow::CalculateWindow(x / halfWidth, kaiserBeta, besselI0Beta);
+			phaseKernel[tapNo] = sinc * window;
+			kernelSum += phaseKernel[tapNo];
+		}
+
+		//Convert the impulse to integer form, and add any rounding error to the largest
+		//tap, so that the taps sum to exactly the unit value.
+		int integerKernelSum = 0;
+		unsigned int largestTapNo = 0;
+		for(unsigned int tapNo = 0; tapNo < kernelTapCount; ++tapNo)
+		{
+			int tap = (int)std::floor(((phaseKernel[tapNo] / kernelSum) * (double)(1 << kernelUnitBitCount)) + 0.5);
+			kernel[(phaseNo * kernelTapCount) + tapNo] = tap;
+			integerKernelSum += tap;
+			if(phaseKernel[tapNo] > phaseKernel[largestTapNo])
+			{
+				largestTapNo = tapNo;
+			}
+		}
+		kernel[(phaseNo * kernelTapCount) + largestTapNo] += (1 << kernelUnitBitCount) - integerKernelSum;
+	}
+}
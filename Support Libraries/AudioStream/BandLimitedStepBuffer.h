@@ -0,0 +1,48 @@
+#ifndef __BANDLIMITEDSTEPBUFFER_H__
+#define __BANDLIMITEDSTEPBUFFER_H__
+#include <vector>
+
+class BandLimitedStepBuffer
+{
+public:
+	//Constructors
+	BandLimitedStepBuffer();
+
+	//Rate functions
+	void SetRates(double aclockRate, unsigned int asampleRate);
+
+	//Buffer management functions
+	void Clear();
+	inline void AddDelta(unsigned int clockTime, int delta);
+	void EndFrame(unsigned int clockCount);
+	inline unsigned int GetSamplesAvailable() const;
+	void ReadSamples(std::vector<short>& targetData, unsigned int sampleCount);
+
+private:
+	//Kernel functions
+	void BuildKernel();
+
+private:
+	//Constants
+	static const unsigned int kernelPhaseBitCount = 6;
+	static const unsigned int kernelPhaseCount = 1 << kernelPhaseBitCount;
+	static const unsigned int kernelTapCount = 32;
+	static const unsigned int kernelUnitBitCount = 15;
+
+	//Rate settings
+	double clockRate;
+	unsigned int sampleRate;
+	unsigned long long clockStep;
+
+	//Kernel data
+	std::vector<int> kernel;
+
+	//Buffer data
+	unsigned long long frameStartPosition;
+	unsigned int samplesAvailable;
+	int integrator;
+	std::vector<int> sampleBuffer;
+};
+
+#include "BandLimitedStepBuffer.inl"
+#endif
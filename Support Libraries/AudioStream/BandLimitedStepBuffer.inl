@@ -0,0 +1,33 @@
+//----------------------------------------------------------------------------------------
+//Buffer management functions
+//----------------------------------------------------------------------------------------
+void BandLimitedStepBuffer::AddDelta(unsigned int clockTime, int delta)
+{
+	//Calculate the position of this transition in the output stream, and select the
+	//kernel phase nearest to its fractional position within the output sample.
+	unsigned long long position = frameStartPosition + ((unsigned long long)clockTime * clockStep);
+	unsigned int sampleNo = (unsigned int)(position >> 32);
+	unsigned int phaseNo = (unsigned int)(position >> (32 - kernelPhaseBitCount)) & (kernelPhaseCount - 1);
+
+	//Ensure the sample buffer is large enough to hold the complete kernel
+	if(sampleBuffer.size() < (sampleNo + kernelTapCount))
+	{
+		sampleBuffer.resize(sampleNo + kernelTapCount, 0);
+	}
+
+	//Add the band-limited impulse for this transition to the sample buffer. The sample
+	//buffer is integrated when samples are read, which turns each impulse into a
+	//band-limited step.
+	const int* phaseKernel = &kernel[phaseNo * kernelTapCount];
+	int* target = &sampleBuffer[sampleNo];
+	for(unsigned int tapNo = 0; tapNo < kernelTapCount; ++tapNo)
+	{
+		target[tapNo] += delta * phaseKernel[tapNo];
+	}
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int BandLimitedStepBuffer::GetSamplesAvailable() const
+{
+	return samplesAvailable;
+}
@@ -0,0 +1,21 @@
+#ifndef __IAUDIOSINK_H__
+#define __IAUDIOSINK_H__
+
+class IAudioSink
+{
+public:
+	//Constructors
+	virtual ~IAudioSink() = 0 {}
+
+	//Sink binding
+	virtual bool Open(unsigned int channelCount, unsigned int bitsPerSample, unsigned int samplesPerSec) = 0;
+	virtual void Close() = 0;
+
+	//Sample output functions
+	//Note that sample data is passed as a raw buffer rather than a container, since sinks
+	//may be created by the system and used by devices in other assemblies. The buffer
+	//holds sampleCount sample frames, with the values for each channel interleaved.
+	virtual void WriteSamples(const short* sampleData, unsigned int sampleCount) = 0;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#include "KaiserWindow.h"
+#include <cmath>
+
+//----------------------------------------------------------------------------------------
+//Window functions
+//----------------------------------------------------------------------------------------
+//Calculates the Kaiser window shape parameter which gives the requested stopband
+//attenuation in decibels, using the empirical design formulas given by Kaiser.
+//----------------------------------------------------------------------------------------
+double KaiserWindow::CalculateBeta(double attenuation)
+{
+	if(attenuation > 50.0)
+	{
+		return 0.1102 * (attenuation - 8.7);
+	}
+	else if(attenuation > 21.0)
+	{
+		return (0.5842 * std::pow(attenuation - 21.0, 0.4)) + (0.07886 * (attenuation - 21.0));
+	}
+	return 0.0;
+}
+
+//----------------------------------------------------------------------------------------
+//Calculates the value of the window at the specified position, where the window extends
+//from -1.0 to 1.0. The besselI0Beta argument is the value of BesselI0(beta), which is
+//passed in by the caller so that it only needs to be calculated once for each window.
+//----------------------------------------------------------------------------------------
+double KaiserWindow::CalculateWindow(double windowPosition, double beta, double besselI0Beta)
+{
+	double windowInput = 1.0 - (windowPosition * windowPosition);
+	return (windowInput > 0.0)? (BesselI0(beta * std::sqrt(windowInput)) / besselI0Beta): 0.0;
+}
+
+//----------------------------------------------------------------------------------------
+double KaiserWindow::BesselI0(double x)
+{
+	//Evaluate the zeroth order modified Bessel function of the first kind using its
+	//power series, which converges quickly for the range of values used by the window.
+	double sum = 1.0;
+	double term = 1.0;
+	double halfX = x / 2.0;
+	for(unsigned int k = 1; k < 64; ++k)
+	{
+		term *= (halfX / (double)k) * (halfX / (double)k);
+		sum += term;
+		if(term < (sum * 1e-12))
+		{
+			break;
+		}
+	}
+	return sum;
+}
@@ -0,0 +1,13 @@
+#ifndef __KAISERWINDOW_H__
+#define __KAISERWINDOW_H__
+
+class KaiserWindow
+{
+public:
+	//Window functions
+	static double CalculateBeta(double attenuation);
+	static double CalculateWindow(double windowPosition, double beta, double besselI0Beta);
+	static double BesselI0(double x);
+};
+
+#endif
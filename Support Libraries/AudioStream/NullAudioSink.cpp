@@ -0,0 +1,54 @@
+#include "NullAudioSink.h"
+
+//----------------------------------------------------------------------------------------
+//Constructors
+//----------------------------------------------------------------------------------------
+NullAudioSink::NullAudioSink()
+:channelCount(1), writtenSampleCount(0), writtenSampleChecksum(fnvOffsetBasis)
+{}
+
+//----------------------------------------------------------------------------------------
+//Sink binding
+//----------------------------------------------------------------------------------------
+bool NullAudioSink::Open(unsigned int achannelCount, unsigned int bitsPerSample, unsigned int samplesPerSec)
+{
+	channelCount = (achannelCount > 0)? achannelCount: 1;
+	writtenSampleCount = 0;
+	writtenSampleChecksum = fnvOffsetBasis;
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+void NullAudioSink::Close()
+{}
+
+//----------------------------------------------------------------------------------------
+//Sample output functions
+//----------------------------------------------------------------------------------------
+void NullAudioSink::WriteSamples(const short* sampleData, unsigned int sampleCount)
+{
+	//Discard the sample data, keeping only a count of the samples we've been given, and
+	//a running FNV-1a hash of their values. Since nothing is ever dropped by a sink, two
+	//runs which generate the same audio produce the same count and checksum, which lets
+	//callers confirm that the output of a core is deterministic without it being played.
+	unsigned int valueCount = sampleCount * channelCount;
+	for(unsigned int i = 0; i < valueCount; ++i)
+	{
+		unsigned short value = (unsigned short)sampleData[i];
+		writtenSampleChecksum = (writtenSampleChecksum ^ (value & 0xFF)) * fnvPrime;
+		writtenSampleChecksum = (writtenSampleChecksum ^ (value >> 8)) * fnvPrime;
+	}
+	writtenSampleCount += sampleCount;
+}
+
+//----------------------------------------------------------------------------------------
+unsigned long long NullAudioSink::GetWrittenSampleCount() const
+{
+	return writtenSampleCount;
+}
+
+//----------------------------------------------------------------------------------------
+unsigned long long NullAudioSink::GetWrittenSampleChecksum() const
+{
+	return writtenSampleChecksum;
+}
@@ -0,0 +1,31 @@
+#ifndef __NULLAUDIOSINK_H__
+#define __NULLAUDIOSINK_H__
+#include "IAudioSink.h"
+
+class NullAudioSink :public IAudioSink
+{
+public:
+	//Constructors
+	NullAudioSink();
+
+	//Sink binding
+	virtual bool Open(unsigned int channelCount, unsigned int bitsPerSample, unsigned int samplesPerSec);
+	virtual void Close();
+
+	//Sample output functions
+	virtual void WriteSamples(const short* sampleData, unsigned int sampleCount);
+	unsigned long long GetWrittenSampleCount() const;
+	unsigned long long GetWrittenSampleChecksum() const;
+
+private:
+	//Constants
+	static const unsigned long long fnvOffsetBasis = 14695981039346656037ULL;
+	static const unsigned long long fnvPrime = 1099511628211ULL;
+
+private:
+	unsigned int channelCount;
+	unsigned long long writtenSampleCount;
+	unsigned long long writtenSampleChecksum;
+};
+
+#endif
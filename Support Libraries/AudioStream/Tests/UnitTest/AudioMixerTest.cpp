@@ -0,0 +1,120 @@
+#include "catch.hpp"
+#include "AudioMixer.h"
+#include "AudioMixerSource.h"
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+//----------------------------------------------------------------------------------------
+//Test helpers
+//----------------------------------------------------------------------------------------
+//Runs a mixer against a simulated producer and consumer, to confirm that the rate control
+//holds the buffered data for a source near the target latency when the emulated and host
+//sample clocks differ. The producer submits a video frame of samples at a time at its
+//nominal rate scaled by the given clock drift, while the consumer pulls blocks of mixed
+//data at the nominal output rate, as the system output thread does. After the rate
+//control has had time to settle, the average error in the fill level is measured as a
+//fraction of the target, along with any underruns or overruns which occurred.
+//----------------------------------------------------------------------------------------
+static void SimulateRateControl(double clockDrift, double& fillLevelError, unsigned int& underrunCount, unsigned int& overrunCount)
+{
+	const unsigned int samplesPerSec = 48000;
+	const unsigned int producerFramesPerSec = 60;
+	const unsigned int consumerBlocksPerSec = 100;
+	const unsigned int settleTimeInSeconds = 50;
+	const unsigned int measureTimeInSeconds = 10;
+	const unsigned int consumerBlockSampleCount = samplesPerSec / consumerBlocksPerSec;
+
+	AudioMixer mixer(2, samplesPerSec, 0);
+	AudioMixerSource* source = mixer.CreateSource();
+	source->Open(1, 16, samplesPerSec);
+	double targetFillLevel = (double)mixer.GetTargetLatencySamples();
+
+	//Step through the simulated time, handling producer and consumer events in the order
+	//they fall due.
+	std::vector<short> producerData;
+	std::vector<short> mixedData;
+	double producerSampleFraction = 0;
+	unsigned long long producerFrameNo = 0;
+	unsigned long long consumerBlockNo = 0;
+	unsigned long long consumerBlockCount = (unsigned long long)consumerBlocksPerSec * (settleTimeInSeconds + measureTimeInSeconds);
+	unsigned long long settleBlockCount = (unsigned long long)consumerBlocksPerSec * settleTimeInSeconds;
+	unsigned int settledUnderrunCount = 0;
+	unsigned int settledOverrunCount = 0;
+	double fillLevelTotal = 0;
+	unsigned int fillLevelSampleCount = 0;
+	while(consumerBlockNo < consumerBlockCount)
+	{
+		double producerTime = (double)producerFrameNo / (double)producerFramesPerSec;
+		double consumerTime = (double)consumerBlockNo / (double)consumerBlocksPerSec;
+		if(producerTime <= consumerTime)
+		{
+			//Generate a frame of a sawtooth wave from the producer
+			double producerSampleCountExact = (((double)samplesPerSec * (1.0 + clockDrift)) / (double)producerFramesPerSec) + producerSampleFraction;
+			unsigned int producerSampleCount = (unsigned int)producerSampleCountExact;
+			producerSampleFraction = producerSampleCountExact - (double)producerSampleCount;
+			producerData.resize(producerSampleCount);
+			for(unsigned int i = 0; i < producerSampleCount; ++i)
+			{
+				producerData[i] = (short)(((i * 64) & 0x3FFF) - 0x2000);
+			}
+			if(producerSampleCount > 0)
+			{
+				source->WriteSamples(&producerData[0], producerSampleCount);
+			}
+			++producerFrameNo;
+		}
+		else
+		{
+			//Pull a block of mixed data from the consumer, and record the fill level once
+			//the rate control has settled.
+			mixer.MixSamples(mixedData, consumerBlockSampleCount);
+			++consumerBlockNo;
+			if(consumerBlockNo == settleBlockCount)
+			{
+				settledUnderrunCount = source->GetUnderrunCount();
+				settledOverrunCount = source->GetOverrunCount();
+			}
+			else if(consumerBlockNo > settleBlockCount)
+			{
+				fillLevelTotal += (double)source->GetBufferedSampleCount();
+				++fillLevelSampleCount;
+			}
+		}
+	}
+
+	//Calculate the results
+	double averageFillLevel = (fillLevelSampleCount > 0)? (fillLevelTotal / (double)fillLevelSampleCount): 0;
+	fillLevelError = (averageFillLevel - targetFillLevel) / targetFillLevel;
+	underrunCount = source->GetUnderrunCount() - settledUnderrunCount;
+	overrunCount = source->GetOverrunCount() - settledOverrunCount;
+	mixer.DeleteSource(source);
+}
+
+//----------------------------------------------------------------------------------------
+//Mixer tests
+//----------------------------------------------------------------------------------------
+TEST_CASE("AudioMixer::MixSamples", "")
+{
+	SECTION("Rate control absorbs clock drift")
+	{
+		//The fill level must settle within a quarter of the target, with no underruns or
+		//overruns, with the producer clock matching the consumer, and with it running
+		//fast and slow. Note that clock drift beyond the maximum rate adjustment can't be
+		//absorbed, so we keep the drift here well within it.
+		const double clockDriftValues[] = {0.0, 0.003, -0.003};
+		for(unsigned int i = 0; i < (sizeof(clockDriftValues) / sizeof(clockDriftValues[0])); ++i)
+		{
+			double fillLevelError;
+			unsigned int underrunCount;
+			unsigned int overrunCount;
+			SimulateRateControl(clockDriftValues[i], fillLevelError, underrunCount, overrunCount);
+			std::stringstream message;
+			message << (clockDriftValues[i] * 100.0) << "% clock drift. Fill level error: " << (fillLevelError * 100.0) << "%, underruns: " << underrunCount << ", overruns: " << overrunCount;
+			INFO(message.str());
+			REQUIRE(std::fabs(fillLevelError) < 0.25);
+			REQUIRE(underrunCount == 0);
+			REQUIRE(overrunCount == 0);
+		}
+	}
+}
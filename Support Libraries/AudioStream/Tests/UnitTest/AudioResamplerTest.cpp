@@ -0,0 +1,164 @@
+#include "catch.hpp"
+#include "AudioResampler.h"
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+//----------------------------------------------------------------------------------------
+//Test helpers
+//----------------------------------------------------------------------------------------
+//The source sample rate used in these tests is close to the FM output rate of the YM2612
+//in an NTSC system, and the target sample rate is a typical sound card output rate.
+//Source samples are passed to the resampler in blocks of 1/60 of a second, in the same way
+//as the devices which use it. The source rate is rounded to a multiple of the block count,
+//so that every block has the same conversion ratio, and the measurements reflect the
+//response of the filter alone. When the number of source samples varies between blocks,
+//each block is stretched by a slightly different amount, which adds phase jitter to the
+//output on top of the response measured here.
+//----------------------------------------------------------------------------------------
+static const double pi = 3.14159265358979323846;
+static const unsigned int sourceSampleRate = 53280;
+static const unsigned int targetSampleRate = 48000;
+static const unsigned int blockCount = 60;
+static const double toneAmplitude = 16384.0;
+
+//----------------------------------------------------------------------------------------
+static std::vector<short> ResampleTone(AudioResampler::Quality quality, double toneFrequency)
+{
+	AudioResampler resampler;
+	resampler.SetQuality(quality);
+	std::vector<short> sourceData;
+	std::vector<short> targetData;
+	std::vector<short> outputData;
+	unsigned int sourceSampleNo = 0;
+	unsigned int sourceSampleRemainder = 0;
+	unsigned int targetSampleRemainder = 0;
+	for(unsigned int blockNo = 0; blockNo < blockCount; ++blockNo)
+	{
+		//Calculate the number of samples in this block, carrying the remainders forward so
+		//that the total number of samples is exact.
+		unsigned int sourceSampleCount = (sourceSampleRate + sourceSampleRemainder) / blockCount;
+		sourceSampleRemainder = (sourceSampleRate + sourceSampleRemainder) % blockCount;
+		unsigned int targetSampleCount = (targetSampleRate + targetSampleRemainder) / blockCount;
+		targetSampleRemainder = (targetSampleRate + targetSampleRemainder) % blockCount;
+
+		sourceData.resize(sourceSampleCount);
+		for(unsigned int i = 0; i < sourceSampleCount; ++i)
+		{
+			sourceData[i] = (short)std::floor((toneAmplitude * std::sin((2.0 * pi * toneFrequency * (double)sourceSampleNo++) / (double)sourceSampleRate)) + 0.5);
+		}
+		targetData.resize(targetSampleCount);
+		resampler.Resample(&sourceData[0], sourceSampleCount, 1, &targetData[0], targetSampleCount);
+		outputData.insert(outputData.end(), targetData.begin(), targetData.end());
+	}
+	return outputData;
+}
+
+//----------------------------------------------------------------------------------------
+//Measures the amplitude of the component of the output data at the specified frequency.
+//We skip the first part of the output, which contains the delay through the filter, and
+//apply a Hann window to the remainder, so that leakage from the other components in the
+//signal doesn't affect the measurement.
+//----------------------------------------------------------------------------------------
+static double MeasureAmplitude(const std::vector<short>& outputData, double frequency)
+{
+	unsigned int startSampleNo = (unsigned int)outputData.size() / 8;
+	unsigned int sampleCount = (unsigned int)outputData.size() - startSampleNo;
+	double sumSin = 0.0;
+	double sumCos = 0.0;
+	double sumWindow = 0.0;
+	for(unsigned int i = 0; i < sampleCount; ++i)
+	{
+		double window = 0.5 - (0.5 * std::cos((2.0 * pi * (double)i) / (double)(sampleCount - 1)));
+		double sample = (double)outputData[startSampleNo + i] * window;
+		double angle = (2.0 * pi * frequency * (double)(startSampleNo + i)) / (double)targetSampleRate;
+		sumSin += sample * std::sin(angle);
+		sumCos += sample * std::cos(angle);
+		sumWindow += window;
+	}
+	return (2.0 * std::sqrt((sumSin * sumSin) + (sumCos * sumCos))) / sumWindow;
+}
+
+//----------------------------------------------------------------------------------------
+//Quality settings
+//----------------------------------------------------------------------------------------
+//The passband edge for each quality setting is the passband scale from
+//AudioResampler::GetQualitySettings, applied to the nyquist frequency of the target. The
+//limits on ripple and aliasing are set with some margin over the response of each
+//filter, so that they only fail if the filter design is broken.
+//----------------------------------------------------------------------------------------
+struct QualityTestSettings
+{
+	AudioResampler::Quality quality;
+	const char* name;
+	double passbandEdge;
+	double maxPassbandRippleDB;
+	double minAliasRejectionDB;
+};
+
+static const QualityTestSettings qualityTestSettings[] = {
+	{AudioResampler::Quality::Low, "Low", 0.70 * (targetSampleRate / 2.0), 0.5, 30.0},
+	{AudioResampler::Quality::Medium, "Medium", 0.80 * (targetSampleRate / 2.0), 0.2, 36.0},
+	{AudioResampler::Quality::High, "High", 0.86 * (targetSampleRate / 2.0), 0.1, 50.0}};
+
+//----------------------------------------------------------------------------------------
+//Resampler tests
+//----------------------------------------------------------------------------------------
+TEST_CASE("AudioResampler::Resample", "")
+{
+	SECTION("Passband ripple")
+	{
+		//Tones within the passband should pass through at the same level
+		for(unsigned int qualityNo = 0; qualityNo < sizeof(qualityTestSettings) / sizeof(qualityTestSettings[0]); ++qualityNo)
+		{
+			const QualityTestSettings& settings = qualityTestSettings[qualityNo];
+			double maxRippleDB = 0.0;
+			double maxRippleFrequency = 0.0;
+			for(unsigned int stepNo = 1; stepNo <= 16; ++stepNo)
+			{
+				double toneFrequency = (settings.passbandEdge * (double)stepNo) / 16.0;
+				double amplitude = MeasureAmplitude(ResampleTone(settings.quality, toneFrequency), toneFrequency);
+				double rippleDB = std::fabs(20.0 * std::log10(amplitude / toneAmplitude));
+				if(rippleDB > maxRippleDB)
+				{
+					maxRippleDB = rippleDB;
+					maxRippleFrequency = toneFrequency;
+				}
+			}
+			std::stringstream message;
+			message << settings.name << " quality: " << maxRippleDB << "dB ripple at " << maxRippleFrequency << "Hz";
+			INFO(message.str());
+			REQUIRE(maxRippleDB <= settings.maxPassbandRippleDB);
+		}
+	}
+
+	SECTION("Alias rejection")
+	{
+		//Tones above the nyquist frequency of the target should be removed before they
+		//can alias back into the output below the nyquist frequency
+		for(unsigned int qualityNo = 0; qualityNo < sizeof(qualityTestSettings) / sizeof(qualityTestSettings[0]); ++qualityNo)
+		{
+			const QualityTestSettings& settings = qualityTestSettings[qualityNo];
+			double minRejectionDB = 1000.0;
+			double minRejectionFrequency = 0.0;
+			double sourceNyquistFrequency = sourceSampleRate / 2.0;
+			double targetNyquistFrequency = targetSampleRate / 2.0;
+			for(unsigned int stepNo = 1; stepNo <= 8; ++stepNo)
+			{
+				double toneFrequency = targetNyquistFrequency + (((sourceNyquistFrequency - targetNyquistFrequency) * (double)stepNo) / 9.0);
+				double aliasFrequency = (double)targetSampleRate - toneFrequency;
+				double amplitude = MeasureAmplitude(ResampleTone(settings.quality, toneFrequency), aliasFrequency);
+				double rejectionDB = -20.0 * std::log10((amplitude + 1e-9) / toneAmplitude);
+				if(rejectionDB < minRejectionDB)
+				{
+					minRejectionDB = rejectionDB;
+					minRejectionFrequency = toneFrequency;
+				}
+			}
+			std::stringstream message;
+			message << settings.name << " quality: " << minRejectionDB << "dB alias rejection at " << minRejectionFrequency << "Hz";
+			INFO(message.str());
+			REQUIRE(minRejectionDB >= settings.minAliasRejectionDB);
+		}
+	}
+}
@@ -0,0 +1,171 @@
+#include "catch.hpp"
+#include "NullAudioSink.h"
+#include "WAVFileAudioSink.h"
+#include "Stream/Stream.pkg"
+#include "WindowsSupport/WindowsSupport.pkg"
+#include <algorithm>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------
+//Test helpers
+//----------------------------------------------------------------------------------------
+//The sample data used in these tests is a pseudo-random stereo stream. Each stream is
+//written to a sink in blocks, and the block sizes are varied between runs, to confirm
+//that the output of each sink depends only on the sample data, and not on how it was
+//supplied.
+//----------------------------------------------------------------------------------------
+static const unsigned int testChannelCount = 2;
+static const unsigned int testBitsPerSample = 16;
+static const unsigned int testSampleRate = 48000;
+static const unsigned int testSampleCount = testSampleRate * 2;
+
+//----------------------------------------------------------------------------------------
+static std::vector<short> BuildTestSamples(unsigned int seed)
+{
+	std::vector<short> sampleData(testSampleCount * testChannelCount);
+	unsigned int state = seed;
+	for(unsigned int i = 0; i < (unsigned int)sampleData.size(); ++i)
+	{
+		state = (state * 1664525) + 1013904223;
+		sampleData[i] = (short)(state >> 16);
+	}
+	return sampleData;
+}
+
+//----------------------------------------------------------------------------------------
+static void WriteTestSamples(IAudioSink& sink, const std::vector<short>& sampleData, unsigned int blockSizeSeed, bool yieldBetweenBlocks)
+{
+	//Write the sample data in blocks of varying size. A seed of 0 writes the whole stream
+	//in a single block.
+	unsigned int sampleNo = 0;
+	unsigned int state = blockSizeSeed;
+	while(sampleNo < testSampleCount)
+	{
+		unsigned int blockSampleCount = testSampleCount - sampleNo;
+		if(blockSizeSeed != 0)
+		{
+			state = (state * 1664525) + 1013904223;
+			unsigned int randomBlockSampleCount = 1 + ((state >> 16) % 2000);
+			blockSampleCount = (randomBlockSampleCount < blockSampleCount)? randomBlockSampleCount: blockSampleCount;
+		}
+		sink.WriteSamples(&sampleData[sampleNo * testChannelCount], blockSampleCount);
+		sampleNo += blockSampleCount;
+		if(yieldBetweenBlocks)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------
+static std::vector<unsigned char> WriteWAVFile(const std::wstring& filePath, const std::vector<short>& sampleData, unsigned int blockSizeSeed, bool yieldBetweenBlocks)
+{
+	//Write the sample data to the target file through a sink
+	WAVFileAudioSink sink(filePath);
+	if(!sink.Open(testChannelCount, testBitsPerSample, testSampleRate))
+	{
+		return std::vector<unsigned char>();
+	}
+	WriteTestSamples(sink, sampleData, blockSizeSeed, yieldBetweenBlocks);
+	sink.Close();
+
+	//Read back the raw contents of the file, then remove it
+	std::vector<unsigned char> fileData;
+	Stream::File file;
+	if(file.Open(filePath, Stream::File::OpenMode::ReadOnly, Stream::File::CreateMode::Open))
+	{
+		fileData.resize((size_t)file.Size());
+		if(!fileData.empty() && !file.ReadData(&fileData[0], (Stream::File::SizeType)fileData.size()))
+		{
+			fileData.clear();
+		}
+		file.Close();
+	}
+	DeleteFile(filePath.c_str());
+	return fileData;
+}
+
+//----------------------------------------------------------------------------------------
+//Null sink tests
+//----------------------------------------------------------------------------------------
+TEST_CASE("NullAudioSink::WriteSamples", "")
+{
+	std::vector<short> sampleData = BuildTestSamples(1);
+
+	SECTION("Block size doesn't affect output")
+	{
+		NullAudioSink sinkSingleBlock;
+		sinkSingleBlock.Open(testChannelCount, testBitsPerSample, testSampleRate);
+		WriteTestSamples(sinkSingleBlock, sampleData, 0, false);
+		for(unsigned int blockSizeSeed = 1; blockSizeSeed <= 4; ++blockSizeSeed)
+		{
+			NullAudioSink sink;
+			sink.Open(testChannelCount, testBitsPerSample, testSampleRate);
+			WriteTestSamples(sink, sampleData, blockSizeSeed, false);
+			REQUIRE(sink.GetWrittenSampleCount() == testSampleCount);
+			REQUIRE(sink.GetWrittenSampleChecksum() == sinkSingleBlock.GetWrittenSampleChecksum());
+		}
+	}
+
+	SECTION("Changed sample data changes checksum")
+	{
+		NullAudioSink sink;
+		sink.Open(testChannelCount, testBitsPerSample, testSampleRate);
+		WriteTestSamples(sink, sampleData, 0, false);
+		sampleData[sampleData.size() / 2] ^= 1;
+		NullAudioSink sinkChanged;
+		sinkChanged.Open(testChannelCount, testBitsPerSample, testSampleRate);
+		WriteTestSamples(sinkChanged, sampleData, 0, false);
+		REQUIRE(sinkChanged.GetWrittenSampleCount() == sink.GetWrittenSampleCount());
+		REQUIRE(sinkChanged.GetWrittenSampleChecksum() != sink.GetWrittenSampleChecksum());
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//WAV file sink tests
+//----------------------------------------------------------------------------------------
+TEST_CASE("WAVFileAudioSink::WriteSamples", "")
+{
+	std::vector<short> sampleData = BuildTestSamples(2);
+
+	SECTION("Output is byte-identical across runs")
+	{
+		//Write the same stream several times, both in a single block and in blocks of
+		//varying size. Yielding between blocks lets the writer thread run at different
+		//points in the stream on each run. Every run must produce exactly the same file.
+		std::vector<unsigned char> referenceData = WriteWAVFile(L"WAVFileAudioSinkTest.wav", sampleData, 0, false);
+		REQUIRE(referenceData.size() > (sampleData.size() * sizeof(short)));
+		for(unsigned int blockSizeSeed = 1; blockSizeSeed <= 4; ++blockSizeSeed)
+		{
+			std::vector<unsigned char> fileData = WriteWAVFile(L"WAVFileAudioSinkTest.wav", sampleData, blockSizeSeed, (blockSizeSeed % 2) == 0);
+			REQUIRE(fileData.size() == referenceData.size());
+			unsigned int mismatchCount = 0;
+			std::stringstream firstMismatch;
+			for(unsigned int i = 0; i < (unsigned int)fileData.size(); ++i)
+			{
+				if(fileData[i] != referenceData[i])
+				{
+					if(mismatchCount == 0)
+					{
+						firstMismatch << "Run " << blockSizeSeed << ", byte " << i << ": " << (unsigned int)fileData[i] << " != " << (unsigned int)referenceData[i];
+					}
+					++mismatchCount;
+				}
+			}
+			INFO(firstMismatch.str());
+			REQUIRE(mismatchCount == 0);
+		}
+	}
+
+	SECTION("Output contains every sample")
+	{
+		//The sample data must appear unchanged at the end of the file, after the header
+		std::vector<unsigned char> fileData = WriteWAVFile(L"WAVFileAudioSinkTest.wav", sampleData, 3, true);
+		size_t sampleDataSize = sampleData.size() * sizeof(short);
+		REQUIRE(fileData.size() >= sampleDataSize);
+		const unsigned char* sampleDataBytes = (const unsigned char*)&sampleData[0];
+		REQUIRE(std::equal(sampleDataBytes, sampleDataBytes + sampleDataSize, fileData.end() - sampleDataSize));
+	}
+}
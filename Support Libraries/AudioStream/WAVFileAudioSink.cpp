@@ -0,0 +1,108 @@
+#include "WAVFileAudioSink.h"
+#include <functional>
+
+//----------------------------------------------------------------------------------------
+//Constructors
+//----------------------------------------------------------------------------------------
+WAVFileAudioSink::WAVFileAudioSink(const std::wstring& afilePath)
+:filePath(afilePath), fileChannelCount(1), writerThreadActive(false)
+{}
+
+//----------------------------------------------------------------------------------------
+WAVFileAudioSink::~WAVFileAudioSink()
+{
+	Close();
+}
+
+//----------------------------------------------------------------------------------------
+//Sink binding
+//----------------------------------------------------------------------------------------
+bool WAVFileAudioSink::Open(unsigned int channelCount, unsigned int bitsPerSample, unsigned int samplesPerSec)
+{
+	//If the sink is already open, close it, so that the previous file is finalized.
+	Close();
+
+	//Create the target file
+	fileChannelCount = (channelCount > 0)? channelCount: 1;
+	wavFile.SetDataFormat(channelCount, bitsPerSample, samplesPerSec);
+	if(!wavFile.Open(filePath, Stream::WAVFile::OpenMode::WriteOnly, Stream::WAVFile::CreateMode::Create))
+	{
+		return false;
+	}
+
+	//Start the writer thread
+	writerThreadActive = true;
+	writerThread = std::thread(std::bind(std::mem_fn(&WAVFileAudioSink::WriterThread), this));
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+void WAVFileAudioSink::Close()
+{
+	//If the writer thread is running, instruct it to stop, and wait for it to finish
+	//writing any buffers which are still queued. Every buffer handed to this sink is
+	//written before the file is closed, so the file contents depend only on the sample
+	//data, and never on how quickly it was supplied.
+	if(writerThread.joinable())
+	{
+		std::unique_lock<std::mutex> lock(writerThreadMutex);
+		writerThreadActive = false;
+		writerThreadUpdate.notify_all();
+		lock.unlock();
+		writerThread.join();
+	}
+
+	//Finalize the file header and close the file
+	if(wavFile.IsOpen())
+	{
+		wavFile.Close();
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Sample output functions
+//----------------------------------------------------------------------------------------
+void WAVFileAudioSink::WriteSamples(const short* sampleData, unsigned int sampleCount)
+{
+	//Take a copy of the supplied sample data and queue it for the writer thread, so the
+	//caller never waits on the file.
+	std::unique_lock<std::mutex> lock(writerThreadMutex);
+	if(!writerThreadActive)
+	{
+		return;
+	}
+	pendingBuffers.push_back(std::vector<short>(sampleData, sampleData + (sampleCount * fileChannelCount)));
+	writerThreadUpdate.notify_all();
+}
+
+//----------------------------------------------------------------------------------------
+//Writer thread functions
+//----------------------------------------------------------------------------------------
+void WAVFileAudioSink::WriterThread()
+{
+	std::unique_lock<std::mutex> lock(writerThreadMutex);
+	std::list<std::vector<short>> buffersToWrite;
+	while(writerThreadActive || !pendingBuffers.empty())
+	{
+		//Wait for more sample data to arrive, or for the sink to be closed
+		if(pendingBuffers.empty())
+		{
+			writerThreadUpdate.wait(lock);
+			continue;
+		}
+
+		//Take all the currently queued buffers, and write them out in the order they
+		//were received without holding the lock.
+		buffersToWrite.splice(buffersToWrite.end(), pendingBuffers);
+		lock.unlock();
+		for(std::list<std::vector<short>>::const_iterator i = buffersToWrite.begin(); i != buffersToWrite.end(); ++i)
+		{
+			if(!i->empty())
+			{
+				wavFile.WriteData(&(*i)[0], i->size());
+			}
+		}
+		buffersToWrite.clear();
+		lock.lock();
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef __WAVFILEAUDIOSINK_H__
+#define __WAVFILEAUDIOSINK_H__
+#include "IAudioSink.h"
+#include "Stream/Stream.pkg"
+#include <string>
+#include <list>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class WAVFileAudioSink :public IAudioSink
+{
+public:
+	//Constructors
+	WAVFileAudioSink(const std::wstring& afilePath);
+	virtual ~WAVFileAudioSink();
+
+	//Sink binding
+	virtual bool Open(unsigned int channelCount, unsigned int bitsPerSample, unsigned int samplesPerSec);
+	virtual void Close();
+
+	//Sample output functions
+	virtual void WriteSamples(const short* sampleData, unsigned int sampleCount);
+
+private:
+	//Writer thread functions
+	void WriterThread();
+
+private:
+	//File settings
+	std::wstring filePath;
+	Stream::WAVFile wavFile;
+	unsigned int fileChannelCount;
+
+	//Writer thread properties
+	std::mutex writerThreadMutex;
+	std::condition_variable writerThreadUpdate;
+	std::thread writerThread;
+	bool writerThreadActive;
+	std::list<std::vector<short>> pendingBuffers;
+};
+
+#endif
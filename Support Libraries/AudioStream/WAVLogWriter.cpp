@@ -0,0 +1,227 @@
+#include "WAVLogWriter.h"
+#include <functional>
+
+//----------------------------------------------------------------------------------------
+//Constructors
+//----------------------------------------------------------------------------------------
+WAVLogWriter::WAVLogWriter(unsigned int alogCount)
+:logCount(alogCount), writerThreadActive(false), writerThreadWaiting(false)
+{
+	//Note that the writer thread isn't started until a log is first opened, since most
+	//devices which own a log writer never have logging enabled.
+	logs = new LogEntry[logCount];
+}
+
+//----------------------------------------------------------------------------------------
+WAVLogWriter::~WAVLogWriter()
+{
+	//Stop the writer thread if it was started
+	std::unique_lock<std::mutex> lock(writerThreadMutex);
+	writerThreadActive = false;
+	writerThreadUpdate.notify_all();
+	lock.unlock();
+	if(writerThread.joinable())
+	{
+		writerThread.join();
+	}
+
+	//Write out any remaining data, and close all open log files
+	for(unsigned int logNo = 0; logNo < logCount; ++logNo)
+	{
+		CloseLog(logNo);
+	}
+	delete[] logs;
+}
+
+//----------------------------------------------------------------------------------------
+//Log binding
+//----------------------------------------------------------------------------------------
+bool WAVLogWriter::OpenLog(unsigned int logNo, const std::wstring& fileName, unsigned int channelCount, unsigned int bitsPerSample, unsigned int samplesPerSec)
+{
+	if(logNo >= logCount)
+	{
+		return false;
+	}
+
+	//Close the log if it's currently open, and open the new target file. We request a
+	//large file buffer, so that the writer thread passes data to the file system in large
+	//blocks.
+	CloseLog(logNo);
+	LogEntry& entry = logs[logNo];
+	std::unique_lock<std::mutex> lock(entry.fileMutex);
+	entry.wavFile.SetDataFormat(channelCount, bitsPerSample, samplesPerSec);
+	if(!entry.wavFile.Open(fileName, Stream::WAVFile::OpenMode::WriteOnly, Stream::WAVFile::CreateMode::Create, fileBufferSize))
+	{
+		return false;
+	}
+	entry.blockQueueHead = 0;
+	entry.blockQueueTail = 0;
+	entry.logOpen = true;
+	lock.unlock();
+
+	//Start the writer thread if this is the first log we've opened
+	std::unique_lock<std::mutex> writerThreadLock(writerThreadMutex);
+	if(!writerThread.joinable())
+	{
+		writerThreadActive = true;
+		writerThread = std::thread(std::bind(std::mem_fn(&WAVLogWriter::WriterThread), this));
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+void WAVLogWriter::CloseLog(unsigned int logNo)
+{
+	if(logNo >= logCount)
+	{
+		return;
+	}
+
+	//Write any data still waiting in the queue for this log, then close the file. Note
+	//that we hold the file lock for the log while doing this, so the writer thread can't
+	//be working on this log at the same time.
+	LogEntry& entry = logs[logNo];
+	std::unique_lock<std::mutex> lock(entry.fileMutex);
+	if(!entry.logOpen)
+	{
+		return;
+	}
+	entry.logOpen = false;
+	WritePendingBlocks(entry);
+	entry.wavFile.Close();
+}
+
+//----------------------------------------------------------------------------------------
+//Sample output functions
+//----------------------------------------------------------------------------------------
+//Queues a block of sample data for the target log. The contents of the supplied buffer
+//are taken by this function, and the buffer is left empty. Calls to this function for
+//any one log must only be made from a single thread at a time, and must not overlap with
+//calls to open or close that log.
+//----------------------------------------------------------------------------------------
+void WAVLogWriter::WriteSamples(unsigned int logNo, std::vector<short>& sampleData)
+{
+	if(QueueSamples(logNo, sampleData))
+	{
+		NotifyWriterThread();
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Queues a block of sample data for every log at once. The sampleDataForEachLog argument
+//points to an array of logCount buffers, indexed by log number. Each buffer is handled in
+//the same way as a call to WriteSamples for that log, but the writer thread is only woken
+//once for the whole batch.
+//----------------------------------------------------------------------------------------
+void WAVLogWriter::WriteSamples(std::vector<short>* sampleDataForEachLog)
+{
+	bool samplesQueued = false;
+	for(unsigned int logNo = 0; logNo < logCount; ++logNo)
+	{
+		samplesQueued |= QueueSamples(logNo, sampleDataForEachLog[logNo]);
+	}
+	if(samplesQueued)
+	{
+		NotifyWriterThread();
+	}
+}
+
+//----------------------------------------------------------------------------------------
+bool WAVLogWriter::QueueSamples(unsigned int logNo, std::vector<short>& sampleData)
+{
+	if((logNo >= logCount) || !logs[logNo].logOpen || sampleData.empty())
+	{
+		sampleData.clear();
+		return false;
+	}
+
+	//If the queue for this log is full, the writer thread has fallen well behind. In this
+	//case we wait for it to free a slot, rather than lose data.
+	LogEntry& entry = logs[logNo];
+	unsigned int head = entry.blockQueueHead.load(std::memory_order_relaxed);
+	while((head - entry.blockQueueTail.load(std::memory_order_acquire)) >= blockQueueSize)
+	{
+		std::this_thread::yield();
+	}
+
+	//Move the sample data into the queue, and publish it to the writer thread. We reuse
+	//the storage from the block previously held in this slot for the caller's next
+	//block, to avoid allocating new memory on each call.
+	std::vector<short>& block = entry.blockQueue[head % blockQueueSize];
+	block.swap(sampleData);
+	sampleData.clear();
+	entry.blockQueueHead.store(head + 1, std::memory_order_seq_cst);
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+void WAVLogWriter::NotifyWriterThread()
+{
+	//If the writer thread is waiting for data, wake it. The writer thread flags that it's
+	//waiting before it checks for data, so either it sees the blocks we've just added, or
+	//we see that it's waiting.
+	if(writerThreadWaiting.load(std::memory_order_seq_cst))
+	{
+		std::unique_lock<std::mutex> lock(writerThreadMutex);
+		writerThreadUpdate.notify_all();
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Writer thread functions
+//----------------------------------------------------------------------------------------
+void WAVLogWriter::WriterThread()
+{
+	std::unique_lock<std::mutex> lock(writerThreadMutex);
+	while(writerThreadActive)
+	{
+		//Wait until there's data to write
+		writerThreadWaiting.store(true, std::memory_order_seq_cst);
+		if(!LogDataPending())
+		{
+			writerThreadUpdate.wait(lock);
+		}
+		writerThreadWaiting = false;
+		lock.unlock();
+
+		//Write out all the queued data for each log
+		for(unsigned int logNo = 0; logNo < logCount; ++logNo)
+		{
+			LogEntry& entry = logs[logNo];
+			std::unique_lock<std::mutex> fileLock(entry.fileMutex);
+			if(entry.logOpen)
+			{
+				WritePendingBlocks(entry);
+			}
+		}
+		lock.lock();
+	}
+}
+
+//----------------------------------------------------------------------------------------
+bool WAVLogWriter::LogDataPending() const
+{
+	for(unsigned int logNo = 0; logNo < logCount; ++logNo)
+	{
+		const LogEntry& entry = logs[logNo];
+		if(entry.blockQueueHead.load(std::memory_order_seq_cst) != entry.blockQueueTail.load(std::memory_order_relaxed))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//----------------------------------------------------------------------------------------
+void WAVLogWriter::WritePendingBlocks(LogEntry& entry)
+{
+	unsigned int tail = entry.blockQueueTail.load(std::memory_order_relaxed);
+	unsigned int head = entry.blockQueueHead.load(std::memory_order_acquire);
+	while(tail != head)
+	{
+		const std::vector<short>& block = entry.blockQueue[tail % blockQueueSize];
+		entry.wavFile.WriteData(&block[0], block.size());
+		++tail;
+		entry.blockQueueTail.store(tail, std::memory_order_release);
+	}
+}
@@ -0,0 +1,63 @@
+#ifndef __WAVLOGWRITER_H__
+#define __WAVLOGWRITER_H__
+#include "Stream/Stream.pkg"
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class WAVLogWriter
+{
+public:
+	//Constructors
+	WAVLogWriter(unsigned int alogCount);
+	~WAVLogWriter();
+
+	//Log binding
+	bool OpenLog(unsigned int logNo, const std::wstring& fileName, unsigned int channelCount, unsigned int bitsPerSample, unsigned int samplesPerSec);
+	void CloseLog(unsigned int logNo);
+	inline bool IsLogOpen(unsigned int logNo) const;
+
+	//Sample output functions
+	void WriteSamples(unsigned int logNo, std::vector<short>& sampleData);
+	void WriteSamples(std::vector<short>* sampleDataForEachLog);
+
+private:
+	//Structures
+	struct LogEntry;
+
+private:
+	//Make sure the WAVLogWriter object is non-copyable
+	WAVLogWriter(const WAVLogWriter& object);
+	WAVLogWriter& operator=(const WAVLogWriter& object);
+
+	//Sample output functions
+	bool QueueSamples(unsigned int logNo, std::vector<short>& sampleData);
+	void NotifyWriterThread();
+
+	//Writer thread functions
+	void WriterThread();
+	bool LogDataPending() const;
+	static void WritePendingBlocks(LogEntry& entry);
+
+private:
+	//Constants
+	static const unsigned int blockQueueSize = 32;
+	static const unsigned int fileBufferSize = 1024 * 1024;
+
+	//Log data
+	unsigned int logCount;
+	LogEntry* logs;
+
+	//Writer thread properties
+	std::mutex writerThreadMutex;
+	std::condition_variable writerThreadUpdate;
+	std::thread writerThread;
+	bool writerThreadActive;
+	std::atomic<bool> writerThreadWaiting;
+};
+
+#include "WAVLogWriter.inl"
+#endif
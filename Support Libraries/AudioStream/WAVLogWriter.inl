@@ -0,0 +1,28 @@
+//----------------------------------------------------------------------------------------
+//Structures
+//----------------------------------------------------------------------------------------
+//Each log holds a fixed queue of sample blocks. Blocks are added at the head by the
+//single thread which supplies sample data, and removed from the tail by whichever thread
+//holds the file lock for the log, so neither side needs to lock the queue itself.
+//----------------------------------------------------------------------------------------
+struct WAVLogWriter::LogEntry
+{
+	LogEntry()
+	:logOpen(false), blockQueue(blockQueueSize), blockQueueHead(0), blockQueueTail(0)
+	{}
+
+	std::atomic<bool> logOpen;
+	std::mutex fileMutex;
+	Stream::WAVFile wavFile;
+	std::vector<std::vector<short>> blockQueue;
+	std::atomic<unsigned int> blockQueueHead;
+	std::atomic<unsigned int> blockQueueTail;
+};
+
+//----------------------------------------------------------------------------------------
+//Log binding
+//----------------------------------------------------------------------------------------
+bool WAVLogWriter::IsLogOpen(unsigned int logNo) const
+{
+	return (logNo < logCount) && logs[logNo].logOpen;
+}
@@ -0,0 +1,71 @@
+#include "HierarchicalStorageArena.h"
+
+//----------------------------------------------------------------------------------------
+//Constructors
+//----------------------------------------------------------------------------------------
+HierarchicalStorageArena::HierarchicalStorageArena()
+:currentChunkPos(0), currentChunkRemaining(0)
+{}
+
+//----------------------------------------------------------------------------------------
+HierarchicalStorageArena::~HierarchicalStorageArena()
+{
+	Reset();
+}
+
+//----------------------------------------------------------------------------------------
+void HierarchicalStorageArena::Reset()
+{
+	for(std::vector<unsigned char*>::iterator i = chunks.begin(); i != chunks.end(); ++i)
+	{
+		delete[] *i;
+	}
+	chunks.clear();
+	currentChunkPos = 0;
+	currentChunkRemaining = 0;
+	names.clear();
+}
+
+//----------------------------------------------------------------------------------------
+//Allocation functions
+//----------------------------------------------------------------------------------------
+void* HierarchicalStorageArena::Allocate(size_t size)
+{
+	//Round the allocation size up so that each allocation begins on an aligned boundary
+	size = (size + (allocationAlignment - 1)) & ~(allocationAlignment - 1);
+
+	//If there isn't enough space left in the current chunk, start a new chunk. Any space
+	//remaining in the previous chunk is left unused. Allocations which are larger than
+	//our normal chunk size are given a chunk of their own.
+	if(size > currentChunkRemaining)
+	{
+		size_t newChunkSize = (size > chunkSize)? size: chunkSize;
+		unsigned char* newChunk = new unsigned char[newChunkSize];
+		chunks.push_back(newChunk);
+		currentChunkPos = newChunk;
+		currentChunkRemaining = newChunkSize;
+	}
+
+	//Allocate the memory from the current chunk
+	void* allocation = currentChunkPos;
+	currentChunkPos += size;
+	currentChunkRemaining -= size;
+	return allocation;
+}
+
+//----------------------------------------------------------------------------------------
+//Name functions
+//----------------------------------------------------------------------------------------
+const std::wstring* HierarchicalStorageArena::InternName(const std::wstring& name)
+{
+	//Note that elements in an unordered set are never moved once inserted, so the address
+	//of each name remains valid until the arena is reset.
+	return &(*names.insert(name).first);
+}
+
+//----------------------------------------------------------------------------------------
+const std::wstring* HierarchicalStorageArena::FindName(const std::wstring& name) const
+{
+	NameSet::const_iterator nameIterator = names.find(name);
+	return (nameIterator != names.end())? &(*nameIterator): 0;
+}
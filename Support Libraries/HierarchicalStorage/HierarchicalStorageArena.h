@@ -0,0 +1,44 @@
+#ifndef __HIERARCHICALSTORAGEARENA_H__
+#define __HIERARCHICALSTORAGEARENA_H__
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+//This class provides the memory for the nodes and attributes in a tree, along with a
+//table of the element and attribute names used within it. Memory is handed out in order
+//from large chunks, and is only released when the arena is reset or destroyed, so objects
+//allocated here must have their destructors called explicitly. Each distinct name is
+//stored only once, and objects refer to the shared copy. Note that as with the rest of a
+//tree, an arena must not be accessed by multiple threads at once.
+class HierarchicalStorageArena
+{
+public:
+	//Constructors
+	HierarchicalStorageArena();
+	~HierarchicalStorageArena();
+	void Reset();
+
+	//Allocation functions
+	void* Allocate(size_t size);
+
+	//Name functions
+	const std::wstring* InternName(const std::wstring& name);
+	const std::wstring* FindName(const std::wstring& name) const;
+
+private:
+	//Typedefs
+	typedef std::unordered_set<std::wstring> NameSet;
+
+private:
+	//Constants
+	static const size_t chunkSize = 64 * 1024;
+	static const size_t allocationAlignment = 16;
+
+private:
+	std::vector<unsigned char*> chunks;
+	unsigned char* currentChunkPos;
+	size_t currentChunkRemaining;
+	NameSet names;
+};
+
+#endif
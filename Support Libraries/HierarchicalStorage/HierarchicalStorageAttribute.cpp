@@ -3,12 +3,8 @@
 //----------------------------------------------------------------------------------------
 //Constructors
 //----------------------------------------------------------------------------------------
-HierarchicalStorageAttribute::HierarchicalStorageAttribute()
-{}
-
-//----------------------------------------------------------------------------------------
-HierarchicalStorageAttribute::HierarchicalStorageAttribute(const std::wstring& aname)
-:name(aname)
+HierarchicalStorageAttribute::HierarchicalStorageAttribute(HierarchicalStorageArena& aarena, const std::wstring* aname)
+:arena(&aarena), name(aname)
 {}
 
 //----------------------------------------------------------------------------------------
@@ -16,13 +12,13 @@ HierarchicalStorageAttribute::HierarchicalStorageAttribute(const std::wstring& a
 //----------------------------------------------------------------------------------------
 MarshalSupport::Marshal::Ret<std::wstring> HierarchicalStorageAttribute::GetName() const
 {
-	return name;
+	return *name;
 }
 
 //----------------------------------------------------------------------------------------
 void HierarchicalStorageAttribute::SetName(const MarshalSupport::Marshal::In<std::wstring>& aname)
 {
-	name = aname;
+	name = arena->InternName(aname.Get());
 }
 
 //----------------------------------------------------------------------------------------
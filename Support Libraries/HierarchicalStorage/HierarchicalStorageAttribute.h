@@ -1,14 +1,16 @@
 #ifndef __HIERARCHICALSTORAGEATTRIBUTE_H__
 #define __HIERARCHICALSTORAGEATTRIBUTE_H__
 #include "HierarchicalStorageInterface/HierarchicalStorageInterface.pkg"
+#include "HierarchicalStorageArena.h"
 #include "Stream/Stream.pkg"
 
 class HierarchicalStorageAttribute :public IHierarchicalStorageAttribute
 {
+	friend class HierarchicalStorageTree;
+
 public:
 	//Constructors
-	HierarchicalStorageAttribute();
-	explicit HierarchicalStorageAttribute(const std::wstring& aname);
+	HierarchicalStorageAttribute(HierarchicalStorageArena& aarena, const std::wstring* aname);
 
 	//Name functions
 	virtual MarshalSupport::Marshal::Ret<std::wstring> GetName() const;
@@ -21,7 +23,8 @@ protected:
 	virtual Stream::IStream& GetInternalStream() const;
 
 private:
-	std::wstring name;
+	HierarchicalStorageArena* arena;
+	const std::wstring* name;
 	mutable Stream::Buffer buffer;
 };
 
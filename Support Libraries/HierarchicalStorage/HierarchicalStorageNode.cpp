@@ -1,38 +1,83 @@
 #include "HierarchicalStorageNode.h"
+#include <cstring>
+#include <algorithm>
+#include <new>
 
 //----------------------------------------------------------------------------------------
 //Constructors
 //----------------------------------------------------------------------------------------
 HierarchicalStorageNode::HierarchicalStorageNode()
-:parent(0), binaryDataPresent(false), inlineBinaryData(false), dataStream(Stream::IStream::TextEncoding::UTF16, Stream::IStream::NewLineEncoding::Unix, Stream::IStream::ByteOrder::BigEndian, 0)
-{}
+:arena(new HierarchicalStorageArena()), arenaOwner(true), parent(0), binaryDataPresent(false), inlineBinaryData(false), dataStream(Stream::IStream::TextEncoding::UTF16, Stream::IStream::NewLineEncoding::Unix, Stream::IStream::ByteOrder::BigEndian, 0), binaryDataReference(0), binaryDataReferenceSize(0), childLookupIndex(0), childPositionIndex(0), attributeLookupIndex(0)
+{
+	name = arena->InternName(L"");
+}
 
 //----------------------------------------------------------------------------------------
 HierarchicalStorageNode::HierarchicalStorageNode(const std::wstring& aname)
-:name(aname), parent(0), binaryDataPresent(false), inlineBinaryData(false), dataStream(Stream::IStream::TextEncoding::UTF16, Stream::IStream::NewLineEncoding::Unix, Stream::IStream::ByteOrder::BigEndian, 0)
+:arena(new HierarchicalStorageArena()), arenaOwner(true), parent(0), binaryDataPresent(false), inlineBinaryData(false), dataStream(Stream::IStream::TextEncoding::UTF16, Stream::IStream::NewLineEncoding::Unix, Stream::IStream::ByteOrder::BigEndian, 0), binaryDataReference(0), binaryDataReferenceSize(0), childLookupIndex(0), childPositionIndex(0), attributeLookupIndex(0)
+{
+	name = arena->InternName(aname);
+}
+
+//----------------------------------------------------------------------------------------
+HierarchicalStorageNode::HierarchicalStorageNode(HierarchicalStorageArena& aarena, const std::wstring* aname)
+:arena(&aarena), arenaOwner(false), name(aname), parent(0), binaryDataPresent(false), inlineBinaryData(false), dataStream(Stream::IStream::TextEncoding::UTF16, Stream::IStream::NewLineEncoding::Unix, Stream::IStream::ByteOrder::BigEndian, 0), binaryDataReference(0), binaryDataReferenceSize(0), childLookupIndex(0), childPositionIndex(0), attributeLookupIndex(0)
 {}
 
 //----------------------------------------------------------------------------------------
 HierarchicalStorageNode::~HierarchicalStorageNode()
 {
-	Initialize();
+	DestroyContent();
+	if(arenaOwner)
+	{
+		delete arena;
+	}
 }
 
 //----------------------------------------------------------------------------------------
 void HierarchicalStorageNode::Initialize()
 {
+	DestroyContent();
+	children.clear();
+	attributes.clear();
+	binaryDataName.clear();
+	binaryDataPresent = false;
+	binaryDataReference = 0;
+	binaryDataReferenceSize = 0;
+
+	//If we own the arena for this tree, nothing else allocated from it is in use now, so
+	//we release its memory, keeping only our own name.
+	if(arenaOwner)
+	{
+		std::wstring nameCopy = *name;
+		arena->Reset();
+		name = arena->InternName(nameCopy);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void HierarchicalStorageNode::DestroyContent()
+{
+	//Our children and attributes are allocated from the arena, so we call their
+	//destructors directly. Their memory is released along with the arena.
 	for(ChildList::iterator i = children.begin(); i != children.end(); ++i)
 	{
-		delete *i;
+		(*i)->~HierarchicalStorageNode();
 	}
 	for(AttributeList::iterator i = attributes.begin(); i != attributes.end(); ++i)
 	{
-		delete i->second;
+		i->second->~HierarchicalStorageAttribute();
 	}
-	children.clear();
-	attributes.clear();
-	binaryDataName.clear();
-	binaryDataPresent = false;
+	InvalidateChildLookupIndex();
+	InvalidateAttributeLookupIndex();
+}
+
+//----------------------------------------------------------------------------------------
+//Interface version functions
+//----------------------------------------------------------------------------------------
+unsigned int HierarchicalStorageNode::GetIHierarchicalStorageNodeVersion() const
+{
+	return ThisIHierarchicalStorageNodeVersion();
 }
 
 //----------------------------------------------------------------------------------------
@@ -40,13 +85,20 @@ void HierarchicalStorageNode::Initialize()
 //----------------------------------------------------------------------------------------
 MarshalSupport::Marshal::Ret<std::wstring> HierarchicalStorageNode::GetName() const
 {
-	return name;
+	return *name;
 }
 
 //----------------------------------------------------------------------------------------
 void HierarchicalStorageNode::SetName(const MarshalSupport::Marshal::In<std::wstring>& aname)
 {
-	name = aname;
+	name = arena->InternName(aname.Get());
+
+	//Since our parent may have indexed its children by name, inform it that the name of
+	//this node has changed.
+	if(parent != 0)
+	{
+		parent->InvalidateChildLookupIndex();
+	}
 }
 
 //----------------------------------------------------------------------------------------
@@ -68,7 +120,7 @@ void HierarchicalStorageNode::SetParent(HierarchicalStorageNode* aparent)
 //----------------------------------------------------------------------------------------
 bool HierarchicalStorageNode::IsEmpty() const
 {
-	return (children.empty() && attributes.empty() && !binaryDataPresent && (dataStream.Size() == 0));
+	return (children.empty() && attributes.empty() && !binaryDataPresent && (dataStream.Size() == 0) && (binaryDataReferenceSize == 0));
 }
 
 //----------------------------------------------------------------------------------------
@@ -82,26 +134,55 @@ void HierarchicalStorageNode::ResetInternalStreamPosition() const
 //----------------------------------------------------------------------------------------
 Stream::IStream& HierarchicalStorageNode::GetInternalStream() const
 {
+	MaterializeBinaryDataReference();
 	return dataStream;
 }
 
+//----------------------------------------------------------------------------------------
+void HierarchicalStorageNode::MaterializeBinaryDataReference() const
+{
+	//If this node currently refers to external binary data, take a copy of it into our
+	//data stream, so that it can be read and modified through the stream interface.
+	if(binaryDataReference != 0)
+	{
+		dataStream.Resize((Stream::IStream::SizeType)binaryDataReferenceSize);
+		if(binaryDataReferenceSize > 0)
+		{
+			memcpy(dataStream.GetRawBuffer(), binaryDataReference, binaryDataReferenceSize);
+		}
+		dataStream.SetStreamPos(0);
+		binaryDataReference = 0;
+		binaryDataReferenceSize = 0;
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Allocation functions
+//----------------------------------------------------------------------------------------
+HierarchicalStorageNode* HierarchicalStorageNode::AllocateChild(const std::wstring* aname)
+{
+	return new(arena->Allocate(sizeof(HierarchicalStorageNode))) HierarchicalStorageNode(*arena, aname);
+}
+
 //----------------------------------------------------------------------------------------
 //Child functions
 //----------------------------------------------------------------------------------------
 IHierarchicalStorageNode& HierarchicalStorageNode::CreateChild()
 {
-	HierarchicalStorageNode* child = new HierarchicalStorageNode();
+	HierarchicalStorageNode* child = AllocateChild(arena->InternName(L""));
 	child->SetParent(this);
 	children.push_back(child);
+	AddChildToLookupIndex(child, children.size() - 1);
 	return *child;
 }
 
 //----------------------------------------------------------------------------------------
 IHierarchicalStorageNode& HierarchicalStorageNode::CreateChild(const MarshalSupport::Marshal::In<std::wstring>& aname)
 {
-	HierarchicalStorageNode* child = new HierarchicalStorageNode(aname);
+	HierarchicalStorageNode* child = AllocateChild(arena->InternName(aname.Get()));
 	child->SetParent(this);
 	children.push_back(child);
+	AddChildToLookupIndex(child, children.size() - 1);
 	return *child;
 }
 
@@ -113,7 +194,12 @@ void HierarchicalStorageNode::DeleteChild(IHierarchicalStorageNode& node)
 	{
 		if(*childListIterator == &node)
 		{
+			//The child is allocated from the arena, so we call its destructor directly to
+			//release its content. Its own memory is released along with the arena.
+			HierarchicalStorageNode* child = *childListIterator;
 			children.erase(childListIterator);
+			InvalidateChildLookupIndex();
+			child->~HierarchicalStorageNode();
 			return;
 		}
 		++childListIterator;
@@ -134,27 +220,56 @@ MarshalSupport::Marshal::Ret<std::list<IHierarchicalStorageNode*>> HierarchicalS
 //----------------------------------------------------------------------------------------
 bool HierarchicalStorageNode::IsChildPresent(const MarshalSupport::Marshal::In<std::wstring>& name) const
 {
-	std::wstring nameResolved = name.Get();
-	for(ChildList::const_iterator i = children.begin(); i != children.end(); ++i)
-	{
-		HierarchicalStorageNode* childNode = *i;
-		if(childNode->GetName() == nameResolved)
-		{
-			return true;
-		}
-	}
-	return false;
+	return (GetChild(name) != 0);
 }
 
 //----------------------------------------------------------------------------------------
 IHierarchicalStorageNode* HierarchicalStorageNode::GetChild(const MarshalSupport::Marshal::In<std::wstring>& name, const IHierarchicalStorageNode* searchAfterChildNode) const
 {
-	std::wstring nameResolved = name.Get();
+	//Since all names in this tree are interned in our arena, if the target name isn't
+	//present in the arena, no node in this tree can have it. Otherwise, we can compare
+	//names by their address alone.
+	const std::wstring* nameResolved = arena->FindName(name.Get());
+	if(nameResolved == 0)
+	{
+		return 0;
+	}
+
+	//If this node has a large number of children, use our lookup index to find the target
+	//child, building the index first if required. The index holds the position of each
+	//child with a given name in ascending order, so the first child with the target name
+	//following the search start node is the first entry after the position of that node.
+	if(children.size() >= lookupIndexThreshold)
+	{
+		if(childLookupIndex == 0)
+		{
+			BuildChildLookupIndex();
+		}
+		ChildLookupIndex::const_iterator childLookupIndexIterator = childLookupIndex->find(nameResolved);
+		if(childLookupIndexIterator == childLookupIndex->end())
+		{
+			return 0;
+		}
+		const std::vector<size_t>& childPositions = childLookupIndexIterator->second;
+		if(searchAfterChildNode == 0)
+		{
+			return children[childPositions.front()];
+		}
+		ChildPositionIndex::const_iterator childPositionIndexIterator = childPositionIndex->find(searchAfterChildNode);
+		if(childPositionIndexIterator == childPositionIndex->end())
+		{
+			return 0;
+		}
+		std::vector<size_t>::const_iterator nextChildPosition = std::upper_bound(childPositions.begin(), childPositions.end(), childPositionIndexIterator->second);
+		return (nextChildPosition != childPositions.end())? children[*nextChildPosition]: 0;
+	}
+
+	//Search the list of children for the target child
 	bool foundSearchStartNode = (searchAfterChildNode == 0);
 	for(ChildList::const_iterator i = children.begin(); i != children.end(); ++i)
 	{
 		HierarchicalStorageNode* childNode = *i;
-		if(foundSearchStartNode && (childNode->GetName() == nameResolved))
+		if(foundSearchStartNode && (childNode->name == nameResolved))
 		{
 			return childNode;
 		}
@@ -168,21 +283,31 @@ IHierarchicalStorageNode* HierarchicalStorageNode::GetChild(const MarshalSupport
 //----------------------------------------------------------------------------------------
 bool HierarchicalStorageNode::IsAttributePresent(const MarshalSupport::Marshal::In<std::wstring>& name) const
 {
-	std::wstring nameResolved = name.Get();
-	for(AttributeList::const_iterator i = attributes.begin(); i != attributes.end(); ++i)
-	{
-		if(i->first == nameResolved)
-		{
-			return true;
-		}
-	}
-	return false;
+	return (GetAttribute(name) != 0);
 }
 
 //----------------------------------------------------------------------------------------
 IHierarchicalStorageAttribute* HierarchicalStorageNode::GetAttribute(const MarshalSupport::Marshal::In<std::wstring>& name) const
 {
-	std::wstring nameResolved = name.Get();
+	const std::wstring* nameResolved = arena->FindName(name.Get());
+	if(nameResolved == 0)
+	{
+		return 0;
+	}
+
+	//If this node has a large number of attributes, use our lookup index to find the
+	//target attribute, building the index first if required.
+	if(attributes.size() >= lookupIndexThreshold)
+	{
+		if(attributeLookupIndex == 0)
+		{
+			BuildAttributeLookupIndex();
+		}
+		AttributeLookupIndex::const_iterator attributeLookupIndexIterator = attributeLookupIndex->find(nameResolved);
+		return (attributeLookupIndexIterator != attributeLookupIndex->end())? attributes[attributeLookupIndexIterator->second].second: 0;
+	}
+
+	//Search the list of attributes for the target attribute
 	for(AttributeList::const_iterator i = attributes.begin(); i != attributes.end(); ++i)
 	{
 		if(i->first == nameResolved)
@@ -199,9 +324,14 @@ IHierarchicalStorageAttribute& HierarchicalStorageNode::CreateAttribute(const Ma
 	IHierarchicalStorageAttribute* attribute = GetAttribute(name);
 	if(attribute == 0)
 	{
-		HierarchicalStorageAttribute* newAttribute = new HierarchicalStorageAttribute(name);
+		const std::wstring* internedName = arena->InternName(name.Get());
+		HierarchicalStorageAttribute* newAttribute = new(arena->Allocate(sizeof(HierarchicalStorageAttribute))) HierarchicalStorageAttribute(*arena, internedName);
 		attribute = newAttribute;
-		attributes.push_back(AttributeListEntry(name, newAttribute));
+		attributes.push_back(AttributeListEntry(internedName, newAttribute));
+		if(attributeLookupIndex != 0)
+		{
+			attributeLookupIndex->insert(AttributeLookupIndex::value_type(attributes.back().first, attributes.size() - 1));
+		}
 	}
 	return *attribute;
 }
@@ -214,9 +344,15 @@ void HierarchicalStorageNode::DeleteAttribute(IHierarchicalStorageAttribute& att
 	{
 		if(attributeIterator->second == &attribute)
 		{
+			//As with child nodes, attributes are allocated from the arena, so we call the
+			//destructor directly.
+			HierarchicalStorageAttribute* attributeToDelete = attributeIterator->second;
 			attributes.erase(attributeIterator);
+			InvalidateAttributeLookupIndex();
+			attributeToDelete->~HierarchicalStorageAttribute();
 			return;
 		}
+		++attributeIterator;
 	}
 }
 
@@ -231,6 +367,61 @@ MarshalSupport::Marshal::Ret<std::list<IHierarchicalStorageAttribute*>> Hierarch
 	return attributeList;
 }
 
+//----------------------------------------------------------------------------------------
+//Lookup index functions
+//----------------------------------------------------------------------------------------
+void HierarchicalStorageNode::BuildChildLookupIndex() const
+{
+	InvalidateChildLookupIndex();
+	childLookupIndex = new ChildLookupIndex();
+	childPositionIndex = new ChildPositionIndex();
+	for(size_t i = 0; i < children.size(); ++i)
+	{
+		AddChildToLookupIndex(children[i], i);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void HierarchicalStorageNode::AddChildToLookupIndex(HierarchicalStorageNode* child, size_t childPosition) const
+{
+	//Children are always added to the index in order, so the list of positions for each
+	//name remains sorted.
+	if(childLookupIndex != 0)
+	{
+		(*childLookupIndex)[child->name].push_back(childPosition);
+		(*childPositionIndex)[child] = childPosition;
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void HierarchicalStorageNode::InvalidateChildLookupIndex() const
+{
+	delete childLookupIndex;
+	delete childPositionIndex;
+	childLookupIndex = 0;
+	childPositionIndex = 0;
+}
+
+//----------------------------------------------------------------------------------------
+void HierarchicalStorageNode::BuildAttributeLookupIndex() const
+{
+	//Note that where the same name appears more than once, we keep the position of the
+	//first occurrence, so that lookups return the same attribute as a search of the list.
+	InvalidateAttributeLookupIndex();
+	attributeLookupIndex = new AttributeLookupIndex();
+	for(size_t i = 0; i < attributes.size(); ++i)
+	{
+		attributeLookupIndex->insert(AttributeLookupIndex::value_type(attributes[i].first, i));
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void HierarchicalStorageNode::InvalidateAttributeLookupIndex() const
+{
+	delete attributeLookupIndex;
+	attributeLookupIndex = 0;
+}
+
 //----------------------------------------------------------------------------------------
 //Common data functions
 //----------------------------------------------------------------------------------------
@@ -240,6 +431,8 @@ void HierarchicalStorageNode::ClearData()
 	inlineBinaryData = false;
 	binaryDataName.clear();
 	dataStream.Resize(0);
+	binaryDataReference = 0;
+	binaryDataReferenceSize = 0;
 }
 
 //----------------------------------------------------------------------------------------
@@ -271,6 +464,7 @@ void HierarchicalStorageNode::SetBinaryDataBufferName(const MarshalSupport::Mars
 //----------------------------------------------------------------------------------------
 Stream::IStream& HierarchicalStorageNode::GetBinaryDataBufferStream()
 {
+	MaterializeBinaryDataReference();
 	return dataStream;
 }
 
@@ -286,6 +480,37 @@ void HierarchicalStorageNode::SetInlineBinaryDataEnabled(bool state)
 	inlineBinaryData = state;
 }
 
+//----------------------------------------------------------------------------------------
+//Binary data view functions
+//----------------------------------------------------------------------------------------
+void HierarchicalStorageNode::SetBinaryDataReference(const unsigned char* data, size_t dataSize)
+{
+	//Discard any data held in our internal stream, and record the location of the
+	//external data. We hold a non-null pointer for a reference to an empty buffer, so that
+	//the reference still replaces the existing data.
+	static const unsigned char emptyBuffer = 0;
+	dataStream.Resize(0);
+	binaryDataReference = ((data != 0) && (dataSize > 0))? data: &emptyBuffer;
+	binaryDataReferenceSize = ((data != 0) && (dataSize > 0))? dataSize: 0;
+}
+
+//----------------------------------------------------------------------------------------
+void HierarchicalStorageNode::GetBinaryDataView(const unsigned char*& data, size_t& dataSize) const
+{
+	//Return either the referenced external data, or the contents of our internal data
+	//stream, without taking a copy of the data in either case.
+	if(binaryDataReference != 0)
+	{
+		data = binaryDataReference;
+		dataSize = binaryDataReferenceSize;
+	}
+	else
+	{
+		data = dataStream.GetRawBuffer();
+		dataSize = (size_t)dataStream.Size();
+	}
+}
+
 //----------------------------------------------------------------------------------------
 void HierarchicalStorageNode::AddBinaryDataEntitiesToList(std::list<IHierarchicalStorageNode*>& binaryEntityList)
 {
@@ -298,3 +523,13 @@ void HierarchicalStorageNode::AddBinaryDataEntitiesToList(std::list<IHierarchica
 		(*i)->AddBinaryDataEntitiesToList(binaryEntityList);
 	}
 }
+
+//----------------------------------------------------------------------------------------
+void HierarchicalStorageNode::MaterializeBinaryDataReferences()
+{
+	MaterializeBinaryDataReference();
+	for(ChildList::iterator i = children.begin(); i != children.end(); ++i)
+	{
+		(*i)->MaterializeBinaryDataReferences();
+	}
+}
@@ -2,13 +2,17 @@
 #define __HIERARCHICALSTORAGENODE_H__
 #include "HierarchicalStorageInterface/HierarchicalStorageInterface.pkg"
 #include "HierarchicalStorageAttribute.h"
+#include "HierarchicalStorageArena.h"
 #include "Stream/Stream.pkg"
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <string>
 
 class HierarchicalStorageNode :public IHierarchicalStorageNode
 {
+	friend class HierarchicalStorageTree;
+
 public:
 	//Constructors
 	HierarchicalStorageNode();
@@ -16,6 +20,9 @@ public:
 	~HierarchicalStorageNode();
 	void Initialize();
 
+	//Interface version functions
+	virtual unsigned int GetIHierarchicalStorageNodeVersion() const;
+
 	//Name functions
 	virtual MarshalSupport::Marshal::Ret<std::wstring> GetName() const;
 	virtual void SetName(const MarshalSupport::Marshal::In<std::wstring>& aname);
@@ -50,30 +57,63 @@ public:
 	virtual Stream::IStream& GetBinaryDataBufferStream();
 	virtual bool GetInlineBinaryDataEnabled() const;
 	virtual void SetInlineBinaryDataEnabled(bool state);
+
+	//Binary data view functions
+	virtual void SetBinaryDataReference(const unsigned char* data, size_t dataSize);
+	virtual void GetBinaryDataView(const unsigned char*& data, size_t& dataSize) const;
 	void AddBinaryDataEntitiesToList(std::list<IHierarchicalStorageNode*>& binaryEntityList);
+	void MaterializeBinaryDataReferences();
 
 protected:
 	//Stream functions
 	virtual void ResetInternalStreamPosition() const;
 	virtual Stream::IStream& GetInternalStream() const;
+	void MaterializeBinaryDataReference() const;
 
 	//Common data functions
 	virtual void ClearData();
 
 private:
+	//Constructors
+	HierarchicalStorageNode(HierarchicalStorageArena& aarena, const std::wstring* aname);
+	void DestroyContent();
+
 	//Parent functions
 	void SetParent(HierarchicalStorageNode* aparent);
 
+	//Allocation functions
+	HierarchicalStorageNode* AllocateChild(const std::wstring* aname);
+
+	//Lookup index functions
+	void BuildChildLookupIndex() const;
+	void AddChildToLookupIndex(HierarchicalStorageNode* child, size_t childPosition) const;
+	void InvalidateChildLookupIndex() const;
+	void BuildAttributeLookupIndex() const;
+	void InvalidateAttributeLookupIndex() const;
+
 private:
 	//Typedefs
 	typedef std::vector<HierarchicalStorageNode*> ChildList;
-	typedef std::pair<std::wstring, HierarchicalStorageAttribute*> AttributeListEntry;
+	typedef std::pair<const std::wstring*, HierarchicalStorageAttribute*> AttributeListEntry;
 	//Note that this is a vector rather than a map, so that we can preserve the explicit
 	//ordering of attributes.
 	typedef std::vector<AttributeListEntry> AttributeList;
+	typedef std::unordered_map<const std::wstring*, std::vector<size_t>> ChildLookupIndex;
+	typedef std::unordered_map<const IHierarchicalStorageNode*, size_t> ChildPositionIndex;
+	typedef std::unordered_map<const std::wstring*, size_t> AttributeLookupIndex;
 
 private:
-	std::wstring name;
+	//Constants
+	//Nodes with at least this many children or attributes build a hash index over the
+	//names on the first lookup, rather than searching the list each time.
+	static const size_t lookupIndexThreshold = 16;
+
+private:
+	//Note that all nodes in a tree share the arena which is owned by the root node, and
+	//names refer to the shared copy held in that arena.
+	HierarchicalStorageArena* arena;
+	bool arenaOwner;
+	const std::wstring* name;
 	HierarchicalStorageNode* parent;
 	ChildList children;
 	AttributeList attributes;
@@ -81,6 +121,16 @@ private:
 	bool inlineBinaryData;
 	std::wstring binaryDataName;
 	mutable Stream::Buffer dataStream;
+	mutable const unsigned char* binaryDataReference;
+	mutable size_t binaryDataReferenceSize;
+
+	//Lookup indexes
+	//Note that these are built on demand by const lookup functions, so as with the rest
+	//of this class, a node must not be accessed by multiple threads at once. They're only
+	//allocated when they're built, since most nodes never need them.
+	mutable ChildLookupIndex* childLookupIndex;
+	mutable ChildPositionIndex* childPositionIndex;
+	mutable AttributeLookupIndex* attributeLookupIndex;
 };
 
 #endif
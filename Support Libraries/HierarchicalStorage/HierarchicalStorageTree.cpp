@@ -1,5 +1,6 @@
 #include "HierarchicalStorageTree.h"
 #include <sstream>
+#include <cstring>
 
 //----------------------------------------------------------------------------------------
 //Constructors
@@ -27,22 +28,19 @@ void HierarchicalStorageTree::Initialize()
 //----------------------------------------------------------------------------------------
 bool HierarchicalStorageTree::SaveTree(Stream::IStream& target)
 {
+	if(storageMode == StorageMode::Binary)
+	{
+		return SaveTreeBinary(target);
+	}
 	return SaveNode(*root, target, L"");
 }
 
 //----------------------------------------------------------------------------------------
 bool HierarchicalStorageTree::LoadTree(Stream::IStream& source)
 {
-	//Load the contents of the source stream into a buffer of unicode characters
-	std::wstring buffer;
-	Stream::ViewText view(source);
-	if(!view.ReadTextString(buffer, false))
-	{
-		return false;
-	}
-	if(buffer.empty())
+	if(storageMode == StorageMode::Binary)
 	{
-		return false;
+		return LoadTreeBinary(source);
 	}
 
 	//Create a new expat XML parser
@@ -57,16 +55,73 @@ bool HierarchicalStorageTree::LoadTree(Stream::IStream& source)
 	XML_SetElementHandler(parser, LoadStartElement, LoadEndElement);
 	XML_SetCharacterDataHandler(parser, LoadData);
 
-	//Parse the XML data
+	//Parse the XML data. Rather than loading the entire source stream into memory before
+	//parsing begins, we decode the source text in fixed size chunks directly into the
+	//input buffer owned by the parser, and parse each chunk as soon as it's been read.
+	//This keeps the memory required to load a tree independent of the size of the source
+	//document. As with the ViewText::ReadTextString function, text is decoded according
+	//to the text encoding of the source stream, and a null terminator ends the document.
 	currentNodeDuringLoad = 0;
-	if(XML_Parse(parser, (char*)&buffer[0], (int)(buffer.size() * sizeof(wchar_t)), 1) != XML_STATUS_OK)
+	pendingInlineBinaryDataDuringLoad.clear();
+	bool sourceTextPresent = false;
+	bool done = false;
+	while(!done)
 	{
-		//If XML parsing failed, set the error string, and return false.
-		std::wstringstream errorStream;
-		errorStream << XML_ErrorString(XML_GetErrorCode(parser)) << L" at line " << XML_GetCurrentLineNumber(parser);
-		errorString = errorStream.str();
-		XML_ParserFree(parser);
-		return false;
+		//Obtain the next input buffer from the parser
+		wchar_t* parseBuffer = (wchar_t*)XML_GetBuffer(parser, (int)(xmlParseBufferCharCount * sizeof(wchar_t)));
+		if(parseBuffer == 0)
+		{
+			XML_ParserFree(parser);
+			return false;
+		}
+
+		//Decode text from the source stream until the buffer is full, or we reach the end
+		//of the document. We stop one character short of the end of the buffer, so that
+		//there's always room for both code units of a surrogate pair.
+		int parseBufferCharsWritten = 0;
+		while(!done && (parseBufferCharsWritten < (xmlParseBufferCharCount - 1)))
+		{
+			if(source.IsAtEnd())
+			{
+				done = true;
+				continue;
+			}
+			Stream::IStream::UnicodeCodePoint codePoint;
+			if(!source.ReadChar(codePoint))
+			{
+				XML_ParserFree(parser);
+				return false;
+			}
+			if(!codePoint.surrogatePair && (codePoint.codeUnit1 == L'\0'))
+			{
+				done = true;
+				continue;
+			}
+			parseBuffer[parseBufferCharsWritten++] = codePoint.codeUnit1;
+			if(codePoint.surrogatePair)
+			{
+				parseBuffer[parseBufferCharsWritten++] = codePoint.codeUnit2;
+			}
+		}
+
+		//If the source stream contained no text, abort any further processing.
+		sourceTextPresent |= (parseBufferCharsWritten > 0);
+		if(!sourceTextPresent)
+		{
+			XML_ParserFree(parser);
+			return false;
+		}
+
+		//Parse the decoded text
+		if(XML_ParseBuffer(parser, (int)(parseBufferCharsWritten * sizeof(wchar_t)), (done? 1: 0)) != XML_STATUS_OK)
+		{
+			//If XML parsing failed, set the error string, and return false.
+			std::wstringstream errorStream;
+			errorStream << XML_ErrorString(XML_GetErrorCode(parser)) << L" at line " << XML_GetCurrentLineNumber(parser);
+			errorString = errorStream.str();
+			XML_ParserFree(parser);
+			return false;
+		}
 	}
 
 	//Free the XML parser
@@ -155,12 +210,12 @@ bool HierarchicalStorageTree::SaveNode(IHierarchicalStorageNode& node, Stream::I
 			else
 			{
 				//Save binary data in the XML structure
-				Stream::IStream::SizeType readCount = (node.GetBinaryDataBufferStream().Size() / (Stream::IStream::SizeType)sizeof(unsigned char));
-				std::vector<unsigned char> buffer(readCount);
-				node.ExtractBinaryData(buffer);
-				for(unsigned int i = 0; i < buffer.size(); ++i)
+				const unsigned char* nodeData;
+				size_t nodeDataSize;
+				node.GetBinaryDataView(nodeData, nodeDataSize);
+				for(size_t i = 0; i < nodeDataSize; ++i)
 				{
-					streamView << Stream::Hex(2) << buffer[i];
+					streamView << Stream::Hex(2) << nodeData[i];
 				}
 			}
 		}
@@ -190,6 +245,7 @@ bool HierarchicalStorageTree::SaveNode(IHierarchicalStorageNode& node, Stream::I
 void XMLCALL HierarchicalStorageTree::LoadStartElement(void *userData, const XML_Char *aname, const XML_Char **aatts)
 {
 	HierarchicalStorageTree* tree = (HierarchicalStorageTree*)userData;
+	tree->pendingInlineBinaryDataDuringLoad.clear();
 	HierarchicalStorageNode* node = 0;
 	if(tree->currentNodeDuringLoad == 0)
 	{
@@ -220,6 +276,7 @@ void XMLCALL HierarchicalStorageTree::LoadStartElement(void *userData, const XML
 void XMLCALL HierarchicalStorageTree::LoadEndElement(void *userData, const XML_Char *aname)
 {
 	HierarchicalStorageTree* tree = (HierarchicalStorageTree*)userData;
+	tree->pendingInlineBinaryDataDuringLoad.clear();
 	if(tree->currentNodeDuringLoad != 0)
 	{
 		tree->currentNodeDuringLoad = &tree->currentNodeDuringLoad->GetParent();
@@ -258,7 +315,10 @@ void XMLCALL HierarchicalStorageTree::LoadData(void *userData, const XML_Char *s
 		else
 		{
 			tree->currentNodeDuringLoad->SetInlineBinaryDataEnabled(true);
-			//Load inline binary data from the XML structure
+			//Load inline binary data from the XML structure. The character data for a node
+			//may be split across several calls, so if we're left with an odd number of
+			//hex digits, we hold the last digit over until the next call.
+			data = tree->pendingInlineBinaryDataDuringLoad + data;
 			size_t charPos = 0;
 			while((data.length() - charPos) >= 2)
 			{
@@ -272,6 +332,7 @@ void XMLCALL HierarchicalStorageTree::LoadData(void *userData, const XML_Char *s
 
 				charPos += 2;
 			}
+			tree->pendingInlineBinaryDataDuringLoad = data.substr(charPos);
 		}
 	}
 	else
@@ -280,6 +341,274 @@ void XMLCALL HierarchicalStorageTree::LoadData(void *userData, const XML_Char *s
 	}
 }
 
+//----------------------------------------------------------------------------------------
+//Binary save/load functions
+//----------------------------------------------------------------------------------------
+//The binary storage format is a compact alternative to the XML format, intended for
+//savestates where load and save time matter more than human readability. All values are
+//stored in little-endian byte order. The stream begins with a 32-bit signature and format
+//version, followed by the root node. Each node is stored as its name, an attribute count,
+//the name and raw content of each attribute, a flags byte, the binary buffer name, the raw
+//content of the node data buffer, a child count, and finally each child node in order.
+//Strings are stored as a 32-bit character count followed by 16-bit characters, and data
+//buffers are stored as a 32-bit byte count followed by the raw bytes of the buffer. Since
+//the raw buffer contents are copied directly, no text or hex conversion is performed on
+//either attribute values or binary data. Binary data is always stored within the tree in
+//this format, so no separate binary data buffers are produced or required.
+//----------------------------------------------------------------------------------------
+bool HierarchicalStorageTree::SaveTreeBinary(Stream::IStream& target) const
+{
+	//Build the entire tree in memory first, so that it can be written to the target
+	//stream with a single write operation.
+	std::vector<unsigned char> buffer;
+	WriteBinaryUInt32(buffer, binaryFormatSignature);
+	WriteBinaryUInt32(buffer, binaryFormatVersion);
+	SaveNodeBinary(*root, buffer);
+	if(!target.WriteData(&buffer[0], (Stream::IStream::SizeType)buffer.size()))
+	{
+		errorString = L"Failed to write binary tree data to the target stream";
+		return false;
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+bool HierarchicalStorageTree::LoadTreeBinary(Stream::IStream& source)
+{
+	//Load the remaining contents of the source stream into a buffer
+	Stream::IStream::SizeType sourceSize = source.Size() - source.GetStreamPos();
+	std::vector<unsigned char> buffer((size_t)sourceSize);
+	if(buffer.empty() || !source.ReadData(&buffer[0], sourceSize))
+	{
+		errorString = L"Failed to read binary tree data from the source stream";
+		return false;
+	}
+
+	//Validate the header
+	size_t bufferPos = 0;
+	unsigned int signature;
+	unsigned int version;
+	if(!ReadBinaryUInt32(buffer, bufferPos, signature) || !ReadBinaryUInt32(buffer, bufferPos, version) || (signature != binaryFormatSignature))
+	{
+		errorString = L"Source stream is not in the binary tree format";
+		return false;
+	}
+	if(version != binaryFormatVersion)
+	{
+		std::wstringstream errorStream;
+		errorStream << L"Unsupported binary tree format version " << version;
+		errorString = errorStream.str();
+		return false;
+	}
+
+	//Load the tree structure
+	errorString.clear();
+	if(!LoadNodeBinary(*root, buffer, bufferPos, 0))
+	{
+		if(errorString.empty())
+		{
+			std::wstringstream errorStream;
+			errorStream << L"Binary tree data is truncated or corrupt at offset " << bufferPos;
+			errorString = errorStream.str();
+		}
+		return false;
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+void HierarchicalStorageTree::SaveNodeBinary(const HierarchicalStorageNode& node, std::vector<unsigned char>& buffer) const
+{
+	//Write the node name
+	WriteBinaryString(buffer, *node.name);
+
+	//Write attributes
+	WriteBinaryUInt32(buffer, (unsigned int)node.attributes.size());
+	for(HierarchicalStorageNode::AttributeList::const_iterator i = node.attributes.begin(); i != node.attributes.end(); ++i)
+	{
+		const HierarchicalStorageAttribute& attribute = *(i->second);
+		WriteBinaryString(buffer, *attribute.name);
+		WriteBinaryStream(buffer, attribute.buffer);
+	}
+
+	//Write data. Note that binary data is always stored inline in this format, but we
+	//retain the separate binary data settings for the node, so that a tree converted from
+	//this format back into XML can reproduce the original layout.
+	unsigned char flags = 0;
+	flags |= node.binaryDataPresent? binaryNodeFlagBinaryDataPresent: 0;
+	flags |= (node.binaryDataPresent && !node.inlineBinaryData)? binaryNodeFlagSeparateBinaryData: 0;
+	buffer.push_back(flags);
+	WriteBinaryString(buffer, node.binaryDataName);
+	const unsigned char* nodeData;
+	size_t nodeDataSize;
+	node.GetBinaryDataView(nodeData, nodeDataSize);
+	WriteBinaryData(buffer, nodeData, nodeDataSize);
+
+	//Write child nodes
+	WriteBinaryUInt32(buffer, (unsigned int)node.children.size());
+	for(HierarchicalStorageNode::ChildList::const_iterator i = node.children.begin(); i != node.children.end(); ++i)
+	{
+		SaveNodeBinary(*(*i), buffer);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+bool HierarchicalStorageTree::LoadNodeBinary(HierarchicalStorageNode& node, const std::vector<unsigned char>& buffer, size_t& bufferPos, unsigned int nodeDepth)
+{
+	//Limit the depth of the tree, so that corrupt or hostile data can't exhaust the stack
+	//through recursion.
+	if(nodeDepth > binaryMaxNodeDepth)
+	{
+		std::wstringstream errorStream;
+		errorStream << L"Binary tree data exceeds the maximum node depth of " << binaryMaxNodeDepth << L" at offset " << bufferPos;
+		errorString = errorStream.str();
+		return false;
+	}
+
+	//Read the node name
+	std::wstring nodeName;
+	if(!ReadBinaryString(buffer, bufferPos, nodeName))
+	{
+		return false;
+	}
+	node.SetName(nodeName);
+
+	//Read attributes. Note that any count which couldn't fit in the remaining data is
+	//rejected before anything is created, so a corrupt count can't cause a large
+	//allocation. Child counts are checked in the same way below.
+	unsigned int attributeCount;
+	if(!ReadBinaryUInt32(buffer, bufferPos, attributeCount) || (((buffer.size() - bufferPos) / binaryMinAttributeSize) < attributeCount))
+	{
+		return false;
+	}
+	for(unsigned int i = 0; i < attributeCount; ++i)
+	{
+		std::wstring attributeName;
+		if(!ReadBinaryString(buffer, bufferPos, attributeName))
+		{
+			return false;
+		}
+		HierarchicalStorageAttribute& attribute = static_cast<HierarchicalStorageAttribute&>(node.CreateAttribute(attributeName));
+		if(!ReadBinaryStream(buffer, bufferPos, attribute.buffer))
+		{
+			return false;
+		}
+	}
+
+	//Read data
+	if(bufferPos >= buffer.size())
+	{
+		return false;
+	}
+	unsigned char flags = buffer[bufferPos++];
+	node.binaryDataPresent = (flags & binaryNodeFlagBinaryDataPresent) != 0;
+	node.inlineBinaryData = node.binaryDataPresent && ((flags & binaryNodeFlagSeparateBinaryData) == 0);
+	if(!ReadBinaryString(buffer, bufferPos, node.binaryDataName) || !ReadBinaryStream(buffer, bufferPos, node.dataStream))
+	{
+		return false;
+	}
+
+	//Read child nodes
+	unsigned int childCount;
+	if(!ReadBinaryUInt32(buffer, bufferPos, childCount) || (((buffer.size() - bufferPos) / binaryMinNodeSize) < childCount))
+	{
+		return false;
+	}
+	for(unsigned int i = 0; i < childCount; ++i)
+	{
+		HierarchicalStorageNode& child = static_cast<HierarchicalStorageNode&>(node.CreateChild());
+		if(!LoadNodeBinary(child, buffer, bufferPos, nodeDepth + 1))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+void HierarchicalStorageTree::WriteBinaryUInt32(std::vector<unsigned char>& buffer, unsigned int data)
+{
+	buffer.push_back((unsigned char)(data & 0xFF));
+	buffer.push_back((unsigned char)((data >> 8) & 0xFF));
+	buffer.push_back((unsigned char)((data >> 16) & 0xFF));
+	buffer.push_back((unsigned char)((data >> 24) & 0xFF));
+}
+
+//----------------------------------------------------------------------------------------
+void HierarchicalStorageTree::WriteBinaryString(std::vector<unsigned char>& buffer, const std::wstring& data)
+{
+	WriteBinaryUInt32(buffer, (unsigned int)data.size());
+	for(size_t i = 0; i < data.size(); ++i)
+	{
+		unsigned int character = (unsigned int)data[i];
+		buffer.push_back((unsigned char)(character & 0xFF));
+		buffer.push_back((unsigned char)((character >> 8) & 0xFF));
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void HierarchicalStorageTree::WriteBinaryStream(std::vector<unsigned char>& buffer, const Stream::Buffer& stream)
+{
+	WriteBinaryData(buffer, stream.GetRawBuffer(), (size_t)stream.Size());
+}
+
+//----------------------------------------------------------------------------------------
+void HierarchicalStorageTree::WriteBinaryData(std::vector<unsigned char>& buffer, const unsigned char* data, size_t dataSize)
+{
+	WriteBinaryUInt32(buffer, (unsigned int)dataSize);
+	if(dataSize > 0)
+	{
+		buffer.insert(buffer.end(), data, data + dataSize);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+bool HierarchicalStorageTree::ReadBinaryUInt32(const std::vector<unsigned char>& buffer, size_t& bufferPos, unsigned int& data)
+{
+	if((buffer.size() - bufferPos) < 4)
+	{
+		return false;
+	}
+	data = (unsigned int)buffer[bufferPos] | ((unsigned int)buffer[bufferPos + 1] << 8) | ((unsigned int)buffer[bufferPos + 2] << 16) | ((unsigned int)buffer[bufferPos + 3] << 24);
+	bufferPos += 4;
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+bool HierarchicalStorageTree::ReadBinaryString(const std::vector<unsigned char>& buffer, size_t& bufferPos, std::wstring& data)
+{
+	unsigned int characterCount;
+	if(!ReadBinaryUInt32(buffer, bufferPos, characterCount) || (((buffer.size() - bufferPos) / 2) < characterCount))
+	{
+		return false;
+	}
+	data.resize(characterCount);
+	for(unsigned int i = 0; i < characterCount; ++i)
+	{
+		data[i] = (wchar_t)((unsigned int)buffer[bufferPos] | ((unsigned int)buffer[bufferPos + 1] << 8));
+		bufferPos += 2;
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+bool HierarchicalStorageTree::ReadBinaryStream(const std::vector<unsigned char>& buffer, size_t& bufferPos, Stream::Buffer& stream)
+{
+	unsigned int streamSize;
+	if(!ReadBinaryUInt32(buffer, bufferPos, streamSize) || ((buffer.size() - bufferPos) < streamSize))
+	{
+		return false;
+	}
+	stream.Resize(streamSize);
+	stream.SetStreamPos(0);
+	if(streamSize > 0)
+	{
+		memcpy(stream.GetRawBuffer(), &buffer[bufferPos], streamSize);
+		bufferPos += streamSize;
+	}
+	return true;
+}
+
 //----------------------------------------------------------------------------------------
 //Storage mode functions
 //----------------------------------------------------------------------------------------
@@ -332,6 +661,17 @@ MarshalSupport::Marshal::Ret<std::list<IHierarchicalStorageNode*>> HierarchicalS
 	return binaryEntityList;
 }
 
+//----------------------------------------------------------------------------------------
+//Binary data reference functions
+//----------------------------------------------------------------------------------------
+void HierarchicalStorageTree::MaterializeBinaryDataReferences()
+{
+	//Take a copy of all external binary data referenced by nodes in this tree. This
+	//allows the tree to outlive the memory its nodes were built from, such as when the
+	//tree is saved after the owning devices have resumed execution.
+	root->MaterializeBinaryDataReferences();
+}
+
 //----------------------------------------------------------------------------------------
 //Reserved character substitution functions
 //----------------------------------------------------------------------------------------
@@ -16,7 +16,6 @@ public:
 	void Initialize();
 
 	//Save/Load functions
-	//##TODO## Take the storage mode into account when saving and loading
 	virtual bool SaveTree(Stream::IStream& target);
 	virtual bool LoadTree(Stream::IStream& source);
 
@@ -33,6 +32,9 @@ public:
 	virtual IHierarchicalStorageNode& GetRootNode() const;
 	virtual MarshalSupport::Marshal::Ret<std::list<IHierarchicalStorageNode*>> GetBinaryDataNodeList();
 
+	//Binary data reference functions
+	void MaterializeBinaryDataReferences();
+
 private:
 	//Save/Load functions
 	bool SaveNode(IHierarchicalStorageNode& node, Stream::IStream& stream, const std::wstring& indentPrefix) const;
@@ -40,14 +42,39 @@ private:
 	static void XMLCALL LoadEndElement(void *userData, const XML_Char *aname);
 	static void XMLCALL LoadData(void *userData, const XML_Char *s, int len);
 
+	//Binary save/load functions
+	bool SaveTreeBinary(Stream::IStream& target) const;
+	bool LoadTreeBinary(Stream::IStream& source);
+	void SaveNodeBinary(const HierarchicalStorageNode& node, std::vector<unsigned char>& buffer) const;
+	bool LoadNodeBinary(HierarchicalStorageNode& node, const std::vector<unsigned char>& buffer, size_t& bufferPos, unsigned int nodeDepth);
+	static void WriteBinaryUInt32(std::vector<unsigned char>& buffer, unsigned int data);
+	static void WriteBinaryString(std::vector<unsigned char>& buffer, const std::wstring& data);
+	static void WriteBinaryStream(std::vector<unsigned char>& buffer, const Stream::Buffer& stream);
+	static void WriteBinaryData(std::vector<unsigned char>& buffer, const unsigned char* data, size_t dataSize);
+	static bool ReadBinaryUInt32(const std::vector<unsigned char>& buffer, size_t& bufferPos, unsigned int& data);
+	static bool ReadBinaryString(const std::vector<unsigned char>& buffer, size_t& bufferPos, std::wstring& data);
+	static bool ReadBinaryStream(const std::vector<unsigned char>& buffer, size_t& bufferPos, Stream::Buffer& stream);
+
 	//Reserved character substitution functions
 	bool IsCharacterReserved(wchar_t character) const;
 	std::wstring GetNumericCharacterReference(wchar_t character) const;
 
+private:
+	//Constants
+	static const unsigned int binaryFormatSignature = 0x53425845;
+	static const unsigned int binaryFormatVersion = 1;
+	static const unsigned char binaryNodeFlagBinaryDataPresent = 0x01;
+	static const unsigned char binaryNodeFlagSeparateBinaryData = 0x02;
+	static const unsigned int binaryMaxNodeDepth = 256;
+	static const unsigned int binaryMinAttributeSize = 4 + 4;
+	static const unsigned int binaryMinNodeSize = 4 + 4 + 1 + 4 + 4 + 4;
+	static const int xmlParseBufferCharCount = 16*1024;
+
 private:
 	StorageMode storageMode;
 	HierarchicalStorageNode* root;
 	IHierarchicalStorageNode* currentNodeDuringLoad;
+	std::wstring pendingInlineBinaryDataDuringLoad;
 	mutable std::wstring errorString;
 	bool allowSeparateBinaryData;
 };
@@ -0,0 +1,193 @@
+#include "catch.hpp"
+#include "HierarchicalStorage/HierarchicalStorage.pkg"
+#include <chrono>
+#include <cstdlib>
+#include <list>
+#include <new>
+#include <sstream>
+#include <vector>
+
+//----------------------------------------------------------------------------------------
+//Allocation tracking
+//----------------------------------------------------------------------------------------
+//We replace the global allocation functions for this test, so that we can measure how
+//much heap memory remains allocated after nodes and attributes are deleted. The size of
+//each allocation is stored in a header in front of it, so that it can be subtracted again
+//when the allocation is freed.
+//----------------------------------------------------------------------------------------
+static const size_t allocationHeaderSize = 16;
+static long long liveAllocatedByteCount = 0;
+
+//----------------------------------------------------------------------------------------
+void* operator new(size_t size)
+{
+	unsigned char* allocation = (unsigned char*)std::malloc(size + allocationHeaderSize);
+	if(allocation == 0)
+	{
+		throw std::bad_alloc();
+	}
+	*((size_t*)allocation) = size;
+	liveAllocatedByteCount += (long long)size;
+	return allocation + allocationHeaderSize;
+}
+
+//----------------------------------------------------------------------------------------
+void operator delete(void* allocation) throw()
+{
+	if(allocation != 0)
+	{
+		unsigned char* allocationStart = (unsigned char*)allocation - allocationHeaderSize;
+		liveAllocatedByteCount -= (long long)*((size_t*)allocationStart);
+		std::free(allocationStart);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Test helpers
+//----------------------------------------------------------------------------------------
+//Builds a node with the kind of content a device writes into a savestate, including
+//attributes, child nodes, text data, and binary data. All content is held in heap memory
+//owned by the node and its children, rather than in the arena.
+//----------------------------------------------------------------------------------------
+static void BuildDeviceNode(IHierarchicalStorageNode& node, const std::vector<unsigned char>& binaryData)
+{
+	node.CreateAttribute(L"DeviceInstanceName", std::wstring(256, L'D'));
+	node.CreateAttribute(L"ModuleID", 1);
+	for(unsigned int i = 0; i < 8; ++i)
+	{
+		IHierarchicalStorageNode& registerNode = node.CreateChild(L"Register");
+		registerNode.CreateAttribute(L"name", std::wstring(L"Register"));
+		registerNode.SetData(std::wstring(64, L'0'));
+	}
+	node.CreateChild(L"Memory").InsertBinaryData(binaryData, L"Memory", false);
+}
+
+//----------------------------------------------------------------------------------------
+//Node deletion tests
+//----------------------------------------------------------------------------------------
+//Nodes and attributes are allocated from the arena owned by the tree, and their memory
+//isn't released until the tree is destroyed. Their content, such as child lists, names,
+//text data, and binary data, is allocated separately though, and must be released as
+//soon as they're deleted. We delete the same content repeatedly, so that any content
+//which isn't released accumulates to far more memory than the arena grows by.
+//----------------------------------------------------------------------------------------
+TEST_CASE("HierarchicalStorageNode::DeleteChild", "")
+{
+	const unsigned int iterationCount = 100;
+	const size_t binaryDataSize = 256 * 1024;
+	std::vector<unsigned char> binaryData(binaryDataSize, 0x5A);
+
+	SECTION("Deleting a child releases its content")
+	{
+		HierarchicalStorageTree tree;
+		IHierarchicalStorageNode& rootNode = tree.GetRootNode();
+		BuildDeviceNode(rootNode.CreateChild(L"Device"), binaryData);
+		rootNode.DeleteChild(*rootNode.GetChild(L"Device"));
+		long long initialLiveAllocatedByteCount = liveAllocatedByteCount;
+		for(unsigned int i = 0; i < iterationCount; ++i)
+		{
+			IHierarchicalStorageNode& deviceNode = rootNode.CreateChild(L"Device");
+			BuildDeviceNode(deviceNode, binaryData);
+			rootNode.DeleteChild(deviceNode);
+		}
+		long long retainedByteCount = liveAllocatedByteCount - initialLiveAllocatedByteCount;
+		INFO("Retained bytes: " << retainedByteCount);
+		REQUIRE(retainedByteCount < (long long)((iterationCount * binaryDataSize) / 8));
+		REQUIRE(rootNode.GetChild(L"Device") == 0);
+	}
+
+	SECTION("Children which aren't deleted are unaffected")
+	{
+		HierarchicalStorageTree tree;
+		IHierarchicalStorageNode& rootNode = tree.GetRootNode();
+		IHierarchicalStorageNode& firstNode = rootNode.CreateChild(L"First");
+		IHierarchicalStorageNode& deletedNode = rootNode.CreateChild(L"Deleted");
+		IHierarchicalStorageNode& lastNode = rootNode.CreateChild(L"Last");
+		firstNode.SetData(std::wstring(L"FirstData"));
+		BuildDeviceNode(deletedNode, binaryData);
+		lastNode.SetData(std::wstring(L"LastData"));
+		rootNode.DeleteChild(deletedNode);
+		std::list<IHierarchicalStorageNode*> childList = rootNode.GetChildList();
+		REQUIRE(childList.size() == 2);
+		REQUIRE(rootNode.GetChild(L"First") == &firstNode);
+		REQUIRE(rootNode.GetChild(L"Deleted") == 0);
+		REQUIRE(rootNode.GetChild(L"Last") == &lastNode);
+		REQUIRE(firstNode.GetData() == L"FirstData");
+		REQUIRE(lastNode.GetData() == L"LastData");
+	}
+}
+
+//----------------------------------------------------------------------------------------
+TEST_CASE("HierarchicalStorageNode::DeleteAttribute", "")
+{
+	const unsigned int iterationCount = 200;
+	const size_t attributeValueLength = 16 * 1024;
+
+	SECTION("Deleting an attribute releases its content")
+	{
+		HierarchicalStorageTree tree;
+		IHierarchicalStorageNode& node = tree.GetRootNode().CreateChild(L"Device");
+		node.CreateAttribute(L"Value", std::wstring(attributeValueLength, L'V'));
+		node.DeleteAttribute(*node.GetAttribute(L"Value"));
+		long long initialLiveAllocatedByteCount = liveAllocatedByteCount;
+		for(unsigned int i = 0; i < iterationCount; ++i)
+		{
+			node.CreateAttribute(L"Value", std::wstring(attributeValueLength, L'V'));
+			node.DeleteAttribute(*node.GetAttribute(L"Value"));
+		}
+		long long retainedByteCount = liveAllocatedByteCount - initialLiveAllocatedByteCount;
+		INFO("Retained bytes: " << retainedByteCount);
+		REQUIRE(retainedByteCount < (long long)((iterationCount * attributeValueLength * sizeof(wchar_t)) / 8));
+		REQUIRE(node.GetAttribute(L"Value") == 0);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+TEST_CASE("HierarchicalStorageTree benchmark", "[.][benchmark]")
+{
+	//Measure the time taken to build and destroy a tree shaped like a savestate, with a
+	//large number of device nodes holding attributes, register values, and binary data,
+	//and the time taken to replace every device node in an existing tree.
+	const unsigned int treeCount = 20;
+	const unsigned int deviceCount = 200;
+	std::vector<unsigned char> binaryData(4 * 1024, 0x5A);
+
+	std::chrono::high_resolution_clock::time_point buildStartTime = std::chrono::high_resolution_clock::now();
+	for(unsigned int treeNo = 0; treeNo < treeCount; ++treeNo)
+	{
+		HierarchicalStorageTree tree;
+		IHierarchicalStorageNode& rootNode = tree.GetRootNode();
+		for(unsigned int deviceNo = 0; deviceNo < deviceCount; ++deviceNo)
+		{
+			BuildDeviceNode(rootNode.CreateChild(L"Device"), binaryData);
+		}
+	}
+	std::chrono::high_resolution_clock::time_point buildEndTime = std::chrono::high_resolution_clock::now();
+
+	HierarchicalStorageTree tree;
+	IHierarchicalStorageNode& rootNode = tree.GetRootNode();
+	std::vector<IHierarchicalStorageNode*> deviceNodes;
+	for(unsigned int deviceNo = 0; deviceNo < deviceCount; ++deviceNo)
+	{
+		deviceNodes.push_back(&rootNode.CreateChild(L"Device"));
+		BuildDeviceNode(*deviceNodes.back(), binaryData);
+	}
+	long long initialLiveAllocatedByteCount = liveAllocatedByteCount;
+	std::chrono::high_resolution_clock::time_point replaceStartTime = std::chrono::high_resolution_clock::now();
+	for(unsigned int treeNo = 0; treeNo < treeCount; ++treeNo)
+	{
+		for(unsigned int deviceNo = 0; deviceNo < deviceCount; ++deviceNo)
+		{
+			rootNode.DeleteChild(*deviceNodes[deviceNo]);
+			deviceNodes[deviceNo] = &rootNode.CreateChild(L"Device");
+			BuildDeviceNode(*deviceNodes[deviceNo], binaryData);
+		}
+	}
+	std::chrono::high_resolution_clock::time_point replaceEndTime = std::chrono::high_resolution_clock::now();
+	long long retainedByteCount = liveAllocatedByteCount - initialLiveAllocatedByteCount;
+
+	std::stringstream results;
+	results << treeCount << " trees of " << deviceCount << " devices built and destroyed: " << std::chrono::duration_cast<std::chrono::microseconds>(buildEndTime - buildStartTime).count() << "us\n";
+	results << (treeCount * deviceCount) << " devices replaced: " << std::chrono::duration_cast<std::chrono::microseconds>(replaceEndTime - replaceStartTime).count() << "us, " << retainedByteCount << " bytes retained";
+	WARN(results.str());
+}
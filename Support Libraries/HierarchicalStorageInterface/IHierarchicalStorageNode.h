@@ -77,11 +77,24 @@ public:
 	//Binary data write functions
 	template<class T> IHierarchicalStorageNode& InsertBinaryData(const T& adata, const std::wstring& bufferName, bool ainlineBinaryData = true);
 	template<class T> IHierarchicalStorageNode& InsertBinaryData(const T* buffer, size_t entries, const std::wstring& bufferName, bool ainlineBinaryData = true);
+	inline IHierarchicalStorageNode& InsertBinaryDataReference(const unsigned char* buffer, size_t bufferSize, const std::wstring& bufferName, bool ainlineBinaryData = true);
 
 protected:
 	//Stream functions
 	virtual void ResetInternalStreamPosition() const = 0;
 	virtual Stream::IStream& GetInternalStream() const = 0;
+
+public:
+	//Interface version functions
+	//Note that the first version of this interface had no version function. Functions
+	//added since then are appended here, after all the original functions, so that the
+	//layout of the original interface is unchanged.
+	static inline unsigned int ThisIHierarchicalStorageNodeVersion() { return 2; }
+	virtual unsigned int GetIHierarchicalStorageNodeVersion() const = 0;
+
+	//Binary data view functions
+	virtual void SetBinaryDataReference(const unsigned char* data, size_t dataSize) = 0;
+	virtual void GetBinaryDataView(const unsigned char*& data, size_t& dataSize) const = 0;
 };
 
 #include "IHierarchicalStorageNode.inl"
@@ -219,3 +219,20 @@ template<class T> IHierarchicalStorageNode& IHierarchicalStorageNode::InsertBina
 	}
 	return *this;
 }
+
+//----------------------------------------------------------------------------------------
+//Stores a reference to a caller-owned block of memory as the binary data for this node,
+//replacing any existing data, rather than copying the data into the node. The referenced
+//memory must remain valid and unchanged until the tree has been saved, or the node is
+//destroyed. If the binary data is accessed through a stream before then, a copy of the
+//referenced data is taken at that point. Since no byte order conversion is performed,
+//this should only be used for byte-sized data.
+//----------------------------------------------------------------------------------------
+IHierarchicalStorageNode& IHierarchicalStorageNode::InsertBinaryDataReference(const unsigned char* buffer, size_t bufferSize, const std::wstring& bufferName, bool ainlineBinaryData)
+{
+	SetBinaryDataPresent(true);
+	SetInlineBinaryDataEnabled(ainlineBinaryData);
+	SetBinaryDataBufferName(bufferName);
+	SetBinaryDataReference(buffer, bufferSize);
+	return *this;
+}
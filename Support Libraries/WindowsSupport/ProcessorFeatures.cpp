@@ -0,0 +1,49 @@
+#include "ProcessorFeatures.h"
+#include <intrin.h>
+
+//----------------------------------------------------------------------------------------
+//Processor feature functions
+//----------------------------------------------------------------------------------------
+//Note that the AVX and AVX2 tests confirm both that the processor supports the
+//instructions, and that the operating system has enabled saving of the extended register
+//state. Both are required before any 256-bit instructions can safely be used.
+//----------------------------------------------------------------------------------------
+bool ProcessorSupportsSSE2()
+{
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 0);
+	if(cpuInfo[0] < 1)
+	{
+		return false;
+	}
+	__cpuid(cpuInfo, 1);
+	return ((cpuInfo[3] & (1 << 26)) != 0);
+}
+
+//----------------------------------------------------------------------------------------
+bool ProcessorSupportsAVX()
+{
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 0);
+	if(cpuInfo[0] < 1)
+	{
+		return false;
+	}
+	__cpuid(cpuInfo, 1);
+	bool osxsaveSupported = ((cpuInfo[2] & (1 << 27)) != 0);
+	bool avxSupported = ((cpuInfo[2] & (1 << 28)) != 0);
+	return osxsaveSupported && avxSupported && ((_xgetbv(0) & 0x6) == 0x6);
+}
+
+//----------------------------------------------------------------------------------------
+bool ProcessorSupportsAVX2()
+{
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 0);
+	if((cpuInfo[0] < 7) || !ProcessorSupportsAVX())
+	{
+		return false;
+	}
+	__cpuidex(cpuInfo, 7, 0);
+	return ((cpuInfo[1] & (1 << 5)) != 0);
+}
@@ -0,0 +1,9 @@
+#ifndef __PROCESSORFEATURES_H__
+#define __PROCESSORFEATURES_H__
+
+//Processor feature functions
+bool ProcessorSupportsSSE2();
+bool ProcessorSupportsAVX();
+bool ProcessorSupportsAVX2();
+
+#endif
@@ -138,6 +138,113 @@ bool DeflateCompress(Stream::IStream& source, Stream::IStream& target, unsigned
 	return true;
 }
 
+//----------------------------------------------------------------------------------------
+//Compresses one block of a larger deflate stream, so that a large data stream can be
+//divided into blocks which are compressed independently, and possibly concurrently. The
+//dictionary should contain the source data immediately preceding this block, up to the
+//32KB deflate window size, which allows matches to be found across the block boundary
+//in the same way they would be if the data was compressed as a single stream. All blocks
+//other than the final block are terminated with a sync flush, which ends the block on a
+//byte boundary without setting the final block flag, so the compressed output of each
+//block can simply be concatenated in order to form a single valid deflate stream.
+//----------------------------------------------------------------------------------------
+bool DeflateCompressBlock(const unsigned char* sourceData, unsigned int sourceSize, const unsigned char* dictionaryData, unsigned int dictionarySize, bool finalBlock, std::vector<unsigned char>& target, unsigned int& calculatedCRC)
+{
+	//Initialize zlib for compression. We use the same settings here as the
+	//DeflateCompress function, so that the compression ratio is comparable.
+	z_stream strm;
+	strm.next_in = Z_NULL;
+	strm.zalloc = Z_NULL;
+	strm.zfree = Z_NULL;
+	strm.opaque = Z_NULL;
+	if(deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 9, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		return false;
+	}
+
+	//Load the preceding source data into the compression window
+	if(dictionarySize > 0)
+	{
+		if(deflateSetDictionary(&strm, dictionaryData, dictionarySize) != Z_OK)
+		{
+			deflateEnd(&strm);
+			return false;
+		}
+	}
+
+	//Size our output buffer to hold the worst case compressed size for this block, with
+	//some extra space for the empty stored block written by a sync flush. The buffer will
+	//be grown if this isn't sufficient.
+	target.resize((size_t)deflateBound(&strm, sourceSize) + 16);
+	size_t targetDataSize = 0;
+
+	//Compress the data
+	int flushParam = finalBlock? Z_FINISH: Z_SYNC_FLUSH;
+	strm.next_in = (Bytef*)sourceData;
+	strm.avail_in = sourceSize;
+	bool done = false;
+	while(!done)
+	{
+		//Grow the output buffer if it's full
+		if(targetDataSize >= target.size())
+		{
+			target.resize(target.size() * 2);
+		}
+
+		//Compress the next block of source data
+		strm.next_out = &target[targetDataSize];
+		strm.avail_out = (uInt)(target.size() - targetDataSize);
+		int deflateResult = deflate(&strm, flushParam);
+		targetDataSize = target.size() - strm.avail_out;
+		if((deflateResult != Z_OK) && (deflateResult != Z_STREAM_END) && (deflateResult != Z_BUF_ERROR))
+		{
+			deflateEnd(&strm);
+			return false;
+		}
+
+		//A final block is complete once the end of the stream has been written. A sync
+		//flush is complete once deflate returns without filling the output buffer.
+		done = finalBlock? (deflateResult == Z_STREAM_END): (strm.avail_out > 0);
+	}
+	target.resize(targetDataSize);
+
+	//Clean up zlib. Note that deflateEnd reports an error when the stream hasn't been
+	//finished, which is always the case for a block other than the final block, so we
+	//only check the result for the final block.
+	int deflateEndResult = deflateEnd(&strm);
+	if(finalBlock && (deflateEndResult != Z_OK))
+	{
+		return false;
+	}
+
+	//Calculate the CRC of the source data in this block
+	uLong crc = crc32(0, Z_NULL, 0);
+	crc = crc32(crc, sourceData, sourceSize);
+	calculatedCRC = (unsigned int)crc;
+
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+//Calculates the CRC of two consecutive blocks of data from the CRC values of each block.
+//This is used to build the CRC for a data stream which was compressed in multiple blocks
+//with the DeflateCompressBlock function.
+//----------------------------------------------------------------------------------------
+unsigned int CombineCRC(unsigned int firstCRC, unsigned int secondCRC, unsigned int secondDataSize)
+{
+	return (unsigned int)crc32_combine(firstCRC, secondCRC, (z_off_t)secondDataSize);
+}
+
+//----------------------------------------------------------------------------------------
+//Calculates the CRC of a block of data which is stored without compression
+//----------------------------------------------------------------------------------------
+unsigned int CalculateCRC(const unsigned char* sourceData, unsigned int sourceSize)
+{
+	uLong crc = crc32(0, Z_NULL, 0);
+	crc = crc32(crc, sourceData, sourceSize);
+	return (unsigned int)crc;
+}
+
 //----------------------------------------------------------------------------------------
 bool DeflateDecompress(Stream::IStream& source, Stream::IStream& target, unsigned int& calculatedCRC, unsigned int inputCacheSize, unsigned int outputCacheSize)
 {
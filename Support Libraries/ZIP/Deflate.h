@@ -1,9 +1,13 @@
 #ifndef __DEFLATE_H__
 #define __DEFLATE_H__
+#include <vector>
 #include "StreamInterface/StreamInterface.pkg"
 namespace Deflate {
 
 bool DeflateCompress(Stream::IStream& source, Stream::IStream& target, unsigned int& calculatedCRC, unsigned int inputCacheSize = 0, unsigned int outputCacheSize = 0);
+bool DeflateCompressBlock(const unsigned char* sourceData, unsigned int sourceSize, const unsigned char* dictionaryData, unsigned int dictionarySize, bool finalBlock, std::vector<unsigned char>& target, unsigned int& calculatedCRC);
+unsigned int CombineCRC(unsigned int firstCRC, unsigned int secondCRC, unsigned int secondDataSize);
+unsigned int CalculateCRC(const unsigned char* sourceData, unsigned int sourceSize);
 bool DeflateDecompress(Stream::IStream& source, Stream::IStream& target, unsigned int& calculatedCRC, unsigned int inputCacheSize = 0, unsigned int outputCacheSize = 0);
 
 } //Close namespace Deflate
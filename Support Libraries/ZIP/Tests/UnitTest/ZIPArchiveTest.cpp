@@ -0,0 +1,176 @@
+#include "catch.hpp"
+#include "ZIP/ZIP.pkg"
+#include "Stream/Stream.pkg"
+#include "WindowsSupport/WindowsSupport.pkg"
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <vector>
+
+//----------------------------------------------------------------------------------------
+//Test helpers
+//----------------------------------------------------------------------------------------
+//Builds an archive laid out in the same way as a savestate. A small stored info file
+//comes first, followed by a compressed screenshot, then the compressed state tree and a
+//large compressed memory image.
+//----------------------------------------------------------------------------------------
+static bool WriteSavestateArchive(Stream::IStream& target, unsigned int seed)
+{
+	std::mt19937 random(seed);
+
+	//Add the info file, stored without compression
+	std::stringstream infoText;
+	infoText << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<Info CreationDate=\"2026-10-19\" CreationTime=\"12:00:" << (seed % 60) << "\" DebuggerState=\"0\" Screenshot=\"screenshot.png\" />\n";
+	std::string infoString = infoText.str();
+	Stream::Buffer infoBuffer(0);
+	infoBuffer.WriteData((const unsigned char*)infoString.data(), (Stream::IStream::SizeType)infoString.size());
+	infoBuffer.SetStreamPos(0);
+	ZIPArchive archive;
+	ZIPFileEntry infoEntry;
+	infoEntry.SetFileName(L"info.xml");
+	if(!infoEntry.Store(infoBuffer))
+	{
+		return false;
+	}
+	archive.AddFileEntry(infoEntry);
+
+	//Add the screenshot, compressed on its own
+	Stream::Buffer screenshotBuffer(0);
+	for(unsigned int i = 0; i < (32 * 1024); ++i)
+	{
+		screenshotBuffer.WriteData((unsigned char)(((i % 320) < 160)? (random() & 0x0F): 0x80));
+	}
+	screenshotBuffer.SetStreamPos(0);
+	ZIPFileEntry screenshotEntry;
+	screenshotEntry.SetFileName(L"screenshot.png");
+	if(!screenshotEntry.Compress(screenshotBuffer))
+	{
+		return false;
+	}
+	archive.AddFileEntry(screenshotEntry);
+
+	//Add the state tree and memory image
+	std::vector<unsigned char> stateData(256 * 1024);
+	for(size_t i = 0; i < stateData.size(); ++i)
+	{
+		stateData[i] = (unsigned char)(((i % 64) < 48)? ('A' + (i % 26)): (random() & 0xFF));
+	}
+	std::vector<unsigned char> memoryData(4 * 1024 * 1024);
+	for(size_t i = 0; i < memoryData.size(); ++i)
+	{
+		memoryData[i] = (unsigned char)(((i % 16) < 12)? 0: (random() & 0xFF));
+	}
+	ZIPParallelCompressor compressor;
+	compressor.AddFileEntry(L"save.xml", &stateData[0], stateData.size());
+	compressor.AddFileEntry(L"Memory.bin", &memoryData[0], memoryData.size());
+	if(!compressor.CompressFileEntries(archive))
+	{
+		return false;
+	}
+	return archive.SaveToStream(target);
+}
+
+//----------------------------------------------------------------------------------------
+static std::wstring GetSlotFilePath(unsigned int slotNo)
+{
+	std::wstringstream filePath;
+	filePath << L"ZIPArchiveTestSlot" << slotNo << L".zip";
+	return filePath.str();
+}
+
+//----------------------------------------------------------------------------------------
+//File entry tests
+//----------------------------------------------------------------------------------------
+TEST_CASE("ZIPArchive::LoadFileEntryFromStream", "")
+{
+	Stream::Buffer archiveData(0);
+	REQUIRE(WriteSavestateArchive(archiveData, 1));
+
+	SECTION("Stored entries at the start of the archive are found")
+	{
+		archiveData.SetStreamPos(0);
+		ZIPFileEntry entry;
+		REQUIRE(ZIPArchive::LoadFileEntryFromStream(archiveData, L"info.xml", entry));
+		Stream::Buffer entryData(0);
+		REQUIRE(entry.Decompress(entryData));
+		REQUIRE(entryData.Size() > 0);
+		REQUIRE(entryData.GetRawBuffer()[0] == '<');
+	}
+
+	SECTION("Compressed entries later in the archive are found")
+	{
+		archiveData.SetStreamPos(0);
+		ZIPFileEntry entry;
+		REQUIRE(ZIPArchive::LoadFileEntryFromStream(archiveData, L"Memory.bin", entry));
+		Stream::Buffer entryData(0);
+		REQUIRE(entry.Decompress(entryData));
+		REQUIRE(entryData.Size() == (4 * 1024 * 1024));
+	}
+
+	SECTION("Missing entries aren't found")
+	{
+		archiveData.SetStreamPos(0);
+		ZIPFileEntry entry;
+		REQUIRE(!ZIPArchive::LoadFileEntryFromStream(archiveData, L"missing.xml", entry));
+	}
+}
+
+//----------------------------------------------------------------------------------------
+TEST_CASE("ZIPArchive::LoadFileEntryFromStream benchmark", "[.][benchmark]")
+{
+	//Measure the time taken to read the info file from 100 savestate slots on disk, in the
+	//same way as the save slot list does, and compare it against loading each archive in
+	//full in order to read the same file.
+	const unsigned int slotCount = 100;
+	for(unsigned int slotNo = 0; slotNo < slotCount; ++slotNo)
+	{
+		Stream::File file;
+		REQUIRE(file.Open(GetSlotFilePath(slotNo), Stream::File::OpenMode::ReadAndWrite, Stream::File::CreateMode::Create));
+		REQUIRE(WriteSavestateArchive(file, slotNo));
+		file.Close();
+	}
+
+	unsigned int infoFilesFound = 0;
+	std::chrono::high_resolution_clock::time_point listingStartTime = std::chrono::high_resolution_clock::now();
+	for(unsigned int slotNo = 0; slotNo < slotCount; ++slotNo)
+	{
+		Stream::File file;
+		ZIPFileEntry entry;
+		Stream::Buffer entryData(0);
+		if(file.Open(GetSlotFilePath(slotNo), Stream::File::OpenMode::ReadOnly, Stream::File::CreateMode::Open) && ZIPArchive::LoadFileEntryFromStream(file, L"info.xml", entry) && entry.Decompress(entryData))
+		{
+			++infoFilesFound;
+		}
+	}
+	std::chrono::high_resolution_clock::time_point listingEndTime = std::chrono::high_resolution_clock::now();
+
+	unsigned int fullLoadInfoFilesFound = 0;
+	std::chrono::high_resolution_clock::time_point fullLoadStartTime = std::chrono::high_resolution_clock::now();
+	for(unsigned int slotNo = 0; slotNo < slotCount; ++slotNo)
+	{
+		Stream::File file;
+		ZIPArchive archive;
+		Stream::Buffer entryData(0);
+		if(file.Open(GetSlotFilePath(slotNo), Stream::File::OpenMode::ReadOnly, Stream::File::CreateMode::Open) && archive.LoadFromStream(file))
+		{
+			ZIPFileEntry* entry = archive.GetFileEntry(L"info.xml");
+			if((entry != 0) && entry->Decompress(entryData))
+			{
+				++fullLoadInfoFilesFound;
+			}
+		}
+	}
+	std::chrono::high_resolution_clock::time_point fullLoadEndTime = std::chrono::high_resolution_clock::now();
+
+	for(unsigned int slotNo = 0; slotNo < slotCount; ++slotNo)
+	{
+		DeleteFile(GetSlotFilePath(slotNo).c_str());
+	}
+
+	long long listingTime = std::chrono::duration_cast<std::chrono::microseconds>(listingEndTime - listingStartTime).count();
+	long long fullLoadTime = std::chrono::duration_cast<std::chrono::microseconds>(fullLoadEndTime - fullLoadStartTime).count();
+	REQUIRE(infoFilesFound == slotCount);
+	REQUIRE(fullLoadInfoFilesFound == slotCount);
+	WARN(slotCount << " slots, info file only: " << listingTime << "us, full archive: " << fullLoadTime << "us");
+	REQUIRE(listingTime < fullLoadTime);
+}
@@ -0,0 +1,201 @@
+#include "catch.hpp"
+#include "ZIP/ZIP.pkg"
+#include "Stream/Stream.pkg"
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------
+//Test helpers
+//----------------------------------------------------------------------------------------
+//Builds data which compresses roughly as well as a device memory image, with repeated
+//runs of bytes and copies of earlier data broken up by random bytes.
+//----------------------------------------------------------------------------------------
+static std::vector<unsigned char> BuildEntryData(size_t dataSize, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	std::vector<unsigned char> data(dataSize);
+	size_t dataPos = 0;
+	while(dataPos < dataSize)
+	{
+		size_t runLength = 1 + (random() % 64);
+		runLength = ((dataPos + runLength) > dataSize)? (dataSize - dataPos): runLength;
+		switch(random() % 3)
+		{
+		case 0:{
+			unsigned char runValue = (unsigned char)random();
+			for(size_t i = 0; i < runLength; ++i)
+			{
+				data[dataPos + i] = runValue;
+			}
+			break;}
+		case 1:
+			for(size_t i = 0; i < runLength; ++i)
+			{
+				data[dataPos + i] = (unsigned char)random();
+			}
+			break;
+		case 2:{
+			size_t copyDistance = 1 + (random() % 4096);
+			for(size_t i = 0; i < runLength; ++i)
+			{
+				data[dataPos + i] = (copyDistance <= (dataPos + i))? data[dataPos + i - copyDistance]: (unsigned char)random();
+			}
+			break;}
+		}
+		dataPos += runLength;
+	}
+	return data;
+}
+
+//----------------------------------------------------------------------------------------
+//Builds a set of entries shaped like a savestate, with many small device entries and a
+//few large memory images.
+//----------------------------------------------------------------------------------------
+static std::vector<std::vector<unsigned char>> BuildSavestateEntries(unsigned int smallEntryCount, unsigned int largeEntryCount, size_t largeEntrySize)
+{
+	std::mt19937 random(1);
+	std::vector<std::vector<unsigned char>> entries;
+	for(unsigned int entryNo = 0; entryNo < smallEntryCount; ++entryNo)
+	{
+		entries.push_back(BuildEntryData(random() % (64 * 1024), entryNo));
+	}
+	for(unsigned int entryNo = 0; entryNo < largeEntryCount; ++entryNo)
+	{
+		entries.push_back(BuildEntryData(largeEntrySize, smallEntryCount + entryNo));
+	}
+	entries.push_back(std::vector<unsigned char>());
+	return entries;
+}
+
+//----------------------------------------------------------------------------------------
+static std::wstring GetEntryName(unsigned int entryNo)
+{
+	std::wstringstream entryName;
+	entryName << L"Entry" << entryNo << L".bin";
+	return entryName.str();
+}
+
+//----------------------------------------------------------------------------------------
+//Compresses the entries using the specified number of threads, and returns the saved
+//archive data.
+//----------------------------------------------------------------------------------------
+static bool WriteArchive(const std::vector<std::vector<unsigned char>>& entries, unsigned int threadCount, Stream::Buffer& archiveData)
+{
+	ZIPParallelCompressor compressor(threadCount);
+	for(unsigned int entryNo = 0; entryNo < (unsigned int)entries.size(); ++entryNo)
+	{
+		compressor.AddFileEntry(GetEntryName(entryNo), (entries[entryNo].empty()? 0: &entries[entryNo][0]), entries[entryNo].size());
+	}
+	ZIPArchive archive;
+	if(!compressor.CompressFileEntries(archive))
+	{
+		return false;
+	}
+	return archive.SaveToStream(archiveData);
+}
+
+//----------------------------------------------------------------------------------------
+//Compression tests
+//----------------------------------------------------------------------------------------
+TEST_CASE("ZIPParallelCompressor::CompressFileEntries", "")
+{
+	std::vector<std::vector<unsigned char>> entries = BuildSavestateEntries(24, 2, 1024 * 1024);
+	unsigned int hardwareThreadCount = std::thread::hardware_concurrency();
+	hardwareThreadCount = (hardwareThreadCount > 1)? hardwareThreadCount: 2;
+
+	SECTION("Entries decompress to the source data")
+	{
+		Stream::Buffer archiveData(0);
+		REQUIRE(WriteArchive(entries, hardwareThreadCount, archiveData));
+		archiveData.SetStreamPos(0);
+		ZIPArchive archive;
+		REQUIRE(archive.LoadFromStream(archiveData));
+		REQUIRE(archive.GetFileEntryCount() == (unsigned int)entries.size());
+
+		unsigned int mismatchCount = 0;
+		std::string firstMismatch;
+		for(unsigned int entryNo = 0; entryNo < (unsigned int)entries.size(); ++entryNo)
+		{
+			ZIPFileEntry* entry = archive.GetFileEntry(GetEntryName(entryNo));
+			REQUIRE(entry != 0);
+			Stream::Buffer decompressedData(0);
+			REQUIRE(entry->Decompress(decompressedData));
+			bool entryMatches = ((size_t)decompressedData.Size() == entries[entryNo].size());
+			for(size_t i = 0; entryMatches && (i < entries[entryNo].size()); ++i)
+			{
+				entryMatches = (decompressedData.GetRawBuffer()[i] == entries[entryNo][i]);
+			}
+			if(!entryMatches)
+			{
+				if(mismatchCount == 0)
+				{
+					std::stringstream message;
+					message << "Entry " << entryNo << ": source size " << entries[entryNo].size() << ", decompressed size " << decompressedData.Size();
+					firstMismatch = message.str();
+				}
+				++mismatchCount;
+			}
+		}
+		INFO(firstMismatch);
+		REQUIRE(mismatchCount == 0);
+	}
+
+	SECTION("The archive is the same for every thread count")
+	{
+		//Each block is compressed with the same dictionary regardless of which thread
+		//compresses it, so the archive should be byte for byte identical no matter how
+		//many threads were used.
+		Stream::Buffer singleThreadArchiveData(0);
+		REQUIRE(WriteArchive(entries, 1, singleThreadArchiveData));
+		Stream::Buffer multiThreadArchiveData(0);
+		REQUIRE(WriteArchive(entries, hardwareThreadCount, multiThreadArchiveData));
+		REQUIRE(multiThreadArchiveData.Size() == singleThreadArchiveData.Size());
+		unsigned int mismatchCount = 0;
+		for(Stream::IStream::SizeType i = 0; i < singleThreadArchiveData.Size(); ++i)
+		{
+			mismatchCount += (multiThreadArchiveData.GetRawBuffer()[i] != singleThreadArchiveData.GetRawBuffer()[i])? 1: 0;
+		}
+		REQUIRE(mismatchCount == 0);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+TEST_CASE("ZIPParallelCompressor::CompressFileEntries benchmark", "[.][benchmark]")
+{
+	//Measure the time taken to write a savestate sized archive with one thread, then with
+	//each doubling of the thread count up to the number of hardware threads. We take the
+	//best of several runs for each thread count, so that a single slow run caused by other
+	//activity on the machine doesn't distort the result.
+	const unsigned int runCount = 3;
+	std::vector<std::vector<unsigned char>> entries = BuildSavestateEntries(64, 2, 4 * 1024 * 1024);
+	unsigned int hardwareThreadCount = std::thread::hardware_concurrency();
+	hardwareThreadCount = (hardwareThreadCount > 0)? hardwareThreadCount: 1;
+	std::vector<unsigned int> threadCounts;
+	for(unsigned int threadCount = 1; threadCount < hardwareThreadCount; threadCount *= 2)
+	{
+		threadCounts.push_back(threadCount);
+	}
+	threadCounts.push_back(hardwareThreadCount);
+
+	long long singleThreadTime = 0;
+	std::stringstream results;
+	for(unsigned int i = 0; i < (unsigned int)threadCounts.size(); ++i)
+	{
+		long long bestTime = 0;
+		for(unsigned int runNo = 0; runNo < runCount; ++runNo)
+		{
+			Stream::Buffer archiveData(0);
+			std::chrono::high_resolution_clock::time_point startTime = std::chrono::high_resolution_clock::now();
+			REQUIRE(WriteArchive(entries, threadCounts[i], archiveData));
+			std::chrono::high_resolution_clock::time_point endTime = std::chrono::high_resolution_clock::now();
+			long long runTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+			bestTime = ((runNo == 0) || (runTime < bestTime))? runTime: bestTime;
+		}
+		singleThreadTime = (i == 0)? bestTime: singleThreadTime;
+		results << threadCounts[i] << " threads: " << bestTime << "us (" << ((double)singleThreadTime / (double)((bestTime > 0)? bestTime: 1)) << "x)\n";
+	}
+	WARN(results.str());
+}
@@ -103,6 +103,51 @@ bool ZIPArchive::SaveToStream(Stream::IStream& target)
 	return true;
 }
 
+//----------------------------------------------------------------------------------------
+bool ZIPArchive::LoadFileEntryFromStream(Stream::IStream& source, const std::wstring& fileName, ZIPFileEntry& fileEntry)
+{
+	//Walk the local file headers from the current position in the stream, seeking past
+	//the data for each file until we find the target file. Only the data for the target
+	//file is read, so a file which is placed near the start of an archive can be
+	//retrieved without loading the rest of the archive.
+	while(true)
+	{
+		//Stop if we've reached the end of the file records in the archive
+		Stream::IStream::SizeType headerPos = source.GetStreamPos();
+		unsigned int chunkID;
+		if(!source.ReadData(chunkID) || (chunkID != ZIPChunk_LocalFileHeader::validSignature))
+		{
+			return false;
+		}
+		source.SetStreamPos(headerPos);
+
+		//Load the local file header for this file
+		ZIPChunk_LocalFileHeader header;
+		if(!header.LoadFromStream(source))
+		{
+			return false;
+		}
+
+		//If this is the target file, load the file entry in full.
+		if(header.fileName == fileName)
+		{
+			source.SetStreamPos(headerPos);
+			return fileEntry.LoadFromStream(source);
+		}
+
+		//If the size of the data for this file is held in a data descriptor following the
+		//data, we can't locate the next header without decoding the data, so we abort.
+		//Note that we never write archives in this form ourselves.
+		if((header.bitFlags & 0x08) != 0)
+		{
+			return false;
+		}
+
+		//Skip the data for this file
+		source.SetStreamPos(source.GetStreamPos() + header.compressedSize);
+	}
+}
+
 //----------------------------------------------------------------------------------------
 //File entry functions
 //----------------------------------------------------------------------------------------
@@ -68,6 +68,7 @@ public:
 	//Serialization functions
 	bool LoadFromStream(Stream::IStream& source);
 	bool SaveToStream(Stream::IStream& target);
+	static bool LoadFileEntryFromStream(Stream::IStream& source, const std::wstring& fileName, ZIPFileEntry& fileEntry);
 
 	//File entry functions
 	unsigned int GetFileEntryCount() const;
@@ -70,6 +70,43 @@ bool ZIPFileEntry::Compress(Stream::IStream& source, unsigned int inputCacheSize
 		return false;
 	}
 
+	//Write header information for the data we just compressed
+	SetCompressedDataHeader((unsigned int)uncompressedDataSize, calculatedCRC);
+
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+bool ZIPFileEntry::Store(Stream::IStream& source)
+{
+	//Calculate the data size
+	Stream::IStream::SizeType dataSize = source.Size() - source.GetStreamPos();
+	if(dataSize < 0)
+	{
+		dataSize = 0;
+	}
+
+	//Copy the data to our buffer unchanged. Files stored in this form can be read
+	//straight out of the archive, which is useful for small files which need to be
+	//accessed quickly, and for files such as images which are already compressed.
+	data.Resize(dataSize);
+	if((dataSize > 0) && !source.ReadData(data.GetRawBuffer(), dataSize))
+	{
+		return false;
+	}
+	unsigned int calculatedCRC = (dataSize > 0)? Deflate::CalculateCRC(data.GetRawBuffer(), (unsigned int)dataSize): 0;
+
+	//Write header information for the data we just stored
+	SetCompressedDataHeader((unsigned int)dataSize, calculatedCRC);
+	localFileHeader.versionToExtract = 10;
+	localFileHeader.compressionMethod = 0;	//No compression
+
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+void ZIPFileEntry::SetCompressedDataHeader(unsigned int uncompressedDataSize, unsigned int calculatedCRC)
+{
 	//Write the current system time as the modification time for the file
 	SYSTEMTIME systemTime;
 	FILETIME fileTime;
@@ -86,13 +123,11 @@ bool ZIPFileEntry::Compress(Stream::IStream& source, unsigned int inputCacheSize
 	localFileHeader.versionToExtract = 20;
 	localFileHeader.compressionMethod = 8;	//Deflate compression
 	localFileHeader.compressedSize = (unsigned int)data.Size();
-	localFileHeader.uncompressedSize = (unsigned int)uncompressedDataSize;
+	localFileHeader.uncompressedSize = uncompressedDataSize;
 	localFileHeader.crc32 = calculatedCRC;
 
 	//Flag that the object has been populated with a compressed data stream
 	compressedDataWritten = true;
-
-	return true;
 }
 
 //----------------------------------------------------------------------------------------
@@ -105,9 +140,19 @@ bool ZIPFileEntry::Decompress(Stream::IStream& target, unsigned int outputCacheS
 		return false;
 	}
 
-	//Attempt to decompress the file from our buffer using deflate compression
+	//If the file was stored without compression, copy the data directly to the target.
+	//Otherwise, attempt to decompress the file from our buffer using deflate compression.
 	unsigned int calculatedCRC;
-	if(!Deflate::DeflateDecompress(data, target, calculatedCRC, (unsigned int)data.Size(), outputCacheSize))
+	if(localFileHeader.compressionMethod == 0)
+	{
+		unsigned int dataSize = (unsigned int)data.Size();
+		calculatedCRC = (dataSize > 0)? Deflate::CalculateCRC(data.GetRawBuffer(), dataSize): 0;
+		if((dataSize > 0) && !target.WriteData(data.GetRawBuffer(), dataSize))
+		{
+			return false;
+		}
+	}
+	else if(!Deflate::DeflateDecompress(data, target, calculatedCRC, (unsigned int)data.Size(), outputCacheSize))
 	{
 		return false;
 	}
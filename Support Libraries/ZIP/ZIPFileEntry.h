@@ -7,6 +7,8 @@
 
 class ZIPFileEntry
 {
+	friend class ZIPParallelCompressor;
+
 public:
 	//Constructors
 	ZIPFileEntry();
@@ -26,6 +28,7 @@ public:
 	//##TODO## Implement a compressionMethod flag to the Compress function, and modify the
 	//function to support multiple compression methods.
 	bool Compress(Stream::IStream& source, unsigned int inputCacheSize = 0);
+	bool Store(Stream::IStream& source);
 	//##TODO## Implement support for multiple compression methods.
 	bool Decompress(Stream::IStream& target, unsigned int outputCacheSize = 0);
 
@@ -36,6 +39,10 @@ public:
 	//File header functions
 	ZIPChunk_CentralFileHeader GetCentralDirectoryFileHeader() const;
 
+private:
+	//Data compression functions
+	void SetCompressedDataHeader(unsigned int uncompressedDataSize, unsigned int calculatedCRC);
+
 private:
 	bool compressedDataWritten;
 	Stream::Buffer data;
@@ -0,0 +1,208 @@
+#include "ZIPParallelCompressor.h"
+#include "Deflate.h"
+#include <thread>
+#include <functional>
+#include <cstring>
+
+//----------------------------------------------------------------------------------------
+//Constructors
+//----------------------------------------------------------------------------------------
+ZIPParallelCompressor::ZIPParallelCompressor(unsigned int athreadCount, unsigned int ablockSize)
+:threadCount(athreadCount), blockSize(ablockSize), nextCompressionBlock(0)
+{
+	//If no thread count was specified, use one thread for each hardware thread.
+	if(threadCount <= 0)
+	{
+		threadCount = std::thread::hardware_concurrency();
+		threadCount = (threadCount > 0)? threadCount: 1;
+	}
+
+	//If no block size was specified, use the default block size. Blocks need to be at
+	//least as large as the dictionary, otherwise the compression ratio would suffer for
+	//no benefit.
+	if(blockSize <= 0)
+	{
+		blockSize = defaultBlockSize;
+	}
+	blockSize = (blockSize < dictionarySize)? dictionarySize: blockSize;
+}
+
+//----------------------------------------------------------------------------------------
+//File entry functions
+//----------------------------------------------------------------------------------------
+bool ZIPParallelCompressor::AddFileEntry(const std::wstring& fileName, Stream::IStream& source)
+{
+	//Calculate the uncompressed data size
+	Stream::IStream::SizeType uncompressedDataSize = source.Size() - source.GetStreamPos();
+	if(uncompressedDataSize < 0)
+	{
+		uncompressedDataSize = 0;
+	}
+
+	//Take a copy of the remaining source data. We copy the data here rather than holding
+	//a reference to the source stream, so that the source doesn't need to remain valid
+	//until the entries are compressed, and so that the worker threads never access the
+	//source stream concurrently.
+	SourceEntry entry;
+	entry.fileName = fileName;
+	entry.ownedData.resize((size_t)uncompressedDataSize);
+	entry.data = 0;
+	entry.dataSize = 0;
+	entry.firstBlockNo = 0;
+	entry.blockCount = 0;
+	if((uncompressedDataSize > 0) && !source.ReadData(&entry.ownedData[0], (Stream::IStream::SizeType)entry.ownedData.size()))
+	{
+		return false;
+	}
+	sourceEntries.push_back(entry);
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+//Adds a file entry which refers directly to a caller-owned block of memory, rather than
+//taking a copy of the data. The memory must remain valid and unchanged until the
+//CompressFileEntries function has returned.
+//----------------------------------------------------------------------------------------
+void ZIPParallelCompressor::AddFileEntry(const std::wstring& fileName, const unsigned char* sourceData, size_t sourceDataSize)
+{
+	SourceEntry entry;
+	entry.fileName = fileName;
+	entry.data = sourceData;
+	entry.dataSize = (sourceData != 0)? sourceDataSize: 0;
+	entry.firstBlockNo = 0;
+	entry.blockCount = 0;
+	sourceEntries.push_back(entry);
+}
+
+//----------------------------------------------------------------------------------------
+void ZIPParallelCompressor::Clear()
+{
+	sourceEntries.clear();
+	compressionBlocks.clear();
+	nextCompressionBlock = 0;
+	failedFileName.clear();
+}
+
+//----------------------------------------------------------------------------------------
+//Compression functions
+//----------------------------------------------------------------------------------------
+bool ZIPParallelCompressor::CompressFileEntries(ZIPArchive& archive)
+{
+	//Divide the source data for each entry into blocks. Every entry has at least one
+	//block, even if it contains no data, since the final block of each entry terminates
+	//its deflate stream.
+	compressionBlocks.clear();
+	failedFileName.clear();
+	for(size_t entryNo = 0; entryNo < sourceEntries.size(); ++entryNo)
+	{
+		//Resolve the location of the source data for entries which hold their own copy.
+		//We do this here rather than when the entry is added, since the location of the
+		//copy changes as the entry list grows.
+		SourceEntry& entry = sourceEntries[entryNo];
+		if(!entry.ownedData.empty())
+		{
+			entry.data = &entry.ownedData[0];
+			entry.dataSize = entry.ownedData.size();
+		}
+		entry.firstBlockNo = compressionBlocks.size();
+		size_t dataOffset = 0;
+		do
+		{
+			size_t remainingDataSize = entry.dataSize - dataOffset;
+			CompressionBlock block;
+			block.entryNo = entryNo;
+			block.dataOffset = dataOffset;
+			block.dataSize = (remainingDataSize > blockSize)? blockSize: (unsigned int)remainingDataSize;
+			block.finalBlock = (remainingDataSize <= blockSize);
+			block.result = false;
+			block.calculatedCRC = 0;
+			compressionBlocks.push_back(block);
+			dataOffset += block.dataSize;
+		}
+		while(dataOffset < entry.dataSize);
+		entry.blockCount = compressionBlocks.size() - entry.firstBlockNo;
+	}
+
+	//Compress all the blocks. Worker threads pull blocks from the list in order, so large
+	//entries which were added first will be started first. The calling thread takes part
+	//in compression as well, so we only need to start one less worker thread than the
+	//total number of threads we're using.
+	nextCompressionBlock = 0;
+	size_t workerThreadCount = (threadCount < compressionBlocks.size())? threadCount: compressionBlocks.size();
+	workerThreadCount = (workerThreadCount > 0)? workerThreadCount - 1: 0;
+	std::vector<std::thread> workerThreads;
+	for(size_t i = 0; i < workerThreadCount; ++i)
+	{
+		workerThreads.push_back(std::thread(std::bind(std::mem_fn(&ZIPParallelCompressor::CompressionWorkerThread), this)));
+	}
+	CompressionWorkerThread();
+	for(size_t i = 0; i < workerThreads.size(); ++i)
+	{
+		workerThreads[i].join();
+	}
+
+	//Assemble the compressed blocks for each entry into a single deflate stream, and add
+	//the completed entries to the archive in the order they were added.
+	for(size_t entryNo = 0; entryNo < sourceEntries.size(); ++entryNo)
+	{
+		const SourceEntry& entry = sourceEntries[entryNo];
+
+		//Calculate the total compressed size and CRC for this entry, and ensure that all
+		//the blocks were compressed successfully.
+		size_t compressedDataSize = 0;
+		unsigned int calculatedCRC = 0;
+		for(size_t blockNo = entry.firstBlockNo; blockNo < (entry.firstBlockNo + entry.blockCount); ++blockNo)
+		{
+			const CompressionBlock& block = compressionBlocks[blockNo];
+			if(!block.result)
+			{
+				failedFileName = entry.fileName;
+				compressionBlocks.clear();
+				return false;
+			}
+			compressedDataSize += block.compressedData.size();
+			calculatedCRC = (blockNo == entry.firstBlockNo)? block.calculatedCRC: Deflate::CombineCRC(calculatedCRC, block.calculatedCRC, block.dataSize);
+		}
+
+		//Concatenate the compressed blocks into the data buffer for the file entry
+		ZIPFileEntry fileEntry;
+		fileEntry.SetFileName(entry.fileName);
+		fileEntry.data.Resize((Stream::IStream::SizeType)compressedDataSize);
+		unsigned char* compressedData = fileEntry.data.GetRawBuffer();
+		for(size_t blockNo = entry.firstBlockNo; blockNo < (entry.firstBlockNo + entry.blockCount); ++blockNo)
+		{
+			const CompressionBlock& block = compressionBlocks[blockNo];
+			if(!block.compressedData.empty())
+			{
+				memcpy(compressedData, &block.compressedData[0], block.compressedData.size());
+				compressedData += block.compressedData.size();
+			}
+		}
+		fileEntry.SetCompressedDataHeader((unsigned int)entry.dataSize, calculatedCRC);
+		archive.AddFileEntry(fileEntry);
+	}
+
+	//Release the compressed block data, since it's now held by the archive.
+	compressionBlocks.clear();
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+void ZIPParallelCompressor::CompressionWorkerThread()
+{
+	std::unique_lock<std::mutex> lock(compressionMutex);
+	while(nextCompressionBlock < compressionBlocks.size())
+	{
+		//Take the next block from the list
+		CompressionBlock& block = compressionBlocks[nextCompressionBlock++];
+		lock.unlock();
+
+		//Compress the block, using up to the last 32KB of source data preceding this
+		//block as the dictionary.
+		const unsigned char* sourceData = sourceEntries[block.entryNo].data;
+		size_t blockDictionarySize = (block.dataOffset < dictionarySize)? block.dataOffset: dictionarySize;
+		block.result = Deflate::DeflateCompressBlock(sourceData + block.dataOffset, block.dataSize, sourceData + (block.dataOffset - blockDictionarySize), (unsigned int)blockDictionarySize, block.finalBlock, block.compressedData, block.calculatedCRC);
+
+		lock.lock();
+	}
+}
@@ -0,0 +1,65 @@
+#ifndef __ZIPPARALLELCOMPRESSOR_H__
+#define __ZIPPARALLELCOMPRESSOR_H__
+#include <string>
+#include <vector>
+#include <mutex>
+#include "StreamInterface/StreamInterface.pkg"
+#include "ZIPFileEntry.h"
+#include "ZIPArchive.h"
+
+//The ZIPParallelCompressor class compresses a set of file entries for a zip archive
+//using a pool of worker threads. The source data for each entry is divided into blocks,
+//which are compressed independently using the Deflate::DeflateCompressBlock function,
+//with the tail of the preceding block used as the compression dictionary. Small entries
+//form a single block, so many small entries are compressed concurrently with each
+//other, while a single large entry is also split across all available threads. The
+//compressed blocks for each entry are concatenated in order to form a single standard
+//deflate stream, so the resulting archive can be read by any zip implementation.
+class ZIPParallelCompressor
+{
+public:
+	//Constructors
+	ZIPParallelCompressor(unsigned int athreadCount = 0, unsigned int ablockSize = 0);
+
+	//Configuration functions
+	inline unsigned int GetThreadCount() const;
+	inline unsigned int GetBlockSize() const;
+
+	//File entry functions
+	bool AddFileEntry(const std::wstring& fileName, Stream::IStream& source);
+	void AddFileEntry(const std::wstring& fileName, const unsigned char* sourceData, size_t sourceDataSize);
+	inline unsigned int GetFileEntryCount() const;
+	void Clear();
+
+	//Compression functions
+	bool CompressFileEntries(ZIPArchive& archive);
+	inline std::wstring GetFailedFileName() const;
+
+private:
+	//Structures
+	struct SourceEntry;
+	struct CompressionBlock;
+
+private:
+	//Compression functions
+	void CompressionWorkerThread();
+
+private:
+	//Constants
+	static const unsigned int defaultBlockSize = 128*1024;
+	static const unsigned int dictionarySize = 32*1024;
+
+	//Configuration
+	unsigned int threadCount;
+	unsigned int blockSize;
+
+	//Compression data
+	std::vector<SourceEntry> sourceEntries;
+	std::vector<CompressionBlock> compressionBlocks;
+	std::mutex compressionMutex;
+	size_t nextCompressionBlock;
+	std::wstring failedFileName;
+};
+
+#include "ZIPParallelCompressor.inl"
+#endif
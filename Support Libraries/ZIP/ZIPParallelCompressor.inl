@@ -0,0 +1,54 @@
+//----------------------------------------------------------------------------------------
+//Structures
+//----------------------------------------------------------------------------------------
+struct ZIPParallelCompressor::SourceEntry
+{
+	std::wstring fileName;
+	std::vector<unsigned char> ownedData;
+	const unsigned char* data;
+	size_t dataSize;
+	size_t firstBlockNo;
+	size_t blockCount;
+};
+
+//----------------------------------------------------------------------------------------
+struct ZIPParallelCompressor::CompressionBlock
+{
+	size_t entryNo;
+	size_t dataOffset;
+	unsigned int dataSize;
+	bool finalBlock;
+	bool result;
+	unsigned int calculatedCRC;
+	std::vector<unsigned char> compressedData;
+};
+
+//----------------------------------------------------------------------------------------
+//Configuration functions
+//----------------------------------------------------------------------------------------
+unsigned int ZIPParallelCompressor::GetThreadCount() const
+{
+	return threadCount;
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int ZIPParallelCompressor::GetBlockSize() const
+{
+	return blockSize;
+}
+
+//----------------------------------------------------------------------------------------
+//File entry functions
+//----------------------------------------------------------------------------------------
+unsigned int ZIPParallelCompressor::GetFileEntryCount() const
+{
+	return (unsigned int)sourceEntries.size();
+}
+
+//----------------------------------------------------------------------------------------
+//Compression functions
+//----------------------------------------------------------------------------------------
+std::wstring ZIPParallelCompressor::GetFailedFileName() const
+{
+	return failedFileName;
+}
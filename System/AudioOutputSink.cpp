@@ -0,0 +1,181 @@
+#include "AudioOutputSink.h"
+#include "WindowsSupport/WindowsSupport.pkg"
+
+//----------------------------------------------------------------------------------------
+//Constructors
+//----------------------------------------------------------------------------------------
+AudioOutputSink::AudioOutputSink(AudioMixer& amixer, const std::wstring& adeviceInstanceName, AudioOutputTarget aoutputTarget, const std::wstring& acapturePath)
+:mixer(amixer), deviceInstanceName(adeviceInstanceName), outputTarget(aoutputTarget), capturePath(acapturePath), sinkOpen(false), channelCount(0), bitsPerSample(0), samplesPerSec(0), mixerSource(0), wavFileSink(0), nullSinkUsed(false)
+{}
+
+//----------------------------------------------------------------------------------------
+AudioOutputSink::~AudioOutputSink()
+{
+	Close();
+}
+
+//----------------------------------------------------------------------------------------
+//Sink binding
+//----------------------------------------------------------------------------------------
+bool AudioOutputSink::Open(unsigned int achannelCount, unsigned int abitsPerSample, unsigned int asamplesPerSec)
+{
+	std::unique_lock<std::mutex> lock(sinkMutex);
+	if(sinkOpen)
+	{
+		CloseBackend();
+	}
+	channelCount = achannelCount;
+	bitsPerSample = abitsPerSample;
+	samplesPerSec = asamplesPerSec;
+	sinkOpen = true;
+
+	//Note that we report success even if the backend couldn't be opened, IE, if no audio
+	//device is present. The device stream stays bound to us, and audio will begin flowing
+	//if the user selects a different output target.
+	OpenBackend();
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+void AudioOutputSink::Close()
+{
+	std::unique_lock<std::mutex> lock(sinkMutex);
+	if(sinkOpen)
+	{
+		CloseBackend();
+		sinkOpen = false;
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Sample output functions
+//----------------------------------------------------------------------------------------
+void AudioOutputSink::WriteSamples(const short* sampleData, unsigned int sampleCount)
+{
+	std::unique_lock<std::mutex> lock(sinkMutex);
+	if(!sinkOpen || (sampleCount <= 0))
+	{
+		return;
+	}
+	switch(outputTarget)
+	{
+	case AudioOutputTarget::Speakers:
+		if(mixerSource != 0)
+		{
+			mixerSource->WriteSamples(sampleData, sampleCount);
+		}
+		break;
+	case AudioOutputTarget::WAVFile:
+		if(wavFileSink != 0)
+		{
+			wavFileSink->WriteSamples(sampleData, sampleCount);
+		}
+		break;
+	case AudioOutputTarget::None:
+		nullSink.WriteSamples(sampleData, sampleCount);
+		break;
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Output target functions
+//----------------------------------------------------------------------------------------
+std::wstring AudioOutputSink::GetDeviceInstanceName() const
+{
+	return deviceInstanceName;
+}
+
+//----------------------------------------------------------------------------------------
+void AudioOutputSink::SetOutputTarget(AudioOutputTarget aoutputTarget, const std::wstring& acapturePath)
+{
+	std::unique_lock<std::mutex> lock(sinkMutex);
+	if(sinkOpen)
+	{
+		CloseBackend();
+	}
+	if(outputTarget == AudioOutputTarget::None)
+	{
+		nullSinkUsed = false;
+	}
+	outputTarget = aoutputTarget;
+	capturePath = acapturePath;
+	if(sinkOpen)
+	{
+		OpenBackend();
+	}
+}
+
+//----------------------------------------------------------------------------------------
+bool AudioOutputSink::GetDiscardedSampleInfo(unsigned long long& sampleCount, unsigned long long& sampleChecksum) const
+{
+	//Return the count and checksum of all samples discarded since the null backend was
+	//last opened. Note that these figures remain valid after the backend is closed, until
+	//it is opened again.
+	std::unique_lock<std::mutex> lock(sinkMutex);
+	if(!nullSinkUsed)
+	{
+		return false;
+	}
+	sampleCount = nullSink.GetWrittenSampleCount();
+	sampleChecksum = nullSink.GetWrittenSampleChecksum();
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+//Backend functions
+//----------------------------------------------------------------------------------------
+bool AudioOutputSink::OpenBackend()
+{
+	switch(outputTarget)
+	{
+	case AudioOutputTarget::Speakers:
+		mixerSource = mixer.CreateSource();
+		if(!mixerSource->Open(channelCount, bitsPerSample, samplesPerSec))
+		{
+			mixer.DeleteSource(mixerSource);
+			mixerSource = 0;
+			return false;
+		}
+		return true;
+	case AudioOutputTarget::WAVFile:
+		wavFileSink = new WAVFileAudioSink(PathCombinePaths(capturePath, deviceInstanceName + L".wav"));
+		if(!wavFileSink->Open(channelCount, bitsPerSample, samplesPerSec))
+		{
+			delete wavFileSink;
+			wavFileSink = 0;
+			return false;
+		}
+		return true;
+	case AudioOutputTarget::None:
+		nullSinkUsed = true;
+		return nullSink.Open(channelCount, bitsPerSample, samplesPerSec);
+	}
+	return false;
+}
+
+//----------------------------------------------------------------------------------------
+void AudioOutputSink::CloseBackend()
+{
+	switch(outputTarget)
+	{
+	case AudioOutputTarget::Speakers:
+		if(mixerSource != 0)
+		{
+			mixerSource->Close();
+			mixer.DeleteSource(mixerSource);
+			mixerSource = 0;
+		}
+		break;
+	case AudioOutputTarget::WAVFile:
+		if(wavFileSink != 0)
+		{
+			wavFileSink->Close();
+			delete wavFileSink;
+			wavFileSink = 0;
+		}
+		break;
+	case AudioOutputTarget::None:
+		nullSink.Close();
+		break;
+	}
+}
@@ -0,0 +1,61 @@
+#ifndef __AUDIOOUTPUTSINK_H__
+#define __AUDIOOUTPUTSINK_H__
+#include "SystemInterface/SystemInterface.pkg"
+#include "AudioStream/AudioStream.pkg"
+#include <string>
+#include <mutex>
+
+//The AudioOutputSink class is the audio sink handed out to devices by the system. It
+//forwards sample data to a backend chosen by the system audio output target, and allows
+//that backend to be swapped while the device stream remains open, so devices never need
+//to reopen their output stream when the user changes where audio is sent. Audio sent to
+//the speakers is fed into a source on the system audio mixer, which combines the output
+//of all devices into the single stream sent to the audio hardware.
+class AudioOutputSink :public IAudioSink
+{
+public:
+	//Enumerations
+	typedef ISystemGUIInterface::AudioOutputTarget AudioOutputTarget;
+
+	//Constructors
+	AudioOutputSink(AudioMixer& amixer, const std::wstring& adeviceInstanceName, AudioOutputTarget aoutputTarget, const std::wstring& acapturePath);
+	virtual ~AudioOutputSink();
+
+	//Sink binding
+	virtual bool Open(unsigned int achannelCount, unsigned int abitsPerSample, unsigned int asamplesPerSec);
+	virtual void Close();
+
+	//Sample output functions
+	virtual void WriteSamples(const short* sampleData, unsigned int sampleCount);
+
+	//Output target functions
+	std::wstring GetDeviceInstanceName() const;
+	void SetOutputTarget(AudioOutputTarget aoutputTarget, const std::wstring& acapturePath);
+	bool GetDiscardedSampleInfo(unsigned long long& sampleCount, unsigned long long& sampleChecksum) const;
+
+private:
+	//Backend functions
+	bool OpenBackend();
+	void CloseBackend();
+
+private:
+	mutable std::mutex sinkMutex;
+	AudioMixer& mixer;
+	std::wstring deviceInstanceName;
+	AudioOutputTarget outputTarget;
+	std::wstring capturePath;
+
+	//Stream format settings
+	bool sinkOpen;
+	unsigned int channelCount;
+	unsigned int bitsPerSample;
+	unsigned int samplesPerSec;
+
+	//Backends
+	AudioMixerSource* mixerSource;
+	WAVFileAudioSink* wavFileSink;
+	NullAudioSink nullSink;
+	bool nullSinkUsed;
+};
+
+#endif
@@ -0,0 +1,263 @@
+#include "StateRewindBuffer.h"
+#include <cstring>
+
+//----------------------------------------------------------------------------------------
+//Constructors
+//----------------------------------------------------------------------------------------
+StateRewindBuffer::StateRewindBuffer(size_t amemoryLimit, unsigned int akeyframeInterval)
+:memoryLimit(amemoryLimit), keyframeInterval((akeyframeInterval > 0)? akeyframeInterval: 1), keyframeCount(0), snapshotsSinceKeyframe(0), encodedDataSize(0)
+{}
+
+//----------------------------------------------------------------------------------------
+//Configuration functions
+//----------------------------------------------------------------------------------------
+void StateRewindBuffer::SetMemoryLimit(size_t amemoryLimit)
+{
+	memoryLimit = amemoryLimit;
+	while((GetMemoryUsage() > memoryLimit) && (keyframeCount > 1))
+	{
+		RemoveOldestSnapshotGroup();
+	}
+}
+
+//----------------------------------------------------------------------------------------
+//Snapshot functions
+//----------------------------------------------------------------------------------------
+void StateRewindBuffer::Clear()
+{
+	snapshots.clear();
+	keyframeCount = 0;
+	snapshotsSinceKeyframe = 0;
+	encodedDataSize = 0;
+	latestStateData.clear();
+}
+
+//----------------------------------------------------------------------------------------
+void StateRewindBuffer::AddSnapshot(const unsigned char* stateData, size_t stateDataSize)
+{
+	//Encode the new snapshot. Keyframes are encoded against an empty base state, while all
+	//other snapshots are encoded against the previous snapshot.
+	bool keyframe = snapshots.empty() || (snapshotsSinceKeyframe + 1 >= keyframeInterval);
+	EncodeSnapshot((keyframe? std::vector<unsigned char>(): latestStateData), stateData, stateDataSize, encodeBuffer);
+
+	//Add the encoded snapshot to the buffer. Note that we copy the encoded data out of our
+	//scratch buffer rather than swapping it, so that each snapshot only retains as much
+	//memory as its encoded data requires.
+	snapshots.push_back(Snapshot());
+	Snapshot& snapshot = snapshots.back();
+	snapshot.keyframe = keyframe;
+	snapshot.decodedSize = stateDataSize;
+	snapshot.encodedData.assign(encodeBuffer.begin(), encodeBuffer.end());
+	encodedDataSize += snapshot.encodedData.size();
+	if(keyframe)
+	{
+		++keyframeCount;
+		snapshotsSinceKeyframe = 0;
+	}
+	else
+	{
+		++snapshotsSinceKeyframe;
+	}
+	latestStateData.assign(stateData, stateData + stateDataSize);
+
+	//Discard the oldest snapshots until we're back within our memory limit. Note that we
+	//always retain the most recent keyframe group, even if it alone exceeds the limit.
+	while((GetMemoryUsage() > memoryLimit) && (keyframeCount > 1))
+	{
+		RemoveOldestSnapshotGroup();
+	}
+}
+
+//----------------------------------------------------------------------------------------
+bool StateRewindBuffer::RemoveLatestSnapshot(std::vector<unsigned char>& stateData)
+{
+	if(snapshots.empty())
+	{
+		return false;
+	}
+
+	//Return the decoded state of the latest snapshot, and remove it from the buffer.
+	stateData.swap(latestStateData);
+	const Snapshot& snapshot = snapshots.back();
+	encodedDataSize -= snapshot.encodedData.size();
+	if(snapshot.keyframe)
+	{
+		--keyframeCount;
+	}
+	snapshots.pop_back();
+
+	//Reconstruct the state of the snapshot which is now the most recent in the buffer, so
+	//that it can be returned by the next call, and used as the base for the next capture.
+	DecodeLatestSnapshot();
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+void StateRewindBuffer::RemoveOldestSnapshotGroup()
+{
+	//The oldest snapshot in the buffer is always a keyframe. Remove it along with all the
+	//following snapshots which depend on it, up to the next keyframe.
+	do
+	{
+		encodedDataSize -= snapshots.front().encodedData.size();
+		snapshots.pop_front();
+	}
+	while(!snapshots.empty() && !snapshots.front().keyframe);
+	--keyframeCount;
+}
+
+//----------------------------------------------------------------------------------------
+void StateRewindBuffer::DecodeLatestSnapshot()
+{
+	latestStateData.clear();
+	snapshotsSinceKeyframe = 0;
+	if(snapshots.empty())
+	{
+		return;
+	}
+
+	//Locate the keyframe the latest snapshot depends on
+	SnapshotList::const_iterator keyframeIterator = snapshots.end();
+	do
+	{
+		--keyframeIterator;
+	}
+	while(!keyframeIterator->keyframe);
+
+	//Apply each difference in turn from the keyframe forward to rebuild the latest state
+	std::vector<unsigned char> baseData;
+	for(SnapshotList::const_iterator i = keyframeIterator; i != snapshots.end(); ++i)
+	{
+		DecodeSnapshot(baseData, i->encodedData, i->decodedSize, latestStateData);
+		baseData.swap(latestStateData);
+		if(i != keyframeIterator)
+		{
+			++snapshotsSinceKeyframe;
+		}
+	}
+	latestStateData.swap(baseData);
+}
+
+//----------------------------------------------------------------------------------------
+//Encoding functions
+//----------------------------------------------------------------------------------------
+//Snapshots are encoded as a series of blocks, where each block consists of a count of
+//bytes which are unchanged from the base state, followed by a count of changed bytes,
+//followed by the changed bytes themselves stored as the XOR of the new and base values.
+//Bytes past the end of the base state are treated as having a base value of zero. Short
+//runs of unchanged bytes are folded into the surrounding changed data, since the
+//overhead of starting a new block would exceed the saving.
+//----------------------------------------------------------------------------------------
+void StateRewindBuffer::EncodeSnapshot(const std::vector<unsigned char>& baseData, const unsigned char* stateData, size_t stateDataSize, std::vector<unsigned char>& encodedData)
+{
+	encodedData.clear();
+	size_t baseDataSize = baseData.size();
+	size_t commonSize = (baseDataSize < stateDataSize)? baseDataSize: stateDataSize;
+	size_t dataPos = 0;
+	while(dataPos < stateDataSize)
+	{
+		//Count the unchanged bytes at the current position. Since most of the state is
+		//usually unchanged between snapshots, we compare a word at a time where possible.
+		size_t unchangedStartPos = dataPos;
+		while(((dataPos + sizeof(unsigned long long)) <= commonSize) && (memcmp(&stateData[dataPos], &baseData[dataPos], sizeof(unsigned long long)) == 0))
+		{
+			dataPos += sizeof(unsigned long long);
+		}
+		while((dataPos < stateDataSize) && (stateData[dataPos] == ((dataPos < baseDataSize)? baseData[dataPos]: 0)))
+		{
+			++dataPos;
+		}
+		size_t unchangedRunLength = dataPos - unchangedStartPos;
+
+		//Find the end of the changed data, stopping when we reach a run of unchanged bytes
+		//long enough to be worth starting a new block.
+		size_t changedStartPos = dataPos;
+		size_t changedEndPos = dataPos;
+		size_t unchangedCount = 0;
+		while((dataPos < stateDataSize) && (unchangedCount < minimumUnchangedRunLength))
+		{
+			if(stateData[dataPos] == ((dataPos < baseDataSize)? baseData[dataPos]: 0))
+			{
+				++unchangedCount;
+			}
+			else
+			{
+				unchangedCount = 0;
+				changedEndPos = dataPos + 1;
+			}
+			++dataPos;
+		}
+		dataPos = changedEndPos;
+
+		//Write this block
+		WriteRunLength(encodedData, unchangedRunLength);
+		WriteRunLength(encodedData, changedEndPos - changedStartPos);
+		for(size_t i = changedStartPos; i < changedEndPos; ++i)
+		{
+			encodedData.push_back(stateData[i] ^ ((i < baseDataSize)? baseData[i]: 0));
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void StateRewindBuffer::DecodeSnapshot(const std::vector<unsigned char>& baseData, const std::vector<unsigned char>& encodedData, size_t decodedSize, std::vector<unsigned char>& stateData)
+{
+	stateData.resize(decodedSize);
+	size_t baseDataSize = baseData.size();
+	size_t dataPos = 0;
+	size_t encodedDataPos = 0;
+	while(dataPos < decodedSize)
+	{
+		//Copy the unchanged bytes from the base state
+		size_t unchangedRunLength = ReadRunLength(encodedData, encodedDataPos);
+		size_t unchangedEndPos = dataPos + unchangedRunLength;
+		size_t copyEndPos = (unchangedEndPos < baseDataSize)? unchangedEndPos: baseDataSize;
+		if(copyEndPos > dataPos)
+		{
+			memcpy(&stateData[dataPos], &baseData[dataPos], copyEndPos - dataPos);
+			dataPos = copyEndPos;
+		}
+		if(unchangedEndPos > dataPos)
+		{
+			memset(&stateData[dataPos], 0, unchangedEndPos - dataPos);
+			dataPos = unchangedEndPos;
+		}
+
+		//Apply the changed bytes to the base state
+		size_t changedRunLength = ReadRunLength(encodedData, encodedDataPos);
+		for(size_t i = 0; i < changedRunLength; ++i)
+		{
+			stateData[dataPos] = encodedData[encodedDataPos++] ^ ((dataPos < baseDataSize)? baseData[dataPos]: 0);
+			++dataPos;
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void StateRewindBuffer::WriteRunLength(std::vector<unsigned char>& encodedData, size_t runLength)
+{
+	//Run lengths are stored as a variable length integer, with 7 bits of data in each
+	//byte, and the upper bit set on all bytes except the last.
+	while(runLength >= 0x80)
+	{
+		encodedData.push_back((unsigned char)((runLength & 0x7F) | 0x80));
+		runLength >>= 7;
+	}
+	encodedData.push_back((unsigned char)runLength);
+}
+
+//----------------------------------------------------------------------------------------
+size_t StateRewindBuffer::ReadRunLength(const std::vector<unsigned char>& encodedData, size_t& encodedDataPos)
+{
+	size_t runLength = 0;
+	unsigned int shiftCount = 0;
+	unsigned char data;
+	do
+	{
+		data = encodedData[encodedDataPos++];
+		runLength |= (size_t)(data & 0x7F) << shiftCount;
+		shiftCount += 7;
+	}
+	while((data & 0x80) != 0);
+	return runLength;
+}
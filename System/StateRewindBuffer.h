@@ -0,0 +1,73 @@
+#ifndef __STATEREWINDBUFFER_H__
+#define __STATEREWINDBUFFER_H__
+#include <vector>
+#include <list>
+
+//The StateRewindBuffer class holds a bounded history of serialized system states in
+//memory, allowing the system to be stepped backward in time without going through the
+//filesystem. Each snapshot is stored as the XOR difference from the previous snapshot,
+//with runs of unchanged bytes collapsed, so that the memory cost of a snapshot is
+//proportional to the amount of state which changed since the last capture rather than
+//the total size of the state. Every keyframeInterval snapshots a keyframe is stored,
+//which is encoded against an empty state, and which bounds the number of differences
+//which need to be applied to reconstruct any snapshot. When the memory limit is reached,
+//the oldest keyframe and all the snapshots which depend on it are discarded together.
+class StateRewindBuffer
+{
+public:
+	//Constructors
+	StateRewindBuffer(size_t amemoryLimit, unsigned int akeyframeInterval);
+
+	//Configuration functions
+	inline size_t GetMemoryLimit() const;
+	void SetMemoryLimit(size_t amemoryLimit);
+	inline unsigned int GetKeyframeInterval() const;
+	inline void SetKeyframeInterval(unsigned int akeyframeInterval);
+
+	//Snapshot functions
+	void Clear();
+	void AddSnapshot(const unsigned char* stateData, size_t stateDataSize);
+	bool RemoveLatestSnapshot(std::vector<unsigned char>& stateData);
+
+	//Statistics functions
+	inline unsigned int GetSnapshotCount() const;
+	inline unsigned int GetKeyframeCount() const;
+	inline size_t GetMemoryUsage() const;
+
+private:
+	//Structures
+	struct Snapshot;
+
+	//Typedefs
+	typedef std::list<Snapshot> SnapshotList;
+
+private:
+	//Snapshot functions
+	void RemoveOldestSnapshotGroup();
+	void DecodeLatestSnapshot();
+
+	//Encoding functions
+	static void EncodeSnapshot(const std::vector<unsigned char>& baseData, const unsigned char* stateData, size_t stateDataSize, std::vector<unsigned char>& encodedData);
+	static void DecodeSnapshot(const std::vector<unsigned char>& baseData, const std::vector<unsigned char>& encodedData, size_t decodedSize, std::vector<unsigned char>& stateData);
+	static void WriteRunLength(std::vector<unsigned char>& encodedData, size_t runLength);
+	static size_t ReadRunLength(const std::vector<unsigned char>& encodedData, size_t& encodedDataPos);
+
+private:
+	//Constants
+	static const size_t minimumUnchangedRunLength = 8;
+
+	//Configuration
+	size_t memoryLimit;
+	unsigned int keyframeInterval;
+
+	//Snapshot data
+	SnapshotList snapshots;
+	unsigned int keyframeCount;
+	unsigned int snapshotsSinceKeyframe;
+	size_t encodedDataSize;
+	std::vector<unsigned char> latestStateData;
+	std::vector<unsigned char> encodeBuffer;
+};
+
+#include "StateRewindBuffer.inl"
+#endif
@@ -0,0 +1,49 @@
+//----------------------------------------------------------------------------------------
+//Structures
+//----------------------------------------------------------------------------------------
+struct StateRewindBuffer::Snapshot
+{
+	bool keyframe;
+	size_t decodedSize;
+	std::vector<unsigned char> encodedData;
+};
+
+//----------------------------------------------------------------------------------------
+//Configuration functions
+//----------------------------------------------------------------------------------------
+size_t StateRewindBuffer::GetMemoryLimit() const
+{
+	return memoryLimit;
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int StateRewindBuffer::GetKeyframeInterval() const
+{
+	return keyframeInterval;
+}
+
+//----------------------------------------------------------------------------------------
+void StateRewindBuffer::SetKeyframeInterval(unsigned int akeyframeInterval)
+{
+	keyframeInterval = (akeyframeInterval > 0)? akeyframeInterval: 1;
+}
+
+//----------------------------------------------------------------------------------------
+//Statistics functions
+//----------------------------------------------------------------------------------------
+unsigned int StateRewindBuffer::GetSnapshotCount() const
+{
+	return (unsigned int)snapshots.size();
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int StateRewindBuffer::GetKeyframeCount() const
+{
+	return keyframeCount;
+}
+
+//----------------------------------------------------------------------------------------
+size_t StateRewindBuffer::GetMemoryUsage() const
+{
+	return encodedDataSize + latestStateData.size();
+}
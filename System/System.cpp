@@ -7,6 +7,7 @@
 #include <time.h>
 #include <functional>
 #include <thread>
+#include <chrono>
 #include <sstream>
 #include <algorithm>
 //##DEBUG##
@@ -17,7 +18,7 @@
 //Constructors
 //----------------------------------------------------------------------------------------
 System::System(IGUIExtensionInterface& aguiExtensionInterface)
-:guiExtensionInterface(aguiExtensionInterface), stopSystem(false), systemStopped(true), initialize(true), rollback(false), performingSingleDeviceStep(false), enableThrottling(true), runWhenProgramModuleLoaded(true), enablePersistentState(true)
+:guiExtensionInterface(aguiExtensionInterface), stopSystem(false), systemStopped(true), initialize(true), rollback(false), performingSingleDeviceStep(false), enableThrottling(true), runWhenProgramModuleLoaded(true), enablePersistentState(true), enableRewind(false), rewindCaptureIntervalInMilliseconds(defaultRewindCaptureIntervalInMilliseconds), emulatedTimeSinceRewindCapture(0), rewindBuffer(defaultRewindMemoryLimit, defaultRewindKeyframeInterval), rewindAverageCaptureTime(0), audioOutputTarget(AudioOutputTarget::Speakers), audioMixer(0), audioMixerThreadActive(false), savestateWriterThreadActive(false), lastAsyncSaveStateResult(false)
 {
 	eventLogSize = 500;
 	eventLogLastModifiedToken = 0;
@@ -37,9 +38,29 @@ System::System(IGUIExtensionInterface& aguiExtensionInterface)
 //----------------------------------------------------------------------------------------
 System::~System()
 {
+	//Stop the savestate writer thread, after it has written any savestates which are still
+	//queued.
+	if(savestateWriterThread.joinable())
+	{
+		std::unique_lock<std::mutex> lock(savestateWriterMutex);
+		savestateWriterThreadActive = false;
+		savestateWriterUpdate.notify_all();
+		lock.unlock();
+		savestateWriterThread.join();
+	}
+
 	//Unload all currently loaded modules
 	UnloadAllModules();
 
+	//Release any audio output sinks which weren't closed by their devices
+	for(std::list<AudioOutputSink*>::const_iterator i = audioOutputSinks.begin(); i != audioOutputSinks.end(); ++i)
+	{
+		LogDiscardedAudioOutput(**i);
+		delete *i;
+	}
+	audioOutputSinks.clear();
+	StopAudioMixer();
+
 	//Unload all persistent global extensions. Persistent extensions should be all that is
 	//left in the list of global extensions at this point.
 	for(LoadedGlobalExtensionInfoList::const_iterator i = globalExtensionInfoList.begin(); i != globalExtensionInfoList.end(); ++i)
@@ -77,6 +98,10 @@ bool System::LoadState(const MarshalSupport::Marshal::In<std::wstring>& filePath
 	bool running = SystemRunning();
 	StopSystem();
 
+	//Ensure any savestates which are still being written in the background are complete,
+	//in case the state we're loading is one of them.
+	WaitForAsyncSaveStates();
+
 	//Open the target file
 	FileStreamReference sourceStreamReference(guiExtensionInterface);
 	if(!sourceStreamReference.OpenExistingFileForRead(filePath))
@@ -242,98 +267,30 @@ bool System::LoadState(const MarshalSupport::Marshal::In<std::wstring>& filePath
 			delete[] buffer;
 		}
 	}
-
-	//Validate the root node
-	IHierarchicalStorageNode& rootNode = tree.GetRootNode();
-	if(rootNode.GetName() != L"State")
+	else if(fileType == FileType::Binary)
 	{
-		WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to load state from file " + filePath + L" because the root node in the XML tree wasn't of type \"State\"!"));
-		if(running)
+		//Attempt to load the binary tree from the file. Binary data is always stored
+		//within the tree in this format, so there are no external files to load.
+		tree.SetStorageMode(IHierarchicalStorageTree::StorageMode::Binary);
+		if(!tree.LoadTree(source))
 		{
-			RunSystem();
+			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to load state from file " + filePath + L" because the binary structure could not be decoded! The decode error string is as follows: " + tree.GetErrorString()));
+			if(running)
+			{
+				RunSystem();
+			}
+			return false;
 		}
-		return false;
 	}
 
-	//Restore system state from XML data
-	ModuleRelationshipMap relationshipMap;
-	std::list<IHierarchicalStorageNode*> childList = rootNode.GetChildList();
-	for(std::list<IHierarchicalStorageNode*>::iterator i = childList.begin(); i != childList.end(); ++i)
+	//Restore the system state from the loaded tree
+	if(!LoadStateNodes(tree.GetRootNode(), debuggerState, L"file " + filePath))
 	{
-		std::wstring elementName = (*i)->GetName();
-
-		//Load the device node
-		if(elementName == L"Device")
-		{
-			//Extract the mandatory attributes
-			IHierarchicalStorageAttribute* nameAttribute = (*i)->GetAttribute(L"Name");
-			IHierarchicalStorageAttribute* moduleIDAttribute = (*i)->GetAttribute(L"ModuleID");
-			if((nameAttribute != 0) && (moduleIDAttribute != 0))
-			{
-				std::wstring deviceName = nameAttribute->GetValue();
-				unsigned int savedModuleID = moduleIDAttribute->ExtractValue<unsigned int>();
-
-				//Attempt to locate a matching loaded device
-				bool foundDevice = false;
-				IDevice* device = 0;
-				ModuleRelationshipMap::const_iterator relationshipMapIterator = relationshipMap.find(savedModuleID);
-				if(relationshipMapIterator != relationshipMap.end())
-				{
-					const ModuleRelationship& moduleRelationship = relationshipMapIterator->second;
-					if(moduleRelationship.foundMatch)
-					{
-						device = GetDevice(moduleRelationship.loadedModuleID, deviceName);
-						if(device != 0)
-						{
-							foundDevice = true;
-						}
-					}
-				}
-
-				//If we found a matching device, load the state for this device.
-				if(foundDevice)
-				{
-					if(debuggerState)
-					{
-						device->LoadDebuggerState(*(*i));
-					}
-					else
-					{
-						//Note that we negate the output line state here, and re-assert it
-						//after loading the state data. This is technically unnecessary
-						//when loading complete system states, but is very important when
-						//loading partial system states.
-						device->NegateCurrentOutputLineState();
-						device->LoadState(*(*i));
-						device->AssertCurrentOutputLineState();
-					}
-				}
-
-				//If a matching loaded device couldn't be located, log an error.
-				if(!foundDevice)
-				{
-					WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"While loading state data from file " + filePath + L" state data was found for device " + deviceName + L" , which could not be located in the system. The state data for this device will be ignored, and the state will continue to load, but note that the system may not run as expected."));
-				}
-			}
-		}
-		//Load the ModuleRelationships node
-		else if(elementName == L"ModuleRelationships")
-		{
-			if(!LoadModuleRelationshipsNode(*(*i), relationshipMap))
-			{
-				WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to load state from file " + filePath + L" because the ModuleRelationships node could not be loaded!"));
-				if(running)
-				{
-					RunSystem();
-				}
-				return false;
-			}
-		}
-		else
+		if(running)
 		{
-			//Log a warning for an unrecognized element
-			WriteLogEvent(LogEntry(LogEntry::EventLevel::Warning, L"System", L"Unrecognized element: " + elementName + L" when loading state from file " + filePath + L"."));
+			RunSystem();
 		}
+		return false;
 	}
 
 	//Log the event
@@ -354,181 +311,279 @@ bool System::SaveState(const MarshalSupport::Marshal::In<std::wstring>& filePath
 	bool running = SystemRunning();
 	StopSystem();
 
-	//Create the new savestate XML tree
-	HierarchicalStorageTree tree;
-	tree.GetRootNode().SetName(L"State");
+	//Ensure any savestates which were queued for asynchronous writing have been written,
+	//so that saves to the same target file always complete in the order they were made.
+	WaitForAsyncSaveStates();
 
-	//Fill in general information about the savestate
-	IHierarchicalStorageNode& stateInfo = tree.GetRootNode().CreateChild(L"Info");
+	//Capture the system state, and write it to the target file. Since the system remains
+	//paused until the write is complete, the captured tree is able to refer directly to
+	//memory owned by devices.
+	SavestateCapture capture;
+	capture.filePath = filePath;
+	capture.fileType = fileType;
+	capture.debuggerState = debuggerState;
+	CaptureSaveState(capture);
+	bool result = WriteSaveState(capture);
+
+	//Restore running state
+	if(running)
+	{
+		RunSystem();
+	}
+	return result;
+}
+
+//----------------------------------------------------------------------------------------
+void System::SaveStateAsync(const MarshalSupport::Marshal::In<std::wstring>& filePath, FileType fileType, bool debuggerState)
+{
+	//Record the time at which we begin the capture, so that we can report how long the
+	//system was paused for.
+	LARGE_INTEGER counterFrequency;
+	LARGE_INTEGER captureStartTime;
+	QueryPerformanceFrequency(&counterFrequency);
+	QueryPerformanceCounter(&captureStartTime);
+
+	//Save running state and pause system
+	bool running = SystemRunning();
+	StopSystem();
+
+	//Capture the system state. Nodes in the captured tree may refer directly to memory
+	//owned by devices, so we take a copy of any referenced data before the system resumes.
+	//This is a flat memory copy, which is far cheaper than encoding the tree, compressing
+	//it, and writing it to disk, all of which are left to the savestate writer thread.
+	SavestateCapture* capture = new SavestateCapture();
+	capture->filePath = filePath;
+	capture->fileType = fileType;
+	capture->debuggerState = debuggerState;
+	CaptureSaveState(*capture);
+	capture->tree.MaterializeBinaryDataReferences();
+
+	//Restore running state
+	if(running)
+	{
+		RunSystem();
+	}
+
+	//Log the length of time the system was paused for the capture
+	LARGE_INTEGER captureEndTime;
+	QueryPerformanceCounter(&captureEndTime);
+	double captureTime = ((double)(captureEndTime.QuadPart - captureStartTime.QuadPart) * 1000.0) / (double)counterFrequency.QuadPart;
+	std::wstringstream message;
+	message << L"Captured state for file " << capture->filePath << L" in " << captureTime << L"ms. The state will be written in the background.";
+	WriteLogEvent(LogEntry(LogEntry::EventLevel::Info, L"System", message.str()));
+
+	//Queue the captured state to be written, starting the writer thread if it isn't
+	//already running.
+	std::unique_lock<std::mutex> lock(savestateWriterMutex);
+	if(!savestateWriterThread.joinable())
+	{
+		savestateWriterThreadActive = true;
+		savestateWriterThread = std::thread(std::bind(std::mem_fn(&System::SavestateWriterThread), this));
+	}
+	pendingSavestateWrites.push_back(capture);
+	savestateWriterUpdate.notify_all();
+}
+
+//----------------------------------------------------------------------------------------
+bool System::AsyncSaveStatePending() const
+{
+	std::unique_lock<std::mutex> lock(savestateWriterMutex);
+	return !pendingSavestateWrites.empty();
+}
+
+//----------------------------------------------------------------------------------------
+void System::AsyncSaveStateCompleteNotifyRegister(IObserverSubscription& observer)
+{
+	savestateWriteCompleteObservers.AddObserver(observer);
+}
+
+//----------------------------------------------------------------------------------------
+void System::AsyncSaveStateCompleteNotifyDeregister(IObserverSubscription& observer)
+{
+	savestateWriteCompleteObservers.RemoveObserver(observer);
+}
+
+//----------------------------------------------------------------------------------------
+//Returns the result of the most recently completed asynchronous savestate write. Note
+//that when observers are notified that a write has completed, another write may already
+//have completed after it, in which case the result and path refer to the later write.
+//----------------------------------------------------------------------------------------
+bool System::GetLastAsyncSaveStateResult() const
+{
+	std::unique_lock<std::mutex> lock(savestateWriterMutex);
+	return lastAsyncSaveStateResult;
+}
+
+//----------------------------------------------------------------------------------------
+MarshalSupport::Marshal::Ret<std::wstring> System::GetLastAsyncSaveStateFilePath() const
+{
+	std::unique_lock<std::mutex> lock(savestateWriterMutex);
+	return lastAsyncSaveStateFilePath;
+}
+
+//----------------------------------------------------------------------------------------
+void System::CaptureSaveState(SavestateCapture& capture) const
+{
+	//Record general information about the savestate
 	Timestamp timestamp = GetTimestamp();
-	stateInfo.CreateAttribute(L"CreationDate", timestamp.GetDate());
-	stateInfo.CreateAttribute(L"CreationTime", timestamp.GetTime());
-	stateInfo.CreateAttribute(L"DebuggerState", debuggerState);
-	Image screenshot;
-	bool screenshotPresent = false;
-	std::wstring screenshotFilename = L"screenshot.png";
-	if(!debuggerState)
+	capture.creationDate = timestamp.GetDate();
+	capture.creationTime = timestamp.GetTime();
+	capture.screenshotPresent = false;
+	capture.screenshotFilename = L"screenshot.png";
+	if(!capture.debuggerState)
 	{
 		for(DeviceArray::const_iterator i = devices.begin(); i != devices.end(); ++i)
 		{
-			screenshotPresent |= (*i)->GetTargetDevice().GetScreenshot(screenshot);
-		}
-		if(screenshotPresent)
-		{
-			stateInfo.CreateAttribute(L"Screenshot", screenshotFilename);
+			capture.screenshotPresent |= (*i)->GetTargetDevice().GetScreenshot(capture.screenshot);
 		}
 	}
 
-	//Save the ModuleRelationships node
-	IHierarchicalStorageNode& moduleRelationshipsNode = tree.GetRootNode().CreateChild(L"ModuleRelationships");
-	SaveModuleRelationshipsNode(moduleRelationshipsNode);
+	//Create the new savestate XML tree
+	capture.tree.GetRootNode().SetName(L"State");
+	IHierarchicalStorageNode& stateInfo = capture.tree.GetRootNode().CreateChild(L"Info");
+	SaveStateInfoNode(stateInfo, capture);
 
-	//Save the system state to the XML tree
-	for(LoadedDeviceInfoList::const_iterator i = loadedDeviceInfoList.begin(); i != loadedDeviceInfoList.end(); ++i)
+	//Save the system state to the tree
+	SaveStateNodes(capture.tree.GetRootNode(), capture.debuggerState);
+}
+
+//----------------------------------------------------------------------------------------
+void System::SaveStateInfoNode(IHierarchicalStorageNode& stateInfo, const SavestateCapture& capture) const
+{
+	stateInfo.CreateAttribute(L"CreationDate", capture.creationDate);
+	stateInfo.CreateAttribute(L"CreationTime", capture.creationTime);
+	stateInfo.CreateAttribute(L"DebuggerState", capture.debuggerState);
+	if(capture.screenshotPresent)
 	{
-		IHierarchicalStorageNode& node = tree.GetRootNode().CreateChild(L"Device");
-		node.CreateAttribute(L"Name", (*i).device->GetDeviceInstanceName());
-		node.CreateAttribute(L"ModuleID").SetValue((*i).moduleID);
-		if(debuggerState)
+		stateInfo.CreateAttribute(L"Screenshot", capture.screenshotFilename);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+bool System::WriteSaveState(SavestateCapture& capture) const
+{
+	if(capture.fileType == FileType::ZIP)
+	{
+		//Save the general information about the savestate to a small separate XML tree.
+		//This is stored without compression as the first file in the archive, followed by
+		//the screenshot, so that savestate information can be retrieved by reading only
+		//the start of the file, without loading or decompressing the full system state.
+		HierarchicalStorageTree infoTree;
+		infoTree.GetRootNode().SetName(L"State");
+		SaveStateInfoNode(infoTree.GetRootNode().CreateChild(L"Info"), capture);
+		Stream::Buffer infoBuffer(Stream::IStream::TextEncoding::UTF8, 0);
+		infoBuffer.InsertByteOrderMark();
+		if(!infoTree.SaveTree(infoBuffer))
 		{
-			(*i).device->SaveDebuggerState(node);
+			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error saving the info xml tree. The xml error string is as follows: " + infoTree.GetErrorString()));
+			return false;
 		}
-		else
+		ZIPArchive archive;
+		ZIPFileEntry infoEntry;
+		infoEntry.SetFileName(L"info.xml");
+		infoBuffer.SetStreamPos(0);
+		if(!infoEntry.Store(infoBuffer))
 		{
-			(*i).device->SaveState(node);
+			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error storing the info.xml file!"));
+			return false;
+		}
+		archive.AddFileEntry(infoEntry);
+
+		//Add the screenshot file
+		if(capture.screenshotPresent)
+		{
+			Stream::Buffer screenshotFile(0);
+			if(!capture.screenshot.SavePNGImage(screenshotFile))
+			{
+				WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error creating the screenshot file with a file name of " + capture.screenshotFilename + L"!"));
+				return false;
+			}
+			ZIPFileEntry screenshotEntry;
+			screenshotEntry.SetFileName(capture.screenshotFilename);
+			screenshotFile.SetStreamPos(0);
+			if(!screenshotEntry.Compress(screenshotFile))
+			{
+				WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error compressing the " + capture.screenshotFilename + L" file!"));
+				return false;
+			}
+			archive.AddFileEntry(screenshotEntry);
 		}
-	}
 
-	if(fileType == FileType::ZIP)
-	{
 		//Save the XML tree to a unicode buffer
 		Stream::Buffer buffer(Stream::IStream::TextEncoding::UTF8, 0);
 		buffer.InsertByteOrderMark();
-		if(!tree.SaveTree(buffer))
+		if(!capture.tree.SaveTree(buffer))
 		{
-			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + filePath + L" because there was an error saving the xml tree. The xml error string is as follows: " + tree.GetErrorString()));
-			if(running)
-			{
-				RunSystem();
-			}
+			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error saving the xml tree. The xml error string is as follows: " + capture.tree.GetErrorString()));
 			return false;
 		}
 
-		ZIPArchive archive;
-		ZIPFileEntry entry;
-		entry.SetFileName(L"save.xml");
+		//Collect the save.xml file and all external binary data files, so that they can be
+		//compressed concurrently. Each file is compressed independently, and large files
+		//are also divided into blocks which are compressed in parallel.
+		ZIPParallelCompressor compressor;
 		buffer.SetStreamPos(0);
-		if(!entry.Compress(buffer))
+		if(!compressor.AddFileEntry(L"save.xml", buffer))
 		{
-			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + filePath + L" because there was an error compressing the save.xml file!"));
-			if(running)
-			{
-				RunSystem();
-			}
+			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error compressing the save.xml file!"));
 			return false;
 		}
-		archive.AddFileEntry(entry);
 
 		//Save external binary data to separate files
 		std::list<IHierarchicalStorageNode*> binaryList;
-		binaryList = tree.GetBinaryDataNodeList();
+		binaryList = capture.tree.GetBinaryDataNodeList();
 		for(std::list<IHierarchicalStorageNode*>::iterator i = binaryList.begin(); i != binaryList.end(); ++i)
 		{
-			ZIPFileEntry entry;
+			//Compress the binary data directly from the node, which may refer to memory
+			//owned by a device, without taking a copy of it.
 			std::wstring binaryFileName = (*i)->GetBinaryDataBufferName() + L".bin";
-			entry.SetFileName(binaryFileName);
-			Stream::IStream& binaryData = (*i)->GetBinaryDataBufferStream();
-			binaryData.SetStreamPos(0);
-			if(!entry.Compress(binaryData))
-			{
-				WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + filePath + L" because there was an error compressing the " + binaryFileName + L" file!"));
-				if(running)
-				{
-					RunSystem();
-				}
-				return false;
-			}
-			archive.AddFileEntry(entry);
+			const unsigned char* binaryData;
+			size_t binaryDataSize;
+			(*i)->GetBinaryDataView(binaryData, binaryDataSize);
+			compressor.AddFileEntry(binaryFileName, binaryData, binaryDataSize);
 		}
 
-		//Add the screenshot file
-		if(screenshotPresent)
+		//Compress all the files into the archive, following the entries above
+		if(!compressor.CompressFileEntries(archive))
 		{
-			ZIPFileEntry entry;
-			entry.SetFileName(screenshotFilename);
-			Stream::Buffer screenshotFile(0);
-			if(!screenshot.SavePNGImage(screenshotFile))
-			{
-				WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + filePath + L" because there was an error creating the screenshot file with a file name of " + screenshotFilename + L"!"));
-				if(running)
-				{
-					RunSystem();
-				}
-				return false;
-			}
-			screenshotFile.SetStreamPos(0);
-			if(!entry.Compress(screenshotFile))
-			{
-				WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + filePath + L" because there was an error compressing the " + screenshotFilename + L" file!"));
-				if(running)
-				{
-					RunSystem();
-				}
-				return false;
-			}
-			archive.AddFileEntry(entry);
+			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error compressing the " + compressor.GetFailedFileName() + L" file!"));
+			return false;
 		}
 
 		//Create the target file
 		Stream::File target;
-		if(!target.Open(filePath, Stream::File::OpenMode::ReadAndWrite, Stream::File::CreateMode::Create))
+		if(!target.Open(capture.filePath, Stream::File::OpenMode::ReadAndWrite, Stream::File::CreateMode::Create))
 		{
-			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + filePath + L" because there was an error creating the file at the full path of " + filePath + L"!"));
-			if(running)
-			{
-				RunSystem();
-			}
+			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error creating the file at the full path of " + capture.filePath + L"!"));
 			return false;
 		}
 		if(!archive.SaveToStream(target))
 		{
-			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + filePath + L" because there was an error saving the zip structure to the file!"));
-			if(running)
-			{
-				RunSystem();
-			}
+			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error saving the zip structure to the file!"));
 			return false;
 		}
 	}
-	else if(fileType == FileType::XML)
+	else if(capture.fileType == FileType::XML)
 	{
 		//Save XML tree to the target file
 		Stream::File file(Stream::IStream::TextEncoding::UTF8);
-		if(!file.Open(filePath, Stream::File::OpenMode::ReadAndWrite, Stream::File::CreateMode::Create))
+		if(!file.Open(capture.filePath, Stream::File::OpenMode::ReadAndWrite, Stream::File::CreateMode::Create))
 		{
-			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + filePath + L" because there was an error creating the file at the full path of " + filePath + L"!"));
-			if(running)
-			{
-				RunSystem();
-			}
+			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error creating the file at the full path of " + capture.filePath + L"!"));
 			return false;
 		}
 		file.InsertByteOrderMark();
-		if(!tree.SaveTree(file))
+		if(!capture.tree.SaveTree(file))
 		{
-			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + filePath + L" because there was an error saving the xml tree. The xml error string is as follows: " + tree.GetErrorString()));
-			if(running)
-			{
-				RunSystem();
-			}
+			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error saving the xml tree. The xml error string is as follows: " + capture.tree.GetErrorString()));
 			return false;
 		}
 
 		//Save external binary data to separate files
-		std::wstring fileName = PathGetFileName(filePath);
-		std::wstring fileDir = PathGetDirectory(filePath);
+		std::wstring fileName = PathGetFileName(capture.filePath);
+		std::wstring fileDir = PathGetDirectory(capture.filePath);
 		std::list<IHierarchicalStorageNode*> binaryList;
-		binaryList = tree.GetBinaryDataNodeList();
+		binaryList = capture.tree.GetBinaryDataNodeList();
 		for(std::list<IHierarchicalStorageNode*>::iterator i = binaryList.begin(); i != binaryList.end(); ++i)
 		{
 			std::wstring binaryFileName = fileName + L" - " + (*i)->GetBinaryDataBufferName() + L".bin";
@@ -536,78 +591,236 @@ bool System::SaveState(const MarshalSupport::Marshal::In<std::wstring>& filePath
 			Stream::File binaryFile;
 			if(!binaryFile.Open(binaryFilePath, Stream::File::OpenMode::ReadAndWrite, Stream::File::CreateMode::Create))
 			{
-				WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + filePath + L" because there was an error creating the binary data file " + binaryFileName + L" at the full path of " + binaryFilePath + L"!"));
-				if(running)
-				{
-					RunSystem();
-				}
+				WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error creating the binary data file " + binaryFileName + L" at the full path of " + binaryFilePath + L"!"));
 				return false;
 			}
 
-			Stream::IStream& binaryData = (*i)->GetBinaryDataBufferStream();
-			binaryData.SetStreamPos(0);
-			while(!binaryData.IsAtEnd())
+			const unsigned char* binaryData;
+			size_t binaryDataSize;
+			(*i)->GetBinaryDataView(binaryData, binaryDataSize);
+			if((binaryDataSize > 0) && !binaryFile.WriteData(binaryData, (Stream::IStream::SizeType)binaryDataSize))
 			{
-				unsigned char temp;
-				if(!binaryData.ReadData(temp))
-				{
-					WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + filePath + L" because there was an error reading the source data from memory to save to the binary data file " + binaryFileName + L"!"));
-					if(running)
-					{
-						RunSystem();
-					}
-					return false;
-				}
-				if(!binaryFile.WriteData(temp))
-				{
-					WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + filePath + L" because there was an error writing to the binary data file " + binaryFileName + L"!"));
-					if(running)
-					{
-						RunSystem();
-					}
-					return false;
-				}
+				WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error writing to the binary data file " + binaryFileName + L"!"));
+				return false;
 			}
 		}
 
 		//Save the screenshot file
-		if(screenshotPresent)
+		if(capture.screenshotPresent)
 		{
-			std::wstring screenshotFilenameFull = fileName + L" - " + screenshotFilename;
+			std::wstring screenshotFilenameFull = fileName + L" - " + capture.screenshotFilename;
 			std::wstring screenshotFilePath = PathCombinePaths(fileDir, screenshotFilenameFull);
 			Stream::File screenshotFile;
 			if(!screenshotFile.Open(screenshotFilePath, Stream::File::OpenMode::ReadAndWrite, Stream::File::CreateMode::Create))
 			{
-				WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + filePath + L" because there was an error creating the screenshot file with a file name of " + screenshotFilenameFull + L" with a full path of " + screenshotFilePath + L"!"));
-				if(running)
-				{
-					RunSystem();
-				}
+				WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error creating the screenshot file with a file name of " + screenshotFilenameFull + L" with a full path of " + screenshotFilePath + L"!"));
 				return false;
 			}
-			if(!screenshot.SavePNGImage(screenshotFile))
+			if(!capture.screenshot.SavePNGImage(screenshotFile))
 			{
-				WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + filePath + L" because there was an error saving the screenshot to the " + screenshotFilenameFull + L" file!"));
-				if(running)
-				{
-					RunSystem();
-				}
+				WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error saving the screenshot to the " + screenshotFilenameFull + L" file!"));
 				return false;
 			}
 		}
 	}
+	else if(capture.fileType == FileType::Binary)
+	{
+		//The binary format is a single file, so the screenshot is stored within the tree
+		//itself, as binary data in a child of the info node.
+		capture.tree.SetStorageMode(IHierarchicalStorageTree::StorageMode::Binary);
+		IHierarchicalStorageNode* stateInfo = capture.tree.GetRootNode().GetChild(L"Info");
+		if(capture.screenshotPresent && (stateInfo != 0))
+		{
+			Stream::Buffer screenshotFile(0);
+			if(!capture.screenshot.SavePNGImage(screenshotFile))
+			{
+				WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error creating the screenshot file with a file name of " + capture.screenshotFilename + L"!"));
+				return false;
+			}
+			stateInfo->CreateChild(L"Screenshot").InsertBinaryData(screenshotFile.GetRawBuffer(), (size_t)screenshotFile.Size(), capture.screenshotFilename);
+		}
+
+		//Save the binary tree to the target file
+		Stream::File file;
+		if(!file.Open(capture.filePath, Stream::File::OpenMode::ReadAndWrite, Stream::File::CreateMode::Create))
+		{
+			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error creating the file at the full path of " + capture.filePath + L"!"));
+			return false;
+		}
+		if(!capture.tree.SaveTree(file))
+		{
+			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save state to file " + capture.filePath + L" because there was an error saving the binary tree. The error string is as follows: " + capture.tree.GetErrorString()));
+			return false;
+		}
+	}
 
 	//Log the event
-	WriteLogEvent(LogEntry(LogEntry::EventLevel::Info, L"System", L"Saved state to file " + filePath));
+	WriteLogEvent(LogEntry(LogEntry::EventLevel::Info, L"System", L"Saved state to file " + capture.filePath));
 
-	//Restore running state
-	if(running)
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+void System::WaitForAsyncSaveStates()
+{
+	std::unique_lock<std::mutex> lock(savestateWriterMutex);
+	while(!pendingSavestateWrites.empty())
 	{
-		RunSystem();
+		savestateWritesComplete.wait(lock);
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void System::SavestateWriterThread()
+{
+	std::unique_lock<std::mutex> lock(savestateWriterMutex);
+	while(savestateWriterThreadActive || !pendingSavestateWrites.empty())
+	{
+		//Wait for a savestate to be queued, or for the writer thread to be stopped
+		if(pendingSavestateWrites.empty())
+		{
+			savestateWriterUpdate.wait(lock);
+			continue;
+		}
+
+		//Write the next queued savestate without holding the lock. Note that we leave the
+		//entry in the queue until the write is complete, so that the save is still seen
+		//as pending while it's being written.
+		SavestateCapture* capture = pendingSavestateWrites.front();
+		lock.unlock();
+		bool result = WriteSaveState(*capture);
+		std::wstring filePath = capture->filePath;
+		delete capture;
+		lock.lock();
+		lastAsyncSaveStateResult = result;
+		lastAsyncSaveStateFilePath = filePath;
+		pendingSavestateWrites.pop_front();
+		if(pendingSavestateWrites.empty())
+		{
+			savestateWritesComplete.notify_all();
+		}
+
+		//Notify any observers that a savestate has been written
+		lock.unlock();
+		savestateWriteCompleteObservers.NotifyObservers();
+		lock.lock();
 	}
+}
+
+//----------------------------------------------------------------------------------------
+bool System::LoadStateNodes(IHierarchicalStorageNode& rootNode, bool debuggerState, const std::wstring& stateSourceName)
+{
+	//Validate the root node
+	if(rootNode.GetName() != L"State")
+	{
+		WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to load state from " + stateSourceName + L" because the root node in the state tree wasn't of type \"State\"!"));
+		return false;
+	}
+
+	//Restore system state from the tree
+	ModuleRelationshipMap relationshipMap;
+	std::list<IHierarchicalStorageNode*> childList = rootNode.GetChildList();
+	for(std::list<IHierarchicalStorageNode*>::iterator i = childList.begin(); i != childList.end(); ++i)
+	{
+		std::wstring elementName = (*i)->GetName();
+
+		//Load the device node
+		if(elementName == L"Device")
+		{
+			//Extract the mandatory attributes
+			IHierarchicalStorageAttribute* nameAttribute = (*i)->GetAttribute(L"Name");
+			IHierarchicalStorageAttribute* moduleIDAttribute = (*i)->GetAttribute(L"ModuleID");
+			if((nameAttribute != 0) && (moduleIDAttribute != 0))
+			{
+				std::wstring deviceName = nameAttribute->GetValue();
+				unsigned int savedModuleID = moduleIDAttribute->ExtractValue<unsigned int>();
+
+				//Attempt to locate a matching loaded device
+				bool foundDevice = false;
+				IDevice* device = 0;
+				ModuleRelationshipMap::const_iterator relationshipMapIterator = relationshipMap.find(savedModuleID);
+				if(relationshipMapIterator != relationshipMap.end())
+				{
+					const ModuleRelationship& moduleRelationship = relationshipMapIterator->second;
+					if(moduleRelationship.foundMatch)
+					{
+						device = GetDevice(moduleRelationship.loadedModuleID, deviceName);
+						if(device != 0)
+						{
+							foundDevice = true;
+						}
+					}
+				}
+
+				//If we found a matching device, load the state for this device.
+				if(foundDevice)
+				{
+					if(debuggerState)
+					{
+						device->LoadDebuggerState(*(*i));
+					}
+					else
+					{
+						//Note that we negate the output line state here, and re-assert it
+						//after loading the state data. This is technically unnecessary
+						//when loading complete system states, but is very important when
+						//loading partial system states.
+						device->NegateCurrentOutputLineState();
+						device->LoadState(*(*i));
+						device->AssertCurrentOutputLineState();
+					}
+				}
+
+				//If a matching loaded device couldn't be located, log an error.
+				if(!foundDevice)
+				{
+					WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"While loading state data from " + stateSourceName + L" state data was found for device " + deviceName + L" , which could not be located in the system. The state data for this device will be ignored, and the state will continue to load, but note that the system may not run as expected."));
+				}
+			}
+		}
+		//Load the ModuleRelationships node
+		else if(elementName == L"ModuleRelationships")
+		{
+			if(!LoadModuleRelationshipsNode(*(*i), relationshipMap))
+			{
+				WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to load state from " + stateSourceName + L" because the ModuleRelationships node could not be loaded!"));
+				return false;
+			}
+		}
+		else
+		{
+			//Log a warning for an unrecognized element
+			WriteLogEvent(LogEntry(LogEntry::EventLevel::Warning, L"System", L"Unrecognized element: " + elementName + L" when loading state from " + stateSourceName + L"."));
+		}
+	}
+
 	return true;
 }
 
+//----------------------------------------------------------------------------------------
+void System::SaveStateNodes(IHierarchicalStorageNode& rootNode, bool debuggerState) const
+{
+	//Save the ModuleRelationships node
+	IHierarchicalStorageNode& moduleRelationshipsNode = rootNode.CreateChild(L"ModuleRelationships");
+	SaveModuleRelationshipsNode(moduleRelationshipsNode);
+
+	//Save the system state to the tree
+	for(LoadedDeviceInfoList::const_iterator i = loadedDeviceInfoList.begin(); i != loadedDeviceInfoList.end(); ++i)
+	{
+		IHierarchicalStorageNode& node = rootNode.CreateChild(L"Device");
+		node.CreateAttribute(L"Name", (*i).device->GetDeviceInstanceName());
+		node.CreateAttribute(L"ModuleID").SetValue((*i).moduleID);
+		if(debuggerState)
+		{
+			(*i).device->SaveDebuggerState(node);
+		}
+		else
+		{
+			(*i).device->SaveState(node);
+		}
+	}
+}
+
 //----------------------------------------------------------------------------------------
 bool System::LoadPersistentStateForModule(const std::wstring& filePath, unsigned int moduleID, FileType fileType, bool returnSuccessOnNoFilePresent)
 {
@@ -739,6 +952,16 @@ bool System::LoadPersistentStateForModule(const std::wstring& filePath, unsigned
 			delete[] buffer;
 		}
 	}
+	else if(fileType == FileType::Binary)
+	{
+		//Attempt to load the binary tree from the file
+		tree.SetStorageMode(IHierarchicalStorageTree::StorageMode::Binary);
+		if(!tree.LoadTree(source))
+		{
+			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to load persistent state from file " + filePath + L" because the binary structure could not be decoded! The decode error string is as follows: " + tree.GetErrorString()));
+			return false;
+		}
+	}
 
 	//Validate the root node
 	IHierarchicalStorageNode& rootNode = tree.GetRootNode();
@@ -850,33 +1073,32 @@ bool System::SavePersistentStateForModule(const std::wstring& filePath, unsigned
 			return false;
 		}
 
-		ZIPArchive archive;
-		ZIPFileEntry entry;
-		entry.SetFileName(L"save.xml");
+		ZIPParallelCompressor compressor;
 		buffer.SetStreamPos(0);
-		if(!entry.Compress(buffer))
+		if(!compressor.AddFileEntry(L"save.xml", buffer))
 		{
 			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save persistent state to file " + filePath + L" because there was an error compressing the save.xml file!"));
 			return false;
 		}
-		archive.AddFileEntry(entry);
 
 		//Save external binary data to separate files
 		std::list<IHierarchicalStorageNode*> binaryList;
 		binaryList = tree.GetBinaryDataNodeList();
 		for(std::list<IHierarchicalStorageNode*>::iterator i = binaryList.begin(); i != binaryList.end(); ++i)
 		{
-			ZIPFileEntry entry;
 			std::wstring binaryFileName = (*i)->GetBinaryDataBufferName() + L".bin";
-			entry.SetFileName(binaryFileName);
-			Stream::IStream& binaryData = (*i)->GetBinaryDataBufferStream();
-			binaryData.SetStreamPos(0);
-			if(!entry.Compress(binaryData))
-			{
-				WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save persistent state to file " + filePath + L" because there was an error compressing the " + binaryFileName + L" file!"));
-				return false;
-			}
-			archive.AddFileEntry(entry);
+			const unsigned char* binaryData;
+			size_t binaryDataSize;
+			(*i)->GetBinaryDataView(binaryData, binaryDataSize);
+			compressor.AddFileEntry(binaryFileName, binaryData, binaryDataSize);
+		}
+
+		//Compress all the files into the archive
+		ZIPArchive archive;
+		if(!compressor.CompressFileEntries(archive))
+		{
+			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save persistent state to file " + filePath + L" because there was an error compressing the " + compressor.GetFailedFileName() + L" file!"));
+			return false;
 		}
 
 		//Create the target file
@@ -924,24 +1146,32 @@ bool System::SavePersistentStateForModule(const std::wstring& filePath, unsigned
 				return false;
 			}
 
-			Stream::IStream& binaryData = (*i)->GetBinaryDataBufferStream();
-			binaryData.SetStreamPos(0);
-			while(!binaryData.IsAtEnd())
+			const unsigned char* binaryData;
+			size_t binaryDataSize;
+			(*i)->GetBinaryDataView(binaryData, binaryDataSize);
+			if((binaryDataSize > 0) && !binaryFile.WriteData(binaryData, (Stream::IStream::SizeType)binaryDataSize))
 			{
-				unsigned char temp;
-				if(!binaryData.ReadData(temp))
-				{
-					WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save persistent state to file " + filePath + L" because there was an error reading the source data from memory to save to the binary data file " + binaryFileName + L"!"));
-					return false;
-				}
-				if(!binaryFile.WriteData(temp))
-				{
-					WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save persistent state to file " + filePath + L" because there was an error writing to the binary data file " + binaryFileName + L"!"));
-					return false;
-				}
+				WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save persistent state to file " + filePath + L" because there was an error writing to the binary data file " + binaryFileName + L"!"));
+				return false;
 			}
 		}
 	}
+	else if(fileType == FileType::Binary)
+	{
+		//Save the binary tree to the target file
+		tree.SetStorageMode(IHierarchicalStorageTree::StorageMode::Binary);
+		Stream::File file;
+		if(!file.Open(filePath, Stream::File::OpenMode::ReadAndWrite, Stream::File::CreateMode::Create))
+		{
+			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save persistent state to file " + filePath + L" because there was an error creating the file at the full path of " + filePath + L"!"));
+			return false;
+		}
+		if(!tree.SaveTree(file))
+		{
+			WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to save persistent state to file " + filePath + L" because there was an error saving the binary tree. The error string is as follows: " + tree.GetErrorString()));
+			return false;
+		}
+	}
 
 	//Log the event
 	WriteLogEvent(LogEntry(LogEntry::EventLevel::Info, L"System", L"Saved persistent state to file " + filePath));
@@ -966,30 +1196,50 @@ MarshalSupport::Marshal::Ret<System::StateInfo> System::GetStateInfo(const Marsh
 	HierarchicalStorageTree tree;
 	if(fileType == FileType::ZIP)
 	{
-		//Load the ZIP header structure
-		ZIPArchive archive;
-		if(!archive.LoadFromStream(source))
-		{
-			return stateInfo;
-		}
-
-		//Load XML tree from file
-		ZIPFileEntry* entry = archive.GetFileEntry(L"save.xml");
-		if(entry == 0)
-		{
-			return stateInfo;
-		}
-		Stream::Buffer buffer(0);
-		if(!entry->Decompress(buffer))
-		{
-			return stateInfo;
+		//Savestates hold a copy of the savestate info node in a small uncompressed file at
+		//the start of the archive. If this file is present, we load the savestate info
+		//from it, which avoids reading or decompressing the full system state. Otherwise,
+		//we fall back to loading the info from the full state tree.
+		ZIPFileEntry infoEntry;
+		Stream::Buffer infoBuffer(0);
+		if(ZIPArchive::LoadFileEntryFromStream(source, L"info.xml", infoEntry) && infoEntry.Decompress(infoBuffer))
+		{
+			infoBuffer.SetStreamPos(0);
+			infoBuffer.SetTextEncoding(Stream::IStream::TextEncoding::UTF8);
+			infoBuffer.ProcessByteOrderMark();
+			if(!tree.LoadTree(infoBuffer))
+			{
+				return stateInfo;
+			}
 		}
-		buffer.SetStreamPos(0);
-		buffer.SetTextEncoding(Stream::IStream::TextEncoding::UTF8);
-		buffer.ProcessByteOrderMark();
-		if(!tree.LoadTree(buffer))
+		else
 		{
-			return stateInfo;
+			//Load the ZIP header structure
+			ZIPArchive archive;
+			source.SetStreamPos(0);
+			if(!archive.LoadFromStream(source))
+			{
+				return stateInfo;
+			}
+
+			//Load XML tree from file
+			ZIPFileEntry* entry = archive.GetFileEntry(L"save.xml");
+			if(entry == 0)
+			{
+				return stateInfo;
+			}
+			Stream::Buffer buffer(0);
+			if(!entry->Decompress(buffer))
+			{
+				return stateInfo;
+			}
+			buffer.SetStreamPos(0);
+			buffer.SetTextEncoding(Stream::IStream::TextEncoding::UTF8);
+			buffer.ProcessByteOrderMark();
+			if(!tree.LoadTree(buffer))
+			{
+				return stateInfo;
+			}
 		}
 	}
 	else if(fileType == FileType::XML)
@@ -1001,6 +1251,14 @@ MarshalSupport::Marshal::Ret<System::StateInfo> System::GetStateInfo(const Marsh
 			return stateInfo;
 		}
 	}
+	else if(fileType == FileType::Binary)
+	{
+		tree.SetStorageMode(IHierarchicalStorageTree::StorageMode::Binary);
+		if(!tree.LoadTree(source))
+		{
+			return stateInfo;
+		}
+	}
 
 	//Load savestate info from XML data
 	IHierarchicalStorageNode& rootNode = tree.GetRootNode();
@@ -2089,6 +2347,352 @@ void System::SetEnablePersistentState(bool state)
 	enablePersistentState = state;
 }
 
+//----------------------------------------------------------------------------------------
+//Rewind functions
+//----------------------------------------------------------------------------------------
+bool System::GetRewindEnabled() const
+{
+	std::unique_lock<std::mutex> lock(rewindMutex);
+	return enableRewind;
+}
+
+//----------------------------------------------------------------------------------------
+void System::SetRewindEnabled(bool state)
+{
+	std::unique_lock<std::mutex> lock(rewindMutex);
+	enableRewind = state;
+	emulatedTimeSinceRewindCapture = 0;
+
+	//Release the memory held by the rewind history when rewind is disabled
+	if(!enableRewind)
+	{
+		rewindBuffer.Clear();
+	}
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int System::GetRewindCaptureIntervalInMilliseconds() const
+{
+	std::unique_lock<std::mutex> lock(rewindMutex);
+	return rewindCaptureIntervalInMilliseconds;
+}
+
+//----------------------------------------------------------------------------------------
+void System::SetRewindCaptureIntervalInMilliseconds(unsigned int milliseconds)
+{
+	std::unique_lock<std::mutex> lock(rewindMutex);
+	rewindCaptureIntervalInMilliseconds = (milliseconds > 0)? milliseconds: 1;
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int System::GetRewindMemoryLimit() const
+{
+	std::unique_lock<std::mutex> lock(rewindMutex);
+	return (unsigned int)rewindBuffer.GetMemoryLimit();
+}
+
+//----------------------------------------------------------------------------------------
+void System::SetRewindMemoryLimit(unsigned int sizeInBytes)
+{
+	std::unique_lock<std::mutex> lock(rewindMutex);
+	rewindBuffer.SetMemoryLimit(sizeInBytes);
+}
+
+//----------------------------------------------------------------------------------------
+bool System::StepRewindBackward()
+{
+	//Save running state and pause system
+	bool running = SystemRunning();
+	StopSystem();
+
+	//Retrieve the most recent snapshot from the rewind history. Note that we restart the
+	//capture interval here, so that the next snapshot is taken a full interval after the
+	//restored state.
+	std::vector<unsigned char> stateData;
+	std::unique_lock<std::mutex> lock(rewindMutex);
+	bool snapshotPresent = rewindBuffer.RemoveLatestSnapshot(stateData);
+	emulatedTimeSinceRewindCapture = 0;
+	lock.unlock();
+	if(!snapshotPresent)
+	{
+		if(running)
+		{
+			RunSystem();
+		}
+		return false;
+	}
+
+	//Decode the state tree from the snapshot
+	Stream::Buffer buffer(0);
+	buffer.WriteData(&stateData[0], (Stream::IStream::SizeType)stateData.size());
+	buffer.SetStreamPos(0);
+	HierarchicalStorageTree tree;
+	tree.SetStorageMode(IHierarchicalStorageTree::StorageMode::Binary);
+	if(!tree.LoadTree(buffer))
+	{
+		WriteLogEvent(LogEntry(LogEntry::EventLevel::Error, L"System", L"Failed to restore state from the rewind buffer because the binary structure could not be decoded! The decode error string is as follows: " + tree.GetErrorString()));
+		if(running)
+		{
+			RunSystem();
+		}
+		return false;
+	}
+
+	//Restore the system state from the decoded tree
+	bool result = LoadStateNodes(tree.GetRootNode(), false, L"the rewind buffer");
+
+	//Restore running state
+	if(running)
+	{
+		RunSystem();
+	}
+	return result;
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int System::GetRewindSnapshotCount() const
+{
+	std::unique_lock<std::mutex> lock(rewindMutex);
+	return rewindBuffer.GetSnapshotCount();
+}
+
+//----------------------------------------------------------------------------------------
+unsigned int System::GetRewindMemoryUsage() const
+{
+	std::unique_lock<std::mutex> lock(rewindMutex);
+	return (unsigned int)rewindBuffer.GetMemoryUsage();
+}
+
+//----------------------------------------------------------------------------------------
+double System::GetRewindCaptureTimePerSecond() const
+{
+	//Since a snapshot is only captured once per capture interval, we return the average
+	//time in milliseconds taken to capture a snapshot, spread across each second of
+	//emulated time.
+	std::unique_lock<std::mutex> lock(rewindMutex);
+	return rewindAverageCaptureTime * (1000.0 / (double)rewindCaptureIntervalInMilliseconds);
+}
+
+//----------------------------------------------------------------------------------------
+void System::CaptureRewindSnapshot()
+{
+	LARGE_INTEGER counterFrequency;
+	LARGE_INTEGER captureStartTime;
+	QueryPerformanceFrequency(&counterFrequency);
+	QueryPerformanceCounter(&captureStartTime);
+
+	//Save the system state. We suspend active device threads while we do this, in the
+	//same way as when the system is stopped for a savestate, to ensure the state of each
+	//device reflects the end of the last system step. Note that the state needs to be
+	//serialized before we resume execution, since nodes may refer directly to memory
+	//owned by devices.
+	Stream::Buffer buffer(0);
+	executionManager.SuspendExecution();
+	bool stateSaved = SaveRewindState(buffer);
+	executionManager.BeginExecution();
+	if(!stateSaved)
+	{
+		return;
+	}
+
+	//Add the snapshot to the rewind history
+	std::unique_lock<std::mutex> lock(rewindMutex);
+	rewindBuffer.AddSnapshot(buffer.GetRawBuffer(), (size_t)buffer.Size());
+
+	//Update our running average of the capture time
+	LARGE_INTEGER captureEndTime;
+	QueryPerformanceCounter(&captureEndTime);
+	double captureTime = ((double)(captureEndTime.QuadPart - captureStartTime.QuadPart) * 1000.0) / (double)counterFrequency.QuadPart;
+	rewindAverageCaptureTime = (rewindAverageCaptureTime == 0)? captureTime: (rewindAverageCaptureTime + ((captureTime - rewindAverageCaptureTime) / 16.0));
+}
+
+//----------------------------------------------------------------------------------------
+bool System::SaveRewindState(Stream::Buffer& buffer) const
+{
+	//Save the system state to a new tree
+	HierarchicalStorageTree tree;
+	tree.GetRootNode().SetName(L"State");
+	SaveStateNodes(tree.GetRootNode(), false);
+
+	//Serialize the tree using the binary storage format. Besides being quicker to produce
+	//than the XML format, binary data is stored raw in this format, so regions of memory
+	//which haven't changed between snapshots produce identical bytes, and are removed by
+	//the difference encoding in the rewind buffer.
+	tree.SetStorageMode(IHierarchicalStorageTree::StorageMode::Binary);
+	if(!tree.SaveTree(buffer))
+	{
+		WriteLogEvent(LogEntry(LogEntry::EventLevel::Warning, L"System", L"Failed to capture a rewind snapshot. The error string is as follows: " + tree.GetErrorString()));
+		return false;
+	}
+	return true;
+}
+
+//----------------------------------------------------------------------------------------
+void System::ClearRewindHistory()
+{
+	std::unique_lock<std::mutex> lock(rewindMutex);
+	rewindBuffer.Clear();
+	emulatedTimeSinceRewindCapture = 0;
+}
+
+//----------------------------------------------------------------------------------------
+//Audio output functions
+//----------------------------------------------------------------------------------------
+System::AudioOutputTarget System::GetAudioOutputTarget() const
+{
+	std::unique_lock<std::mutex> lock(audioOutputMutex);
+	return audioOutputTarget;
+}
+
+//----------------------------------------------------------------------------------------
+void System::SetAudioOutputTarget(AudioOutputTarget target)
+{
+	//Switch every open sink over to the new target. Devices keep writing to the same sink
+	//object throughout, so their output streams don't need to be reopened.
+	std::unique_lock<std::mutex> lock(audioOutputMutex);
+	if(target == audioOutputTarget)
+	{
+		return;
+	}
+	for(std::list<AudioOutputSink*>::const_iterator i = audioOutputSinks.begin(); i != audioOutputSinks.end(); ++i)
+	{
+		if(audioOutputTarget == AudioOutputTarget::None)
+		{
+			LogDiscardedAudioOutput(**i);
+		}
+		(*i)->SetOutputTarget(target, capturePath);
+	}
+	audioOutputTarget = target;
+}
+
+//----------------------------------------------------------------------------------------
+IAudioSink* System::OpenAudioOutputSink(IDeviceContext* deviceContext)
+{
+	std::unique_lock<std::mutex> lock(audioOutputMutex);
+	if(audioMixer == 0)
+	{
+		StartAudioMixer();
+	}
+	std::wstring deviceInstanceName = ((DeviceContext*)deviceContext)->GetFullyQualifiedDeviceInstanceName();
+	AudioOutputSink* sink = new AudioOutputSink(*audioMixer, deviceInstanceName, audioOutputTarget, capturePath);
+	audioOutputSinks.push_back(sink);
+	return sink;
+}
+
+//----------------------------------------------------------------------------------------
+void System::CloseAudioOutputSink(IAudioSink* sink)
+{
+	std::unique_lock<std::mutex> lock(audioOutputMutex);
+	for(std::list<AudioOutputSink*>::iterator i = audioOutputSinks.begin(); i != audioOutputSinks.end(); ++i)
+	{
+		if(*i == sink)
+		{
+			AudioOutputSink* outputSink = *i;
+			audioOutputSinks.erase(i);
+			outputSink->Close();
+			LogDiscardedAudioOutput(*outputSink);
+			delete outputSink;
+			if(audioOutputSinks.empty())
+			{
+				StopAudioMixer();
+			}
+			return;
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------
+void System::LogDiscardedAudioOutput(const AudioOutputSink& sink) const
+{
+	//If this sink discarded its output, log how many samples it was given, and the checksum
+	//of their values. Running the same input twice with the output target set to none and
+	//comparing these figures confirms that the audio output of a device is deterministic.
+	unsigned long long sampleCount;
+	unsigned long long sampleChecksum;
+	if(!sink.GetDiscardedSampleInfo(sampleCount, sampleChecksum))
+	{
+		return;
+	}
+	std::wstringstream message;
+	message << L"Discarded " << sampleCount << L" audio samples from " << sink.GetDeviceInstanceName() << L" with checksum " << std::hex << std::setw(16) << std::setfill(L'0') << sampleChecksum;
+	WriteLogEvent(LogEntry(LogEntry::EventLevel::Info, L"System", message.str()));
+}
+
+//----------------------------------------------------------------------------------------
+void System::StartAudioMixer()
+{
+	//Create the audio mixer, and open the audio output stream it feeds. This is the only
+	//stream which is sent to the audio hardware. Audio from each device is fed into a
+	//source on this mixer, and the mixer output thread pulls the combined output as the
+	//hardware consumes it.
+	audioMixer = new AudioMixer(audioMixerChannelCount, audioMixerSamplesPerSec, 0);
+	unsigned int targetLatencySamples = audioMixer->GetTargetLatencySamples();
+	if(!audioMixerStream.Open(audioMixerChannelCount, 16, audioMixerSamplesPerSec, targetLatencySamples * 2, targetLatencySamples / 2))
+	{
+		WriteLogEvent(LogEntry(LogEntry::EventLevel::Warning, L"System", L"Failed to open the audio output device. Audio sent to the speakers will not be heard."));
+	}
+
+	//Start the mixer output thread
+	audioMixerThreadActive = true;
+	audioMixerThread = std::thread(std::bind(std::mem_fn(&System::AudioMixerThread), this));
+}
+
+//----------------------------------------------------------------------------------------
+void System::StopAudioMixer()
+{
+	if(audioMixer == 0)
+	{
+		return;
+	}
+
+	//Stop the mixer output thread
+	std::unique_lock<std::mutex> lock(audioMixerThreadMutex);
+	audioMixerThreadActive = false;
+	audioMixerThreadUpdate.notify_all();
+	lock.unlock();
+	audioMixerThread.join();
+
+	//Close the audio output stream, and delete the mixer
+	audioMixerStream.Close();
+	delete audioMixer;
+	audioMixer = 0;
+}
+
+//----------------------------------------------------------------------------------------
+void System::AudioMixerThread()
+{
+	//Keep the audio output stream filled to the mixer target latency, mixing a new block
+	//of output each time the amount of queued data falls below it. Since blocks are only
+	//mixed as the hardware consumes data, the mixer is called at the rate of the host
+	//sample clock, which is what its rate control relies on.
+	unsigned int blockSampleCount = audioMixerSamplesPerSec / audioMixerBlocksPerSec;
+	unsigned int targetQueuedSampleCount = audioMixer->GetTargetLatencySamples();
+	std::vector<short> mixedData;
+	std::unique_lock<std::mutex> lock(audioMixerThreadMutex);
+	while(audioMixerThreadActive)
+	{
+		lock.unlock();
+		while(audioMixerStream.GetQueuedSampleCount() < targetQueuedSampleCount)
+		{
+			AudioStream::AudioBuffer* outputBuffer = audioMixerStream.CreateAudioBuffer(blockSampleCount, audioMixerChannelCount);
+			if(outputBuffer == 0)
+			{
+				break;
+			}
+			audioMixer->MixSamples(mixedData, blockSampleCount);
+			std::copy(mixedData.begin(), mixedData.end(), outputBuffer->buffer.begin());
+			audioMixerStream.PlayBuffer(outputBuffer);
+		}
+		lock.lock();
+
+		//Wait until about half a block has been consumed before checking again
+		if(audioMixerThreadActive)
+		{
+			audioMixerThreadUpdate.wait_for(lock, std::chrono::milliseconds(500 / audioMixerBlocksPerSec));
+		}
+	}
+}
+
 //----------------------------------------------------------------------------------------
 void System::SignalSystemStopped()
 {
@@ -2422,6 +3026,31 @@ void System::ExecuteThread()
 		if(accumulatedExecutionTime >= 20000000.0)
 //		if(accumulatedExecutionTime >= 1000000000.0)
 		{
+			//Capture a rewind snapshot if one is due. The capture interval is measured in
+			//emulated time, so snapshots are spaced evenly through the emulated system's
+			//execution regardless of how closely we're keeping up with real time. We do
+			//this before synchronizing, so that the time spent on the capture comes out of
+			//the time we would otherwise spend waiting. Note that the rewind settings can
+			//be changed by other threads, so we check them under lock, but release the
+			//lock before capturing, since the capture takes it again to store the
+			//snapshot.
+			std::unique_lock<std::mutex> rewindLock(rewindMutex);
+			bool rewindCaptureDue = false;
+			if(enableRewind)
+			{
+				emulatedTimeSinceRewindCapture += accumulatedExecutionTime;
+				rewindCaptureDue = (emulatedTimeSinceRewindCapture >= ((double)rewindCaptureIntervalInMilliseconds * 1000000.0));
+				if(rewindCaptureDue)
+				{
+					emulatedTimeSinceRewindCapture = 0;
+				}
+			}
+			rewindLock.unlock();
+			if(rewindCaptureDue)
+			{
+				CaptureRewindSnapshot();
+			}
+
 			timer.Sync(accumulatedExecutionTime, enableThrottling, guiExtensionInterface.GetGlobalPreferenceShowDebugConsole());
 			accumulatedExecutionTime = 0;
 		}
@@ -3307,6 +3936,9 @@ bool System::LoadModule(const MarshalSupport::Marshal::In<std::wstring>& filePat
 	//Flag that the load system operation is complete
 	loadSystemComplete = true;
 
+	//Discard the rewind history, since it was captured from a different set of modules.
+	ClearRewindHistory();
+
 	//Notify any registered observers that the set of loaded modules has now changed
 	lock.unlock();
 	loadedModuleChangeObservers.NotifyObservers();
@@ -4348,6 +4980,9 @@ bool System::UnloadModule(unsigned int moduleID)
 		RunSystem();
 	}
 
+	//Discard the rewind history, since it was captured from a different set of modules.
+	ClearRewindHistory();
+
 	//Notify any registered observers that the set of loaded modules has now changed
 	lock.unlock();
 	loadedModuleChangeObservers.NotifyObservers();
@@ -8166,6 +8801,9 @@ void System::UnloadAllModules()
 	//Flag that the operation is complete
 	clearSystemComplete = true;
 
+	//Discard the rewind history, since it was captured from a different set of modules.
+	ClearRewindHistory();
+
 	//Notify any registered observers that the set of loaded modules has now changed
 	lock.unlock();
 	loadedModuleChangeObservers.NotifyObservers();
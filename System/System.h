@@ -26,11 +26,16 @@ should be able to be sent to all devices simultaneously.
 #include "ClockSource.h"
 #include "DeviceContext.h"
 #include "ExecutionManager.h"
+#include "StateRewindBuffer.h"
+#include "AudioOutputSink.h"
+#include "HierarchicalStorage/HierarchicalStorage.pkg"
+#include "Image/Image.pkg"
 #include <string>
 #include <vector>
 #include <map>
 #include <mutex>
 #include <condition_variable>
+#include <thread>
 
 //Terminology:
 //Assembly  - An assembly (IE, a dll) which contains the definition of one or more devices
@@ -73,6 +78,12 @@ public:
 	//Savestate functions
 	virtual bool LoadState(const MarshalSupport::Marshal::In<std::wstring>& filePath, FileType fileType, bool debuggerState);
 	virtual bool SaveState(const MarshalSupport::Marshal::In<std::wstring>& filePath, FileType fileType, bool debuggerState);
+	virtual void SaveStateAsync(const MarshalSupport::Marshal::In<std::wstring>& filePath, FileType fileType, bool debuggerState);
+	virtual bool AsyncSaveStatePending() const;
+	virtual void AsyncSaveStateCompleteNotifyRegister(IObserverSubscription& observer);
+	virtual void AsyncSaveStateCompleteNotifyDeregister(IObserverSubscription& observer);
+	virtual bool GetLastAsyncSaveStateResult() const;
+	virtual MarshalSupport::Marshal::Ret<std::wstring> GetLastAsyncSaveStateFilePath() const;
 	virtual MarshalSupport::Marshal::Ret<StateInfo> GetStateInfo(const MarshalSupport::Marshal::In<std::wstring>& filePath, FileType fileType) const;
 	virtual bool LoadModuleRelationshipsNode(IHierarchicalStorageNode& node, const MarshalSupport::Marshal::Out<ModuleRelationshipMap>& relationshipMap) const;
 	virtual void SaveModuleRelationshipsNode(IHierarchicalStorageNode& node, bool saveFilePathInfo = false, const MarshalSupport::Marshal::In<std::wstring>& relativePathBase = L"") const;
@@ -116,6 +127,24 @@ public:
 	virtual bool GetEnablePersistentState() const;
 	virtual void SetEnablePersistentState(bool state);
 
+	//Rewind functions
+	virtual bool GetRewindEnabled() const;
+	virtual void SetRewindEnabled(bool state);
+	virtual unsigned int GetRewindCaptureIntervalInMilliseconds() const;
+	virtual void SetRewindCaptureIntervalInMilliseconds(unsigned int milliseconds);
+	virtual unsigned int GetRewindMemoryLimit() const;
+	virtual void SetRewindMemoryLimit(unsigned int sizeInBytes);
+	virtual bool StepRewindBackward();
+	virtual unsigned int GetRewindSnapshotCount() const;
+	virtual unsigned int GetRewindMemoryUsage() const;
+	virtual double GetRewindCaptureTimePerSecond() const;
+
+	//Audio output functions
+	virtual AudioOutputTarget GetAudioOutputTarget() const;
+	virtual void SetAudioOutputTarget(AudioOutputTarget target);
+	virtual IAudioSink* OpenAudioOutputSink(IDeviceContext* deviceContext);
+	virtual void CloseAudioOutputSink(IAudioSink* sink);
+
 	//Device registration
 	virtual bool RegisterDevice(const IDeviceInfo& entry, AssemblyHandle assemblyHandle);
 	virtual void UnregisterDevice(const MarshalSupport::Marshal::In<std::wstring>& deviceName);
@@ -247,6 +276,7 @@ private:
 	struct ImportedSystemSettingInfo;
 	struct SystemLineMapping;
 	struct EmbeddedROMInfoInternal;
+	struct SavestateCapture;
 
 	//Typedefs
 	typedef std::map<std::wstring, unsigned int> NameToIDMap;
@@ -303,11 +333,29 @@ private:
 	//Savestate functions
 	bool LoadPersistentStateForModule(const std::wstring& filePath, unsigned int moduleID, FileType fileType, bool returnSuccessOnNoFilePresent);
 	bool SavePersistentStateForModule(const std::wstring& filePath, unsigned int moduleID, FileType fileType, bool generateNoFileIfNoContentPresent);
+	bool LoadStateNodes(IHierarchicalStorageNode& rootNode, bool debuggerState, const std::wstring& stateSourceName);
+	void SaveStateNodes(IHierarchicalStorageNode& rootNode, bool debuggerState) const;
+	void CaptureSaveState(SavestateCapture& capture) const;
+	void SaveStateInfoNode(IHierarchicalStorageNode& stateInfo, const SavestateCapture& capture) const;
+	bool WriteSaveState(SavestateCapture& capture) const;
+	void WaitForAsyncSaveStates();
+	void SavestateWriterThread();
 	bool LoadSavedRelationshipMap(IHierarchicalStorageNode& node, SavedRelationshipMap& relationshipMap) const;
 	void SaveModuleRelationshipsExportConnectors(IHierarchicalStorageNode& moduleNode, unsigned int moduleID) const;
 	void SaveModuleRelationshipsImportConnectors(IHierarchicalStorageNode& moduleNode, unsigned int moduleID) const;
 	bool DoesLoadedModuleMatchSavedModule(const SavedRelationshipMap& savedRelationshipData, const SavedRelationshipModule& savedModuleInfo, const LoadedModuleInfoInternal& loadedModuleInfo, const ConnectorInfoMapOnImportingModuleID& connectorDetailsOnImportingModuleID) const;
 
+	//Rewind functions
+	void CaptureRewindSnapshot();
+	bool SaveRewindState(Stream::Buffer& buffer) const;
+	void ClearRewindHistory();
+
+	//Audio output functions
+	void LogDiscardedAudioOutput(const AudioOutputSink& sink) const;
+	void StartAudioMixer();
+	void StopAudioMixer();
+	void AudioMixerThread();
+
 	//Module loading and unloading
 	unsigned int GetFirstAvailableDeviceIndex() const;
 	unsigned int GenerateFreeModuleID() const;
@@ -538,6 +586,43 @@ private:
 	bool runWhenProgramModuleLoaded;
 	bool enablePersistentState;
 
+	//Rewind settings
+	//Note that the capture interval is measured in emulated time, not real time.
+	static const unsigned int defaultRewindCaptureIntervalInMilliseconds = 200;
+	static const unsigned int defaultRewindKeyframeInterval = 30;
+	static const unsigned int defaultRewindMemoryLimit = 64 * 1024 * 1024;
+	mutable std::mutex rewindMutex;
+	bool enableRewind;
+	unsigned int rewindCaptureIntervalInMilliseconds;
+	double emulatedTimeSinceRewindCapture;
+	StateRewindBuffer rewindBuffer;
+	double rewindAverageCaptureTime;
+
+	//Audio output settings
+	static const unsigned int audioMixerChannelCount = 2;
+	static const unsigned int audioMixerSamplesPerSec = 48000;
+	static const unsigned int audioMixerBlocksPerSec = 200;
+	mutable std::mutex audioOutputMutex;
+	AudioOutputTarget audioOutputTarget;
+	std::list<AudioOutputSink*> audioOutputSinks;
+	AudioMixer* audioMixer;
+	AudioStream audioMixerStream;
+	std::mutex audioMixerThreadMutex;
+	std::condition_variable audioMixerThreadUpdate;
+	std::thread audioMixerThread;
+	bool audioMixerThreadActive;
+
+	//Asynchronous savestate settings
+	mutable std::mutex savestateWriterMutex;
+	std::condition_variable savestateWriterUpdate;
+	std::condition_variable savestateWritesComplete;
+	std::thread savestateWriterThread;
+	bool savestateWriterThreadActive;
+	std::list<SavestateCapture*> pendingSavestateWrites;
+	ObserverCollection savestateWriteCompleteObservers;
+	bool lastAsyncSaveStateResult;
+	std::wstring lastAsyncSaveStateFilePath;
+
 	//Connector settings
 	mutable unsigned int nextFreeConnectorID;
 	ConnectorDetailsMap connectorDetailsMap;
@@ -476,3 +476,17 @@ struct System::EmbeddedROMInfoInternal
 	unsigned int romEntryBitCount;
 	std::wstring filePath;
 };
+
+//----------------------------------------------------------------------------------------
+struct System::SavestateCapture
+{
+	std::wstring filePath;
+	FileType fileType;
+	bool debuggerState;
+	std::wstring creationDate;
+	std::wstring creationTime;
+	HierarchicalStorageTree tree;
+	Image screenshot;
+	bool screenshotPresent;
+	std::wstring screenshotFilename;
+};
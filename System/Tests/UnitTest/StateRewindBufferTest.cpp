@@ -0,0 +1,174 @@
+#include "catch.hpp"
+#include "StateRewindBuffer.h"
+#include <random>
+#include <sstream>
+#include <vector>
+
+//----------------------------------------------------------------------------------------
+//Test helpers
+//----------------------------------------------------------------------------------------
+//Builds a sequence of snapshots which change in the same way as a serialized system
+//state. Each snapshot is a copy of the one before it with a few scattered bytes and a few
+//larger blocks changed, and the size of the state changes occasionally.
+//----------------------------------------------------------------------------------------
+static std::vector<std::vector<unsigned char>> BuildSnapshots(unsigned int snapshotCount, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	std::vector<std::vector<unsigned char>> snapshots(snapshotCount);
+	std::vector<unsigned char> state(64 * 1024);
+	for(size_t i = 0; i < state.size(); ++i)
+	{
+		state[i] = (unsigned char)random();
+	}
+	for(unsigned int snapshotNo = 0; snapshotNo < snapshotCount; ++snapshotNo)
+	{
+		for(unsigned int changeNo = 0; changeNo < 32; ++changeNo)
+		{
+			state[random() % state.size()] = (unsigned char)random();
+		}
+		for(unsigned int blockNo = 0; blockNo < 2; ++blockNo)
+		{
+			size_t blockStart = random() % (state.size() - 256);
+			for(size_t i = 0; i < 256; ++i)
+			{
+				state[blockStart + i] = (unsigned char)random();
+			}
+		}
+		if((snapshotNo % 7) == 3)
+		{
+			state.resize(state.size() + (random() % 64) - 24, (unsigned char)random());
+		}
+		snapshots[snapshotNo] = state;
+	}
+	return snapshots;
+}
+
+//----------------------------------------------------------------------------------------
+static std::string CompareSnapshot(const std::vector<unsigned char>& restoredData, const std::vector<unsigned char>& capturedData, unsigned int snapshotNo)
+{
+	std::stringstream message;
+	if(restoredData.size() != capturedData.size())
+	{
+		message << "Snapshot " << snapshotNo << ": restored size " << restoredData.size() << " != captured size " << capturedData.size();
+		return message.str();
+	}
+	for(size_t i = 0; i < capturedData.size(); ++i)
+	{
+		if(restoredData[i] != capturedData[i])
+		{
+			message << "Snapshot " << snapshotNo << ", byte " << i << ": " << (unsigned int)restoredData[i] << " != " << (unsigned int)capturedData[i];
+			return message.str();
+		}
+	}
+	return "";
+}
+
+//----------------------------------------------------------------------------------------
+//Snapshot tests
+//----------------------------------------------------------------------------------------
+//Stepping the system back relies on each snapshot being restored exactly as it was
+//captured, so these tests confirm that every snapshot comes back byte for byte, across
+//keyframes, difference encoded snapshots, and changes in the state size.
+//----------------------------------------------------------------------------------------
+TEST_CASE("StateRewindBuffer::RemoveLatestSnapshot", "")
+{
+	const unsigned int snapshotCount = 100;
+	std::vector<std::vector<unsigned char>> snapshots = BuildSnapshots(snapshotCount, 1);
+
+	SECTION("Snapshots restore exactly")
+	{
+		StateRewindBuffer rewindBuffer(256 * 1024 * 1024, 8);
+		for(unsigned int snapshotNo = 0; snapshotNo < snapshotCount; ++snapshotNo)
+		{
+			rewindBuffer.AddSnapshot(&snapshots[snapshotNo][0], snapshots[snapshotNo].size());
+		}
+		REQUIRE(rewindBuffer.GetSnapshotCount() == snapshotCount);
+
+		unsigned int mismatchCount = 0;
+		std::string firstMismatch;
+		std::vector<unsigned char> restoredData;
+		for(unsigned int snapshotNo = snapshotCount; snapshotNo > 0; --snapshotNo)
+		{
+			REQUIRE(rewindBuffer.RemoveLatestSnapshot(restoredData));
+			std::string mismatch = CompareSnapshot(restoredData, snapshots[snapshotNo - 1], snapshotNo - 1);
+			if(!mismatch.empty())
+			{
+				firstMismatch = (mismatchCount == 0)? mismatch: firstMismatch;
+				++mismatchCount;
+			}
+		}
+		INFO(firstMismatch);
+		REQUIRE(mismatchCount == 0);
+		REQUIRE(!rewindBuffer.RemoveLatestSnapshot(restoredData));
+	}
+
+	SECTION("Snapshots restore exactly after new captures")
+	{
+		//Step back part of the way, then capture new snapshots from the restored point, in
+		//the same way as when the system resumes after stepping back.
+		StateRewindBuffer rewindBuffer(256 * 1024 * 1024, 8);
+		for(unsigned int snapshotNo = 0; snapshotNo < (snapshotCount / 2); ++snapshotNo)
+		{
+			rewindBuffer.AddSnapshot(&snapshots[snapshotNo][0], snapshots[snapshotNo].size());
+		}
+		std::vector<unsigned char> restoredData;
+		for(unsigned int i = 0; i < 13; ++i)
+		{
+			REQUIRE(rewindBuffer.RemoveLatestSnapshot(restoredData));
+		}
+		std::vector<std::vector<unsigned char>> expectedSnapshots(snapshots.begin(), snapshots.begin() + ((snapshotCount / 2) - 13));
+		for(unsigned int snapshotNo = (snapshotCount / 2); snapshotNo < snapshotCount; ++snapshotNo)
+		{
+			rewindBuffer.AddSnapshot(&snapshots[snapshotNo][0], snapshots[snapshotNo].size());
+			expectedSnapshots.push_back(snapshots[snapshotNo]);
+		}
+		REQUIRE(rewindBuffer.GetSnapshotCount() == expectedSnapshots.size());
+
+		unsigned int mismatchCount = 0;
+		std::string firstMismatch;
+		for(unsigned int snapshotNo = (unsigned int)expectedSnapshots.size(); snapshotNo > 0; --snapshotNo)
+		{
+			REQUIRE(rewindBuffer.RemoveLatestSnapshot(restoredData));
+			std::string mismatch = CompareSnapshot(restoredData, expectedSnapshots[snapshotNo - 1], snapshotNo - 1);
+			if(!mismatch.empty())
+			{
+				firstMismatch = (mismatchCount == 0)? mismatch: firstMismatch;
+				++mismatchCount;
+			}
+		}
+		INFO(firstMismatch);
+		REQUIRE(mismatchCount == 0);
+	}
+
+	SECTION("Snapshots restore exactly after old snapshots are discarded")
+	{
+		//Limit the memory so that old groups of snapshots are discarded. The snapshots which
+		//remain must still be the most recent ones, and must restore exactly.
+		StateRewindBuffer rewindBuffer(512 * 1024, 8);
+		for(unsigned int snapshotNo = 0; snapshotNo < snapshotCount; ++snapshotNo)
+		{
+			rewindBuffer.AddSnapshot(&snapshots[snapshotNo][0], snapshots[snapshotNo].size());
+		}
+		unsigned int retainedSnapshotCount = rewindBuffer.GetSnapshotCount();
+		REQUIRE(retainedSnapshotCount > 0);
+		REQUIRE(retainedSnapshotCount < snapshotCount);
+		REQUIRE(rewindBuffer.GetMemoryUsage() <= (512 * 1024));
+
+		unsigned int mismatchCount = 0;
+		std::string firstMismatch;
+		std::vector<unsigned char> restoredData;
+		for(unsigned int snapshotNo = snapshotCount; snapshotNo > (snapshotCount - retainedSnapshotCount); --snapshotNo)
+		{
+			REQUIRE(rewindBuffer.RemoveLatestSnapshot(restoredData));
+			std::string mismatch = CompareSnapshot(restoredData, snapshots[snapshotNo - 1], snapshotNo - 1);
+			if(!mismatch.empty())
+			{
+				firstMismatch = (mismatchCount == 0)? mismatch: firstMismatch;
+				++mismatchCount;
+			}
+		}
+		INFO(firstMismatch);
+		REQUIRE(mismatchCount == 0);
+		REQUIRE(!rewindBuffer.RemoveLatestSnapshot(restoredData));
+	}
+}